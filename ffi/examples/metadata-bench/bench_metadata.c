@@ -0,0 +1,301 @@
+// Times building snapshots and planning a scan of a table through kernel's FFI, for tracking how
+// kernel's metadata handling scales. Each run builds a snapshot of the latest version and one of an
+// older version, and then iterates all the scan metadata of the latest snapshot, without reading
+// any data.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "delta_kernel_ffi.h"
+#include "kernel_utils.h"
+
+typedef struct BenchOptions
+{
+  const char* table_path;
+  int runs;
+  // the version to build the older snapshot at, or -1 for half the latest version
+  int64_t version;
+  const char* json_path;
+} BenchOptions;
+
+typedef struct RunResult
+{
+  int64_t snapshot_ns;
+  int64_t snapshot_at_version_ns;
+  int64_t scan_metadata_ns;
+  int64_t files;
+  int64_t files_with_dv;
+  int64_t peak_rss_kb;
+} RunResult;
+
+// What the scan metadata visitor counts
+typedef struct ScanCounts
+{
+  int64_t files;
+  int64_t files_with_dv;
+} ScanCounts;
+
+static void print_usage(const char* program)
+{
+  fprintf(
+    stderr,
+    "Usage: %s [--runs N] [--version V] [--json out.json] path/to/table\n"
+    "  --runs N         number of times to run the benchmark (default 3)\n"
+    "  --version V      version to build the older snapshot at (default: half the latest)\n"
+    "  --json FILE      write the results to FILE instead of stdout\n",
+    program);
+}
+
+static int64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t peak_rss_kb(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  // macOS reports bytes, linux kilobytes
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+static double ns_to_ms(int64_t ns)
+{
+  return (double)ns / 1e6;
+}
+
+static void count_scan_file(
+  void* engine_context,
+  KernelStringSlice path,
+  int64_t size,
+  const Stats* stats,
+  const CDvInfo* dv_info,
+  const Expression* transform,
+  const CStringMap* partition_values)
+{
+  (void)path;
+  (void)size;
+  (void)stats;
+  (void)transform;
+  (void)partition_values;
+  ScanCounts* counts = engine_context;
+  counts->files++;
+  if (dv_info->has_vector) {
+    counts->files_with_dv++;
+  }
+}
+
+static void count_scan_metadata(void* engine_context, HandleSharedScanMetadata scan_metadata)
+{
+  visit_scan_metadata(scan_metadata, engine_context, count_scan_file);
+  free_scan_metadata(scan_metadata);
+}
+
+static SharedSnapshot* timed_snapshot(
+  KernelStringSlice path,
+  SharedExternEngine* engine,
+  int64_t version,
+  int64_t* elapsed_ns)
+{
+  int64_t start = now_ns();
+  ExternResultHandleSharedSnapshot res = version < 0
+                                           ? snapshot(path, engine)
+                                           : snapshot_at_version(path, engine, (uint64_t)version);
+  *elapsed_ns = now_ns() - start;
+  if (res.tag != OkHandleSharedSnapshot) {
+    print_error("Failed to create snapshot.", (Error*)res.err);
+    free_error((Error*)res.err);
+    return NULL;
+  }
+  return res.ok;
+}
+
+// Iterate all the scan metadata of `snapshot`, counting the files to scan
+static bool timed_scan_metadata(
+  SharedSnapshot* snapshot,
+  SharedExternEngine* engine,
+  RunResult* result)
+{
+  int64_t start = now_ns();
+  ExternResultHandleSharedScan scan_res = scan(snapshot, engine, NULL);
+  if (scan_res.tag != OkHandleSharedScan) {
+    print_error("Failed to create scan.", (Error*)scan_res.err);
+    free_error((Error*)scan_res.err);
+    return false;
+  }
+  SharedScan* scan = scan_res.ok;
+  ExternResultHandleSharedScanMetadataIterator iter_res = scan_metadata_iter_init(engine, scan);
+  if (iter_res.tag != OkHandleSharedScanMetadataIterator) {
+    print_error("Failed to construct scan metadata iterator.", (Error*)iter_res.err);
+    free_error((Error*)iter_res.err);
+    free_scan(scan);
+    return false;
+  }
+  SharedScanMetadataIterator* iter = iter_res.ok;
+  ScanCounts counts = { 0 };
+  bool ok = true;
+  for (;;) {
+    ExternResultbool next_res = scan_metadata_next(iter, &counts, count_scan_metadata);
+    if (next_res.tag != Okbool) {
+      print_error("Failed to iterate scan metadata.", (Error*)next_res.err);
+      free_error((Error*)next_res.err);
+      ok = false;
+      break;
+    } else if (!next_res.ok) {
+      break;
+    }
+  }
+  free_scan_metadata_iter(iter);
+  free_scan(scan);
+  result->scan_metadata_ns = now_ns() - start;
+  result->files = counts.files;
+  result->files_with_dv = counts.files_with_dv;
+  return ok;
+}
+
+static bool run_once(
+  const BenchOptions* opts,
+  SharedExternEngine* engine,
+  int64_t* latest_version,
+  int64_t* older_version,
+  RunResult* result)
+{
+  KernelStringSlice path = { opts->table_path, strlen(opts->table_path) };
+  SharedSnapshot* latest = timed_snapshot(path, engine, -1, &result->snapshot_ns);
+  if (!latest) {
+    return false;
+  }
+  *latest_version = (int64_t)version(latest);
+  *older_version = opts->version >= 0 ? opts->version : *latest_version / 2;
+
+  SharedSnapshot* older =
+    timed_snapshot(path, engine, *older_version, &result->snapshot_at_version_ns);
+  if (!older) {
+    free_snapshot(latest);
+    return false;
+  }
+  free_snapshot(older);
+
+  bool ok = timed_scan_metadata(latest, engine, result);
+  free_snapshot(latest);
+  result->peak_rss_kb = peak_rss_kb();
+  return ok;
+}
+
+static void write_json(
+  FILE* out,
+  const char* table_path,
+  int64_t latest_version,
+  int64_t older_version,
+  const RunResult* runs,
+  int num_runs)
+{
+  // table paths are urls or file system paths, so we only need to escape quotes and backslashes
+  fprintf(out, "{\n  \"table\": \"");
+  for (const char* c = table_path; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', out);
+    }
+    fputc(*c, out);
+  }
+  fprintf(out, "\",\n  \"version\": %" PRId64 ",\n", latest_version);
+  fprintf(out, "  \"snapshot_at_version\": %" PRId64 ",\n", older_version);
+  fprintf(out, "  \"runs\": [");
+  for (int r = 0; r < num_runs; r++) {
+    const RunResult* run = &runs[r];
+    double scan_secs = (double)run->scan_metadata_ns / 1e9;
+    fprintf(out, "%s\n    {\n", r ? "," : "");
+    fprintf(out, "      \"snapshot_ms\": %.3f,\n", ns_to_ms(run->snapshot_ns));
+    fprintf(
+      out, "      \"snapshot_at_version_ms\": %.3f,\n", ns_to_ms(run->snapshot_at_version_ns));
+    fprintf(out, "      \"scan_metadata_ms\": %.3f,\n", ns_to_ms(run->scan_metadata_ns));
+    fprintf(out, "      \"files\": %" PRId64 ",\n", run->files);
+    fprintf(out, "      \"files_with_dv\": %" PRId64 ",\n", run->files_with_dv);
+    fprintf(out, "      \"files_per_sec\": %.1f,\n", scan_secs > 0 ? run->files / scan_secs : 0);
+    fprintf(out, "      \"peak_rss_kb\": %" PRId64 "\n", run->peak_rss_kb);
+    fprintf(out, "    }");
+  }
+  fprintf(out, "\n  ]\n}\n");
+}
+
+static bool parse_options(int argc, char* argv[], BenchOptions* opts)
+{
+  *opts = (BenchOptions){ .runs = 3, .version = -1 };
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (arg[0] != '-') {
+      if (opts->table_path) {
+        return false;
+      }
+      opts->table_path = arg;
+    } else if (i + 1 == argc) {
+      return false;
+    } else if (strcmp(arg, "--runs") == 0) {
+      opts->runs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--version") == 0) {
+      opts->version = strtoll(argv[++i], NULL, 10);
+    } else if (strcmp(arg, "--json") == 0) {
+      opts->json_path = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return opts->table_path && opts->runs > 0 && opts->version >= -1;
+}
+
+int main(int argc, char* argv[])
+{
+  BenchOptions opts;
+  if (!parse_options(argc, argv, &opts)) {
+    print_usage(argv[0]);
+    return -1;
+  }
+
+  KernelStringSlice path = { opts.table_path, strlen(opts.table_path) };
+  ExternResultHandleSharedExternEngine engine_res = get_default_engine(path, allocate_error);
+  if (engine_res.tag != OkHandleSharedExternEngine) {
+    print_error("Failed to get engine.", (Error*)engine_res.err);
+    free_error((Error*)engine_res.err);
+    return -1;
+  }
+  SharedExternEngine* engine = engine_res.ok;
+
+  RunResult* runs = calloc((size_t)opts.runs, sizeof(RunResult));
+  int64_t latest_version = 0;
+  int64_t older_version = 0;
+  int ret = 0;
+  for (int r = 0; r < opts.runs; r++) {
+    if (!run_once(&opts, engine, &latest_version, &older_version, &runs[r])) {
+      ret = -1;
+      break;
+    }
+  }
+
+  if (ret == 0) {
+    FILE* out = opts.json_path ? fopen(opts.json_path, "w") : stdout;
+    if (!out) {
+      fprintf(stderr, "Failed to open %s\n", opts.json_path);
+      ret = -1;
+    } else {
+      write_json(out, opts.table_path, latest_version, older_version, runs, opts.runs);
+      if (out != stdout) {
+        fclose(out);
+      }
+    }
+  }
+
+  free(runs);
+  free_engine(engine);
+  return ret;
+}
@@ -0,0 +1,502 @@
+// Generates a synthetic delta table, shaped like a large production table, for benchmarking
+// snapshot construction and scan planning. Only the `_delta_log` is written: the data files it
+// refers to don't exist, so the table can be used for metadata reads only.
+//
+// The log is written directly as JSON, without going through kernel, so generating even a very
+// large table is mostly IO. Checkpoints are V2 checkpoints in JSON format, since writing parquet
+// would need a parquet library.
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// An inline deletion vector deleting 6 rows, which all generated DVs use. Scan planning doesn't
+// look at the content of DVs, and this one is valid should anyone read it anyway
+#define INLINE_DV "^Bg9^0rr910000000000iXQKl0rr91000f55c8Xg0@@D72lkbi5=-{L"
+#define INLINE_DV_SIZE 44
+#define INLINE_DV_CARDINALITY 6
+#define RECORDS_PER_FILE 100000
+// like delta's default `delta.dataSkippingNumIndexedCols`, only collect stats for this many leaf
+// columns
+#define STATS_LEAF_COLUMNS 32
+// 2023-11-14, so the commits have plausible timestamps
+#define BASE_TIMESTAMP_MS 1700000000000LL
+
+typedef struct GenerateOptions
+{
+  const char* table_path;
+  int64_t commits;
+  int64_t files_per_commit;
+  int64_t dv_updates_per_commit;
+  int64_t checkpoint_interval;
+  int columns;
+  int nesting;
+  int partitions;
+  uint64_t seed;
+} GenerateOptions;
+
+// A file added to the table. Its path and partition are derived from its index
+typedef struct GeneratedFile
+{
+  int64_t size;
+  bool has_dv;
+} GeneratedFile;
+
+typedef struct Generator
+{
+  const GenerateOptions* opts;
+  char* log_path;
+  uint64_t rng;
+  GeneratedFile* files;
+  int64_t num_files;
+  // the oldest file that might not have a DV yet
+  int64_t next_dv_candidate;
+  // the schema, already escaped to be embedded as a JSON string
+  char* schema_string;
+  char table_id[37];
+} Generator;
+
+static void print_usage(const char* program)
+{
+  fprintf(
+    stderr,
+    "Usage: %s [options] path/to/new/table\n"
+    "  --commits N                number of commits (default 100)\n"
+    "  --files-per-commit N       files added by each commit (default 100)\n"
+    "  --dv-updates-per-commit N  files given a deletion vector by each commit (default 0)\n"
+    "  --checkpoint-interval N    write a checkpoint every N commits, 0 for none (default 0)\n"
+    "  --columns N                top-level columns in the schema (default 10)\n"
+    "  --nesting N                depth of the struct nesting of each column (default 0)\n"
+    "  --partitions N             distinct values of the partition column, 0 to not partition the\n"
+    "                             table (default 0)\n"
+    "  --seed N                   seed for the generated sizes and stats (default 42)\n",
+    program);
+}
+
+// splitmix64, so the same seed always generates the same table
+static uint64_t next_random(Generator* gen)
+{
+  uint64_t z = (gen->rng += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void random_uuid(Generator* gen, char out[37])
+{
+  uint64_t hi = next_random(gen);
+  uint64_t lo = next_random(gen);
+  snprintf(
+    out,
+    37,
+    "%08" PRIx64 "-%04" PRIx64 "-4%03" PRIx64 "-8%03" PRIx64 "-%012" PRIx64,
+    hi >> 32,
+    (hi >> 16) & 0xffff,
+    hi & 0xfff,
+    lo >> 52,
+    lo & UINT64_C(0xffffffffffff));
+}
+
+// A growable string, to build the schema in
+typedef struct StringBuf
+{
+  char* data;
+  size_t len;
+  size_t cap;
+} StringBuf;
+
+static void buf_printf(StringBuf* buf, const char* fmt, ...)
+{
+  for (;;) {
+    va_list args;
+    va_start(args, fmt);
+    int needed = vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, args);
+    va_end(args);
+    if (needed < 0) {
+      fprintf(stderr, "Failed to format schema\n");
+      exit(-1);
+    }
+    if (buf->len + (size_t)needed < buf->cap) {
+      buf->len += (size_t)needed;
+      return;
+    }
+    buf->cap = (buf->cap + (size_t)needed + 1) * 2;
+    buf->data = realloc(buf->data, buf->cap);
+    if (!buf->data) {
+      fprintf(stderr, "Out of memory\n");
+      exit(-1);
+    }
+  }
+}
+
+// Column `c<i>` is a long if `depth` is 0, and otherwise a struct of a long `a` and a nested struct
+// `s` of one less depth
+static void write_column_type(StringBuf* buf, int depth)
+{
+  if (depth == 0) {
+    buf_printf(buf, "\"long\"");
+    return;
+  }
+  buf_printf(
+    buf,
+    "{\"type\":\"struct\",\"fields\":[{\"name\":\"a\",\"type\":\"long\",\"nullable\":true,"
+    "\"metadata\":{}},{\"name\":\"s\",\"type\":");
+  write_column_type(buf, depth - 1);
+  buf_printf(buf, ",\"nullable\":true,\"metadata\":{}}]}");
+}
+
+static char* build_schema_string(const GenerateOptions* opts)
+{
+  StringBuf buf = { 0 };
+  buf_printf(&buf, "{\"type\":\"struct\",\"fields\":[");
+  for (int i = 0; i < opts->columns; i++) {
+    buf_printf(&buf, "%s{\"name\":\"c%d\",\"type\":", i ? "," : "", i);
+    write_column_type(&buf, opts->nesting);
+    buf_printf(&buf, ",\"nullable\":true,\"metadata\":{}}");
+  }
+  if (opts->partitions > 0) {
+    buf_printf(
+      &buf,
+      "%s{\"name\":\"part\",\"type\":\"string\",\"nullable\":true,\"metadata\":{}}",
+      opts->columns ? "," : "");
+  }
+  buf_printf(&buf, "]}");
+
+  // the schema is embedded in the metadata action as a string, so its quotes must be escaped
+  char* escaped = malloc(buf.len * 2 + 1);
+  char* out = escaped;
+  for (size_t i = 0; i < buf.len; i++) {
+    if (buf.data[i] == '"') {
+      *out++ = '\\';
+    }
+    *out++ = buf.data[i];
+  }
+  *out = '\0';
+  free(buf.data);
+  return escaped;
+}
+
+// Stats for a value of column type `depth` (see `write_column_type`), with the quotes escaped since
+// stats are embedded in the add action as a string
+static void write_column_stats(FILE* out, int depth, int64_t value)
+{
+  if (depth == 0) {
+    fprintf(out, "%" PRId64, value);
+    return;
+  }
+  fprintf(out, "{\\\"a\\\":%" PRId64 ",\\\"s\\\":", value);
+  write_column_stats(out, depth - 1, value);
+  fprintf(out, "}");
+}
+
+static void write_stats(FILE* out, const GenerateOptions* opts, int64_t file_index)
+{
+  // each column has one leaf per level of nesting
+  int stats_columns = STATS_LEAF_COLUMNS / (opts->nesting + 1);
+  if (stats_columns > opts->columns) {
+    stats_columns = opts->columns;
+  }
+  fprintf(out, "\"stats\":\"{\\\"numRecords\\\":%d", RECORDS_PER_FILE);
+  const char* names[] = { "minValues", "maxValues" };
+  for (int which = 0; which < 2; which++) {
+    fprintf(out, ",\\\"%s\\\":{", names[which]);
+    for (int i = 0; i < stats_columns; i++) {
+      // files cover consecutive ranges of values, as if the table was clustered by every column
+      int64_t value = file_index * RECORDS_PER_FILE + (which ? RECORDS_PER_FILE - 1 : 0);
+      fprintf(out, "%s\\\"c%d\\\":", i ? "," : "", i);
+      write_column_stats(out, opts->nesting, value);
+    }
+    fprintf(out, "}");
+  }
+  fprintf(out, ",\\\"nullCount\\\":{");
+  for (int i = 0; i < stats_columns; i++) {
+    fprintf(out, "%s\\\"c%d\\\":", i ? "," : "", i);
+    write_column_stats(out, opts->nesting, 0);
+  }
+  fprintf(out, "}}\"");
+}
+
+static void write_path_and_partition(FILE* out, const GenerateOptions* opts, int64_t file_index)
+{
+  if (opts->partitions > 0) {
+    int64_t part = file_index % opts->partitions;
+    fprintf(
+      out,
+      "\"path\":\"part=p%" PRId64 "/part-%010" PRId64 ".parquet\","
+      "\"partitionValues\":{\"part\":\"p%" PRId64 "\"}",
+      part,
+      file_index,
+      part);
+  } else {
+    fprintf(out, "\"path\":\"part-%010" PRId64 ".parquet\",\"partitionValues\":{}", file_index);
+  }
+}
+
+static void write_deletion_vector(FILE* out)
+{
+  fprintf(
+    out,
+    ",\"deletionVector\":{\"storageType\":\"i\",\"pathOrInlineDv\":\"%s\","
+    "\"sizeInBytes\":%d,\"cardinality\":%d}",
+    INLINE_DV,
+    INLINE_DV_SIZE,
+    INLINE_DV_CARDINALITY);
+}
+
+static void write_add(Generator* gen, FILE* out, int64_t file_index, int64_t timestamp)
+{
+  GeneratedFile* file = &gen->files[file_index];
+  fprintf(out, "{\"add\":{");
+  write_path_and_partition(out, gen->opts, file_index);
+  fprintf(
+    out,
+    ",\"size\":%" PRId64 ",\"modificationTime\":%" PRId64 ",\"dataChange\":true,",
+    file->size,
+    timestamp);
+  write_stats(out, gen->opts, file_index);
+  if (file->has_dv) {
+    write_deletion_vector(out);
+  }
+  fprintf(out, "}}\n");
+}
+
+static void write_remove(Generator* gen, FILE* out, int64_t file_index, int64_t timestamp)
+{
+  fprintf(out, "{\"remove\":{");
+  write_path_and_partition(out, gen->opts, file_index);
+  fprintf(
+    out,
+    ",\"deletionTimestamp\":%" PRId64 ",\"dataChange\":true,\"extendedFileMetadata\":true,"
+    "\"size\":%" PRId64 "}}\n",
+    timestamp,
+    gen->files[file_index].size);
+}
+
+static void write_protocol_and_metadata(Generator* gen, FILE* out)
+{
+  fprintf(
+    out,
+    "{\"protocol\":{\"minReaderVersion\":3,\"minWriterVersion\":7,"
+    "\"readerFeatures\":[\"deletionVectors\",\"v2Checkpoint\"],"
+    "\"writerFeatures\":[\"deletionVectors\",\"v2Checkpoint\"]}}\n");
+  fprintf(
+    out,
+    "{\"metaData\":{\"id\":\"%s\",\"format\":{\"provider\":\"parquet\",\"options\":{}},"
+    "\"schemaString\":\"%s\",\"partitionColumns\":[%s],"
+    "\"configuration\":{\"delta.enableDeletionVectors\":\"true\","
+    "\"delta.checkpointPolicy\":\"v2\"},\"createdTime\":%" PRId64 "}}\n",
+    gen->table_id,
+    gen->schema_string,
+    gen->opts->partitions > 0 ? "\"part\"" : "",
+    (int64_t)BASE_TIMESTAMP_MS);
+}
+
+static FILE* open_log_file(Generator* gen, const char* name)
+{
+  size_t len = strlen(gen->log_path) + strlen(name) + 2;
+  char* path = malloc(len);
+  snprintf(path, len, "%s/%s", gen->log_path, name);
+  FILE* out = fopen(path, "w");
+  if (!out) {
+    fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+    exit(-1);
+  }
+  free(path);
+  return out;
+}
+
+static void close_log_file(FILE* out)
+{
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Failed to write log file: %s\n", strerror(errno));
+    exit(-1);
+  }
+}
+
+static void write_commit(Generator* gen, int64_t version)
+{
+  const GenerateOptions* opts = gen->opts;
+  char name[32];
+  snprintf(name, sizeof(name), "%020" PRId64 ".json", version);
+  FILE* out = open_log_file(gen, name);
+  int64_t timestamp = BASE_TIMESTAMP_MS + version * 1000;
+
+  fprintf(
+    out,
+    "{\"commitInfo\":{\"timestamp\":%" PRId64 ",\"operation\":\"WRITE\","
+    "\"operationParameters\":{\"mode\":\"Append\"},\"isBlindAppend\":%s}}\n",
+    timestamp,
+    version > 0 && opts->dv_updates_per_commit > 0 ? "false" : "true");
+  if (version == 0) {
+    write_protocol_and_metadata(gen, out);
+  }
+
+  // give some older files a deletion vector: remove the file, and add it back with the DV
+  for (int64_t i = 0; version > 0 && i < opts->dv_updates_per_commit; i++) {
+    while (gen->next_dv_candidate < gen->num_files && gen->files[gen->next_dv_candidate].has_dv) {
+      gen->next_dv_candidate++;
+    }
+    if (gen->next_dv_candidate == gen->num_files) {
+      break;
+    }
+    int64_t file_index = gen->next_dv_candidate++;
+    write_remove(gen, out, file_index, timestamp);
+    gen->files[file_index].has_dv = true;
+    write_add(gen, out, file_index, timestamp);
+  }
+
+  for (int64_t i = 0; i < opts->files_per_commit; i++) {
+    int64_t file_index = gen->num_files++;
+    // between 64MB and 128MB, like the output of a well tuned writer
+    gen->files[file_index].size = (64 << 20) + (int64_t)(next_random(gen) % (64 << 20));
+    gen->files[file_index].has_dv = false;
+    write_add(gen, out, file_index, timestamp);
+  }
+  close_log_file(out);
+}
+
+// Write a V2 checkpoint with the state of the table as of `version`, and point `_last_checkpoint`
+// at it
+static void write_checkpoint(Generator* gen, int64_t version)
+{
+  char uuid[37];
+  random_uuid(gen, uuid);
+  char name[96];
+  snprintf(name, sizeof(name), "%020" PRId64 ".checkpoint.%s.json", version, uuid);
+  FILE* out = open_log_file(gen, name);
+  fprintf(out, "{\"checkpointMetadata\":{\"version\":%" PRId64 "}}\n", version);
+  write_protocol_and_metadata(gen, out);
+  for (int64_t i = 0; i < gen->num_files; i++) {
+    write_add(gen, out, i, BASE_TIMESTAMP_MS + version * 1000);
+  }
+  close_log_file(out);
+
+  out = open_log_file(gen, "_last_checkpoint");
+  // checkpointMetadata, protocol and metaData, plus the adds
+  fprintf(
+    out,
+    "{\"version\":%" PRId64 ",\"size\":%" PRId64 ",\"numOfAddFiles\":%" PRId64 "}\n",
+    version,
+    gen->num_files + 3,
+    gen->num_files);
+  close_log_file(out);
+}
+
+static void make_dir(const char* path)
+{
+  if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+    exit(-1);
+  }
+}
+
+static bool parse_int(const char* arg, int64_t* out)
+{
+  char* end;
+  errno = 0;
+  long long value = strtoll(arg, &end, 10);
+  if (errno != 0 || *end != '\0' || end == arg || value < 0) {
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+static bool parse_options(int argc, char* argv[], GenerateOptions* opts)
+{
+  *opts = (GenerateOptions){
+    .commits = 100,
+    .files_per_commit = 100,
+    .columns = 10,
+    .seed = 42,
+  };
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (arg[0] != '-') {
+      if (opts->table_path) {
+        return false;
+      }
+      opts->table_path = arg;
+      continue;
+    }
+    int64_t value;
+    if (i + 1 == argc || !parse_int(argv[i + 1], &value)) {
+      return false;
+    }
+    i++;
+    if (strcmp(arg, "--commits") == 0) {
+      opts->commits = value;
+    } else if (strcmp(arg, "--files-per-commit") == 0) {
+      opts->files_per_commit = value;
+    } else if (strcmp(arg, "--dv-updates-per-commit") == 0) {
+      opts->dv_updates_per_commit = value;
+    } else if (strcmp(arg, "--checkpoint-interval") == 0) {
+      opts->checkpoint_interval = value;
+    } else if (strcmp(arg, "--columns") == 0 && value <= 100000) {
+      opts->columns = (int)value;
+    } else if (strcmp(arg, "--nesting") == 0 && value <= 64) {
+      opts->nesting = (int)value;
+    } else if (strcmp(arg, "--partitions") == 0 && value <= 1000000) {
+      opts->partitions = (int)value;
+    } else if (strcmp(arg, "--seed") == 0) {
+      opts->seed = (uint64_t)value;
+    } else {
+      return false;
+    }
+  }
+  return opts->table_path && opts->commits > 0;
+}
+
+int main(int argc, char* argv[])
+{
+  GenerateOptions opts;
+  if (!parse_options(argc, argv, &opts)) {
+    print_usage(argv[0]);
+    return -1;
+  }
+
+  Generator gen = {
+    .opts = &opts,
+    .rng = opts.seed,
+  };
+  gen.files = malloc(sizeof(GeneratedFile) * (size_t)(opts.commits * opts.files_per_commit + 1));
+  if (!gen.files) {
+    fprintf(stderr, "Out of memory\n");
+    return -1;
+  }
+  gen.schema_string = build_schema_string(&opts);
+  random_uuid(&gen, gen.table_id);
+
+  make_dir(opts.table_path);
+  size_t len = strlen(opts.table_path) + strlen("/_delta_log") + 1;
+  gen.log_path = malloc(len);
+  snprintf(gen.log_path, len, "%s/_delta_log", opts.table_path);
+  make_dir(gen.log_path);
+
+  for (int64_t version = 0; version < opts.commits; version++) {
+    write_commit(&gen, version);
+    if (opts.checkpoint_interval > 0 && version > 0 && version % opts.checkpoint_interval == 0) {
+      write_checkpoint(&gen, version);
+    }
+  }
+
+  int64_t files_with_dv = 0;
+  for (int64_t i = 0; i < gen.num_files; i++) {
+    files_with_dv += gen.files[i].has_dv;
+  }
+  printf("version: %" PRId64 "\n", opts.commits - 1);
+  printf("files: %" PRId64 "\n", gen.num_files);
+  printf("files_with_dv: %" PRId64 "\n", files_with_dv);
+
+  free(gen.log_path);
+  free(gen.schema_string);
+  free(gen.files);
+  return 0;
+}
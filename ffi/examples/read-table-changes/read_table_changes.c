@@ -0,0 +1,445 @@
+// Reads the change data feed of a table through kernel's table changes FFI, and prints every
+// changed row. Kernel works out which files hold the changes of each commit, and which of their
+// rows are changes. We read the files, apply the transform kernel gives us for each one, which adds
+// the `_change_type`, `_commit_version` and `_commit_timestamp` columns, and drop the rows that
+// aren't changes.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "delta_kernel_ffi.h"
+#include "kernel_utils.h"
+#include "predicate.h"
+
+#ifdef PRINT_ARROW_DATA
+#include <arrow-glib/arrow-glib.h>
+#endif
+
+typedef struct ReadTableChangesOptions
+{
+  const char* table_path;
+  uint64_t start_version;
+  // -1 for the latest version
+  int64_t end_version;
+  const char* where;
+  const char* columns;
+} ReadTableChangesOptions;
+
+// What the callbacks of a scan share
+typedef struct ChangesContext
+{
+  SharedExternEngine* engine;
+  SharedSchema* logical_schema;
+  uint64_t num_files;
+  uint64_t num_changes;
+  bool failed;
+} ChangesContext;
+
+// The read of one file of the scan
+typedef struct FileRead
+{
+  ChangesContext* context;
+  SharedExpressionEvaluator* evaluator;
+  // the rows of the file that are changes, see `is_change`
+  KernelBoolSlice selection_vector;
+  bool rows_past_end_selected;
+  // the number of rows of the file read so far
+  uint64_t rows_read;
+} FileRead;
+
+// The columns kernel adds to the changes. They aren't in the table's files, so there are no stats a
+// predicate on them could skip files with
+static const char* CHANGE_DATA_COLUMNS[] = {
+  "_change_type",
+  "_commit_version",
+  "_commit_timestamp",
+};
+
+// Parse the argument of `--where` against the schema of the changes, which is the table schema plus
+// the change data columns, rejecting predicates on the change data columns. Returns NULL (after
+// printing why) if the predicate is invalid
+static WherePredicate* parse_changes_predicate(const char* where, SharedTableChanges* changes)
+{
+  SharedSchema* schema = table_changes_schema(changes);
+  WherePredicate* predicate = parse_where_predicate(where, schema);
+  free_schema(schema);
+  if (predicate == NULL) {
+    return NULL;
+  }
+  for (int i = 0; i < predicate->num_terms; i++) {
+    for (size_t j = 0; j < sizeof(CHANGE_DATA_COLUMNS) / sizeof(CHANGE_DATA_COLUMNS[0]); j++) {
+      if (!strcmp(predicate->terms[i].column, CHANGE_DATA_COLUMNS[j])) {
+        printf("--where can't filter on the change data column %s\n", CHANGE_DATA_COLUMNS[j]);
+        free_where_predicate(predicate);
+        return NULL;
+      }
+    }
+  }
+  return predicate;
+}
+
+static void print_usage(const char* prog)
+{
+  printf("Usage: %s [--start-version V] [--end-version V] [--where PREDICATE] [--columns a,b,c] "
+         "table/path\n",
+         prog);
+  printf("  --start-version V  the first version to read the changes of (default: 0)\n");
+  printf("  --end-version V    the last version to read the changes of (default: the latest)\n");
+  printf("  --where PREDICATE  skip files that can't contain changes matching PREDICATE, of the\n");
+  printf("                     form \"col op literal [AND ...]\". The change data columns can't\n");
+  printf("                     be filtered on\n");
+  printf("  --columns a,b,c    only read the listed top-level columns\n");
+}
+
+// Split a comma separated list of column names into string slices, which point into `columns`.
+// Returns the number of slices, which the caller must free with `free`
+static uintptr_t parse_column_list(const char* columns, KernelStringSlice** slices)
+{
+  uintptr_t count = 1;
+  for (const char* c = columns; *c; c++) {
+    count += *c == ',';
+  }
+  *slices = malloc(sizeof(KernelStringSlice) * count);
+  const char* start = columns;
+  for (uintptr_t i = 0; i < count; i++) {
+    size_t len = strcspn(start, ",");
+    (*slices)[i] = (KernelStringSlice){ start, len };
+    start += len + 1;
+  }
+  return count;
+}
+
+// Whether row `row` of the file of `read` is a change. Rows past the end of the selection vector
+// are changes if kernel says so: they are for files with a deletion vector, but not for files
+// whose changes kernel worked out from two deletion vectors
+static bool is_change(const FileRead* read, uint64_t row)
+{
+  if (row < read->selection_vector.len) {
+    return read->selection_vector.ptr[row];
+  }
+  return read->rows_past_end_selected;
+}
+
+#ifdef PRINT_ARROW_DATA
+// report and free an error if it's not NULL. Return true if error was not null, false otherwise
+static bool report_g_error(char* msg, GError* error)
+{
+  if (error != NULL) {
+    printf("%s: %s\n", msg, error->message);
+    g_error_free(error);
+    return true;
+  }
+  return false;
+}
+
+// Print one value of `array` the way arrow prints arrays, minus the brackets around them
+static bool print_value(GArrowArray* array, gint64 row)
+{
+  GError* error = NULL;
+  GArrowArray* value = garrow_array_slice(array, row, 1);
+  gchar* printed = garrow_array_to_string(value, &error);
+  g_object_unref(value);
+  if (report_g_error("Can't get value as string", error)) {
+    return false;
+  }
+  // a one element array prints as "[\n  value\n]"
+  size_t len = strlen(printed);
+  if (len >= 6 && strncmp(printed, "[\n  ", 4) == 0) {
+    printf("%.*s", (int)(len - 6), printed + 4);
+  } else {
+    printf("%s", printed);
+  }
+  g_free(printed);
+  return true;
+}
+
+// Print the rows of `batch` that are changes, one per line
+static bool print_changes(FileRead* read, GArrowRecordBatch* batch)
+{
+  guint num_columns = garrow_record_batch_get_n_columns(batch);
+  gint64 num_rows = garrow_record_batch_get_n_rows(batch);
+  GArrowArray** columns = malloc(sizeof(GArrowArray*) * num_columns);
+  for (guint c = 0; c < num_columns; c++) {
+    columns[c] = garrow_record_batch_get_column_data(batch, c);
+  }
+  bool ok = true;
+  for (gint64 row = 0; ok && row < num_rows; row++) {
+    if (!is_change(read, read->rows_read + (uint64_t)row)) {
+      continue;
+    }
+    for (guint c = 0; ok && c < num_columns; c++) {
+      // name owned by the batch, so no need to free
+      printf("%s%s: ", c > 0 ? ", " : "", garrow_record_batch_get_column_name(batch, c));
+      ok = print_value(columns[c], row);
+    }
+    printf("\n");
+    read->context->num_changes++;
+  }
+  for (guint c = 0; c < num_columns; c++) {
+    g_object_unref(columns[c]);
+  }
+  free(columns);
+  return ok;
+}
+
+// Print the changes of logical (i.e. transformed) data. Consumes `data`
+static bool visit_changes(FileRead* read, ExclusiveEngineData* data)
+{
+  ExternResultArrowFFIData arrow_res = get_raw_arrow_data(data, read->context->engine);
+  if (arrow_res.tag != OkArrowFFIData) {
+    print_error("Failed to get arrow data.", (Error*)arrow_res.err);
+    free_error((Error*)arrow_res.err);
+    return false;
+  }
+  ArrowFFIData* arrow_data = arrow_res.ok;
+  GError* error = NULL;
+  GArrowSchema* schema = garrow_schema_import((gpointer)&arrow_data->schema, &error);
+  if (report_g_error("Can't get schema", error)) {
+    free(arrow_data);
+    return false;
+  }
+  GArrowRecordBatch* batch =
+    garrow_record_batch_import((gpointer)&arrow_data->array, schema, &error);
+  g_object_unref(schema);
+  free(arrow_data); // just frees the struct, the data and schema are now owned by the batch
+  if (report_g_error("Can't get record batch", error)) {
+    return false;
+  }
+  bool ok = print_changes(read, batch);
+  read->rows_read += (uint64_t)garrow_record_batch_get_n_rows(batch);
+  g_object_unref(batch);
+  return ok;
+}
+#else
+// Count the changes of logical (i.e. transformed) data. Consumes `data`
+static bool visit_changes(FileRead* read, ExclusiveEngineData* data)
+{
+  uint64_t num_rows = engine_data_length(&data);
+  for (uint64_t row = 0; row < num_rows; row++) {
+    read->context->num_changes += is_change(read, read->rows_read + row);
+  }
+  read->rows_read += num_rows;
+  free_engine_data(data);
+  return true;
+}
+#endif
+
+// Called for each chunk of data read from a file
+static void visit_read_data(void* vread, ExclusiveEngineData* data)
+{
+  FileRead* read = vread;
+  ExternResultHandleExclusiveEngineData transformed_res =
+    evaluate_expression(read->context->engine, &data, read->evaluator);
+  free_engine_data(data);
+  if (transformed_res.tag != OkHandleExclusiveEngineData) {
+    print_error("Failed to transform read data.", (Error*)transformed_res.err);
+    free_error((Error*)transformed_res.err);
+    read->context->failed = true;
+    return;
+  }
+  if (!visit_changes(read, transformed_res.ok)) {
+    read->context->failed = true;
+  }
+}
+
+// Kernel calls this for each file with changes, in commit order
+static void visit_changed_file(void* engine_context, SharedTableChangesScanFile* file)
+{
+  ChangesContext* context = engine_context;
+  context->num_files++;
+  char* location = table_changes_scan_file_location(file, allocate_string);
+  print_diag("Reading changes of version %" PRId64 " from %s\n",
+             table_changes_scan_file_commit_version(file),
+             location);
+  SharedSchema* physical_schema = table_changes_scan_file_physical_schema(file);
+  FileRead read = {
+    .context = context,
+    .evaluator = new_expression_evaluator(context->engine,
+                                          physical_schema,
+                                          table_changes_scan_file_transform(file),
+                                          context->logical_schema),
+    .selection_vector = table_changes_scan_file_selection_vector(file),
+    .rows_past_end_selected = table_changes_scan_file_rows_past_end_selected(file),
+    .rows_read = 0,
+  };
+  FileMeta meta = {
+    .path = { location, strlen(location) },
+    .last_modified = 0,
+    .size = 0,
+  };
+  ExternResultHandleExclusiveFileReadResultIterator read_res =
+    read_parquet_file(context->engine, &meta, physical_schema, NULL);
+  if (read_res.tag != OkHandleExclusiveFileReadResultIterator) {
+    print_error("Couldn't read file.", (Error*)read_res.err);
+    free_error((Error*)read_res.err);
+    context->failed = true;
+  } else {
+    ExclusiveFileReadResultIterator* read_iter = read_res.ok;
+    while (!context->failed) {
+      ExternResultbool ok_res = read_result_next(read_iter, &read, visit_read_data);
+      if (ok_res.tag != Okbool) {
+        print_error("Failed to iterate read data.", (Error*)ok_res.err);
+        free_error((Error*)ok_res.err);
+        context->failed = true;
+      } else if (!ok_res.ok) {
+        break;
+      }
+    }
+    free_read_result_iter(read_iter);
+  }
+  free_bool_slice(read.selection_vector);
+  free_expression_evaluator(read.evaluator);
+  free_schema(physical_schema);
+  free(location);
+  free_table_changes_scan_file(file);
+}
+
+// Read all the changed files of `scan`. Returns 0 on success
+static int read_changes(ChangesContext* context, SharedTableChangesScan* scan)
+{
+  ExternResultHandleSharedTableChangesScanFileIterator iter_res =
+    table_changes_scan_files_init(context->engine, scan);
+  if (iter_res.tag != OkHandleSharedTableChangesScanFileIterator) {
+    print_error("Failed to construct table changes iterator.", (Error*)iter_res.err);
+    free_error((Error*)iter_res.err);
+    return -1;
+  }
+  SharedTableChangesScanFileIterator* iter = iter_res.ok;
+  while (!context->failed) {
+    ExternResultbool ok_res = table_changes_scan_files_next(iter, context, visit_changed_file);
+    if (ok_res.tag != Okbool) {
+      print_error("Failed to iterate table changes.", (Error*)ok_res.err);
+      free_error((Error*)ok_res.err);
+      context->failed = true;
+    } else if (!ok_res.ok) {
+      break;
+    }
+  }
+  free_table_changes_scan_files_iter(iter);
+  return context->failed ? -1 : 0;
+}
+
+static int read_table_changes(const ReadTableChangesOptions* opts)
+{
+  KernelStringSlice table_path_slice = { opts->table_path, strlen(opts->table_path) };
+  ExternResultHandleSharedExternEngine engine_res =
+    get_default_engine(table_path_slice, allocate_error);
+  if (engine_res.tag != OkHandleSharedExternEngine) {
+    print_error("Failed to get engine.", (Error*)engine_res.err);
+    free_error((Error*)engine_res.err);
+    return -1;
+  }
+  SharedExternEngine* engine = engine_res.ok;
+
+  ExternResultHandleSharedTableChanges table_changes_res =
+    opts->end_version < 0
+      ? table_changes_from_version(table_path_slice, engine, opts->start_version)
+      : table_changes_between_versions(
+          table_path_slice, engine, opts->start_version, (uint64_t)opts->end_version);
+  if (table_changes_res.tag != OkHandleSharedTableChanges) {
+    print_error("Failed to get table changes.", (Error*)table_changes_res.err);
+    free_error((Error*)table_changes_res.err);
+    free_engine(engine);
+    return -1;
+  }
+  SharedTableChanges* changes = table_changes_res.ok;
+  // the table path isn't printed, so the output of the same table is the same wherever it is
+  printf("Reading table changes from version %" PRIu64 " to %" PRIu64 "\n",
+         table_changes_start_version(changes),
+         table_changes_end_version(changes));
+
+  WherePredicate* where_predicate = NULL;
+  EnginePredicate engine_predicate;
+  EnginePredicate* predicate = NULL;
+  if (opts->where) {
+    where_predicate = parse_changes_predicate(opts->where, changes);
+    if (where_predicate == NULL) {
+      free_table_changes(changes);
+      free_engine(engine);
+      return -1;
+    }
+    engine_predicate.predicate = where_predicate;
+    engine_predicate.visitor = visit_where_predicate;
+    predicate = &engine_predicate;
+  }
+
+  ExternResultHandleSharedTableChangesScan scan_res;
+  if (opts->columns) {
+    KernelStringSlice* column_slices = NULL;
+    uintptr_t num_columns = parse_column_list(opts->columns, &column_slices);
+    scan_res =
+      table_changes_scan_with_columns(changes, engine, predicate, column_slices, num_columns);
+    free(column_slices);
+  } else {
+    scan_res = table_changes_scan(changes, engine, predicate);
+  }
+  int ret = 0;
+  if (scan_res.tag != OkHandleSharedTableChangesScan) {
+    print_error("Failed to create table changes scan.", (Error*)scan_res.err);
+    free_error((Error*)scan_res.err);
+    ret = -1;
+  } else {
+    SharedTableChangesScan* scan = scan_res.ok;
+    ChangesContext context = {
+      .engine = engine,
+      .logical_schema = table_changes_scan_logical_schema(scan),
+      .num_files = 0,
+      .num_changes = 0,
+      .failed = false,
+    };
+    ret = read_changes(&context, scan);
+    print_diag("Read %" PRIu64 " changes from %" PRIu64 " files\n",
+               context.num_changes,
+               context.num_files);
+#ifndef PRINT_ARROW_DATA
+    printf("changes: %" PRIu64 "\n", context.num_changes);
+#endif
+    free_schema(context.logical_schema);
+    free_table_changes_scan(scan);
+  }
+
+  if (where_predicate) {
+    free_where_predicate(where_predicate);
+  }
+  free_table_changes(changes);
+  free_engine(engine);
+  return ret;
+}
+
+int main(int argc, char* argv[])
+{
+  ReadTableChangesOptions opts = {
+    .table_path = NULL,
+    .start_version = 0,
+    .end_version = -1,
+    .where = NULL,
+    .columns = NULL,
+  };
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--start-version") == 0 && i + 1 < argc) {
+      opts.start_version = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--end-version") == 0 && i + 1 < argc) {
+      opts.end_version = strtoll(argv[++i], NULL, 10);
+      if (opts.end_version < 0) {
+        printf("--end-version must not be negative\n");
+        return -1;
+      }
+    } else if (strcmp(argv[i], "--where") == 0 && i + 1 < argc) {
+      opts.where = argv[++i];
+    } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+      opts.columns = argv[++i];
+    } else if (opts.table_path == NULL && strncmp(argv[i], "--", 2) != 0) {
+      opts.table_path = argv[i];
+    } else {
+      print_usage(argv[0]);
+      return -1;
+    }
+  }
+  if (opts.table_path == NULL) {
+    print_usage(argv[0]);
+    return -1;
+  }
+  return read_table_changes(&opts);
+}
@@ -1,23 +1,88 @@
 #include "arrow.h"
+#include "bench.h"
 #include "kernel_utils.h"
 #include <stdio.h>
 #include <string.h>
 
 #ifdef PRINT_ARROW_DATA
 
-ArrowContext* init_arrow_context()
+// All the state needed to read a single file. Each file read gets its own `ReadTask`, so reads
+// running concurrently on the read pool never share any mutable state
+typedef struct ReadTask
+{
+  struct EngineContext* engine_context;
+  // the full path of the file. This points into the data of `paths`, which the task holds a
+  // reference to, so paths are never copied
+  KernelStringSlice path;
+  GArrowStringArray* paths;
+  int64_t size;
+  // our own copy of the deletion vector of the file, or NULL if it has none. The one in the scan
+  // file batch is freed with the batch, before the task runs
+  DvInfo* dv_info;
+  // with --compiled-transforms, the rows of the file the deletion vector keeps, loaded when the read
+  // starts. NULL if all rows are kept, or kernel drops the deleted rows. See `drop_deleted_rows`
+  GArrowBooleanArray* selection_vector;
+  // the number of rows read from the file so far, before dropping deleted rows
+  gint64 rows_read;
+  // evaluator for the transform of this file, or NULL if no transform is needed
+  SharedExpressionEvaluator* evaluator;
+  // with --compiled-transforms, the compiled transform of this file. Used instead of `evaluator`
+  BoundTransform* bound_transform;
+  gsize num_batches;
+  gint64 num_rows;
+  GList* batches;
+} ReadTask;
+
+static void read_task_worker(gpointer task, gpointer user_data);
+
+ArrowContext* init_arrow_context(int num_threads, bool compiled_transforms)
 {
   ArrowContext* context = malloc(sizeof(ArrowContext));
   context->num_batches = 0;
   context->batches = NULL;
-  context->cur_filter = NULL;
-  context->cur_transform = NULL;
+  context->read_pool = NULL;
+  context->pending_reads = NULL;
+  context->prepared_evaluators = g_array_new(FALSE, FALSE, sizeof(PreparedEvaluatorEntry));
+  context->compiled_transforms = compiled_transforms;
+  context->transform_plans = NULL;
+  context->physical_arrow_schema = NULL;
+  context->logical_arrow_schema = NULL;
+  context->num_rows = 0;
+  if (compiled_transforms) {
+    print_diag("Applying transforms with compiled plans\n");
+  }
+  if (num_threads > 1) {
+    GError* error = NULL;
+    context->read_pool = g_thread_pool_new(read_task_worker, NULL, num_threads, TRUE, &error);
+    if (context->read_pool == NULL) {
+      printf("Can't create read pool: %s\n", error->message);
+      g_error_free(error);
+      exit(-1);
+    }
+    context->pending_reads = g_ptr_array_new();
+    print_diag("Reading files with %i threads\n", num_threads);
+  }
   return context;
 }
 
 // unref all the data in the context
 void free_arrow_context(ArrowContext* context)
 {
+  finish_arrow_reads(context);
+  if (context->pending_reads != NULL) {
+    g_ptr_array_free(context->pending_reads, TRUE);
+  }
+  for (guint i = 0; i < context->prepared_evaluators->len; i++) {
+    PreparedEvaluatorEntry* entry =
+      &g_array_index(context->prepared_evaluators, PreparedEvaluatorEntry, i);
+    free_prepared_expression_evaluator(entry->prepared);
+  }
+  g_array_free(context->prepared_evaluators, TRUE);
+  if (context->transform_plans != NULL) {
+    free_transform_plan_cache(context->transform_plans);
+  }
+  g_clear_object(&context->physical_arrow_schema);
+  g_clear_object(&context->logical_arrow_schema);
   g_list_free_full(g_steal_pointer(&context->batches), g_object_unref);
   free(context);
 }
@@ -51,83 +116,90 @@ static GArrowRecordBatch* get_record_batch(FFI_ArrowArray* array, GArrowSchema*
   return record_batch;
 }
 
-// append a batch to our context
-static void add_batch_to_context(
-  ArrowContext* context,
-  ArrowFFIData* arrow_data)
+// Turn ffi formatted arrow data into a GArrowRecordBatch. The data and schema are owned by the
+// result, but `arrow_data` itself must still be freed
+static GArrowRecordBatch* import_arrow_data(ArrowFFIData* arrow_data)
 {
   GArrowSchema* schema = get_schema(&arrow_data->schema);
   GArrowRecordBatch* record_batch = get_record_batch(&arrow_data->array, schema);
   g_object_unref(schema);
-  if (context->cur_filter != NULL) {
-    GArrowRecordBatch* unfiltered = record_batch;
-    record_batch = garrow_record_batch_filter(unfiltered, context->cur_filter, NULL, NULL);
-    // unref the old batch and filter since we don't need them anymore
-    g_object_unref(unfiltered);
-    g_object_unref(context->cur_filter);
-    context->cur_filter = NULL;
-  }
-  context->batches = g_list_append(context->batches, record_batch);
-  context->num_batches++;
-  print_diag(
-    "  Added batch to arrow context, have %i batches in context now\n", context->num_batches);
+  return record_batch;
 }
 
-// convert to a garrow boolean array. can't use garrow_boolean_array_builder_append_values as that
-// expects a gboolean*, which is actually an int* which is 4 bytes, but our slice is a C99 _Bool*
-// which is 1 byte
-static GArrowBooleanArray* slice_to_arrow_bool_array(const KernelBoolSlice slice)
+// add a batch to the task that read it. Batches are kept newest first, so this is O(1)
+static void add_batch_to_task(ReadTask* task, GArrowRecordBatch* record_batch)
 {
-  GArrowBooleanArrayBuilder* builder = garrow_boolean_array_builder_new();
-  GError* error = NULL;
-  for (uintptr_t i = 0; i < slice.len; i++) {
-    gboolean val = slice.ptr[i] ? TRUE : FALSE;
-    garrow_boolean_array_builder_append_value(builder, val, &error);
-    if (report_g_error("Can't append to boolean builder", error)) {
-      g_object_unref(builder);
-      break;
-    }
-  }
+  task->batches = g_list_prepend(task->batches, record_batch);
+  task->num_batches++;
+  task->num_rows += garrow_record_batch_get_n_rows(record_batch);
+  print_diag("  Added batch to read of %.*s, have %i batches for this file now\n",
+             (int)task->path.len,
+             task->path.ptr,
+             task->num_batches);
+}
 
-  if (error != NULL) {
-    return NULL;
+// Drop the rows of `raw` that the deletion vector of `task` deletes. Rows past the end of the
+// selection vector are kept. Consumes `raw`, and returns NULL on error
+static GArrowRecordBatch* drop_deleted_rows(ReadTask* task, GArrowRecordBatch* raw)
+{
+  gint64 num_rows = garrow_record_batch_get_n_rows(raw);
+  gint64 offset = task->rows_read;
+  task->rows_read += num_rows;
+  if (task->selection_vector == NULL) {
+    return raw;
   }
-
-  GArrowArray* ret = garrow_array_builder_finish((GArrowArrayBuilder*)builder, &error);
-  g_object_unref(builder);
-  if (ret == NULL) {
-    printf("Error in building boolean array");
-    if (error != NULL) {
-      printf(": %s\n", error->message);
-      g_error_free(error);
-    } else {
-      printf(".\n");
-    }
+  gint64 selection_len = garrow_array_get_length(GARROW_ARRAY(task->selection_vector));
+  if (offset >= selection_len) {
+    return raw;
+  }
+  gint64 selected_len = MIN(num_rows, selection_len - offset);
+  GArrowArray* filter =
+    garrow_array_slice(GARROW_ARRAY(task->selection_vector), offset, selected_len);
+  GError* error = NULL;
+  if (selected_len < num_rows) {
+    // the batch runs past the end of the selection vector, so keep the rest of it. The rest is
+    // all set bits, which we can fill in one go rather than appending them one by one
+    gint64 rest_len = num_rows - selected_len;
+    gsize rest_size = (gsize)(rest_len + 7) / 8;
+    guint8* all_set = g_malloc(rest_size);
+    memset(all_set, 0xff, rest_size);
+    GBytes* bytes = g_bytes_new_take(all_set, rest_size);
+    GArrowBuffer* data = garrow_buffer_new_bytes(bytes);
+    g_bytes_unref(bytes);
+    GArrowBooleanArray* rest = garrow_boolean_array_new(rest_len, data, NULL, 0);
+    g_object_unref(data);
+    GList* others = g_list_append(NULL, rest);
+    GArrowArray* padded = garrow_array_concatenate(filter, others, &error);
+    g_list_free_full(others, g_object_unref);
+    g_object_unref(filter);
+    filter = padded;
+  }
+  GArrowRecordBatch* filtered = NULL;
+  if (!report_g_error("Can't build filter of deleted rows", error)) {
+    filtered = garrow_record_batch_filter(raw, GARROW_BOOLEAN_ARRAY(filter), NULL, &error);
+    report_g_error("Can't drop deleted rows", error);
   }
-  return (GArrowBooleanArray*)ret;
+  g_clear_object(&filter);
+  g_object_unref(raw);
+  return filtered;
 }
 
-// This will apply the transform in the context to the specified data. This consumes the passed
+// This will apply the transform of the task to the specified data. This consumes the passed
 // ExclusiveEngineData and return a new transformed one
-static ExclusiveEngineData* apply_transform(
-  struct EngineContext* context,
-  ExclusiveEngineData* data) {
-  if (!context->arrow_context->cur_transform) {
+static ExclusiveEngineData* apply_transform(ReadTask* task, ExclusiveEngineData* data)
+{
+  if (!task->evaluator) {
     print_diag("  No transform needed");
     return data;
   }
   print_diag("  Applying transform\n");
-  SharedExpressionEvaluator* evaluator = new_expression_evaluator(
-    context->engine,
-    context->physical_schema, // input schema
-    context->arrow_context->cur_transform,
-    context->logical_schema); // output schema
+  BENCH_START(transform_timer, PhaseTransform);
   ExternResultHandleExclusiveEngineData transformed_res = evaluate_expression(
-    context->engine,
+    task->engine_context->engine,
     &data,
-    evaluator);
+    task->evaluator);
+  BENCH_STOP(transform_timer);
   free_engine_data(data);
-  free_expression_evaluator(evaluator);
   if (transformed_res.tag != OkHandleExclusiveEngineData) {
     print_error("Failed to transform read data.", (Error*)transformed_res.err);
     free_error((Error*)transformed_res.err);
@@ -137,59 +209,174 @@ static ExclusiveEngineData* apply_transform(
 }
 
 // This is the callback that will be called for each chunk of data read from the parquet file
-static void visit_read_data(void* vcontext, ExclusiveEngineData* data)
+static void visit_read_data(void* vtask, ExclusiveEngineData* data)
 {
   print_diag("  Converting read data to arrow\n");
-  struct EngineContext* context = vcontext;
-  ExclusiveEngineData* transformed = apply_transform(context, data);
+  ReadTask* task = vtask;
+  ExclusiveEngineData* transformed = apply_transform(task, data);
   if (!transformed) {
     exit(-1);
   }
-  ExternResultArrowFFIData arrow_res = get_raw_arrow_data(transformed, context->engine);
+  BENCH_START(export_timer, PhaseExport);
+  ExternResultArrowFFIData arrow_res =
+    get_raw_arrow_data(transformed, task->engine_context->engine);
   if (arrow_res.tag != OkArrowFFIData) {
     print_error("Failed to get arrow data.", (Error*)arrow_res.err);
     free_error((Error*)arrow_res.err);
     exit(-1);
   }
   ArrowFFIData* arrow_data = arrow_res.ok;
-  add_batch_to_context(context->arrow_context, arrow_data);
-  free(arrow_data); // just frees the struct, the data and schema are freed/owned by add_batch_to_context
+  GArrowRecordBatch* record_batch = import_arrow_data(arrow_data);
+  free(arrow_data); // just frees the struct, the data and schema are now owned by the batch
+  BENCH_STOP(export_timer);
+  if (record_batch == NULL) {
+    exit(-1);
+  }
+  record_batch = drop_deleted_rows(task, record_batch);
+  if (record_batch == NULL) {
+    exit(-1);
+  }
+  add_batch_to_task(task, record_batch);
 }
 
-// We call this for each file we get called back to read in read_table.c::visit_callback
-void c_read_parquet_file(
-  struct EngineContext* context,
-  const KernelStringSlice path,
-  const KernelBoolSlice selection_vector,
-  const Expression* transform)
+// The callback for chunks of data read by tasks with a compiled transform. Unlike kernel's
+// evaluator, the compiled transform works on arrow data, so we export the data first
+static void visit_read_data_compiled(void* vtask, ExclusiveEngineData* data)
+{
+  print_diag("  Converting read data to arrow\n");
+  ReadTask* task = vtask;
+  BENCH_START(export_timer, PhaseExport);
+  ExternResultArrowFFIData arrow_res = get_raw_arrow_data(data, task->engine_context->engine);
+  if (arrow_res.tag != OkArrowFFIData) {
+    print_error("Failed to get arrow data.", (Error*)arrow_res.err);
+    free_error((Error*)arrow_res.err);
+    exit(-1);
+  }
+  ArrowFFIData* arrow_data = arrow_res.ok;
+  GArrowRecordBatch* raw = import_arrow_data(arrow_data);
+  free(arrow_data); // just frees the struct, the data and schema are now owned by `raw`
+  BENCH_STOP(export_timer);
+  if (raw == NULL) {
+    exit(-1);
+  }
+  raw = drop_deleted_rows(task, raw);
+  if (raw == NULL) {
+    exit(-1);
+  }
+  print_diag("  Applying compiled transform\n");
+  BENCH_START(transform_timer, PhaseTransform);
+  GError* error = NULL;
+  GArrowRecordBatch* transformed = apply_bound_transform(task->bound_transform, raw, &error);
+  BENCH_STOP(transform_timer);
+  g_object_unref(raw);
+  if (report_g_error("Can't apply compiled transform", error)) {
+    exit(-1);
+  }
+  add_batch_to_task(task, transformed);
+}
+
+// Load the deletion vector of a task as an arrow boolean array, which we import without copying.
+// Returns false on error
+static bool load_selection_vector(ReadTask* task)
+{
+  struct EngineContext* context = task->engine_context;
+  KernelStringSlice table_root_slice = { context->table_root, strlen(context->table_root) };
+  BENCH_START(dv_timer, PhaseDvMaterialize);
+  ExternResultArrowFFIData selection_res =
+    selection_vector_from_dv_as_arrow(task->dv_info, context->engine, table_root_slice);
+  BENCH_STOP(dv_timer);
+  if (selection_res.tag != OkArrowFFIData) {
+    print_error("Failed to get selection vector as arrow.", (Error*)selection_res.err);
+    free_error((Error*)selection_res.err);
+    return false;
+  }
+  ArrowFFIData* selection_data = selection_res.ok;
+  GError* error = NULL;
+  GArrowDataType* type = garrow_data_type_import((gpointer)&selection_data->schema, &error);
+  GArrowArray* selection_vector = NULL;
+  if (!report_g_error("Can't get selection vector type", error)) {
+    selection_vector = garrow_array_import((gpointer)&selection_data->array, type, &error);
+    g_object_unref(type);
+    report_g_error("Can't get selection vector", error);
+  }
+  free(selection_data); // just frees the struct, the data is now owned by `selection_vector`
+  if (selection_vector == NULL) {
+    return false;
+  }
+  if (garrow_array_get_length(selection_vector) == 0) {
+    // an empty selection vector keeps all rows
+    g_object_unref(selection_vector);
+  } else {
+    task->selection_vector = GARROW_BOOLEAN_ARRAY(selection_vector);
+  }
+  return true;
+}
+
+// Start reading the file of a task, dropping the rows deleted by its deletion vector. This runs on
+// the thread that reads the task, so loading the deletion vector doesn't hold up the thread
+// iterating the scan metadata. Returns NULL if the read couldn't be started.
+static ExclusiveFileReadResultIterator* start_read(ReadTask* task)
 {
-  int full_len = strlen(context->table_root) + path.len + 1;
-  char* full_path = malloc(sizeof(char) * full_len);
-  snprintf(full_path, full_len, "%s%.*s", context->table_root, (int)path.len, path.ptr);
-  print_diag("  Reading parquet file at %s\n", full_path);
-  KernelStringSlice path_slice = { full_path, full_len };
+  struct EngineContext* context = task->engine_context;
   FileMeta meta = {
-    .path = path_slice,
+    .path = task->path,
+    .size = task->size,
   };
-  ExternResultHandleExclusiveFileReadResultIterator read_res =
-    read_parquet_file(context->engine, &meta, context->physical_schema);
-  free(full_path);
+  // The predicate is written against the logical schema, so it can't prune row groups of columns
+  // that are renamed by column mapping, or are partition columns. Kernel ignores those columns.
+  ExternResultHandleExclusiveFileReadResultIterator read_res;
+  if (task->dv_info && context->arrow_context->compiled_transforms) {
+    // with compiled transforms we do the per-file work in arrow, so we drop deleted rows in arrow
+    // as well. The deletion vector refers to row positions, so no row groups may be skipped
+    print_diag("  Deleted rows of this file will be dropped with arrow\n");
+    if (!load_selection_vector(task)) {
+      return NULL;
+    }
+    BENCH_START(read_timer, PhaseReadParquet);
+    read_res = read_parquet_file(context->engine, &meta, context->physical_schema, NULL);
+    BENCH_STOP(read_timer);
+  } else if (task->dv_info) {
+    print_diag("  Deleted rows of this file will be dropped by kernel\n");
+    KernelStringSlice table_root_slice = { context->table_root, strlen(context->table_root) };
+    // kernel loads the deletion vector before starting the (lazy) read, so this is almost all DV
+    BENCH_START(dv_timer, PhaseDvMaterialize);
+    read_res = read_parquet_file_with_dv(
+      context->engine,
+      &meta,
+      context->physical_schema,
+      task->dv_info,
+      table_root_slice,
+      context->predicate);
+    BENCH_STOP(dv_timer);
+  } else {
+    print_diag("  No selection vector for this file\n");
+    BENCH_START(read_timer, PhaseReadParquet);
+    read_res =
+      read_parquet_file(context->engine, &meta, context->physical_schema, context->predicate);
+    BENCH_STOP(read_timer);
+  }
   if (read_res.tag != OkHandleExclusiveFileReadResultIterator) {
-    print_error("Couldn't read data.", (Error*) read_res.err);
+    print_error("Couldn't read data.", (Error*)read_res.err);
     free_error((Error*)read_res.err);
-    return;
+    return NULL;
   }
-  if (selection_vector.len > 0) {
-    GArrowBooleanArray* sel_array = slice_to_arrow_bool_array(selection_vector);
-    if (sel_array == NULL) {
-      printf("[WARN] Failed to get an arrow boolean array, selection vector will be ignored\n");
-    }
-    context->arrow_context->cur_filter = sel_array;
+  return read_res.ok;
+}
+
+// Read all the data for a task. This only touches the task itself and the (thread-safe) shared
+// handles in the engine context, so it is safe to call from any thread
+static void run_read_task(ReadTask* task)
+{
+  ExclusiveFileReadResultIterator* read_iter = start_read(task);
+  if (read_iter == NULL) {
+    return;
   }
-  context->arrow_context->cur_transform = transform;
-  ExclusiveFileReadResultIterator* read_iter = read_res.ok;
+  print_diag("  Reading parquet file at %.*s\n", (int)task->path.len, task->path.ptr);
   for (;;) {
-    ExternResultbool ok_res = read_result_next(read_iter, context, visit_read_data);
+    BENCH_START(read_timer, PhaseReadParquet);
+    ExternResultbool ok_res = read_result_next(
+      read_iter, task, task->bound_transform ? visit_read_data_compiled : visit_read_data);
+    BENCH_STOP(read_timer);
     if (ok_res.tag != Okbool) {
       print_error("Failed to iterate read data.", (Error*)ok_res.err);
       free_error((Error*)ok_res.err);
@@ -198,10 +385,304 @@ void c_read_parquet_file(
       print_diag("  Done reading parquet file\n");
       break;
     }
+    int64_t limit = task->engine_context->limit;
+    if (limit >= 0 && task->num_rows >= limit) {
+      // no file needs to contribute more rows than the limit
+      print_diag("  Read enough rows for the limit, not reading the rest of the file\n");
+      break;
+    }
   }
   free_read_result_iter(read_iter);
 }
 
+// Entry point for a read pool worker thread
+static void read_task_worker(gpointer task, gpointer user_data)
+{
+  (void)user_data;
+  run_read_task(task);
+}
+
+// Move the batches of a completed task into the context, and free the task. Like the task, the
+// context keeps its batches newest first, so this only walks the batches of the task
+static void finish_read_task(ArrowContext* context, ReadTask* task)
+{
+  context->batches = g_list_concat(g_steal_pointer(&task->batches), context->batches);
+  context->num_batches += task->num_batches;
+  context->num_rows += task->num_rows;
+  print_diag(
+    "  Added batches to arrow context, have %i batches in context now\n", context->num_batches);
+  if (task->evaluator) {
+    free_expression_evaluator(task->evaluator);
+  }
+  if (task->bound_transform) {
+    free_bound_transform(task->bound_transform);
+  }
+  if (task->dv_info) {
+    free_dv_info(task->dv_info);
+  }
+  g_clear_object(&task->selection_vector);
+  g_object_unref(task->paths);
+  free(task);
+}
+
+// Get the prepared evaluator for the given pair of schemas, preparing a new one if this is the first
+// time we see this pair. The pairs are compared by handle, not by content, which is all we need
+// since every file of a scan uses the scan's own schema handles. The returned evaluator is owned by
+// the context.
+static SharedPreparedExpressionEvaluator* get_prepared_evaluator(
+  ArrowContext* arrow_context,
+  SharedExternEngine* engine,
+  SharedSchema* input_schema,
+  SharedSchema* output_schema)
+{
+  GArray* cache = arrow_context->prepared_evaluators;
+  for (guint i = 0; i < cache->len; i++) {
+    PreparedEvaluatorEntry* entry = &g_array_index(cache, PreparedEvaluatorEntry, i);
+    if (entry->input_schema == input_schema && entry->output_schema == output_schema) {
+      return entry->prepared;
+    }
+  }
+  print_diag("  Preparing new expression evaluator\n");
+  PreparedEvaluatorEntry entry = {
+    .input_schema = input_schema,
+    .output_schema = output_schema,
+    .prepared = new_prepared_expression_evaluator(engine, input_schema, output_schema),
+  };
+  g_array_append_val(cache, entry);
+  return entry.prepared;
+}
+
+// Get a kernel schema as an arrow schema
+static GArrowSchema* get_arrow_schema(SharedExternEngine* engine, SharedSchema* schema)
+{
+  ExternResultFFIArrowSchema schema_res = schema_as_arrow(schema, engine);
+  if (schema_res.tag != OkFFIArrowSchema) {
+    print_error("Failed to get schema as arrow.", (Error*)schema_res.err);
+    free_error((Error*)schema_res.err);
+    exit(-1);
+  }
+  FFI_ArrowSchema* ffi_schema = schema_res.ok;
+  GArrowSchema* arrow_schema = get_schema(ffi_schema);
+  free(ffi_schema); // just frees the struct, the schema is now owned by `arrow_schema`
+  return arrow_schema;
+}
+
+// Bind the transform of a file, serialized in `view`, to a compiled plan, compiling a new plan if
+// none of the plans we have match its shape. Returns NULL if the transform can't be compiled, in
+// which case kernel must evaluate it. Like the prepared evaluators, the plans are owned by the
+// context.
+static BoundTransform* bind_compiled_transform(
+  struct EngineContext* context,
+  const ExpressionBytecodeView* view)
+{
+  ArrowContext* arrow_context = context->arrow_context;
+  if (arrow_context->transform_plans == NULL) {
+    arrow_context->physical_arrow_schema =
+      get_arrow_schema(context->engine, context->physical_schema);
+    arrow_context->logical_arrow_schema =
+      get_arrow_schema(context->engine, context->logical_schema);
+    arrow_context->transform_plans = new_transform_plan_cache(
+      arrow_context->physical_arrow_schema, arrow_context->logical_arrow_schema);
+  }
+  guint num_plans = transform_plan_cache_size(arrow_context->transform_plans);
+  BoundTransform* bound = bind_cached_transform(arrow_context->transform_plans, view);
+  if (bound == NULL) {
+    print_diag("  Can't compile transform, evaluating it with kernel\n");
+  } else if (transform_plan_cache_size(arrow_context->transform_plans) > num_plans) {
+    print_diag("  Compiled new transform plan\n");
+  }
+  return bound;
+}
+
+// Submit the read of a single file of a scan file batch
+static void submit_read(
+  struct EngineContext* context,
+  GArrowStringArray* paths,
+  KernelStringSlice path,
+  int64_t size,
+  const DvInfo* dv_info,
+  SharedExpression* transform,
+  const ExpressionBytecodeView* transform_view)
+{
+  ArrowContext* arrow_context = context->arrow_context;
+  // reads on the pool may still be running, so we only know how many rows we have without one
+  if (arrow_context->read_pool == NULL && context->limit >= 0 &&
+      arrow_context->num_rows >= context->limit) {
+    print_diag("  Have enough rows for the limit, skipping %.*s\n", (int)path.len, path.ptr);
+    return;
+  }
+  ReadTask* task = malloc(sizeof(ReadTask));
+  task->engine_context = context;
+  task->path = path;
+  task->paths = g_object_ref(paths);
+  task->size = size;
+  task->dv_info = dv_info ? copy_dv_info(dv_info) : NULL;
+  task->selection_vector = NULL;
+  task->rows_read = 0;
+  task->num_batches = 0;
+  task->num_rows = 0;
+  task->batches = NULL;
+  // The evaluator shares the transform with kernel rather than copying it, so the caller may free
+  // `transform` once this returns. The evaluator is a shared handle the task owns, and can be used
+  // from any thread.
+  task->evaluator = NULL;
+  task->bound_transform = NULL;
+  if (transform_view) {
+    task->bound_transform = bind_compiled_transform(context, transform_view);
+  }
+  if (transform && !task->bound_transform) {
+    SharedPreparedExpressionEvaluator* prepared = get_prepared_evaluator(
+      arrow_context,
+      context->engine,
+      context->physical_schema, // input schema
+      context->logical_schema); // output schema
+    task->evaluator = bind_prepared_expression_evaluator_shared(prepared, &transform);
+  }
+
+  if (arrow_context->read_pool == NULL) {
+    run_read_task(task);
+    finish_read_task(arrow_context, task);
+    return;
+  }
+  g_ptr_array_add(arrow_context->pending_reads, task);
+  GError* error = NULL;
+  if (!g_thread_pool_push(arrow_context->read_pool, task, &error)) {
+    printf("Can't submit read of %.*s: %s\n", (int)path.len, path.ptr, error->message);
+    g_error_free(error);
+    exit(-1);
+  }
+}
+
+// Print the (already typed) partition values of the files in `batch` if `VERBOSE` is defined in
+// read_table.h. Kernel gives us one arrow column per partition column, so there's no need to look
+// up and parse the values of each file one at a time.
+static void print_partition_values(struct EngineContext* context, SharedScanFileBatch* batch)
+{
+#ifdef VERBOSE
+  if (context->partition_cols->len == 0) {
+    return;
+  }
+  ExternResultArrowFFIData values_res =
+    scan_file_batch_partition_values_as_arrow(batch, context->engine);
+  if (values_res.tag != OkArrowFFIData) {
+    print_error("Failed to get partition values as arrow.", (Error*)values_res.err);
+    free_error((Error*)values_res.err);
+    return;
+  }
+  ArrowFFIData* values_data = values_res.ok;
+  GArrowSchema* schema = get_schema(&values_data->schema);
+  GArrowRecordBatch* values = get_record_batch(&values_data->array, schema);
+  g_object_unref(schema);
+  free(values_data);
+  if (values == NULL) {
+    return;
+  }
+  GError* error = NULL;
+  gchar* values_str = garrow_record_batch_to_string(values, &error);
+  if (report_g_error("Can't print partition values", error)) {
+    g_object_unref(values);
+    return;
+  }
+  print_diag("Partition values of scan file batch:\n%s\n", values_str);
+  g_free(values_str);
+  g_object_unref(values);
+#else
+  (void)context;
+  (void)batch;
+#endif
+}
+
+// We call this for each scan file batch in read_table.c::do_visit_scan_metadata. All the file
+// information comes to us as one arrow record batch, so we don't need a callback per file.
+void c_read_scan_file_batch(struct EngineContext* context, SharedScanFileBatch* batch)
+{
+  print_partition_values(context, batch);
+  ExternResultArrowFFIData files_res = scan_file_batch_as_arrow(batch, context->engine);
+  if (files_res.tag != OkArrowFFIData) {
+    print_error("Failed to get scan files as arrow.", (Error*)files_res.err);
+    free_error((Error*)files_res.err);
+    exit(-1);
+  }
+  ArrowFFIData* files_data = files_res.ok;
+  GArrowSchema* schema = get_schema(&files_data->schema);
+  GArrowRecordBatch* files = get_record_batch(&files_data->array, schema);
+  g_object_unref(schema);
+  free(files_data); // just frees the struct, the data and schema are now owned by `files`
+  if (files == NULL) {
+    exit(-1);
+  }
+  // see `ScanFileBatch` in the kernel docs for the columns of the batch
+  GArrowStringArray* paths = GARROW_STRING_ARRAY(garrow_record_batch_get_column_data(files, 0));
+  GArrowInt64Array* sizes = GARROW_INT64_ARRAY(garrow_record_batch_get_column_data(files, 1));
+  GArrowArray* dv_indexes = garrow_record_batch_get_column_data(files, 3);
+  GArrowArray* transform_ids = garrow_record_batch_get_column_data(files, 4);
+  gint64 num_files = garrow_record_batch_get_n_rows(files);
+  print_diag("Reading %" G_GINT64_FORMAT " files from scan file batch\n", num_files);
+  // with --compiled-transforms, the serialized transforms of the batch by transform id. Files with
+  // equal transforms share an id, so each distinct transform is only serialized once
+  GHashTable* transform_bytecodes = NULL;
+  if (context->arrow_context->compiled_transforms) {
+    transform_bytecodes =
+      g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify)free_expression_bytecode);
+  }
+  for (gint64 i = 0; i < num_files; i++) {
+    // the bytes point into the array data, which stays alive as long as `paths` does
+    GBytes* path_bytes = garrow_binary_array_get_value(GARROW_BINARY_ARRAY(paths), i);
+    gsize path_len;
+    const char* path_ptr = g_bytes_get_data(path_bytes, &path_len);
+    KernelStringSlice path = { path_ptr, path_len };
+    g_bytes_unref(path_bytes);
+    const DvInfo* dv_info = NULL;
+    if (!garrow_array_is_null(dv_indexes, i)) {
+      guint32 dv_index = garrow_uint32_array_get_value(GARROW_UINT32_ARRAY(dv_indexes), i);
+      dv_info = scan_file_batch_dv_info(batch, dv_index);
+    }
+    SharedExpression* transform = NULL;
+    ExpressionBytecodeView view;
+    const ExpressionBytecodeView* transform_view = NULL;
+    if (!garrow_array_is_null(transform_ids, i)) {
+      guint32 transform_id = garrow_uint32_array_get_value(GARROW_UINT32_ARRAY(transform_ids), i);
+      transform = scan_file_batch_transform_handle(batch, transform_id);
+      if (transform_bytecodes) {
+        SharedExpressionBytecode* bytecode =
+          g_hash_table_lookup(transform_bytecodes, GUINT_TO_POINTER(transform_id));
+        if (bytecode == NULL) {
+          bytecode = serialize_expression(&transform);
+          g_hash_table_insert(transform_bytecodes, GUINT_TO_POINTER(transform_id), bytecode);
+        }
+        view = get_expression_bytecode(&bytecode);
+        transform_view = &view;
+      }
+    }
+    gint64 size = garrow_int64_array_get_value(sizes, i);
+    submit_read(context, paths, path, size, dv_info, transform, transform_view);
+    if (transform) {
+      free_kernel_expression(transform);
+    }
+  }
+  if (transform_bytecodes) {
+    g_hash_table_destroy(transform_bytecodes);
+  }
+  g_object_unref(transform_ids);
+  g_object_unref(dv_indexes);
+  g_object_unref(sizes);
+  g_object_unref(paths);
+  g_object_unref(files);
+}
+
+void finish_arrow_reads(ArrowContext* context)
+{
+  if (context->read_pool == NULL) {
+    return;
+  }
+  // wait for all queued reads to complete
+  g_thread_pool_free(g_steal_pointer(&context->read_pool), FALSE, TRUE);
+  for (guint i = 0; i < context->pending_reads->len; i++) {
+    finish_read_task(context, g_ptr_array_index(context->pending_reads, i));
+  }
+  g_ptr_array_set_size(context->pending_reads, 0);
+}
+
 struct extract_col_data {
   GList* list;
   guint col_idx;
@@ -209,13 +690,15 @@ struct extract_col_data {
 
 void extract_col(GArrowRecordBatch* element, struct extract_col_data* data) {
   GArrowArray* array_data = garrow_record_batch_get_column_data(element, data->col_idx);
-  data->list = g_list_append(data->list, array_data);
+  data->list = g_list_prepend(data->list, array_data);
 }
 
 // Print the whole set of data. We iterate over each column, and concat each batch's data for that
 // column together, then print the result.
-void print_arrow_context(ArrowContext* context)
+void print_arrow_context(ArrowContext* context, gint64 limit)
 {
+  // batches were added newest first, put them back in scan order
+  context->batches = g_list_reverse(context->batches);
   if (context->num_batches > 0) {
     GError* error = NULL;
     guint cols = garrow_record_batch_get_n_columns(context->batches->data);
@@ -232,6 +715,7 @@ void print_arrow_context(ArrowContext* context)
           .col_idx = c,
         };
         g_list_foreach(remaining, (GFunc)extract_col, &remaining_data);
+        remaining_data.list = g_list_reverse(remaining_data.list);
         GArrowArray* prev_data = data;
         data = garrow_array_concatenate(data, remaining_data.list, &error);
         g_object_unref(prev_data);
@@ -241,6 +725,11 @@ void print_arrow_context(ArrowContext* context)
           return;
         }
       }
+      if (limit >= 0 && garrow_array_get_length(data) > limit) {
+        GArrowArray* prev_data = data;
+        data = garrow_array_slice(data, 0, limit);
+        g_object_unref(prev_data);
+      }
       gchar* array_out = garrow_array_to_string(data, &error);
       if (report_g_error("Can't get array as string", error)) {
         g_object_unref(data);
@@ -255,4 +744,124 @@ void print_arrow_context(ArrowContext* context)
   }
 }
 
+// Where `stream_arrow_scan` writes the batches it reads
+typedef struct StreamSink
+{
+  // NULL if we print batches to stdout
+  GArrowOutputStream* output;
+  GArrowRecordBatchWriter* writer;
+} StreamSink;
+
+static bool open_stream_sink(StreamSink* sink, const char* ipc_path, GArrowSchema* schema)
+{
+  sink->output = NULL;
+  sink->writer = NULL;
+  if (ipc_path == NULL) {
+    return true;
+  }
+  GError* error = NULL;
+  GArrowFileOutputStream* file = garrow_file_output_stream_new(ipc_path, FALSE, &error);
+  if (report_g_error("Can't open IPC output", error)) {
+    return false;
+  }
+  sink->output = GARROW_OUTPUT_STREAM(file);
+  GArrowRecordBatchStreamWriter* writer =
+    garrow_record_batch_stream_writer_new(sink->output, schema, &error);
+  if (report_g_error("Can't create IPC writer", error)) {
+    g_object_unref(sink->output);
+    return false;
+  }
+  sink->writer = GARROW_RECORD_BATCH_WRITER(writer);
+  return true;
+}
+
+static bool write_to_stream_sink(StreamSink* sink, GArrowRecordBatch* batch)
+{
+  GError* error = NULL;
+  if (sink->writer != NULL) {
+    garrow_record_batch_writer_write_record_batch(sink->writer, batch, &error);
+    return !report_g_error("Can't write batch to IPC output", error);
+  }
+  gchar* batch_str = garrow_record_batch_to_string(batch, &error);
+  if (report_g_error("Can't get batch as string", error)) {
+    return false;
+  }
+  printf("%s\n", batch_str);
+  g_free(batch_str);
+  return true;
+}
+
+static void close_stream_sink(StreamSink* sink)
+{
+  if (sink->writer == NULL) {
+    return;
+  }
+  GError* error = NULL;
+  garrow_record_batch_writer_close(sink->writer, &error);
+  report_g_error("Can't close IPC writer", error);
+  g_object_unref(sink->writer);
+  error = NULL;
+  garrow_file_close(GARROW_FILE(sink->output), &error);
+  report_g_error("Can't close IPC output", error);
+  g_object_unref(sink->output);
+}
+
+bool stream_arrow_scan(struct EngineContext* context, const char* ipc_path)
+{
+  ExternResultFFIArrowArrayStream stream_res = scan_into_arrow_stream(context->scan, context->engine);
+  if (stream_res.tag != OkFFIArrowArrayStream) {
+    print_error("Failed to get scan as an arrow stream.", (Error*)stream_res.err);
+    free_error((Error*)stream_res.err);
+    return false;
+  }
+  FFI_ArrowArrayStream* stream = stream_res.ok;
+  GError* error = NULL;
+  GArrowRecordBatchReader* reader = garrow_record_batch_reader_import(stream, &error);
+  free(stream); // just frees the struct, the stream itself is now owned by `reader`
+  if (report_g_error("Can't import arrow stream", error)) {
+    return false;
+  }
+  GArrowSchema* schema = garrow_record_batch_reader_get_schema(reader);
+  StreamSink sink;
+  bool ok = open_stream_sink(&sink, ipc_path, schema);
+  g_object_unref(schema);
+  gsize num_batches = 0;
+  gint64 remaining = context->limit;
+  while (ok && remaining != 0) {
+    // kernel only reads the next batch when we ask for it, and we drop each batch once it has been
+    // written, so we never hold more than one batch in memory
+    // kernel reads, filters and transforms the data inside this call, so it's all charged to
+    // reading parquet
+    BENCH_START(read_timer, PhaseReadParquet);
+    GArrowRecordBatch* batch = garrow_record_batch_reader_read_next(reader, &error);
+    BENCH_STOP(read_timer);
+    if (report_g_error("Failed to read batch from arrow stream", error)) {
+      ok = false;
+    } else if (batch == NULL) {
+      break;
+    } else {
+      gint64 num_rows = garrow_record_batch_get_n_rows(batch);
+      if (remaining >= 0 && num_rows > remaining) {
+        GArrowRecordBatch* full_batch = batch;
+        batch = garrow_record_batch_slice(full_batch, 0, remaining);
+        g_object_unref(full_batch);
+        num_rows = remaining;
+      }
+      if (remaining > 0) {
+        remaining -= num_rows;
+      }
+      ok = write_to_stream_sink(&sink, batch);
+      g_object_unref(batch);
+      num_batches++;
+    }
+  }
+  if (ok && num_batches == 0 && ipc_path == NULL) {
+    printf("[No data]\n");
+  }
+  print_diag("Streamed %" G_GSIZE_FORMAT " batches\n", num_batches);
+  close_stream_sink(&sink);
+  g_object_unref(reader);
+  return ok;
+}
+
 #endif // PRINT_ARROW_DATA
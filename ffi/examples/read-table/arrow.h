@@ -6,25 +6,64 @@
 
 #include "delta_kernel_ffi.h"
 #include "read_table.h"
+#include "transform_plan.h"
 
 #include <glib.h>
 #include <arrow-glib/arrow-glib.h>
 
+// A prepared evaluator for a given pair of input and output schemas. See `get_prepared_evaluator`
+typedef struct PreparedEvaluatorEntry
+{
+  SharedSchema* input_schema;
+  SharedSchema* output_schema;
+  SharedPreparedExpressionEvaluator* prepared;
+} PreparedEvaluatorEntry;
+
 typedef struct ArrowContext
 {
   gsize num_batches;
+  // batches read so far, newest first
   GList* batches;
-  GArrowBooleanArray* cur_filter;
-  const Expression* cur_transform;
+  // pool of workers that read files concurrently. NULL if we read files on the calling thread
+  GThreadPool* read_pool;
+  // every file read submitted to `read_pool`, in submission order. We use this to add batches to
+  // the context in scan order, regardless of the order the reads complete in
+  GPtrArray* pending_reads;
+  // prepared evaluators, one per (input schema, output schema) pair we have seen. Per-file
+  // transforms are bound to these, sharing the transform instead of copying it
+  GArray* prepared_evaluators;
+  // if true, transforms are applied with plans compiled by `transform_plan.h`, and only fall back to
+  // kernel's evaluator for transforms that can't be compiled
+  bool compiled_transforms;
+  // compiled plans, one per transform shape we have seen. Created with the first plan, so NULL
+  // unless `compiled_transforms`
+  TransformPlanCache* transform_plans;
+  // the physical and logical schemas of the scan, which plans are compiled against. Created with
+  // the first plan
+  GArrowSchema* physical_arrow_schema;
+  GArrowSchema* logical_arrow_schema;
+  // the number of rows in `batches`
+  gint64 num_rows;
 } ArrowContext;
 
-ArrowContext* init_arrow_context(void);
-void c_read_parquet_file(
-  struct EngineContext* context,
-  const KernelStringSlice path,
-  const KernelBoolSlice selection_vector,
-  const Expression* transform);
-void print_arrow_context(ArrowContext* context);
+// Create a new arrow context. If `num_threads` is greater than one, files passed to
+// `c_read_scan_file_batch` are read on a pool of that many worker threads. If `compiled_transforms`
+// is true, transforms are compiled to arrow-glib calls instead of being evaluated by kernel
+ArrowContext* init_arrow_context(int num_threads, bool compiled_transforms);
+// Read all the files of `batch`, applying their deletion vectors and transforms. If the context has
+// a read pool the reads happen in the background, and `finish_arrow_reads` must be called to wait
+// for them. Reads stop early once they have the rows needed for the limit of `context`. The batch
+// can be freed as soon as this returns
+void c_read_scan_file_batch(struct EngineContext* context, SharedScanFileBatch* batch);
+// Wait for all in-flight reads to finish and add their batches to the context in scan order
+void finish_arrow_reads(ArrowContext* context);
+// Print all the data of the context, up to `limit` rows if `limit` isn't negative
+void print_arrow_context(ArrowContext* context, gint64 limit);
 void free_arrow_context(ArrowContext* context);
+// Read the whole scan of `context` through kernel's arrow stream, writing out each batch as soon as
+// it arrives rather than collecting them in an arrow context. Batches are printed to stdout, or
+// written as an arrow IPC stream to `ipc_path` if it isn't NULL. The stream is dropped once the
+// limit of `context` has been written. Returns false if the scan failed
+bool stream_arrow_scan(struct EngineContext* context, const char* ipc_path);
 
 #endif // PRINT_ARROW_DATA
@@ -0,0 +1,145 @@
+#include "bench.h"
+
+#ifdef BENCHMARK
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char* PHASE_NAMES[NumBenchPhases] = {
+  "engine_build",   "snapshot",     "scan",      "scan_metadata_next",
+  "dv_materialize", "read_parquet", "transform", "export",
+};
+
+// Totals for a phase. Reads run on the worker pool, so these are updated from many threads
+typedef struct PhaseTotals
+{
+  atomic_int_fast64_t calls;
+  atomic_int_fast64_t wall_ns;
+  atomic_int_fast64_t cpu_ns;
+} PhaseTotals;
+
+typedef struct PhaseResult
+{
+  int64_t calls;
+  int64_t wall_ns;
+  int64_t cpu_ns;
+} PhaseResult;
+
+typedef struct RunResult
+{
+  int64_t wall_ns;
+  int64_t cpu_ns;
+  PhaseResult phases[NumBenchPhases];
+} RunResult;
+
+static PhaseTotals totals[NumBenchPhases];
+static int64_t run_wall_start_ns;
+static int64_t run_cpu_start_ns;
+static RunResult* runs = NULL;
+static int num_runs = 0;
+
+// the innermost running timer of each thread, so nested timers can charge their time to it
+static _Thread_local BenchTimer* current_timer = NULL;
+
+static int64_t now_ns(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void bench_start(BenchTimer* timer, BenchPhase phase)
+{
+  timer->phase = phase;
+  timer->child_wall_ns = 0;
+  timer->child_cpu_ns = 0;
+  timer->parent = current_timer;
+  current_timer = timer;
+  timer->cpu_start_ns = now_ns(CLOCK_THREAD_CPUTIME_ID);
+  timer->wall_start_ns = now_ns(CLOCK_MONOTONIC);
+}
+
+void bench_stop(BenchTimer* timer)
+{
+  int64_t wall_ns = now_ns(CLOCK_MONOTONIC) - timer->wall_start_ns;
+  int64_t cpu_ns = now_ns(CLOCK_THREAD_CPUTIME_ID) - timer->cpu_start_ns;
+  current_timer = timer->parent;
+  if (timer->parent) {
+    timer->parent->child_wall_ns += wall_ns;
+    timer->parent->child_cpu_ns += cpu_ns;
+  }
+  PhaseTotals* phase = &totals[timer->phase];
+  atomic_fetch_add(&phase->calls, 1);
+  atomic_fetch_add(&phase->wall_ns, wall_ns - timer->child_wall_ns);
+  atomic_fetch_add(&phase->cpu_ns, cpu_ns - timer->child_cpu_ns);
+}
+
+void bench_begin_run(void)
+{
+  for (int i = 0; i < NumBenchPhases; i++) {
+    atomic_store(&totals[i].calls, 0);
+    atomic_store(&totals[i].wall_ns, 0);
+    atomic_store(&totals[i].cpu_ns, 0);
+  }
+  run_cpu_start_ns = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+  run_wall_start_ns = now_ns(CLOCK_MONOTONIC);
+}
+
+void bench_end_run(void)
+{
+  runs = realloc(runs, sizeof(RunResult) * (num_runs + 1));
+  RunResult* run = &runs[num_runs++];
+  run->wall_ns = now_ns(CLOCK_MONOTONIC) - run_wall_start_ns;
+  // process cpu time includes kernel's own (e.g. tokio) threads, which per-phase times can't see
+  run->cpu_ns = now_ns(CLOCK_PROCESS_CPUTIME_ID) - run_cpu_start_ns;
+  for (int i = 0; i < NumBenchPhases; i++) {
+    run->phases[i].calls = atomic_load(&totals[i].calls);
+    run->phases[i].wall_ns = atomic_load(&totals[i].wall_ns);
+    run->phases[i].cpu_ns = atomic_load(&totals[i].cpu_ns);
+  }
+}
+
+static double ns_to_ms(int64_t ns)
+{
+  return (double)ns / 1e6;
+}
+
+void bench_write_json(FILE* out, const char* table_path)
+{
+  // table paths are urls or file system paths, so we only need to escape quotes and backslashes
+  fprintf(out, "{\n  \"table\": \"");
+  for (const char* c = table_path; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', out);
+    }
+    fputc(*c, out);
+  }
+  fprintf(out, "\",\n  \"runs\": [");
+  for (int r = 0; r < num_runs; r++) {
+    RunResult* run = &runs[r];
+    fprintf(out, "%s\n    {\n", r ? "," : "");
+    fprintf(out, "      \"wall_ms\": %.3f,\n", ns_to_ms(run->wall_ns));
+    fprintf(out, "      \"cpu_ms\": %.3f,\n", ns_to_ms(run->cpu_ns));
+    fprintf(out, "      \"phases\": {");
+    for (int i = 0; i < NumBenchPhases; i++) {
+      PhaseResult* phase = &run->phases[i];
+      fprintf(out,
+              "%s\n        \"%s\": { \"calls\": %" PRId64
+              ", \"wall_ms\": %.3f, \"cpu_ms\": %.3f }",
+              i ? "," : "",
+              PHASE_NAMES[i],
+              phase->calls,
+              ns_to_ms(phase->wall_ns),
+              ns_to_ms(phase->cpu_ns));
+    }
+    fprintf(out, "\n      }\n    }");
+  }
+  fprintf(out, "\n  ]\n}\n");
+  free(runs);
+  runs = NULL;
+  num_runs = 0;
+}
+
+#endif // BENCHMARK
@@ -0,0 +1,59 @@
+// Per-phase timing for the `bench_read_table` target. When `BENCHMARK` isn't defined the timing
+// macros compile to nothing, so `read_table` itself pays no cost for them.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// The phases of reading a table we time. Phases can nest (e.g. a transform runs inside the
+// `read_result_next` call that produced the data), so each phase is only charged for the time not
+// spent in a nested phase. That way the phases of a run add up to its total.
+typedef enum BenchPhase
+{
+  PhaseEngineBuild,
+  PhaseSnapshot,
+  PhaseScan,
+  PhaseScanMetadata,
+  PhaseDvMaterialize,
+  PhaseReadParquet,
+  PhaseTransform,
+  PhaseExport,
+  NumBenchPhases,
+} BenchPhase;
+
+// A running timer for one phase. Lives on the stack of the code being timed
+typedef struct BenchTimer
+{
+  BenchPhase phase;
+  int64_t wall_start_ns;
+  int64_t cpu_start_ns;
+  // time spent in phases nested inside this one
+  int64_t child_wall_ns;
+  int64_t child_cpu_ns;
+  struct BenchTimer* parent;
+} BenchTimer;
+
+#ifdef BENCHMARK
+
+// Start timing `phase` on the calling thread
+void bench_start(BenchTimer* timer, BenchPhase phase);
+// Stop a timer started by `bench_start`, and add its time to the totals of its phase
+void bench_stop(BenchTimer* timer);
+// Start a new run, resetting the totals of all phases
+void bench_begin_run(void);
+// End the current run and save its results
+void bench_end_run(void);
+// Write the results of all runs so far as JSON
+void bench_write_json(FILE* out, const char* table_path);
+
+#define BENCH_START(timer, phase)                                                                  \
+  BenchTimer timer;                                                                                \
+  bench_start(&timer, phase)
+#define BENCH_STOP(timer) bench_stop(&timer)
+
+#else
+
+#define BENCH_START(timer, phase)
+#define BENCH_STOP(timer)
+
+#endif
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "delta_kernel_ffi.h"
+#include "kernel_utils.h"
+#include "schema.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+
+/**
+ * This module parses the very simple predicate language accepted by `read_table --where`, and
+ * turns it into an `EnginePredicate` kernel can use for data skipping. A predicate is one or more
+ * terms joined by `AND`, where each term is `column op literal`:
+ *
+ *   --where "id > 10 AND name = 'foo'"
+ *
+ * `op` is one of `<`, `<=`, `>`, `>=`, `=`, `!=`. Column names may be nested (`a.b`), and string
+ * literals may be single or double quoted. Kernel's data skipping only compares values of the same
+ * type, so we look up the type of each column in the table schema, and parse the literal as that
+ * type.
+ */
+
+typedef enum CompareOp
+{
+  CompareLt,
+  CompareLe,
+  CompareGt,
+  CompareGe,
+  CompareEq,
+  CompareNe,
+} CompareOp;
+
+typedef struct PredicateTerm
+{
+  char* column;
+  CompareOp op;
+  // the literal as written (minus any quotes)
+  char* literal;
+  // type of the column, as named by the schema visitor. Always a static string
+  const char* type;
+  // the literal parsed as `type`, for non-string types
+  union
+  {
+    int64_t int_value;
+    double float_value;
+    bool bool_value;
+  } value;
+} PredicateTerm;
+
+typedef struct WherePredicate
+{
+  int num_terms;
+  PredicateTerm* terms;
+} WherePredicate;
+
+// copy `len` bytes from `start`, without any leading or trailing whitespace
+static char* trim_copy(const char* start, size_t len)
+{
+  while (len > 0 && isspace((unsigned char)*start)) {
+    start++;
+    len--;
+  }
+  while (len > 0 && isspace((unsigned char)start[len - 1])) {
+    len--;
+  }
+  char* copy = malloc(len + 1);
+  memcpy(copy, start, len);
+  copy[len] = '\0';
+  return copy;
+}
+
+// parse the operator at the start of `op`, returning its length, or 0 if it isn't an operator
+static size_t parse_compare_op(const char* op, CompareOp* out)
+{
+  if (!strncmp(op, "<=", 2)) {
+    *out = CompareLe;
+    return 2;
+  } else if (!strncmp(op, ">=", 2)) {
+    *out = CompareGe;
+    return 2;
+  } else if (!strncmp(op, "!=", 2) || !strncmp(op, "<>", 2)) {
+    *out = CompareNe;
+    return 2;
+  } else if (*op == '<') {
+    *out = CompareLt;
+    return 1;
+  } else if (*op == '>') {
+    *out = CompareGt;
+    return 1;
+  } else if (*op == '=') {
+    *out = CompareEq;
+    return 1;
+  }
+  return 0;
+}
+
+// parse an integer literal, checking it fits in the range of the column type
+static bool parse_int_literal(PredicateTerm* term, int64_t min, int64_t max)
+{
+  char* end;
+  errno = 0;
+  long long value = strtoll(term->literal, &end, 10);
+  if (errno != 0 || end == term->literal || *end != '\0' || value < min || value > max) {
+    printf(
+      "'%s' is not a valid %s literal for column %s\n", term->literal, term->type, term->column);
+    return false;
+  }
+  term->value.int_value = value;
+  return true;
+}
+
+// parse the literal of `term` according to the type of its column
+static bool parse_literal(PredicateTerm* term)
+{
+  const char* type = term->type;
+  if (!strcmp(type, "string")) {
+    return true;
+  } else if (!strcmp(type, "long")) {
+    return parse_int_literal(term, INT64_MIN, INT64_MAX);
+  } else if (!strcmp(type, "integer")) {
+    return parse_int_literal(term, INT32_MIN, INT32_MAX);
+  } else if (!strcmp(type, "short")) {
+    return parse_int_literal(term, INT16_MIN, INT16_MAX);
+  } else if (!strcmp(type, "byte")) {
+    return parse_int_literal(term, INT8_MIN, INT8_MAX);
+  } else if (!strcmp(type, "float") || !strcmp(type, "double")) {
+    char* end;
+    term->value.float_value = strtod(term->literal, &end);
+    if (end == term->literal || *end != '\0') {
+      printf("'%s' is not a valid %s literal for column %s\n", term->literal, type, term->column);
+      return false;
+    }
+    return true;
+  } else if (!strcmp(type, "boolean")) {
+    if (strcmp(term->literal, "true") && strcmp(term->literal, "false")) {
+      printf("'%s' is not a valid boolean literal for column %s\n", term->literal, term->column);
+      return false;
+    }
+    term->value.bool_value = !strcmp(term->literal, "true");
+    return true;
+  }
+  printf("Column %s has type %s, which --where doesn't support\n", term->column, type);
+  return false;
+}
+
+// parse a single `column op literal` term, of `len` bytes at `start`
+static bool parse_term(
+  const char* start,
+  size_t len,
+  SchemaBuilder* builder,
+  uintptr_t schema_list_id,
+  PredicateTerm* term)
+{
+  term->column = NULL;
+  term->literal = NULL;
+  size_t op_pos = strcspn(start, "<>=!");
+  size_t op_len = op_pos < len ? parse_compare_op(start + op_pos, &term->op) : 0;
+  if (op_len == 0) {
+    printf("Expected 'column op literal', got '%.*s'\n", (int)len, start);
+    return false;
+  }
+  term->column = trim_copy(start, op_pos);
+  term->literal = trim_copy(start + op_pos + op_len, len - op_pos - op_len);
+  size_t literal_len = strlen(term->literal);
+  bool quoted = literal_len >= 2 && (term->literal[0] == '\'' || term->literal[0] == '"') &&
+                term->literal[literal_len - 1] == term->literal[0];
+  if (quoted) {
+    memmove(term->literal, term->literal + 1, literal_len - 2);
+    term->literal[literal_len - 2] = '\0';
+  }
+  SchemaItem* item = find_schema_item(builder, schema_list_id, term->column);
+  if (item == NULL) {
+    printf("No column named %s in the table\n", term->column);
+    return false;
+  }
+  term->type = item->type;
+  return parse_literal(term);
+}
+
+void free_where_predicate(WherePredicate* predicate)
+{
+  for (int i = 0; i < predicate->num_terms; i++) {
+    free(predicate->terms[i].column);
+    free(predicate->terms[i].literal);
+  }
+  free(predicate->terms);
+  free(predicate);
+}
+
+// find the next ` AND ` (or ` and `) separator in `where`, or the end of the string
+static const char* next_and(const char* where, size_t* sep_len)
+{
+  const char* upper = strstr(where, " AND ");
+  const char* lower = strstr(where, " and ");
+  const char* next = upper == NULL || (lower != NULL && lower < upper) ? lower : upper;
+  if (next == NULL) {
+    *sep_len = 0;
+    return where + strlen(where);
+  }
+  *sep_len = 5;
+  return next;
+}
+
+// Parse the argument of `--where`, resolving column types against `schema`. Returns NULL (after
+// printing why) if the predicate is invalid
+WherePredicate* parse_where_predicate(const char* where, SharedSchema* schema)
+{
+  SchemaBuilder builder;
+  uintptr_t schema_list_id = build_schema(schema, &builder);
+  WherePredicate* predicate = malloc(sizeof(WherePredicate));
+  predicate->num_terms = 0;
+  predicate->terms = NULL;
+  bool ok = true;
+  const char* start = where;
+  while (ok) {
+    size_t sep_len;
+    const char* end = next_and(start, &sep_len);
+    predicate->terms =
+      realloc(predicate->terms, sizeof(PredicateTerm) * (predicate->num_terms + 1));
+    PredicateTerm* term = &predicate->terms[predicate->num_terms++];
+    ok = parse_term(start, end - start, &builder, schema_list_id, term);
+    if (sep_len == 0) {
+      break;
+    }
+    start = end + sep_len;
+  }
+  // all the type names we kept are static strings, so they outlive the builder
+  free_builder(builder);
+  if (!ok) {
+    free_where_predicate(predicate);
+    return NULL;
+  }
+  return predicate;
+}
+
+// Get the id of a kernel expression out of a visitor result, or 0 (the kernel's "invalid" id) if
+// the visit failed
+static uintptr_t unwrap_visit_result(ExternResultusize res, const char* what)
+{
+  if (res.tag != Okusize) {
+    print_error(what, (Error*)res.err);
+    free_error((Error*)res.err);
+    return 0;
+  }
+  return res.ok;
+}
+
+static uintptr_t visit_term_literal(KernelExpressionVisitorState* state, const PredicateTerm* term)
+{
+  const char* type = term->type;
+  if (!strcmp(type, "string")) {
+    KernelStringSlice literal = { term->literal, strlen(term->literal) };
+    return unwrap_visit_result(
+      visit_expression_literal_string(state, literal, allocate_error),
+      "Failed to visit string literal");
+  } else if (!strcmp(type, "long")) {
+    return visit_expression_literal_long(state, term->value.int_value);
+  } else if (!strcmp(type, "integer")) {
+    return visit_expression_literal_int(state, (int32_t)term->value.int_value);
+  } else if (!strcmp(type, "short")) {
+    return visit_expression_literal_short(state, (int16_t)term->value.int_value);
+  } else if (!strcmp(type, "byte")) {
+    return visit_expression_literal_byte(state, (int8_t)term->value.int_value);
+  } else if (!strcmp(type, "float")) {
+    return visit_expression_literal_float(state, (float)term->value.float_value);
+  } else if (!strcmp(type, "double")) {
+    return visit_expression_literal_double(state, term->value.float_value);
+  } else if (!strcmp(type, "boolean")) {
+    return visit_expression_literal_bool(state, term->value.bool_value);
+  }
+  return 0; // parse_literal rejects any other type
+}
+
+static uintptr_t visit_term(KernelExpressionVisitorState* state, const PredicateTerm* term)
+{
+  KernelStringSlice column = { term->column, strlen(term->column) };
+  uintptr_t column_id = unwrap_visit_result(
+    visit_expression_column(state, column, allocate_error), "Failed to visit column");
+  uintptr_t literal_id = visit_term_literal(state, term);
+  if (column_id == 0 || literal_id == 0) {
+    return 0;
+  }
+  switch (term->op) {
+    case CompareLt:
+      return visit_predicate_lt(state, column_id, literal_id);
+    case CompareLe:
+      return visit_predicate_le(state, column_id, literal_id);
+    case CompareGt:
+      return visit_predicate_gt(state, column_id, literal_id);
+    case CompareGe:
+      return visit_predicate_ge(state, column_id, literal_id);
+    case CompareEq:
+      return visit_predicate_eq(state, column_id, literal_id);
+    case CompareNe:
+      return visit_predicate_ne(state, column_id, literal_id);
+  }
+  return 0;
+}
+
+// Iterates the ids of the visited terms, to pass them to `visit_predicate_and`
+typedef struct TermIdIterator
+{
+  uintptr_t* ids;
+  int len;
+  int next;
+} TermIdIterator;
+
+static const void* next_term_id(void* data)
+{
+  TermIdIterator* iter = data;
+  if (iter->next >= iter->len) {
+    return NULL;
+  }
+  return (const void*)iter->ids[iter->next++];
+}
+
+// The `visitor` of the `EnginePredicate` for a `WherePredicate`. Kernel calls this each time it
+// needs the predicate, and we build it up through the kernel visitor functions
+uintptr_t visit_where_predicate(void* data, KernelExpressionVisitorState* state)
+{
+  WherePredicate* predicate = data;
+  if (predicate->num_terms == 1) {
+    return visit_term(state, &predicate->terms[0]);
+  }
+  uintptr_t* ids = malloc(sizeof(uintptr_t) * predicate->num_terms);
+  bool ok = true;
+  for (int i = 0; i < predicate->num_terms; i++) {
+    ids[i] = visit_term(state, &predicate->terms[i]);
+    ok = ok && ids[i] != 0;
+  }
+  uintptr_t and_id = 0;
+  if (ok) {
+    TermIdIterator iter = {
+      .ids = ids,
+      .len = predicate->num_terms,
+      .next = 0,
+    };
+    EngineIterator children = {
+      .data = &iter,
+      .get_next = next_term_id,
+    };
+    and_id = visit_predicate_and(state, &children);
+  }
+  free(ids);
+  return and_id;
+}
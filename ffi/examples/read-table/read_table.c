@@ -4,8 +4,10 @@
 #include <sys/time.h>
 
 #include "arrow.h"
+#include "bench.h"
 #include "read_table.h"
 #include "schema.h"
+#include "predicate.h"
 #include "kernel_utils.h"
 
 // Print the content of a selection vector if `VERBOSE` is defined in read_table.h
@@ -43,7 +45,8 @@ void print_partition_info(struct EngineContext* context, const CStringMap* parti
 }
 
 // Kernel will call this function for each file that should be scanned. The arguments include enough
-// context to construct the correct logical data from the physically read parquet
+// context to construct the correct logical data from the physically read parquet. We only use this
+// to print diagnostics when we aren't reading data, see `do_visit_scan_metadata`
 void scan_row_callback(
   void* engine_context,
   KernelStringSlice path,
@@ -61,33 +64,30 @@ void scan_row_callback(
   } else {
     print_diag(" [no stats])\n");
   }
+  context->partition_values = partition_values;
+  print_partition_info(context, partition_values);
+  (void)transform;
   KernelStringSlice table_root_slice = { context->table_root, strlen(context->table_root) };
-  KernelBoolSlice selection_vector;
-
   if (cdv_info->has_vector) {
+    BENCH_START(dv_timer, PhaseDvMaterialize);
     ExternResultKernelBoolSlice selection_vector_res =
       selection_vector_from_dv(cdv_info->info, context->engine, table_root_slice);
+    BENCH_STOP(dv_timer);
     if (selection_vector_res.tag != OkKernelBoolSlice) {
       printf("Could not get selection vector from kernel\n");
       exit(-1);
     }
-    selection_vector = selection_vector_res.ok;
+    KernelBoolSlice selection_vector = selection_vector_res.ok;
     if (selection_vector.len > 0) {
       print_diag("  Selection vector for this file:\n");
       print_selection_vector("    ", &selection_vector);
     } else {
       print_diag("  No selection vector for this file\n");
     }
+    free_bool_slice(selection_vector);
   } else {
     print_diag("  No selection vector for this file\n");
-    selection_vector.len = 0;
   }
-  context->partition_values = partition_values;
-  print_partition_info(context, partition_values);
-#ifdef PRINT_ARROW_DATA
-  c_read_parquet_file(context, path, selection_vector, transform);
-#endif
-  free_bool_slice(selection_vector);
   context->partition_values = NULL;
 }
 
@@ -108,9 +108,23 @@ void do_visit_scan_metadata(void* engine_context, HandleSharedScanMetadata scan_
   KernelBoolSlice selection_vector = selection_vector_res.ok;
   print_selection_vector("    ", &selection_vector);
 
+#ifdef PRINT_ARROW_DATA
+  // Ask kernel for all the files in this chunk at once, and hand them to the arrow reader
+  print_diag("Asking kernel for a batch of the files to read\n");
+  ExternResultHandleSharedScanFileBatch batch_res =
+    scan_file_batch(scan_metadata, context->scan, context->engine);
+  if (batch_res.tag != OkHandleSharedScanFileBatch) {
+    print_error("Failed to get scan file batch.", (Error*)batch_res.err);
+    free_error((Error*)batch_res.err);
+    exit(-1);
+  }
+  c_read_scan_file_batch(context, batch_res.ok);
+  free_scan_file_batch(batch_res.ok);
+#else
   // Ask kernel to iterate each individual file and call us back with extracted metadata
   print_diag("Asking kernel to call us back for each scan row (file to read)\n");
   visit_scan_metadata(scan_metadata, engine_context, scan_row_callback);
+#endif
   free_bool_slice(selection_vector);
   free_scan_metadata(scan_metadata);
 }
@@ -210,30 +224,213 @@ void tracing_callback(struct Event event) {
   }
 }
 
+// Print a kernel span enter or exit. Timestamps are monotonic and relative to when tracing was
+// enabled, so the time a span was active is the difference between its enter and exit
+static void print_span(const char* kind, struct SpanEvent span) {
+  printf(
+    "%s%12.6fms%s [%sKernel span %s%s] %s%.*s%s #%" PRIu64 " (parent #%" PRIu64 ") %.*s\n",
+    DIM,
+    (double)span.timestamp_ns / 1e6,
+    RESET,
+    BLUE,
+    kind,
+    RESET,
+    DIM,
+    (int)span.name.len,
+    span.name.ptr,
+    RESET,
+    span.id,
+    span.parent_id,
+    (int)span.fields.len,
+    span.fields.ptr);
+}
+
+void span_enter_callback(struct SpanEvent span) {
+  print_span("enter", span);
+}
+
+void span_exit_callback(struct SpanEvent span) {
+  print_span("exit", span);
+}
+
 void log_line_callback(KernelStringSlice line) {
   printf("%.*s", (int)line.len, line.ptr);
 }
 
-int main(int argc, char* argv[])
+static void print_usage(const char* prog)
 {
-  if (argc < 2) {
-    printf("Usage: %s table/path\n", argv[0]);
-    return -1;
+  printf("Usage: %s [--threads N] [--where PREDICATE] [--columns a,b,c] [--limit N] [--prefetch N] "
+         "[--stream] [--ipc FILE] [--compiled-transforms] table/path\n",
+         prog);
+  printf("  --threads N        read data files using a pool of N threads (default: 1)\n");
+  printf("  --where PREDICATE  skip files and row groups that can't match PREDICATE, which is of\n");
+  printf("                     the form \"col op literal [AND ...]\"\n");
+  printf("  --columns a,b,c    only read the listed top-level columns\n");
+  printf("  --limit N          only read (and print) the first N rows of the table\n");
+  printf("  --prefetch N       replay the log up to N scan metadata chunks ahead of the files\n");
+  printf("                     being read (default: 0)\n");
+  printf("  --stream           print each batch as soon as it is read, instead of collecting the\n");
+  printf("                     whole table and printing it column by column at the end\n");
+  printf("  --ipc FILE         like --stream, but write the batches to FILE as an arrow IPC stream\n");
+  printf("  --compiled-transforms\n");
+  printf("                     apply per-file transforms with compiled arrow-glib plans, instead of\n");
+  printf("                     kernel's expression evaluator\n");
+#ifdef BENCHMARK
+  printf("  --runs N           read the table N times (default: 1)\n");
+  printf("  --json FILE        write the timings of each run to FILE, instead of stdout\n");
+#endif
+}
+
+// Split a comma separated list of column names into string slices, which point into `columns`.
+// Returns the number of slices, which the caller must free with `free`
+static uintptr_t parse_column_list(const char* columns, KernelStringSlice** slices)
+{
+  uintptr_t count = 1;
+  for (const char* c = columns; *c; c++) {
+    count += *c == ',';
+  }
+  *slices = malloc(sizeof(KernelStringSlice) * count);
+  const char* start = columns;
+  for (uintptr_t i = 0; i < count; i++) {
+    size_t len = strcspn(start, ",");
+    (*slices)[i] = (KernelStringSlice){ start, len };
+    start += len + 1;
   }
+  return count;
+}
 
-#ifdef VERBOSE
-  enable_event_tracing(tracing_callback, TRACE);
-  // we could also do something like this if we want less control over formatting
-  // enable_formatted_log_line_tracing(log_line_callback, TRACE, FULL, true, true, false, false);
+// Print what kernel did to produce the scan metadata. Only complete once the iterator is exhausted
+static void print_scan_metrics(SharedScan* scan)
+{
+  ScanMetrics metrics = scan_metrics(scan);
+  print_diag("Scan metrics:\n"
+             "  log files read: %" PRIu64 " commits, %" PRIu64 " checkpoint parts, %" PRIu64
+             " sidecars (%" PRIu64 " bytes)\n"
+             "  actions replayed: %" PRIu64 "\n"
+             "  files: %" PRIu64 " considered, %" PRIu64 " skipped by stats, %" PRIu64
+             " skipped by partition, %" PRIu64 " selected (%" PRIu64 " with deletion vectors)\n"
+             "  time: %.3fms reading log, %.3fms data skipping, %.3fms replaying actions\n",
+             metrics.commit_files_read,
+             metrics.checkpoint_parts_read,
+             metrics.sidecar_files_read,
+             metrics.log_bytes_read,
+             metrics.actions_replayed,
+             metrics.files_considered,
+             metrics.files_skipped_by_stats,
+             metrics.files_skipped_by_partition,
+             metrics.files_selected,
+             metrics.files_with_deletion_vector,
+             (double)metrics.log_read_ns / 1e6,
+             (double)metrics.data_skipping_ns / 1e6,
+             (double)metrics.log_replay_ns / 1e6);
+}
+
+// Iterate the scan metadata of the scan in `context`, reading (or, without PRINT_ARROW_DATA, just
+// describing) each file it selects. If `prefetch` is positive, kernel produces up to that many scan
+// metadata chunks in the background while we read the files of the current one. Returns 0 on
+// success
+static int read_scan_metadata(
+  struct EngineContext* context,
+  int num_threads,
+  bool compiled_transforms,
+  int prefetch)
+{
+#ifdef PRINT_ARROW_DATA
+  context->arrow_context = init_arrow_context(num_threads, compiled_transforms);
 #else
-  enable_event_tracing(tracing_callback, INFO);
+  // we only read data files when printing data
+  (void)num_threads;
+  (void)compiled_transforms;
 #endif
 
-  char* table_path = argv[1];
+  ExternResultHandleSharedScanMetadataIterator data_iter_res;
+  if (prefetch > 0) {
+    print_diag("Prefetching up to %i scan metadata chunks\n", prefetch);
+    data_iter_res =
+      scan_metadata_iter_init_with_prefetch(context->engine, context->scan, (uintptr_t)prefetch);
+  } else {
+    data_iter_res = scan_metadata_iter_init(context->engine, context->scan);
+  }
+  if (data_iter_res.tag != OkHandleSharedScanMetadataIterator) {
+    print_error("Failed to construct scan metadata iterator.", (Error*)data_iter_res.err);
+    free_error((Error*)data_iter_res.err);
+    return -1;
+  }
+
+  SharedScanMetadataIterator* data_iter = data_iter_res.ok;
+
+  print_diag("\nIterating scan metadata\n");
+
+  // iterate scan files
+  for (;;) {
+    BENCH_START(scan_metadata_timer, PhaseScanMetadata);
+    ExternResultbool ok_res =
+      scan_metadata_next(data_iter, context, do_visit_scan_metadata);
+    BENCH_STOP(scan_metadata_timer);
+    if (ok_res.tag != Okbool) {
+      print_error("Failed to iterate scan metadata.", (Error*)ok_res.err);
+      free_error((Error*)ok_res.err);
+      return -1;
+    } else if (!ok_res.ok) {
+      print_diag("Scan metadata iterator done\n");
+      print_scan_metrics(context->scan);
+      break;
+    }
+  }
+
+  print_diag("All done reading table data\n");
+
+#ifdef PRINT_ARROW_DATA
+  finish_arrow_reads(context->arrow_context);
+#ifndef BENCHMARK
+  // printing the table would dwarf the time spent in kernel, so benchmarks only read it
+  print_arrow_context(context->arrow_context, context->limit);
+#endif
+  free_arrow_context(context->arrow_context);
+  context->arrow_context = NULL;
+#endif
+
+  free_scan_metadata_iter(data_iter);
+  return 0;
+}
+
+// Options controlling how `read_table` reads a table. See `print_usage`
+typedef struct ReadTableOptions
+{
+  const char* table_path;
+  int num_threads;
+  const char* where;
+  const char* columns;
+  // -1 for no limit
+  int64_t limit;
+  int prefetch;
+  bool stream;
+  const char* ipc_path;
+  bool compiled_transforms;
+#ifdef BENCHMARK
+  int runs;
+  const char* json_path;
+#endif
+} ReadTableOptions;
+
+// Read (or with PRINT_ARROW_DATA, read and print) the whole table. Returns 0 on success
+static int read_table(const ReadTableOptions* opts)
+{
+  const char* table_path = opts->table_path;
+  int num_threads = opts->num_threads;
+  const char* where = opts->where;
+  const char* columns = opts->columns;
+  int64_t limit = opts->limit;
+  int prefetch = opts->prefetch;
+  bool stream = opts->stream;
+  const char* ipc_path = opts->ipc_path;
+  bool compiled_transforms = opts->compiled_transforms;
+
   printf("Reading table at %s\n", table_path);
 
   KernelStringSlice table_path_slice = { table_path, strlen(table_path) };
 
+  BENCH_START(engine_timer, PhaseEngineBuild);
   ExternResultEngineBuilder engine_builder_res =
     get_engine_builder(table_path_slice, allocate_error);
   if (engine_builder_res.tag != OkEngineBuilder) {
@@ -249,6 +446,7 @@ int main(int argc, char* argv[])
   // set_builder_opt(engine_builder, "aws_access_key_id" , "[redacted]");
   // set_builder_opt(engine_builder, "aws_secret_access_key", "[redacted]");
   ExternResultHandleSharedExternEngine engine_res = builder_build(engine_builder);
+  BENCH_STOP(engine_timer);
 
   // alternately if we don't care to set any options on the builder:
   // ExternResultExternEngineHandle engine_res =
@@ -262,7 +460,9 @@ int main(int argc, char* argv[])
 
   SharedExternEngine* engine = engine_res.ok;
 
+  BENCH_START(snapshot_timer, PhaseSnapshot);
   ExternResultHandleSharedSnapshot snapshot_res = snapshot(table_path_slice, engine);
+  BENCH_STOP(snapshot_timer);
   if (snapshot_res.tag != OkHandleSharedSnapshot) {
     print_error("Failed to create snapshot.", (Error*)snapshot_res.err);
     free_error((Error*)snapshot_res.err);
@@ -280,11 +480,66 @@ int main(int argc, char* argv[])
 
   PartitionList* partition_cols = get_partition_list(snapshot);
 
+#ifndef PRINT_ARROW_DATA
+  if (stream) {
+    printf("--stream and --ipc need read_table to be built with PRINT_DATA\n");
+    return -1;
+  }
+  (void)ipc_path;
+#endif
+
+  WherePredicate* where_predicate = NULL;
+  EnginePredicate engine_predicate;
+  EnginePredicate* predicate = NULL;
+  SharedPredicate* read_predicate = NULL;
+  if (where) {
+    SharedSchema* table_schema = logical_schema(snapshot);
+    where_predicate = parse_where_predicate(where, table_schema);
+    free_schema(table_schema);
+    if (where_predicate == NULL) {
+      return -1;
+    }
+    engine_predicate.predicate = where_predicate;
+    engine_predicate.visitor = visit_where_predicate;
+    predicate = &engine_predicate;
+    // the file reads run on many threads at once, so they share one kernel copy of the predicate
+    // rather than each visiting `engine_predicate` again
+    ExternResultHandleSharedPredicate read_predicate_res =
+      kernel_predicate_from_engine(engine, predicate);
+    if (read_predicate_res.tag != OkHandleSharedPredicate) {
+      print_error("Failed to convert predicate.", (Error*)read_predicate_res.err);
+      free_error((Error*)read_predicate_res.err);
+      free_where_predicate(where_predicate);
+      return -1;
+    }
+    read_predicate = read_predicate_res.ok;
+    print_diag("Scanning with predicate: %s\n", where);
+  }
+
   print_diag("Starting table scan\n\n");
 
-  ExternResultHandleSharedScan scan_res = scan(snapshot, engine, NULL);
+  BENCH_START(scan_timer, PhaseScan);
+  ExternResultHandleSharedScan scan_res;
+  KernelStringSlice* column_slices = NULL;
+  uintptr_t num_columns = 0;
+  if (columns) {
+    num_columns = parse_column_list(columns, &column_slices);
+  }
+  if (limit >= 0) {
+    // kernel stops selecting files once their stats show they have enough rows
+    print_diag("Scanning with a limit of %" PRId64 " rows\n", limit);
+    scan_res =
+      scan_with_limit(snapshot, engine, predicate, column_slices, num_columns, (uint64_t)limit);
+  } else if (columns) {
+    scan_res = scan_with_columns(snapshot, engine, predicate, column_slices, num_columns);
+  } else {
+    scan_res = scan(snapshot, engine, predicate);
+  }
+  free(column_slices);
+  BENCH_STOP(scan_timer);
   if (scan_res.tag != OkHandleSharedScan) {
-    printf("Failed to create scan\n");
+    print_error("Failed to create scan.", (Error*)scan_res.err);
+    free_error((Error*)scan_res.err);
     return -1;
   }
 
@@ -302,46 +557,28 @@ int main(int argc, char* argv[])
     engine,
     partition_cols,
     .partition_values = NULL,
+    .predicate = read_predicate,
+    .scan = scan,
+    .limit = limit,
 #ifdef PRINT_ARROW_DATA
-    .arrow_context = init_arrow_context(),
+    .arrow_context = NULL,
 #endif
   };
 
-  ExternResultHandleSharedScanMetadataIterator data_iter_res =
-    scan_metadata_iter_init(engine, scan);
-  if (data_iter_res.tag != OkHandleSharedScanMetadataIterator) {
-    print_error("Failed to construct scan metadata iterator.", (Error*)data_iter_res.err);
-    free_error((Error*)data_iter_res.err);
-    return -1;
-  }
-
-  SharedScanMetadataIterator* data_iter = data_iter_res.ok;
-
-  print_diag("\nIterating scan metadata\n");
-
-  // iterate scan files
-  for (;;) {
-    ExternResultbool ok_res =
-      scan_metadata_next(data_iter, &context, do_visit_scan_metadata);
-    if (ok_res.tag != Okbool) {
-      print_error("Failed to iterate scan metadata.", (Error*)ok_res.err);
-      free_error((Error*)ok_res.err);
-      return -1;
-    } else if (!ok_res.ok) {
-      print_diag("Scan metadata iterator done\n");
-      break;
-    }
-  }
-
-  print_diag("All done reading table data\n");
-
+  int ret;
 #ifdef PRINT_ARROW_DATA
-  print_arrow_context(context.arrow_context);
-  free_arrow_context(context.arrow_context);
-  context.arrow_context = NULL;
+  if (stream) {
+    // kernel reads the files one by one as we pull batches, so we don't need to iterate scan
+    // metadata ourselves, or hold the whole table in memory
+    print_diag("Streaming scan data\n");
+    ret = stream_arrow_scan(&context, ipc_path) ? 0 : -1;
+  } else {
+    ret = read_scan_metadata(&context, num_threads, compiled_transforms, prefetch);
+  }
+#else
+  ret = read_scan_metadata(&context, num_threads, compiled_transforms, prefetch);
 #endif
 
-  free_scan_metadata_iter(data_iter);
   free_scan(scan);
   free_schema(logical_schema);
   free_schema(physical_schema);
@@ -350,6 +587,114 @@ int main(int argc, char* argv[])
   free(context.table_root);
   free(scan_table_path);
   free_partition_list(context.partition_cols);
+  if (read_predicate) {
+    free_kernel_predicate(read_predicate);
+  }
+  if (where_predicate) {
+    free_where_predicate(where_predicate);
+  }
+
+  return ret;
+}
+
+int main(int argc, char* argv[])
+{
+  ReadTableOptions opts = {
+    .table_path = NULL,
+    .num_threads = 1,
+    .where = NULL,
+    .columns = NULL,
+    .limit = -1,
+    .prefetch = 0,
+    .stream = false,
+    .ipc_path = NULL,
+    .compiled_transforms = false,
+#ifdef BENCHMARK
+    .runs = 1,
+    .json_path = NULL,
+#endif
+  };
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      opts.num_threads = atoi(argv[++i]);
+      if (opts.num_threads < 1) {
+        printf("--threads must be a positive number\n");
+        return -1;
+      }
+    } else if (strcmp(argv[i], "--where") == 0 && i + 1 < argc) {
+      opts.where = argv[++i];
+    } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+      opts.columns = argv[++i];
+    } else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+      opts.limit = atoll(argv[++i]);
+      if (opts.limit < 0) {
+        printf("--limit must not be negative\n");
+        return -1;
+      }
+    } else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc) {
+      opts.prefetch = atoi(argv[++i]);
+      if (opts.prefetch < 0) {
+        printf("--prefetch must not be negative\n");
+        return -1;
+      }
+    } else if (strcmp(argv[i], "--stream") == 0) {
+      opts.stream = true;
+    } else if (strcmp(argv[i], "--ipc") == 0 && i + 1 < argc) {
+      opts.stream = true;
+      opts.ipc_path = argv[++i];
+    } else if (strcmp(argv[i], "--compiled-transforms") == 0) {
+      opts.compiled_transforms = true;
+#ifdef BENCHMARK
+    } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      opts.runs = atoi(argv[++i]);
+      if (opts.runs < 1) {
+        printf("--runs must be a positive number\n");
+        return -1;
+      }
+    } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      opts.json_path = argv[++i];
+#endif
+    } else if (opts.table_path == NULL && strncmp(argv[i], "--", 2) != 0) {
+      opts.table_path = argv[i];
+    } else {
+      print_usage(argv[0]);
+      return -1;
+    }
+  }
+  if (opts.table_path == NULL) {
+    print_usage(argv[0]);
+    return -1;
+  }
 
+#ifdef VERBOSE
+  enable_event_and_span_tracing(tracing_callback, span_enter_callback, span_exit_callback, TRACE);
+  // we could also do something like this if we want less control over formatting
+  // enable_formatted_log_line_tracing(log_line_callback, TRACE, FULL, true, true, false, false);
+#else
+  enable_event_tracing(tracing_callback, INFO);
+#endif
+
+
+#ifdef BENCHMARK
+  for (int run = 0; run < opts.runs; run++) {
+    bench_begin_run();
+    int ret = read_table(&opts);
+    bench_end_run();
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  FILE* json_out = opts.json_path ? fopen(opts.json_path, "w") : stdout;
+  if (json_out == NULL) {
+    printf("Can't open %s for writing\n", opts.json_path);
+    return -1;
+  }
+  bench_write_json(json_out, opts.table_path);
+  if (json_out != stdout) {
+    fclose(json_out);
+  }
   return 0;
+#else
+  return read_table(&opts);
+#endif
 }
@@ -19,6 +19,11 @@ struct EngineContext
   SharedExternEngine* engine;
   PartitionList* partition_cols;
   const CStringMap* partition_values;
+  // predicate from `--where`, or NULL. Passed to parquet reads as a row group skipping hint
+  SharedPredicate* predicate;
+  SharedScan* scan;
+  // the number of rows to read from `--limit`, or -1 to read all of them
+  int64_t limit;
 #ifdef PRINT_ARROW_DATA
   struct ArrowContext* arrow_context;
 #endif
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "delta_kernel_ffi.h"
 #include "read_table.h"
 #include "kernel_utils.h"
@@ -245,16 +247,14 @@ void free_builder(SchemaBuilder builder)
   free(builder.lists);
 }
 
-// Print the schema of the snapshot
-void print_schema(SharedSnapshot* snapshot)
+// Visit `schema` into `builder`, and return the id of the list holding its top-level fields
+uintptr_t build_schema(SharedSchema* schema, SchemaBuilder* builder)
 {
   print_diag("Building schema\n");
-  SchemaBuilder builder = {
-    .list_count = 0,
-    .lists = NULL,
-  };
+  builder->list_count = 0;
+  builder->lists = NULL;
   EngineSchemaVisitor visitor = {
-    .data = &builder,
+    .data = builder,
     .make_field_list = make_field_list,
     .visit_struct = visit_struct,
     .visit_array = visit_array,
@@ -273,12 +273,44 @@ void print_schema(SharedSnapshot* snapshot)
     .visit_timestamp = visit_timestamp,
     .visit_timestamp_ntz = visit_timestamp_ntz,
   };
-  SharedSchema* schema = logical_schema(snapshot);
   uintptr_t schema_list_id = visit_schema(schema, &visitor);
 #ifdef VERBOSE
   printf("Schema returned in list %" PRIxPTR "\n", schema_list_id);
 #endif
   print_diag("Done building schema\n");
+  return schema_list_id;
+}
+
+// Find the item for the (possibly nested, dot-separated) column `name` in the list `list_id`, or
+// NULL if there is no such column
+SchemaItem* find_schema_item(SchemaBuilder* builder, uintptr_t list_id, const char* name)
+{
+  const char* dot = strchr(name, '.');
+  size_t len = dot ? (size_t)(dot - name) : strlen(name);
+  SchemaItemList* list = &builder->lists[list_id];
+  for (uint32_t i = 0; i < list->len; i++) {
+    SchemaItem* item = &list->list[i];
+    if (strlen(item->name) != len || strncmp(item->name, name, len) != 0) {
+      continue;
+    }
+    if (dot == NULL) {
+      return item;
+    }
+    // only structs have named children we can look into
+    if (item->children == UINTPTR_MAX || strcmp(item->type, "struct") != 0) {
+      return NULL;
+    }
+    return find_schema_item(builder, item->children, dot + 1);
+  }
+  return NULL;
+}
+
+// Print the schema of the snapshot
+void print_schema(SharedSnapshot* snapshot)
+{
+  SchemaBuilder builder;
+  SharedSchema* schema = logical_schema(snapshot);
+  uintptr_t schema_list_id = build_schema(schema, &builder);
   printf("Schema:\n");
   print_list(&builder, schema_list_id, 0, 0);
   printf("\n");
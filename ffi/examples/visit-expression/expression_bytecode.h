@@ -0,0 +1,265 @@
+#pragma once
+
+#include "delta_kernel_ffi.h"
+#include "expression.h"
+#include <stdlib.h>
+
+/**
+ * This module decodes the flat bytecode produced by `serialize_expression` (and friends) into the
+ * same model of an expression that `construct_expression` builds with the visitor.
+ *
+ * Instead of one allocation per node and per child list, every node and list lives in a single
+ * "arena" allocation, whose size we know before decoding: each instruction produces at most one
+ * node, and the child lists of all nodes together hold each instruction's operands exactly once.
+ * Strings are not copied either, they point straight into the kernel's string pool. The decoded
+ * expression is therefore only valid until the bytecode is freed, and freeing it is a single
+ * `free` of the arena.
+ */
+
+typedef union {
+  struct BinOp binop;
+  struct Variadic variadic;
+  struct Unary unary;
+  struct TransformExpression transform;
+  struct FieldTransform field_transform;
+  struct OpaqueExpression opaque_expr;
+  struct OpaquePredicate opaque_pred;
+  struct Unknown unknown;
+  struct Literal literal;
+} DecodedNode;
+
+typedef struct {
+  ExpressionItemList expression;
+  void* arena;
+} DecodedExpression;
+
+typedef struct {
+  DecodedNode* next_node;
+  ExpressionItem* next_item;
+} Arena;
+
+static void* new_node(Arena* arena) {
+  return arena->next_node++;
+}
+
+// Move the top `len` values of the stack into a new list
+static ExpressionItemList pop_list(Arena* arena, ExpressionItem* stack, size_t* depth, size_t len) {
+  ExpressionItemList list = { .len = len, .list = NULL };
+  if (len) {
+    list.list = arena->next_item;
+    arena->next_item += len;
+    *depth -= len;
+    memcpy(list.list, &stack[*depth], len * sizeof(ExpressionItem));
+  }
+  return list;
+}
+
+// Split a list of (first, second) pairs into a list of firsts and a list of seconds
+static void unzip_list(Arena* arena,
+                       ExpressionItem* stack,
+                       size_t* depth,
+                       size_t arity,
+                       ExpressionItemList* firsts,
+                       ExpressionItemList* seconds) {
+  size_t len = arity / 2;
+  firsts->len = len;
+  firsts->list = arena->next_item;
+  seconds->len = len;
+  seconds->list = arena->next_item + len;
+  arena->next_item += arity;
+  *depth -= arity;
+  for (size_t i = 0; i < len; i++) {
+    firsts->list[i] = stack[*depth + 2 * i];
+    seconds->list[i] = stack[*depth + 2 * i + 1];
+  }
+}
+
+static char* pool_string(const ExpressionBytecodeView* view, uint64_t id) {
+  return (char*)view->bytes + view->strings[id].offset;
+}
+
+static struct Literal* new_literal(Arena* arena, enum LitType type) {
+  struct Literal* lit = new_node(arena);
+  lit->type = type;
+  return lit;
+}
+
+DecodedExpression decode_expression_bytecode(const ExpressionBytecodeView* view) {
+  size_t num_items = 1; // the top level list
+  for (size_t i = 0; i < view->num_instructions; i++) {
+    num_items += view->instructions[i].arity;
+  }
+  size_t nodes_size = view->num_instructions * sizeof(DecodedNode);
+  size_t items_size = (num_items + view->max_stack_depth) * sizeof(ExpressionItem);
+  void* memory = malloc(nodes_size + items_size);
+  Arena arena = { .next_node = memory, .next_item = (ExpressionItem*)((char*)memory + nodes_size) };
+  ExpressionItem* stack = arena.next_item + num_items;
+  size_t depth = 0;
+
+  for (size_t i = 0; i < view->num_instructions; i++) {
+    ExpressionInstruction instr = view->instructions[i];
+    ExpressionItem item = { .ref = NULL, .type = Literal };
+    switch (instr.op) {
+#define SIMPLE_LITERAL(op_name, lit_type, field, c_type)                                          \
+  case ExpressionOpCode_##op_name: {                                                               \
+    struct Literal* lit = new_literal(&arena, lit_type);                                           \
+    lit->value.field = (c_type)instr.arg;                                                          \
+    item.ref = lit;                                                                                \
+    break;                                                                                         \
+  }
+      SIMPLE_LITERAL(LiteralInt, Integer, integer_data, int32_t)
+      SIMPLE_LITERAL(LiteralLong, Long, long_data, int64_t)
+      SIMPLE_LITERAL(LiteralShort, Short, short_data, int16_t)
+      SIMPLE_LITERAL(LiteralByte, Byte, byte_data, int8_t)
+      SIMPLE_LITERAL(LiteralBool, Boolean, boolean_data, bool)
+      SIMPLE_LITERAL(LiteralTimestamp, Timestamp, long_data, int64_t)
+      SIMPLE_LITERAL(LiteralTimestampNtz, TimestampNtz, long_data, int64_t)
+      SIMPLE_LITERAL(LiteralDate, Date, integer_data, int32_t)
+#undef SIMPLE_LITERAL
+      case ExpressionOpCode_LiteralFloat: {
+        struct Literal* lit = new_literal(&arena, Float);
+        uint32_t bits = (uint32_t)instr.arg;
+        memcpy(&lit->value.float_data, &bits, sizeof(float));
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralDouble: {
+        struct Literal* lit = new_literal(&arena, Double);
+        memcpy(&lit->value.double_data, &instr.arg, sizeof(double));
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralString: {
+        struct Literal* lit = new_literal(&arena, String);
+        lit->value.string_data = pool_string(view, instr.arg);
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralBinary: {
+        struct Literal* lit = new_literal(&arena, Binary);
+        lit->value.binary.buf = (uint8_t*)pool_string(view, instr.arg);
+        lit->value.binary.len = view->strings[instr.arg].len;
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralDecimal: {
+        struct Literal* lit = new_literal(&arena, Decimal);
+        ExpressionDecimal dec = view->decimals[instr.arg];
+        lit->value.decimal.hi = dec.value_ms;
+        lit->value.decimal.lo = dec.value_ls;
+        lit->value.decimal.precision = dec.precision;
+        lit->value.decimal.scale = dec.scale;
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralNull:
+        item.ref = new_literal(&arena, Null);
+        break;
+      case ExpressionOpCode_LiteralStruct: {
+        struct Literal* lit = new_literal(&arena, Struct);
+        struct Struct* data = &lit->value.struct_data;
+        unzip_list(&arena, stack, &depth, instr.arity, &data->fields, &data->values);
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralArray: {
+        struct Literal* lit = new_literal(&arena, Array);
+        lit->value.array_data.exprs = pop_list(&arena, stack, &depth, instr.arity);
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_LiteralMap: {
+        struct Literal* lit = new_literal(&arena, Map);
+        struct MapData* data = &lit->value.map_data;
+        unzip_list(&arena, stack, &depth, instr.arity, &data->keys, &data->vals);
+        item.ref = lit;
+        break;
+      }
+      case ExpressionOpCode_Column:
+        item.type = Column;
+        item.ref = pool_string(view, instr.arg);
+        break;
+#define OPERATOR(op_name, item_type, node_type, node_op, list_field)                              \
+  case ExpressionOpCode_##op_name: {                                                               \
+    node_type* node = new_node(&arena);                                                            \
+    node->list_field = pop_list(&arena, stack, &depth, instr.arity);                               \
+    node_op;                                                                                       \
+    item.type = item_type;                                                                         \
+    item.ref = node;                                                                               \
+    break;                                                                                         \
+  }
+      OPERATOR(And, Variadic, struct Variadic, node->op = And, exprs)
+      OPERATOR(Or, Variadic, struct Variadic, node->op = Or, exprs)
+      OPERATOR(Struct, Variadic, struct Variadic, node->op = StructExpression, exprs)
+      OPERATOR(Not, Unary, struct Unary, node->type = Not, sub_expr)
+      OPERATOR(IsNull, Unary, struct Unary, node->type = IsNull, sub_expr)
+      OPERATOR(LessThan, BinOp, struct BinOp, node->op = LessThan, exprs)
+      OPERATOR(GreaterThan, BinOp, struct BinOp, node->op = GreaterThan, exprs)
+      OPERATOR(Equal, BinOp, struct BinOp, node->op = Equal, exprs)
+      OPERATOR(Distinct, BinOp, struct BinOp, node->op = Distinct, exprs)
+      OPERATOR(In, BinOp, struct BinOp, node->op = In, exprs)
+      OPERATOR(Add, BinOp, struct BinOp, node->op = Add, exprs)
+      OPERATOR(Minus, BinOp, struct BinOp, node->op = Minus, exprs)
+      OPERATOR(Multiply, BinOp, struct BinOp, node->op = Multiply, exprs)
+      OPERATOR(Divide, BinOp, struct BinOp, node->op = Divide, exprs)
+      OPERATOR(OpaqueExpression,
+               OpaqueExpression,
+               struct OpaqueExpression,
+               node->op = view->opaque_expression_ops[instr.arg],
+               exprs)
+      OPERATOR(OpaquePredicate,
+               OpaquePredicate,
+               struct OpaquePredicate,
+               node->op = view->opaque_predicate_ops[instr.arg],
+               exprs)
+#undef OPERATOR
+      case ExpressionOpCode_FieldInsert:
+      case ExpressionOpCode_FieldReplace: {
+        struct FieldTransform* field_transform = new_node(&arena);
+        field_transform->field_name = instr.arg == UINT64_MAX ? NULL : pool_string(view, instr.arg);
+        field_transform->exprs = pop_list(&arena, stack, &depth, instr.arity);
+        field_transform->is_replace = instr.op == ExpressionOpCode_FieldReplace;
+        item.type = FieldTransform;
+        item.ref = field_transform;
+        break;
+      }
+      case ExpressionOpCode_Transform: {
+        struct TransformExpression* transform = new_node(&arena);
+        size_t num_field_transforms = instr.arity - instr.arg;
+        transform->field_transforms = pop_list(&arena, stack, &depth, num_field_transforms);
+        transform->input_path = pop_list(&arena, stack, &depth, instr.arg);
+        // stable sort the ops by field name to ensure deterministic output
+        qsort(transform->field_transforms.list,
+              transform->field_transforms.len,
+              sizeof(ExpressionItem),
+              transform_op_cmp);
+        item.type = Transform;
+        item.ref = transform;
+        break;
+      }
+      case ExpressionOpCode_Unknown: {
+        struct Unknown* unknown = new_node(&arena);
+        unknown->name = pool_string(view, instr.arg);
+        item.type = Unknown;
+        item.ref = unknown;
+        break;
+      }
+      case ExpressionOpCode_ToJson:
+      case ExpressionOpCode_Coalesce:
+        // not part of our expression model (the visitor doesn't handle them either)
+        fprintf(stderr, "Unsupported expression op code %d\n", (int)instr.op);
+        abort();
+    }
+    stack[depth++] = item;
+  }
+
+  DecodedExpression decoded = {
+    .expression = pop_list(&arena, stack, &depth, depth),
+    .arena = memory,
+  };
+  return decoded;
+}
+
+void free_decoded_expression(DecodedExpression decoded) {
+  free(decoded.arena);
+}
@@ -0,0 +1,138 @@
+#include "delta_kernel_ffi.h"
+#include "transform_plan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Test the transform plan compiler with kernel's testing transform, which inserts an int `part`
+// column after `id`. Transforms that only differ in their literal must share one plan, transforms
+// we can't compile must not add any, and applying a plan must insert the bound literal.
+
+#define CHECK(cond)                                                                                \
+  do {                                                                                             \
+    if (!(cond)) {                                                                                 \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                     \
+      exit(1);                                                                                     \
+    }                                                                                              \
+  } while (0)
+
+static void check_g_error(GError* error) {
+  if (error != NULL) {
+    fprintf(stderr, "Unexpected error: %s\n", error->message);
+    exit(1);
+  }
+}
+
+static GArrowSchema* make_schema(gboolean with_part) {
+  GArrowDataType* long_type = GARROW_DATA_TYPE(garrow_int64_data_type_new());
+  GArrowDataType* int_type = GARROW_DATA_TYPE(garrow_int32_data_type_new());
+  GArrowDataType* string_type = GARROW_DATA_TYPE(garrow_string_data_type_new());
+  GList* fields = NULL;
+  fields = g_list_append(fields, garrow_field_new("id", long_type));
+  if (with_part) {
+    fields = g_list_append(fields, garrow_field_new("part", int_type));
+  }
+  fields = g_list_append(fields, garrow_field_new("name", string_type));
+  GArrowSchema* schema = garrow_schema_new(fields);
+  g_list_free_full(fields, g_object_unref);
+  g_object_unref(string_type);
+  g_object_unref(int_type);
+  g_object_unref(long_type);
+  return schema;
+}
+
+static GArrowRecordBatch* make_input(GArrowSchema* schema) {
+  GError* error = NULL;
+  GArrowInt64ArrayBuilder* ids = garrow_int64_array_builder_new();
+  GArrowStringArrayBuilder* names = garrow_string_array_builder_new();
+  const char* values[] = { "a", "b", "c" };
+  for (gint64 i = 0; i < 3; i++) {
+    garrow_int64_array_builder_append_value(ids, i, &error);
+    check_g_error(error);
+    garrow_string_array_builder_append_string(names, values[i], &error);
+    check_g_error(error);
+  }
+  GList* columns = NULL;
+  columns = g_list_append(columns, garrow_array_builder_finish(GARROW_ARRAY_BUILDER(ids), &error));
+  check_g_error(error);
+  columns =
+    g_list_append(columns, garrow_array_builder_finish(GARROW_ARRAY_BUILDER(names), &error));
+  check_g_error(error);
+  GArrowRecordBatch* batch = garrow_record_batch_new(schema, 3, columns, &error);
+  check_g_error(error);
+  g_list_free_full(columns, g_object_unref);
+  g_object_unref(names);
+  g_object_unref(ids);
+  return batch;
+}
+
+static BoundTransform* bind_expression(TransformPlanCache* cache, SharedExpression* expression) {
+  SharedExpressionBytecode* bytecode = serialize_expression(&expression);
+  ExpressionBytecodeView view = get_expression_bytecode(&bytecode);
+  BoundTransform* bound = bind_cached_transform(cache, &view);
+  free_expression_bytecode(bytecode);
+  free_kernel_expression(expression);
+  return bound;
+}
+
+// Apply `bound` to `input`, and check the result has `output_schema`, the columns of `input` and
+// a `part` column of `part`
+static void check_apply(BoundTransform* bound,
+                        GArrowRecordBatch* input,
+                        GArrowSchema* output_schema,
+                        gint32 part) {
+  GError* error = NULL;
+  GArrowRecordBatch* output = apply_bound_transform(bound, input, &error);
+  check_g_error(error);
+  GArrowSchema* schema = garrow_record_batch_get_schema(output);
+  CHECK(garrow_schema_equal(schema, output_schema));
+  g_object_unref(schema);
+  CHECK(garrow_record_batch_get_n_rows(output) == 3);
+  guint input_columns[] = { 0, 1 };
+  guint output_columns[] = { 0, 2 };
+  for (int i = 0; i < 2; i++) {
+    GArrowArray* expected = garrow_record_batch_get_column_data(input, input_columns[i]);
+    GArrowArray* actual = garrow_record_batch_get_column_data(output, output_columns[i]);
+    CHECK(garrow_array_equal(expected, actual));
+    g_object_unref(actual);
+    g_object_unref(expected);
+  }
+  GArrowArray* parts = garrow_record_batch_get_column_data(output, 1);
+  for (gint64 i = 0; i < 3; i++) {
+    CHECK(garrow_int32_array_get_value(GARROW_INT32_ARRAY(parts), i) == part);
+  }
+  g_object_unref(parts);
+  g_object_unref(output);
+}
+
+int main(void) {
+  GArrowSchema* input_schema = make_schema(FALSE);
+  GArrowSchema* output_schema = make_schema(TRUE);
+  GArrowRecordBatch* input = make_input(input_schema);
+  TransformPlanCache* cache = new_transform_plan_cache(input_schema, output_schema);
+
+  BoundTransform* first = bind_expression(cache, get_testing_kernel_transform(1));
+  CHECK(first != NULL);
+  CHECK(transform_plan_cache_size(cache) == 1);
+  BoundTransform* second = bind_expression(cache, get_testing_kernel_transform(2));
+  CHECK(second != NULL);
+  CHECK(transform_plan_cache_size(cache) == 1);
+
+  // the testing expression computes values, so it must be left to kernel
+  CHECK(bind_expression(cache, get_testing_kernel_expression()) == NULL);
+  CHECK(transform_plan_cache_size(cache) == 1);
+
+  // apply twice, so the second one uses the cached expanded literals
+  check_apply(first, input, output_schema, 1);
+  check_apply(first, input, output_schema, 1);
+  check_apply(second, input, output_schema, 2);
+
+  free_bound_transform(second);
+  free_bound_transform(first);
+  free_transform_plan_cache(cache);
+  g_object_unref(input);
+  g_object_unref(output_schema);
+  g_object_unref(input_schema);
+  printf("transform plan tests passed\n");
+  return 0;
+}
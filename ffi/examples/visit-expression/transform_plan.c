@@ -0,0 +1,744 @@
+#include "transform_plan.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef enum NodeKind {
+  // a (possibly nested) input column. `start` and `len` are its path of field indices in `paths`
+  NodeColumn,
+  // a literal. `start` is its index in `literals`
+  NodeLiteral,
+  // a struct. `start` and `len` are the node indices of its fields in `children`
+  NodeStruct,
+} NodeKind;
+
+typedef struct PlanNode {
+  NodeKind kind;
+  guint start;
+  guint len;
+} PlanNode;
+
+// The tree of nodes a transform evaluates, with column names already resolved to field indices.
+// Nodes are numbered in the order they are first visited when walking the output columns, so two
+// transforms have the same shape exactly when everything but the values of their literals matches
+typedef struct TransformLayout {
+  GArray* nodes;    // PlanNode
+  GArray* paths;    // gint
+  GArray* children; // guint
+  // the node of each output column
+  GArray* roots; // guint
+  // the instruction of each literal, which is only meaningful while its bytecode is alive
+  GArray* literals; // ExpressionInstruction
+} TransformLayout;
+
+struct TransformPlan {
+  TransformLayout layout;
+  GArrowSchema* input_schema;
+  GArrowSchema* output_schema;
+  // the output type of each node
+  GArrowDataType** node_types;
+};
+
+struct TransformPlanCache {
+  GArrowSchema* input_schema;
+  GArrowSchema* output_schema;
+  // shape hash -> GPtrArray of the plans with that hash. Different shapes rarely share a hash, so
+  // these are almost always of length one
+  GHashTable* plans;
+  guint num_plans;
+};
+
+struct BoundTransform {
+  const TransformPlan* plan;
+  // each literal of the transform, as an array of length one
+  GArrowArray** literals;
+  // each literal expanded to `num_rows` rows, or NULL if it hasn't been expanded yet
+  GArrowArray** expanded;
+  gint64 num_rows;
+  // `num_rows` zero indices, used to `take` the expanded literals. NULL until first needed
+  GArrowArray* zeros;
+};
+
+// A parsed `FieldInsert` or `FieldReplace`. Its operands are `len` node indices starting at `start`
+// in the parser's operand list
+typedef struct FieldTransformItem {
+  // NULL for the fields to prepend
+  const char* field_name;
+  bool is_replace;
+  guint start;
+  guint len;
+} FieldTransformItem;
+
+// An entry of the parse stack. Field transforms can only be the operands of a `Transform`
+typedef struct StackItem {
+  bool is_field_transform;
+  guint index;
+} StackItem;
+
+static void init_layout(TransformLayout* layout) {
+  layout->nodes = g_array_new(FALSE, FALSE, sizeof(PlanNode));
+  layout->paths = g_array_new(FALSE, FALSE, sizeof(gint));
+  layout->children = g_array_new(FALSE, FALSE, sizeof(guint));
+  layout->roots = g_array_new(FALSE, FALSE, sizeof(guint));
+  layout->literals = g_array_new(FALSE, FALSE, sizeof(ExpressionInstruction));
+}
+
+static void clear_layout(TransformLayout* layout) {
+  g_array_free(layout->nodes, TRUE);
+  g_array_free(layout->paths, TRUE);
+  g_array_free(layout->children, TRUE);
+  g_array_free(layout->roots, TRUE);
+  g_array_free(layout->literals, TRUE);
+}
+
+static guint add_node(TransformLayout* layout, NodeKind kind, guint start, guint len) {
+  PlanNode node = { kind, start, len };
+  g_array_append_val(layout->nodes, node);
+  return layout->nodes->len - 1;
+}
+
+static const char* pool_string(const ExpressionBytecodeView* view, uint64_t id) {
+  return (const char*)view->bytes + view->strings[id].offset;
+}
+
+// Append the path of field indices of the (dotted) column `name` in `schema` to `paths`. Returns
+// false if there is no such column. Names with backtick escaped parts would need a real parser to
+// split, and so are treated as missing
+static bool resolve_column(GArrowSchema* schema, const char* name, GArray* paths) {
+  if (name[0] == '\0' || strchr(name, '`')) {
+    return false;
+  }
+  gchar** parts = g_strsplit(name, ".", -1);
+  GArrowField* field = NULL;
+  bool found = true;
+  for (gchar** part = parts; found && *part; part++) {
+    GArrowField* child = NULL;
+    gint index = -1;
+    if (field == NULL) {
+      index = garrow_schema_get_field_index(schema, *part);
+      if (index >= 0) {
+        child = garrow_schema_get_field(schema, index);
+      }
+    } else {
+      GArrowDataType* type = garrow_field_get_data_type(field);
+      if (GARROW_IS_STRUCT_DATA_TYPE(type)) {
+        GArrowStructDataType* struct_type = GARROW_STRUCT_DATA_TYPE(type);
+        index = garrow_struct_data_type_get_field_index(struct_type, *part);
+        if (index >= 0) {
+          child = garrow_struct_data_type_get_field(struct_type, index);
+        }
+      }
+      g_object_unref(field);
+    }
+    field = child;
+    found = field != NULL;
+    if (found) {
+      g_array_append_val(paths, index);
+    }
+  }
+  if (field) {
+    g_object_unref(field);
+  }
+  g_strfreev(parts);
+  return found;
+}
+
+// Append the node indices of `len` stack items to `out`. Returns false if any of them is a field
+// transform
+static bool collect_nodes(const StackItem* items, guint len, GArray* out) {
+  for (guint i = 0; i < len; i++) {
+    if (items[i].is_field_transform) {
+      return false;
+    }
+    g_array_append_val(out, items[i].index);
+  }
+  return true;
+}
+
+static void append_roots(TransformLayout* layout,
+                         const FieldTransformItem* item,
+                         GArray* operands) {
+  g_array_append_vals(layout->roots, &g_array_index(operands, guint, item->start), item->len);
+}
+
+// Turn the field transforms of a top-level `Transform` into the list of output columns: each input
+// field in order, with fields inserted after it or replacing it. Returns false if a field transform
+// names a field the input doesn't have
+static bool resolve_transform(GArrowSchema* input_schema,
+                              const StackItem* items,
+                              guint len,
+                              GArray* field_transforms,
+                              GArray* operands,
+                              TransformLayout* layout) {
+  guint used = 0;
+  for (guint i = 0; i < len; i++) {
+    FieldTransformItem* item = &g_array_index(field_transforms, FieldTransformItem, items[i].index);
+    if (item->field_name == NULL) {
+      append_roots(layout, item, operands);
+      used++;
+    }
+  }
+  guint num_fields = garrow_schema_n_fields(input_schema);
+  for (guint f = 0; f < num_fields; f++) {
+    GArrowField* field = garrow_schema_get_field(input_schema, f);
+    const gchar* name = garrow_field_get_name(field);
+    const FieldTransformItem* match = NULL;
+    for (guint i = 0; match == NULL && i < len; i++) {
+      FieldTransformItem* item =
+        &g_array_index(field_transforms, FieldTransformItem, items[i].index);
+      if (item->field_name && strcmp(item->field_name, name) == 0) {
+        match = item;
+      }
+    }
+    g_object_unref(field);
+    if (match == NULL || !match->is_replace) {
+      gint index = (gint)f;
+      g_array_append_val(layout->paths, index);
+      guint column = add_node(layout, NodeColumn, layout->paths->len - 1, 1);
+      g_array_append_val(layout->roots, column);
+    }
+    if (match) {
+      append_roots(layout, match, operands);
+      used++;
+    }
+  }
+  return used == len;
+}
+
+// Copy the tree of node `index` of `from` into `to`, numbering its nodes in visiting order
+static guint copy_node(const TransformLayout* from, guint index, TransformLayout* to) {
+  PlanNode node = g_array_index(from->nodes, PlanNode, index);
+  switch (node.kind) {
+    case NodeColumn: {
+      guint start = to->paths->len;
+      g_array_append_vals(to->paths, &g_array_index(from->paths, gint, node.start), node.len);
+      return add_node(to, NodeColumn, start, node.len);
+    }
+    case NodeLiteral:
+      g_array_append_val(
+        to->literals, g_array_index(from->literals, ExpressionInstruction, node.start));
+      return add_node(to, NodeLiteral, to->literals->len - 1, 0);
+    case NodeStruct: {
+      // copy the fields first, so their indices end up next to each other in `to->children`
+      guint* fields = g_new(guint, node.len);
+      for (guint i = 0; i < node.len; i++) {
+        fields[i] = copy_node(from, g_array_index(from->children, guint, node.start + i), to);
+      }
+      guint start = to->children->len;
+      g_array_append_vals(to->children, fields, node.len);
+      g_free(fields);
+      return add_node(to, NodeStruct, start, node.len);
+    }
+  }
+  return 0;
+}
+
+// Parse the transform serialized in `view` into `layout`, resolving column names against
+// `input_schema`. Returns false if the transform isn't one we can compile.
+//
+// Kernel keeps the field transforms of a `Transform` in a hash map, so transforms of the same shape
+// can list them in different orders. We parse into a scratch layout first, and then copy it in
+// output column order, so that the result only depends on the shape of the transform
+static bool parse_transform(const ExpressionBytecodeView* view,
+                            GArrowSchema* input_schema,
+                            TransformLayout* layout) {
+  TransformLayout parsed;
+  init_layout(&parsed);
+  GArray* stack = g_array_sized_new(FALSE, FALSE, sizeof(StackItem), view->max_stack_depth);
+  GArray* field_transforms = g_array_new(FALSE, FALSE, sizeof(FieldTransformItem));
+  GArray* operands = g_array_new(FALSE, FALSE, sizeof(guint));
+  bool have_roots = false;
+  bool ok = true;
+  for (size_t i = 0; ok && i < view->num_instructions; i++) {
+    ExpressionInstruction instr = view->instructions[i];
+    if (instr.arity > stack->len) {
+      ok = false;
+      break;
+    }
+    guint first = stack->len - instr.arity;
+    const StackItem* args = (const StackItem*)stack->data + first;
+    StackItem result = { false, 0 };
+    switch (instr.op) {
+      case ExpressionOpCode_LiteralInt:
+      case ExpressionOpCode_LiteralLong:
+      case ExpressionOpCode_LiteralShort:
+      case ExpressionOpCode_LiteralByte:
+      case ExpressionOpCode_LiteralFloat:
+      case ExpressionOpCode_LiteralDouble:
+      case ExpressionOpCode_LiteralBool:
+      case ExpressionOpCode_LiteralTimestamp:
+      case ExpressionOpCode_LiteralTimestampNtz:
+      case ExpressionOpCode_LiteralDate:
+      case ExpressionOpCode_LiteralString:
+      case ExpressionOpCode_LiteralBinary:
+      case ExpressionOpCode_LiteralDecimal:
+      case ExpressionOpCode_LiteralNull:
+        g_array_append_val(parsed.literals, instr);
+        result.index = add_node(&parsed, NodeLiteral, parsed.literals->len - 1, 0);
+        break;
+      case ExpressionOpCode_Column: {
+        guint start = parsed.paths->len;
+        ok = resolve_column(input_schema, pool_string(view, instr.arg), parsed.paths);
+        result.index = add_node(&parsed, NodeColumn, start, parsed.paths->len - start);
+        break;
+      }
+      case ExpressionOpCode_Struct: {
+        guint start = parsed.children->len;
+        ok = collect_nodes(args, instr.arity, parsed.children);
+        result.index = add_node(&parsed, NodeStruct, start, instr.arity);
+        break;
+      }
+      case ExpressionOpCode_FieldInsert:
+      case ExpressionOpCode_FieldReplace: {
+        FieldTransformItem item = {
+          .field_name = instr.arg == UINT64_MAX ? NULL : pool_string(view, instr.arg),
+          .is_replace = instr.op == ExpressionOpCode_FieldReplace,
+          .start = operands->len,
+          .len = instr.arity,
+        };
+        ok = collect_nodes(args, instr.arity, operands);
+        g_array_append_val(field_transforms, item);
+        result.is_field_transform = true;
+        result.index = field_transforms->len - 1;
+        break;
+      }
+      case ExpressionOpCode_Transform:
+        // only a top-level transform of the top-level columns maps to whole batches
+        ok = i + 1 == view->num_instructions && instr.arg == 0;
+        for (guint a = 0; ok && a < instr.arity; a++) {
+          ok = args[a].is_field_transform;
+        }
+        ok = ok &&
+             resolve_transform(
+               input_schema, args, instr.arity, field_transforms, operands, &parsed);
+        have_roots = true;
+        break;
+      default:
+        // anything that computes values (or nested literals) is left to kernel
+        ok = false;
+        break;
+    }
+    g_array_set_size(stack, first);
+    g_array_append_val(stack, result);
+  }
+
+  if (ok && stack->len == 1 && !have_roots) {
+    // the only other top-level expression we can compile is a struct of the output columns
+    StackItem top = g_array_index(stack, StackItem, 0);
+    PlanNode node = g_array_index(parsed.nodes, PlanNode, top.index);
+    ok = !top.is_field_transform && node.kind == NodeStruct;
+    if (ok) {
+      g_array_append_vals(
+        parsed.roots, &g_array_index(parsed.children, guint, node.start), node.len);
+    }
+  } else {
+    ok = ok && stack->len == 1;
+  }
+  for (guint i = 0; ok && i < parsed.roots->len; i++) {
+    guint root = copy_node(&parsed, g_array_index(parsed.roots, guint, i), layout);
+    g_array_append_val(layout->roots, root);
+  }
+
+  g_array_free(operands, TRUE);
+  g_array_free(field_transforms, TRUE);
+  g_array_free(stack, TRUE);
+  clear_layout(&parsed);
+  return ok;
+}
+
+static bool arrays_equal(const GArray* a, const GArray* b, gsize element_size) {
+  return a->len == b->len && memcmp(a->data, b->data, a->len * element_size) == 0;
+}
+
+static bool same_shape(const TransformLayout* a, const TransformLayout* b) {
+  return arrays_equal(a->nodes, b->nodes, sizeof(PlanNode)) &&
+         arrays_equal(a->paths, b->paths, sizeof(gint)) &&
+         arrays_equal(a->children, b->children, sizeof(guint)) &&
+         arrays_equal(a->roots, b->roots, sizeof(guint)) && a->literals->len == b->literals->len;
+}
+
+// FNV-1a, continuing from `hash`
+static guint32 hash_bytes(guint32 hash, const void* data, gsize len) {
+  const guint8* bytes = data;
+  for (gsize i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// A hash of everything `same_shape` compares
+static guint32 shape_hash(const TransformLayout* layout) {
+  guint32 hash = 2166136261u;
+  hash = hash_bytes(hash, layout->nodes->data, layout->nodes->len * sizeof(PlanNode));
+  hash = hash_bytes(hash, layout->paths->data, layout->paths->len * sizeof(gint));
+  hash = hash_bytes(hash, layout->children->data, layout->children->len * sizeof(guint));
+  hash = hash_bytes(hash, layout->roots->data, layout->roots->len * sizeof(guint));
+  return hash_bytes(hash, &layout->literals->len, sizeof(guint));
+}
+
+// The type of the input column at `path`
+static GArrowDataType* column_type(GArrowSchema* schema, const gint* path, guint len) {
+  GArrowField* field = garrow_schema_get_field(schema, path[0]);
+  for (guint i = 1; i < len; i++) {
+    GArrowDataType* type = garrow_field_get_data_type(field);
+    GArrowField* child = garrow_struct_data_type_get_field(GARROW_STRUCT_DATA_TYPE(type), path[i]);
+    g_object_unref(field);
+    field = child;
+  }
+  GArrowDataType* type = g_object_ref(garrow_field_get_data_type(field));
+  g_object_unref(field);
+  return type;
+}
+
+// Check that node `index` of `plan` can produce a column of `type`, recording the types of it and
+// its children. Columns are not cast, so they must already have the output type
+static bool resolve_types(TransformPlan* plan, guint index, GArrowDataType* type) {
+  const TransformLayout* layout = &plan->layout;
+  PlanNode node = g_array_index(layout->nodes, PlanNode, index);
+  plan->node_types[index] = g_object_ref(type);
+  switch (node.kind) {
+    case NodeColumn: {
+      const gint* path = &g_array_index(layout->paths, gint, node.start);
+      GArrowDataType* input_type = column_type(plan->input_schema, path, node.len);
+      bool same = garrow_data_type_equal(input_type, type);
+      g_object_unref(input_type);
+      return same;
+    }
+    case NodeLiteral:
+      return true;
+    case NodeStruct: {
+      if (!GARROW_IS_STRUCT_DATA_TYPE(type)) {
+        return false;
+      }
+      GArrowStructDataType* struct_type = GARROW_STRUCT_DATA_TYPE(type);
+      bool ok = garrow_struct_data_type_get_n_fields(struct_type) == (gint)node.len;
+      for (guint i = 0; ok && i < node.len; i++) {
+        GArrowField* field = garrow_struct_data_type_get_field(struct_type, i);
+        guint child = g_array_index(layout->children, guint, node.start + i);
+        ok = resolve_types(plan, child, garrow_field_get_data_type(field));
+        g_object_unref(field);
+      }
+      return ok;
+    }
+  }
+  return false;
+}
+
+static void free_transform_plan(TransformPlan* plan) {
+  for (guint i = 0; i < plan->layout.nodes->len; i++) {
+    g_clear_object(&plan->node_types[i]);
+  }
+  g_free(plan->node_types);
+  clear_layout(&plan->layout);
+  g_object_unref(plan->input_schema);
+  g_object_unref(plan->output_schema);
+  g_free(plan);
+}
+
+// Compile a plan from a parsed `layout`, which the plan takes ownership of. Returns NULL if the
+// layout doesn't produce `output_schema`
+static TransformPlan* compile_transform_plan(TransformLayout layout,
+                                             GArrowSchema* input_schema,
+                                             GArrowSchema* output_schema) {
+  TransformPlan* plan = g_new0(TransformPlan, 1);
+  plan->layout = layout;
+  plan->input_schema = g_object_ref(input_schema);
+  plan->output_schema = g_object_ref(output_schema);
+  plan->node_types = g_new0(GArrowDataType*, layout.nodes->len);
+  bool ok = layout.roots->len == garrow_schema_n_fields(output_schema);
+  for (guint i = 0; ok && i < layout.roots->len; i++) {
+    GArrowField* field = garrow_schema_get_field(output_schema, i);
+    guint root = g_array_index(layout.roots, guint, i);
+    ok = resolve_types(plan, root, garrow_field_get_data_type(field));
+    g_object_unref(field);
+  }
+  if (!ok) {
+    free_transform_plan(plan);
+    return NULL;
+  }
+  return plan;
+}
+
+static float float_from_bits(uint64_t bits) {
+  uint32_t low = (uint32_t)bits;
+  float value;
+  memcpy(&value, &low, sizeof(value));
+  return value;
+}
+
+static double double_from_bits(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Build an array holding just the literal `instr`, which must be of `type`. Returns NULL without
+// setting `error` if it isn't. Decimals are only supported if their value fits in 64 bits
+static GArrowArray* literal_array(const ExpressionBytecodeView* view,
+                                  ExpressionInstruction instr,
+                                  GArrowDataType* type,
+                                  GError** error) {
+  GArrowArrayBuilder* builder = NULL;
+  gboolean appended = FALSE;
+  switch (instr.op) {
+#define SIMPLE_LITERAL(op_name, upper, lower, value)                                               \
+  case ExpressionOpCode_##op_name:                                                                 \
+    if (GARROW_IS_##upper##_DATA_TYPE(type)) {                                                     \
+      GArrow##upper##ArrayBuilder* typed = garrow_##lower##_array_builder_new();                   \
+      appended = garrow_##lower##_array_builder_append_value(typed, value, error);                 \
+      builder = GARROW_ARRAY_BUILDER(typed);                                                       \
+    }                                                                                              \
+    break;
+    SIMPLE_LITERAL(LiteralInt, INT32, int32, (gint32)instr.arg)
+    SIMPLE_LITERAL(LiteralLong, INT64, int64, (gint64)instr.arg)
+    SIMPLE_LITERAL(LiteralShort, INT16, int16, (gint16)instr.arg)
+    SIMPLE_LITERAL(LiteralByte, INT8, int8, (gint8)instr.arg)
+    SIMPLE_LITERAL(LiteralFloat, FLOAT, float, float_from_bits(instr.arg))
+    SIMPLE_LITERAL(LiteralDouble, DOUBLE, double, double_from_bits(instr.arg))
+    SIMPLE_LITERAL(LiteralBool, BOOLEAN, boolean, instr.arg != 0)
+    SIMPLE_LITERAL(LiteralDate, DATE32, date32, (gint32)instr.arg)
+#undef SIMPLE_LITERAL
+    case ExpressionOpCode_LiteralTimestamp:
+    case ExpressionOpCode_LiteralTimestampNtz:
+      if (GARROW_IS_TIMESTAMP_DATA_TYPE(type) &&
+          garrow_timestamp_data_type_get_unit(GARROW_TIMESTAMP_DATA_TYPE(type)) ==
+            GARROW_TIME_UNIT_MICRO) {
+        GArrowTimestampArrayBuilder* typed =
+          garrow_timestamp_array_builder_new(GARROW_TIMESTAMP_DATA_TYPE(type));
+        appended = garrow_timestamp_array_builder_append_value(typed, (gint64)instr.arg, error);
+        builder = GARROW_ARRAY_BUILDER(typed);
+      }
+      break;
+    case ExpressionOpCode_LiteralString:
+    case ExpressionOpCode_LiteralBinary: {
+      const guint8* data = (const guint8*)pool_string(view, instr.arg);
+      gint32 len = (gint32)view->strings[instr.arg].len;
+      if (instr.op == ExpressionOpCode_LiteralString && GARROW_IS_STRING_DATA_TYPE(type)) {
+        builder = GARROW_ARRAY_BUILDER(garrow_string_array_builder_new());
+      } else if (instr.op == ExpressionOpCode_LiteralBinary && GARROW_IS_BINARY_DATA_TYPE(type)) {
+        builder = GARROW_ARRAY_BUILDER(garrow_binary_array_builder_new());
+      }
+      if (builder) {
+        // string builders are binary builders that check their values are utf8
+        appended = garrow_binary_array_builder_append_value(
+          GARROW_BINARY_ARRAY_BUILDER(builder), data, len, error);
+      }
+      break;
+    }
+    case ExpressionOpCode_LiteralDecimal: {
+      ExpressionDecimal dec = view->decimals[instr.arg];
+      bool fits = (dec.value_ms == 0 && dec.value_ls <= INT64_MAX) ||
+                  (dec.value_ms == -1 && dec.value_ls > INT64_MAX);
+      if (fits && GARROW_IS_DECIMAL128_DATA_TYPE(type) &&
+          garrow_decimal_data_type_get_precision(GARROW_DECIMAL_DATA_TYPE(type)) == dec.precision &&
+          garrow_decimal_data_type_get_scale(GARROW_DECIMAL_DATA_TYPE(type)) == dec.scale) {
+        GArrowDecimal128ArrayBuilder* typed =
+          garrow_decimal128_array_builder_new(GARROW_DECIMAL128_DATA_TYPE(type));
+        GArrowDecimal128* value = garrow_decimal128_new_integer((gint64)dec.value_ls);
+        appended = garrow_decimal128_array_builder_append_value(typed, value, error);
+        g_object_unref(value);
+        builder = GARROW_ARRAY_BUILDER(typed);
+      }
+      break;
+    }
+    case ExpressionOpCode_LiteralNull: {
+      // the type of a null literal isn't part of the bytecode, so make a null of the output type
+      GArrowArray* nulls = GARROW_ARRAY(garrow_null_array_new(1));
+      GArrowArray* array = garrow_array_cast(nulls, type, NULL, error);
+      g_object_unref(nulls);
+      return array;
+    }
+    default:
+      break;
+  }
+  if (builder == NULL) {
+    return NULL;
+  }
+  GArrowArray* array = appended ? garrow_array_builder_finish(builder, error) : NULL;
+  g_object_unref(builder);
+  return array;
+}
+
+// Bind `plan` to the literals of `layout`, which must have the shape of the plan and be parsed from
+// `view`
+static BoundTransform* bind_transform_plan(const TransformPlan* plan,
+                                           const TransformLayout* layout,
+                                           const ExpressionBytecodeView* view) {
+  guint num_literals = layout->literals->len;
+  BoundTransform* bound = g_new0(BoundTransform, 1);
+  bound->plan = plan;
+  bound->literals = g_new0(GArrowArray*, num_literals);
+  bound->expanded = g_new0(GArrowArray*, num_literals);
+  bound->num_rows = -1;
+  for (guint i = 0; bound && i < layout->nodes->len; i++) {
+    PlanNode node = g_array_index(layout->nodes, PlanNode, i);
+    if (node.kind != NodeLiteral) {
+      continue;
+    }
+    ExpressionInstruction instr =
+      g_array_index(layout->literals, ExpressionInstruction, node.start);
+    GError* error = NULL;
+    bound->literals[node.start] = literal_array(view, instr, plan->node_types[i], &error);
+    if (bound->literals[node.start] == NULL) {
+      // e.g. a literal of another type than the plan's. Kernel will evaluate this one instead
+      g_clear_error(&error);
+      free_bound_transform(g_steal_pointer(&bound));
+    }
+  }
+  return bound;
+}
+
+TransformPlanCache* new_transform_plan_cache(GArrowSchema* input_schema,
+                                             GArrowSchema* output_schema) {
+  TransformPlanCache* cache = g_new0(TransformPlanCache, 1);
+  cache->input_schema = g_object_ref(input_schema);
+  cache->output_schema = g_object_ref(output_schema);
+  cache->plans = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify)g_ptr_array_unref);
+  return cache;
+}
+
+BoundTransform* bind_cached_transform(TransformPlanCache* cache,
+                                      const ExpressionBytecodeView* view) {
+  TransformLayout layout;
+  init_layout(&layout);
+  if (!parse_transform(view, cache->input_schema, &layout)) {
+    clear_layout(&layout);
+    return NULL;
+  }
+  gpointer hash = GUINT_TO_POINTER(shape_hash(&layout));
+  GPtrArray* plans = g_hash_table_lookup(cache->plans, hash);
+  for (guint i = 0; plans && i < plans->len; i++) {
+    const TransformPlan* plan = g_ptr_array_index(plans, i);
+    if (same_shape(&plan->layout, &layout)) {
+      BoundTransform* bound = bind_transform_plan(plan, &layout, view);
+      clear_layout(&layout);
+      return bound;
+    }
+  }
+  // a new shape. The plan takes the layout, whose literals are still those of `view`
+  TransformPlan* plan = compile_transform_plan(layout, cache->input_schema, cache->output_schema);
+  if (plan == NULL) {
+    return NULL;
+  }
+  if (plans == NULL) {
+    plans = g_ptr_array_new_with_free_func((GDestroyNotify)free_transform_plan);
+    g_hash_table_insert(cache->plans, hash, plans);
+  }
+  g_ptr_array_add(plans, plan);
+  cache->num_plans++;
+  return bind_transform_plan(plan, &plan->layout, view);
+}
+
+guint transform_plan_cache_size(const TransformPlanCache* cache) {
+  return cache->num_plans;
+}
+
+void free_transform_plan_cache(TransformPlanCache* cache) {
+  g_hash_table_destroy(cache->plans);
+  g_object_unref(cache->input_schema);
+  g_object_unref(cache->output_schema);
+  g_free(cache);
+}
+
+// Drop the literals expanded for the current number of rows
+static void clear_expanded(BoundTransform* bound) {
+  for (guint i = 0; i < bound->plan->layout.literals->len; i++) {
+    g_clear_object(&bound->expanded[i]);
+  }
+  g_clear_object(&bound->zeros);
+}
+
+void free_bound_transform(BoundTransform* bound) {
+  clear_expanded(bound);
+  for (guint i = 0; i < bound->plan->layout.literals->len; i++) {
+    g_clear_object(&bound->literals[i]);
+  }
+  g_free(bound->literals);
+  g_free(bound->expanded);
+  g_free(bound);
+}
+
+// Get literal `index` as a column of `bound->num_rows` rows
+static GArrowArray* expand_literal(BoundTransform* bound, guint index, GError** error) {
+  if (bound->expanded[index] == NULL) {
+    if (bound->zeros == NULL) {
+      gsize size = bound->num_rows * sizeof(guint32);
+      GBytes* bytes = g_bytes_new_take(g_malloc0(size), size);
+      GArrowBuffer* data = garrow_buffer_new_bytes(bytes);
+      g_bytes_unref(bytes);
+      bound->zeros = GARROW_ARRAY(garrow_uint32_array_new(bound->num_rows, data, NULL, 0));
+      g_object_unref(data);
+    }
+    bound->expanded[index] = garrow_array_take(bound->literals[index], bound->zeros, NULL, error);
+    if (bound->expanded[index] == NULL) {
+      return NULL;
+    }
+  }
+  return g_object_ref(bound->expanded[index]);
+}
+
+static GArrowArray* evaluate_node(BoundTransform* bound,
+                                  GArrowRecordBatch* input,
+                                  guint index,
+                                  GError** error) {
+  const TransformLayout* layout = &bound->plan->layout;
+  PlanNode node = g_array_index(layout->nodes, PlanNode, index);
+  switch (node.kind) {
+    case NodeColumn: {
+      const gint* path = &g_array_index(layout->paths, gint, node.start);
+      GArrowArray* array = garrow_record_batch_get_column_data(input, path[0]);
+      for (guint i = 1; i < node.len; i++) {
+        GArrowArray* child = garrow_struct_array_get_field(GARROW_STRUCT_ARRAY(array), path[i]);
+        g_object_unref(array);
+        array = child;
+      }
+      return array;
+    }
+    case NodeLiteral:
+      return expand_literal(bound, node.start, error);
+    case NodeStruct: {
+      GList* fields = NULL;
+      for (guint i = 0; i < node.len; i++) {
+        guint child = g_array_index(layout->children, guint, node.start + i);
+        GArrowArray* field = evaluate_node(bound, input, child, error);
+        if (field == NULL) {
+          g_list_free_full(fields, g_object_unref);
+          return NULL;
+        }
+        fields = g_list_prepend(fields, field);
+      }
+      fields = g_list_reverse(fields);
+      GArrowStructArray* array =
+        garrow_struct_array_new(bound->plan->node_types[index], bound->num_rows, fields, NULL, 0);
+      g_list_free_full(fields, g_object_unref);
+      return GARROW_ARRAY(array);
+    }
+  }
+  return NULL;
+}
+
+GArrowRecordBatch* apply_bound_transform(BoundTransform* bound,
+                                         GArrowRecordBatch* input,
+                                         GError** error) {
+  gint64 num_rows = garrow_record_batch_get_n_rows(input);
+  if (num_rows != bound->num_rows) {
+    // all but the last batch of a file usually have the same size, so this is rare
+    clear_expanded(bound);
+    bound->num_rows = num_rows;
+  }
+  const TransformLayout* layout = &bound->plan->layout;
+  GList* columns = NULL;
+  for (guint i = 0; i < layout->roots->len; i++) {
+    guint root = g_array_index(layout->roots, guint, i);
+    GArrowArray* column = evaluate_node(bound, input, root, error);
+    if (column == NULL) {
+      g_list_free_full(columns, g_object_unref);
+      return NULL;
+    }
+    columns = g_list_prepend(columns, column);
+  }
+  columns = g_list_reverse(columns);
+  GArrowRecordBatch* output =
+    garrow_record_batch_new(bound->plan->output_schema, (guint32)num_rows, columns, error);
+  g_list_free_full(columns, g_object_unref);
+  return output;
+}
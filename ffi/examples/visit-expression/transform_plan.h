@@ -0,0 +1,47 @@
+// This file contains a compiler from kernel's per-file transform expressions to arrow-glib calls.
+// read_table uses it instead of kernel's expression evaluator when run with --compiled-transforms
+#pragma once
+
+#include "delta_kernel_ffi.h"
+
+#include <glib.h>
+#include <arrow-glib/arrow-glib.h>
+
+// A transform compiled against a pair of input and output schemas. The plan only describes the
+// "shape" of the transform: which input columns end up where in the output, and the types of the
+// literals it inserts. The literal values themselves are bound per file, so one plan serves every
+// file whose transform has the same shape, e.g. every file of a partitioned table. A plan is never
+// modified after it is compiled, and so can be shared by reads running on any thread
+typedef struct TransformPlan TransformPlan;
+
+// A plan bound to the literal values of one file's transform. Expanded literal columns are cached,
+// so applying it to the many (typically equally sized) batches of a file only builds them once. A
+// bound transform must only be used by one thread at a time
+typedef struct BoundTransform BoundTransform;
+
+// The plans compiled for transforms from one input schema to one output schema, keyed by a hash of
+// their shape. Finding the plan of a transform therefore takes one parse of the transform and
+// (almost always) one comparison, no matter how many plans the cache holds. The cache owns its
+// plans, and must outlive every transform bound through it. It must only be used by one thread at
+// a time, but the transforms it binds can be applied on any thread
+typedef struct TransformPlanCache TransformPlanCache;
+
+TransformPlanCache* new_transform_plan_cache(GArrowSchema* input_schema,
+                                             GArrowSchema* output_schema);
+// Bind the transform serialized in `view` to the plan of its shape, compiling a new plan if the
+// cache has none. Supported transforms are a top-level `Transform` or `Struct` expression whose
+// fields are column references, primitive literals (including nulls) or nested `Struct`s of those,
+// which covers the transforms kernel uses to insert partition values. Returns NULL if the transform
+// uses anything else, in which case it must be evaluated by kernel. The view is only used during
+// the call
+BoundTransform* bind_cached_transform(TransformPlanCache* cache,
+                                      const ExpressionBytecodeView* view);
+// The number of plans compiled so far
+guint transform_plan_cache_size(const TransformPlanCache* cache);
+void free_transform_plan_cache(TransformPlanCache* cache);
+
+// Apply a bound transform to a batch read from a file. Returns NULL and sets `error` on failure
+GArrowRecordBatch* apply_bound_transform(BoundTransform* bound,
+                                         GArrowRecordBatch* input,
+                                         GError** error);
+void free_bound_transform(BoundTransform* bound);
@@ -1,18 +1,41 @@
 #include "delta_kernel_ffi.h"
 #include "expression.h"
+#include "expression_bytecode.h"
 #include "expression_print.h"
 
-int main() {
+// Print the kernel's test expression and predicate. With `--bytecode` they are decoded from their
+// serialized bytecode instead of built with the expression visitor. Both must print the same output.
+int main(int argc, char* argv[]) {
+  bool use_bytecode = argc > 1 && strcmp(argv[1], "--bytecode") == 0;
+
   SharedExpression* expr = get_testing_kernel_expression();
-  ExpressionItemList expr_list = construct_expression(expr);
-  print_expression(expr_list);
-  free_expression_list(expr_list);
+  if (use_bytecode) {
+    SharedExpressionBytecode* bytecode = serialize_expression(&expr);
+    ExpressionBytecodeView view = get_expression_bytecode(&bytecode);
+    DecodedExpression decoded = decode_expression_bytecode(&view);
+    print_expression(decoded.expression);
+    free_decoded_expression(decoded);
+    free_expression_bytecode(bytecode);
+  } else {
+    ExpressionItemList expr_list = construct_expression(expr);
+    print_expression(expr_list);
+    free_expression_list(expr_list);
+  }
   free_kernel_expression(expr);
 
   SharedPredicate* pred = get_testing_kernel_predicate();
-  ExpressionItemList pred_list = construct_predicate(pred);
-  print_expression(pred_list);
-  free_expression_list(pred_list);
+  if (use_bytecode) {
+    SharedExpressionBytecode* bytecode = serialize_predicate(&pred);
+    ExpressionBytecodeView view = get_expression_bytecode(&bytecode);
+    DecodedExpression decoded = decode_expression_bytecode(&view);
+    print_expression(decoded.expression);
+    free_decoded_expression(decoded);
+    free_expression_bytecode(bytecode);
+  } else {
+    ExpressionItemList pred_list = construct_predicate(pred);
+    print_expression(pred_list);
+    free_expression_list(pred_list);
+  }
   free_kernel_predicate(pred);
   return 0;
 }
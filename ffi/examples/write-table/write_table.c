@@ -0,0 +1,597 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <arrow-glib/arrow-glib.h>
+#include <parquet-glib/parquet-glib.h>
+
+#include "delta_kernel_ffi.h"
+#include "kernel_utils.h"
+
+// Simple example of appending data to a table using kernel's cffi. The data, read from an arrow IPC
+// stream, is split up by partition, written to parquet files on a pool of threads, and then added
+// to the table in a single commit.
+
+// One parquet file to write, and what kernel needs to know about it once it's written
+typedef struct FileTask
+{
+  GArrowRecordBatch* data;
+  // path relative to the table root, e.g. "part=a/part-00000-<uuid>.parquet". Partition values are
+  // escaped, see `append_escaped`
+  char* path;
+  // the value of each partition column in this file, NULL for a null value
+  char** partition_values;
+  uintptr_t num_partition_values;
+  int64_t num_rows;
+  int64_t size;
+  int64_t modification_time;
+  // set by the worker that wrote the file
+  bool ok;
+} FileTask;
+
+typedef struct WriteContext
+{
+  char* table_dir;
+  uintptr_t num_partition_cols;
+  char** partition_cols;
+} WriteContext;
+
+// All the rows of an input batch that belong to one partition
+typedef struct PartitionGroup
+{
+  char* dir;
+  char** values;
+  GArray* rows;
+} PartitionGroup;
+
+static bool report_g_error(const char* msg, GError* error)
+{
+  if (error != NULL) {
+    printf("%s: %s\n", msg, error->message);
+    g_error_free(error);
+    return true;
+  }
+  return false;
+}
+
+static void visit_partition(void* context, const KernelStringSlice partition)
+{
+  WriteContext* write_context = context;
+  write_context->partition_cols[write_context->num_partition_cols++] = allocate_string(partition);
+}
+
+// Runs on the write pool. Writes one file and records its size and modification time
+static void write_task_worker(gpointer data, gpointer user_data)
+{
+  FileTask* task = data;
+  WriteContext* context = user_data;
+  char* full_path = g_build_filename(context->table_dir, task->path, NULL);
+  char* dir = g_path_get_dirname(full_path);
+  g_mkdir_with_parents(dir, 0755);
+  g_free(dir);
+
+  GError* error = NULL;
+  GArrowSchema* schema = garrow_record_batch_get_schema(task->data);
+  GArrowTable* table = garrow_table_new_record_batches(schema, &task->data, 1, &error);
+  if (!report_g_error("Can't create table to write", error)) {
+    GParquetArrowFileWriter* writer =
+      gparquet_arrow_file_writer_new_path(schema, full_path, NULL, &error);
+    if (!report_g_error("Can't open parquet file", error)) {
+      gparquet_arrow_file_writer_write_table(writer, table, task->num_rows, &error);
+      if (!report_g_error("Can't write parquet file", error)) {
+        gparquet_arrow_file_writer_close(writer, &error);
+        task->ok = !report_g_error("Can't close parquet file", error);
+      }
+      g_object_unref(writer);
+    }
+    g_object_unref(table);
+  }
+  g_object_unref(schema);
+
+  struct stat file_stat;
+  if (task->ok && stat(full_path, &file_stat) == 0) {
+    task->size = file_stat.st_size;
+    task->modification_time = (int64_t)file_stat.st_mtime * 1000;
+  } else {
+    task->ok = false;
+  }
+  g_free(full_path);
+}
+
+static void free_partition_group(gpointer data)
+{
+  PartitionGroup* group = data;
+  g_free(group->dir);
+  g_array_free(group->rows, TRUE);
+  free(group);
+}
+
+// Append `name` to a partition directory, escaped the way Hive (and with it Spark and the other
+// Delta writers) escapes partition directories: characters that are special in paths or URIs become
+// a `%` followed by their hex code
+static void append_escaped(GString* dir, const char* name)
+{
+  for (const char* c = name; *c; c++) {
+    unsigned char ch = (unsigned char)*c;
+    if (ch < 0x20 || ch == 0x7F || strchr(" \"#%'*/:=?\\[]^{}", ch)) {
+      g_string_append_printf(dir, "%%%02X", ch);
+    } else {
+      g_string_append_c(dir, *c);
+    }
+  }
+}
+
+// Split `batch` by the values of its partition columns, which are removed from the split batches.
+// Each distinct partition gets its own files of at most `rows_per_file` rows, appended to `tasks`
+static bool plan_files(
+  WriteContext* context,
+  GArrowRecordBatch* batch,
+  int64_t rows_per_file,
+  GPtrArray* tasks)
+{
+  GError* error = NULL;
+  int64_t num_rows = garrow_record_batch_get_n_rows(batch);
+  uintptr_t num_cols = context->num_partition_cols;
+  GArrowArray** values = malloc(sizeof(GArrowArray*) * (num_cols + 1));
+  GArrowDataType* string_type = GARROW_DATA_TYPE(garrow_string_data_type_new());
+  GArrowSchema* schema = garrow_record_batch_get_schema(batch);
+  GArrowRecordBatch* data = g_object_ref(batch);
+  uintptr_t num_values = 0;
+  bool ok = true;
+  for (uintptr_t c = 0; c < num_cols && ok; c++) {
+    gint index = garrow_schema_get_field_index(schema, context->partition_cols[c]);
+    if (index < 0) {
+      printf("Input has no partition column '%s'\n", context->partition_cols[c]);
+      ok = false;
+      break;
+    }
+    GArrowArray* column = garrow_record_batch_get_column_data(batch, index);
+    values[c] = garrow_array_cast(column, string_type, NULL, &error);
+    g_object_unref(column);
+    if (report_g_error("Can't cast partition column to string", error)) {
+      ok = false;
+      break;
+    }
+    num_values++;
+    // data files don't contain the partition columns
+    GArrowSchema* data_schema = garrow_record_batch_get_schema(data);
+    index = garrow_schema_get_field_index(data_schema, context->partition_cols[c]);
+    g_object_unref(data_schema);
+    GArrowRecordBatch* without = garrow_record_batch_remove_column(data, index, &error);
+    g_object_unref(data);
+    data = without;
+    ok = !report_g_error("Can't remove partition column", error);
+  }
+  g_object_unref(schema);
+  g_object_unref(string_type);
+  if (!ok) {
+    for (uintptr_t c = 0; c < num_values; c++) {
+      g_object_unref(values[c]);
+    }
+    free(values);
+    g_clear_object(&data);
+    return false;
+  }
+
+  // find the rows of each partition, keeping the partitions in the order they first appear
+  GHashTable* groups_by_dir = g_hash_table_new(g_str_hash, g_str_equal);
+  GPtrArray* groups = g_ptr_array_new_with_free_func(free_partition_group);
+  for (int64_t row = 0; row < num_rows; row++) {
+    char** row_values = calloc(num_cols, sizeof(char*));
+    GString* dir = g_string_new(NULL);
+    for (uintptr_t c = 0; c < num_cols; c++) {
+      if (!garrow_array_is_null(values[c], row)) {
+        row_values[c] = garrow_string_array_get_string(GARROW_STRING_ARRAY(values[c]), row);
+      }
+      append_escaped(dir, context->partition_cols[c]);
+      g_string_append_c(dir, '=');
+      append_escaped(dir, row_values[c] ? row_values[c] : "__HIVE_DEFAULT_PARTITION__");
+      g_string_append_c(dir, '/');
+    }
+    PartitionGroup* group = g_hash_table_lookup(groups_by_dir, dir->str);
+    if (group == NULL) {
+      group = malloc(sizeof(PartitionGroup));
+      group->dir = g_string_free(dir, FALSE);
+      group->values = row_values;
+      group->rows = g_array_new(FALSE, FALSE, sizeof(gint64));
+      g_hash_table_insert(groups_by_dir, group->dir, group);
+      g_ptr_array_add(groups, group);
+    } else {
+      g_string_free(dir, TRUE);
+      for (uintptr_t c = 0; c < num_cols; c++) {
+        g_free(row_values[c]);
+      }
+      free(row_values);
+    }
+    gint64 index = row;
+    g_array_append_val(group->rows, index);
+  }
+  g_hash_table_destroy(groups_by_dir);
+  for (uintptr_t c = 0; c < num_cols; c++) {
+    g_object_unref(values[c]);
+  }
+  free(values);
+
+  for (guint g = 0; g < groups->len && ok; g++) {
+    PartitionGroup* group = g_ptr_array_index(groups, g);
+    GArrowRecordBatch* rows = NULL;
+    if (num_cols == 0) {
+      rows = g_object_ref(data);
+    } else {
+      GArrowInt64ArrayBuilder* builder = garrow_int64_array_builder_new();
+      garrow_int64_array_builder_append_values(
+        builder, (const gint64*)group->rows->data, group->rows->len, NULL, 0, &error);
+      GArrowArray* indices = NULL;
+      if (!report_g_error("Can't build row indices", error)) {
+        indices = garrow_array_builder_finish(GARROW_ARRAY_BUILDER(builder), &error);
+      }
+      g_object_unref(builder);
+      if (indices != NULL && !report_g_error("Can't build row indices", error)) {
+        rows = garrow_record_batch_take(data, indices, NULL, &error);
+        g_object_unref(indices);
+        report_g_error("Can't select partition rows", error);
+      }
+    }
+    if (rows == NULL) {
+      ok = false;
+      break;
+    }
+    int64_t group_rows = garrow_record_batch_get_n_rows(rows);
+    for (int64_t offset = 0; offset < group_rows; offset += rows_per_file) {
+      FileTask* task = calloc(1, sizeof(FileTask));
+      task->num_rows = MIN(rows_per_file, group_rows - offset);
+      task->data = garrow_record_batch_slice(rows, offset, task->num_rows);
+      char* uuid = g_uuid_string_random();
+      task->path = g_strdup_printf("%spart-%05u-%s.parquet", group->dir, tasks->len, uuid);
+      g_free(uuid);
+      task->num_partition_values = num_cols;
+      task->partition_values = calloc(num_cols, sizeof(char*));
+      for (uintptr_t c = 0; c < num_cols; c++) {
+        task->partition_values[c] = g_strdup(group->values[c]);
+      }
+      g_ptr_array_add(tasks, task);
+    }
+    g_object_unref(rows);
+  }
+  for (guint g = 0; g < groups->len; g++) {
+    PartitionGroup* group = g_ptr_array_index(groups, g);
+    for (uintptr_t c = 0; c < num_cols; c++) {
+      g_free(group->values[c]);
+    }
+    free(group->values);
+  }
+  g_ptr_array_free(groups, TRUE);
+  g_object_unref(data);
+  return ok;
+}
+
+static void free_file_task(gpointer data)
+{
+  FileTask* task = data;
+  g_clear_object(&task->data);
+  g_free(task->path);
+  for (uintptr_t c = 0; c < task->num_partition_values; c++) {
+    g_free(task->partition_values[c]);
+  }
+  free(task->partition_values);
+  free(task);
+}
+
+static GArrowArray* finish_builder(gpointer builder, GError** error)
+{
+  GArrowArray* array = garrow_array_builder_finish(GARROW_ARRAY_BUILDER(builder), error);
+  g_object_unref(builder);
+  return array;
+}
+
+// Build the metadata of all the written files as one batch in the layout of kernel's
+// `add_files_schema`, so that they can all be added to the transaction with one call
+static GArrowRecordBatch* build_add_files_batch(WriteContext* context, GPtrArray* tasks)
+{
+  GError* error = NULL;
+  GArrowStringArrayBuilder* paths = garrow_string_array_builder_new();
+  GArrowDataType* string_type = GARROW_DATA_TYPE(garrow_string_data_type_new());
+  GArrowMapDataType* map_type = garrow_map_data_type_new(string_type, string_type);
+  GArrowMapArrayBuilder* partition_values = garrow_map_array_builder_new(map_type, &error);
+  if (report_g_error("Can't create partition values builder", error)) {
+    g_object_unref(paths);
+    g_object_unref(map_type);
+    g_object_unref(string_type);
+    return NULL;
+  }
+  GArrowArrayBuilder* keys = garrow_map_array_builder_get_key_builder(partition_values);
+  GArrowArrayBuilder* items = garrow_map_array_builder_get_item_builder(partition_values);
+  GArrowInt64ArrayBuilder* sizes = garrow_int64_array_builder_new();
+  GArrowInt64ArrayBuilder* modification_times = garrow_int64_array_builder_new();
+  GArrowBooleanArrayBuilder* data_changes = garrow_boolean_array_builder_new();
+  GArrowInt64ArrayBuilder* num_records = garrow_int64_array_builder_new();
+
+  for (guint i = 0; i < tasks->len && error == NULL; i++) {
+    FileTask* task = g_ptr_array_index(tasks, i);
+    // paths in the log are URIs, so the `%`s of escaped directories are escaped once more
+    char* uri_path = g_uri_escape_string(task->path, "/", FALSE);
+    garrow_string_array_builder_append_string(paths, uri_path, &error);
+    g_free(uri_path);
+    garrow_map_array_builder_append_value(partition_values, &error);
+    for (uintptr_t c = 0; c < context->num_partition_cols && error == NULL; c++) {
+      garrow_string_array_builder_append_string(
+        GARROW_STRING_ARRAY_BUILDER(keys), context->partition_cols[c], &error);
+      if (task->partition_values[c]) {
+        garrow_string_array_builder_append_string(
+          GARROW_STRING_ARRAY_BUILDER(items), task->partition_values[c], &error);
+      } else {
+        garrow_array_builder_append_null(items, &error);
+      }
+    }
+    garrow_int64_array_builder_append_value(sizes, task->size, &error);
+    garrow_int64_array_builder_append_value(modification_times, task->modification_time, &error);
+    garrow_boolean_array_builder_append_value(data_changes, TRUE, &error);
+    garrow_int64_array_builder_append_value(num_records, task->num_rows, &error);
+  }
+  GArrowArray* columns[6] = { NULL };
+  if (error == NULL) {
+    columns[0] = finish_builder(paths, &error);
+    columns[1] = finish_builder(partition_values, &error);
+    columns[2] = finish_builder(sizes, &error);
+    columns[3] = finish_builder(modification_times, &error);
+    columns[4] = finish_builder(data_changes, &error);
+    GArrowArray* num_records_array = finish_builder(num_records, &error);
+    GArrowDataType* int64_type = GARROW_DATA_TYPE(garrow_int64_data_type_new());
+    GList* stats_fields = g_list_append(NULL, garrow_field_new("numRecords", int64_type));
+    g_object_unref(int64_type);
+    GArrowStructDataType* stats_type = garrow_struct_data_type_new(stats_fields);
+    GList* stats_children = g_list_append(NULL, num_records_array);
+    columns[5] = GARROW_ARRAY(garrow_struct_array_new(
+      GARROW_DATA_TYPE(stats_type), tasks->len, stats_children, NULL, 0));
+    g_list_free(stats_children);
+    g_clear_object(&num_records_array);
+    g_list_free_full(stats_fields, g_object_unref);
+    g_object_unref(stats_type);
+  } else {
+    g_object_unref(paths);
+    g_object_unref(partition_values);
+    g_object_unref(sizes);
+    g_object_unref(modification_times);
+    g_object_unref(data_changes);
+    g_object_unref(num_records);
+  }
+
+  GArrowRecordBatch* batch = NULL;
+  if (!report_g_error("Can't build file metadata", error)) {
+    // kernel requires everything but the stats to be non-null
+    const char* names[6] = {
+      "path", "partitionValues", "size", "modificationTime", "dataChange", "stats"
+    };
+    GList* fields = NULL;
+    GList* arrays = NULL;
+    for (int i = 0; i < 6; i++) {
+      GArrowDataType* type = garrow_array_get_value_data_type(columns[i]);
+      fields = g_list_append(fields, garrow_field_new_full(names[i], type, i == 5));
+      arrays = g_list_append(arrays, columns[i]);
+      g_object_unref(type);
+    }
+    GArrowSchema* schema = garrow_schema_new(fields);
+    batch = garrow_record_batch_new(schema, tasks->len, arrays, &error);
+    report_g_error("Can't build file metadata batch", error);
+    g_object_unref(schema);
+    g_list_free_full(fields, g_object_unref);
+    g_list_free(arrays);
+  }
+  for (int i = 0; i < 6; i++) {
+    g_clear_object(&columns[i]);
+  }
+  g_object_unref(map_type);
+  g_object_unref(string_type);
+  return batch;
+}
+
+// Hand the file metadata to kernel over the C data interface. Kernel takes ownership of the array,
+// but only borrows the schema, which we release again afterwards
+static bool add_files_to_transaction(
+  ExclusiveTransaction* txn,
+  SharedExternEngine* engine,
+  GArrowRecordBatch* batch)
+{
+  gpointer c_array = NULL;
+  gpointer c_schema = NULL;
+  GError* error = NULL;
+  if (!garrow_record_batch_export(batch, &c_array, &c_schema, &error)) {
+    report_g_error("Can't export file metadata", error);
+    return false;
+  }
+  ExternResultusize res =
+    add_files_arrow(txn, *(FFI_ArrowArray*)c_array, (FFI_ArrowSchema*)c_schema, engine);
+  // the array struct was moved into kernel, so only its shell is left to free
+  g_free(c_array);
+  FFI_ArrowSchema* schema = c_schema;
+  schema->release(schema);
+  g_free(schema);
+  if (res.tag != Okusize) {
+    print_error("Failed to add files.", (Error*)res.err);
+    free_error((Error*)res.err);
+    return false;
+  }
+  printf("Added %" PRIuPTR " files to the transaction\n", res.ok);
+  return true;
+}
+
+static GPtrArray* read_input(const char* input_path)
+{
+  GError* error = NULL;
+  GArrowMemoryMappedInputStream* input = garrow_memory_mapped_input_stream_new(input_path, &error);
+  if (report_g_error("Can't open input", error)) {
+    return NULL;
+  }
+  GArrowRecordBatchStreamReader* reader =
+    garrow_record_batch_stream_reader_new(GARROW_INPUT_STREAM(input), &error);
+  g_object_unref(input);
+  if (report_g_error("Can't read input as an arrow IPC stream", error)) {
+    return NULL;
+  }
+  GPtrArray* batches = g_ptr_array_new_with_free_func(g_object_unref);
+  for (;;) {
+    GArrowRecordBatch* batch =
+      garrow_record_batch_reader_read_next(GARROW_RECORD_BATCH_READER(reader), &error);
+    if (report_g_error("Can't read input batch", error)) {
+      g_ptr_array_free(batches, TRUE);
+      batches = NULL;
+      break;
+    }
+    if (batch == NULL) {
+      break;
+    }
+    g_ptr_array_add(batches, batch);
+  }
+  g_object_unref(reader);
+  return batches;
+}
+
+static void print_usage(const char* prog)
+{
+  printf("Usage: %s [--threads N] [--rows-per-file N] input.arrows table/path\n", prog);
+  printf("  --threads N        write data files using a pool of N threads (default: 1)\n");
+  printf("  --rows-per-file N  start a new file after N rows of a partition (default: 1000000)\n");
+}
+
+int main(int argc, char* argv[])
+{
+  int num_threads = 1;
+  int64_t rows_per_file = 1000000;
+  const char* input_path = NULL;
+  const char* table_path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+      if (num_threads < 1) {
+        printf("--threads must be a positive number\n");
+        return -1;
+      }
+    } else if (strcmp(argv[i], "--rows-per-file") == 0 && i + 1 < argc) {
+      rows_per_file = atoll(argv[++i]);
+      if (rows_per_file < 1) {
+        printf("--rows-per-file must be a positive number\n");
+        return -1;
+      }
+    } else if (input_path == NULL && strncmp(argv[i], "--", 2) != 0) {
+      input_path = argv[i];
+    } else if (table_path == NULL && strncmp(argv[i], "--", 2) != 0) {
+      table_path = argv[i];
+    } else {
+      print_usage(argv[0]);
+      return -1;
+    }
+  }
+  if (table_path == NULL) {
+    print_usage(argv[0]);
+    return -1;
+  }
+
+  GPtrArray* batches = read_input(input_path);
+  if (batches == NULL) {
+    return -1;
+  }
+
+  KernelStringSlice table_path_slice = { table_path, strlen(table_path) };
+  ExternResultHandleSharedExternEngine engine_res =
+    get_default_engine(table_path_slice, allocate_error);
+  if (engine_res.tag != OkHandleSharedExternEngine) {
+    print_error("Failed to get engine.", (Error*)engine_res.err);
+    free_error((Error*)engine_res.err);
+    return -1;
+  }
+  SharedExternEngine* engine = engine_res.ok;
+
+  ExternResultHandleSharedSnapshot snapshot_res = snapshot(table_path_slice, engine);
+  if (snapshot_res.tag != OkHandleSharedSnapshot) {
+    print_error("Failed to create snapshot.", (Error*)snapshot_res.err);
+    free_error((Error*)snapshot_res.err);
+    return -1;
+  }
+  SharedSnapshot* snapshot = snapshot_res.ok;
+  WriteContext context = { .table_dir = NULL, .num_partition_cols = 0 };
+  context.partition_cols = malloc(sizeof(char*) * get_partition_column_count(snapshot));
+  StringSliceIterator* part_iter = get_partition_columns(snapshot);
+  while (string_slice_next(part_iter, &context, visit_partition)) {
+  }
+  free_string_slice_data(part_iter);
+  free_snapshot(snapshot);
+
+  ExternResultHandleExclusiveTransaction txn_res = transaction(table_path_slice, engine);
+  if (txn_res.tag != OkHandleExclusiveTransaction) {
+    print_error("Failed to start transaction.", (Error*)txn_res.err);
+    free_error((Error*)txn_res.err);
+    return -1;
+  }
+  ExclusiveTransaction* txn = txn_res.ok;
+  SharedWriteContext* write_context = get_write_context(txn);
+  char* write_url = get_write_path(write_context, allocate_string);
+  free_write_context(write_context);
+  GError* error = NULL;
+  context.table_dir = g_filename_from_uri(write_url, NULL, &error);
+  free(write_url);
+  if (report_g_error("Can only write to local tables", error)) {
+    return -1;
+  }
+
+  GPtrArray* tasks = g_ptr_array_new_with_free_func(free_file_task);
+  for (guint i = 0; i < batches->len; i++) {
+    if (!plan_files(&context, g_ptr_array_index(batches, i), rows_per_file, tasks)) {
+      return -1;
+    }
+  }
+  g_ptr_array_free(batches, TRUE);
+
+  printf("Writing %u files with %i threads\n", tasks->len, num_threads);
+  GThreadPool* pool = g_thread_pool_new(write_task_worker, &context, num_threads, TRUE, &error);
+  if (report_g_error("Can't create write pool", error)) {
+    return -1;
+  }
+  for (guint i = 0; i < tasks->len; i++) {
+    g_thread_pool_push(pool, g_ptr_array_index(tasks, i), NULL);
+  }
+  // waits for all the writes to finish
+  g_thread_pool_free(pool, FALSE, TRUE);
+
+  int ret = 0;
+  for (guint i = 0; i < tasks->len; i++) {
+    FileTask* task = g_ptr_array_index(tasks, i);
+    g_clear_object(&task->data);
+    if (!task->ok) {
+      printf("Failed to write %s\n", task->path);
+      ret = -1;
+    }
+  }
+
+  GArrowRecordBatch* add_files_batch = ret == 0 ? build_add_files_batch(&context, tasks) : NULL;
+  if (add_files_batch == NULL || !add_files_to_transaction(txn, engine, add_files_batch)) {
+    // the written files are left behind, but aren't part of the table
+    free_transaction(txn);
+    ret = -1;
+  } else {
+    ExternResultPostCommitHint commit_res = commit_with_post_commit_hint(txn, engine);
+    if (commit_res.tag != OkPostCommitHint) {
+      print_error("Failed to commit.", (Error*)commit_res.err);
+      free_error((Error*)commit_res.err);
+      ret = -1;
+    } else {
+      PostCommitHint hint = commit_res.ok;
+      printf("Committed version %" PRIu64 "\n", hint.version);
+      if (hint.checkpoint_due) {
+        printf(
+          "%" PRIu64 " commits since the last checkpoint, the table should be checkpointed\n",
+          hint.commits_since_checkpoint);
+      }
+    }
+  }
+  g_clear_object(&add_files_batch);
+
+  g_ptr_array_free(tasks, TRUE);
+  for (uintptr_t c = 0; c < context.num_partition_cols; c++) {
+    free(context.partition_cols[c]);
+  }
+  free(context.partition_cols);
+  g_free(context.table_dir);
+  free_engine(engine);
+  return ret;
+}
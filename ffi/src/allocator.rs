@@ -0,0 +1,186 @@
+//! Support for kernel allocating engine-side strings and buffers with an engine-supplied allocator.
+//!
+//! Functions that return engine-owned data usually take an [`AllocateStringFn`], which kernel calls
+//! once per string. Those callbacks get no context, so every string must be freed on its own. The
+//! `_in` variants of those functions instead take an [`EngineAllocator`], whose `context` is passed
+//! to every call, so that an engine can e.g. put everything kernel allocates for a query in one
+//! arena and release it all at once.
+//!
+//! [`AllocateStringFn`]: crate::AllocateStringFn
+
+use std::os::raw::c_char;
+
+use crate::NullableCvoid;
+
+/// An allocator kernel uses for memory it hands to the engine. Kernel never frees memory it has
+/// returned to the engine, and only calls `free` to release allocations it can't return after all,
+/// e.g. the strings allocated so far when a later allocation of the same call fails.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct EngineAllocator {
+    /// Passed to every call of `alloc` and `free`, e.g. the arena to allocate in
+    pub context: NullableCvoid,
+    /// Allocate `size` bytes, aligned to `align` (a power of two). Returns NULL on failure
+    pub alloc: extern "C" fn(context: NullableCvoid, size: usize, align: usize) -> NullableCvoid,
+    /// Free memory returned by `alloc`
+    pub free: extern "C" fn(context: NullableCvoid, ptr: NullableCvoid),
+}
+
+// Safety: the engine is responsible for `context` being usable from whatever thread it calls
+// kernel on
+unsafe impl Send for EngineAllocator {}
+
+impl EngineAllocator {
+    fn alloc(&self, size: usize, align: usize) -> NullableCvoid {
+        (self.alloc)(self.context, size, align)
+    }
+
+    fn free(&self, ptr: NullableCvoid) {
+        (self.free)(self.context, ptr)
+    }
+
+    /// Copy `s` into a new nul-terminated string
+    pub(crate) fn allocate_string(&self, s: &str) -> NullableCvoid {
+        let ptr = self.alloc(s.len() + 1, 1)?;
+        let buf = ptr.as_ptr().cast::<u8>();
+        unsafe {
+            std::ptr::copy_nonoverlapping(s.as_ptr(), buf, s.len());
+            *buf.add(s.len()) = 0;
+        }
+        Some(ptr)
+    }
+
+    /// Copy each of `strings` into a new nul-terminated string, and return an array of pointers to
+    /// them. If any allocation fails, everything allocated so far is freed again.
+    pub(crate) fn allocate_string_array<'a>(
+        &self,
+        strings: impl ExactSizeIterator<Item = &'a str>,
+    ) -> NullableCvoid {
+        let len = strings.len();
+        let array = self.alloc(
+            // an empty array still needs a pointer the engine can tell apart from a failure
+            len.max(1) * size_of::<*mut c_char>(),
+            align_of::<*mut c_char>(),
+        )?;
+        let slots = array.as_ptr().cast::<NullableCvoid>();
+        for (i, s) in strings.enumerate() {
+            let Some(string) = self.allocate_string(s) else {
+                for done in 0..i {
+                    self.free(unsafe { *slots.add(done) });
+                }
+                self.free(Some(array));
+                return None;
+            };
+            unsafe { slots.add(i).write(Some(string)) };
+        }
+        Some(array)
+    }
+}
+
+#[cfg(test)]
+pub(crate) mod test_utils {
+    use std::alloc::Layout;
+    use std::ffi::c_void;
+    use std::ptr::NonNull;
+    use std::sync::Mutex;
+
+    use super::EngineAllocator;
+    use crate::NullableCvoid;
+
+    /// A simple arena, which frees everything it allocated when dropped
+    #[derive(Default)]
+    pub(crate) struct TestArena {
+        allocations: Mutex<Vec<(NonNull<u8>, Layout)>>,
+        // fail every allocation after this many
+        pub(crate) fail_after: Option<usize>,
+    }
+
+    impl TestArena {
+        pub(crate) fn allocator(&self) -> EngineAllocator {
+            EngineAllocator {
+                context: NonNull::new(self as *const Self as *mut c_void),
+                alloc: arena_alloc,
+                free: arena_free,
+            }
+        }
+
+        pub(crate) fn num_allocations(&self) -> usize {
+            self.allocations.lock().unwrap().len()
+        }
+    }
+
+    impl Drop for TestArena {
+        fn drop(&mut self) {
+            for (ptr, layout) in self.allocations.lock().unwrap().drain(..) {
+                unsafe { std::alloc::dealloc(ptr.as_ptr(), layout) };
+            }
+        }
+    }
+
+    /// Convert a string allocated by an [`EngineAllocator`] back into a `&str`
+    pub(crate) unsafe fn allocated_str<'a>(ptr: NonNull<c_void>) -> &'a str {
+        let s = unsafe { std::ffi::CStr::from_ptr(ptr.as_ptr().cast()) };
+        s.to_str().unwrap()
+    }
+
+    fn arena(context: NullableCvoid) -> &'static TestArena {
+        unsafe { &*(context.unwrap().as_ptr() as *const TestArena) }
+    }
+
+    extern "C" fn arena_alloc(context: NullableCvoid, size: usize, align: usize) -> NullableCvoid {
+        let arena = arena(context);
+        let mut allocations = arena.allocations.lock().unwrap();
+        if arena.fail_after.is_some_and(|n| allocations.len() >= n) {
+            return None;
+        }
+        let layout = Layout::from_size_align(size, align).unwrap();
+        let ptr = NonNull::new(unsafe { std::alloc::alloc(layout) })?;
+        allocations.push((ptr, layout));
+        Some(ptr.cast())
+    }
+
+    extern "C" fn arena_free(context: NullableCvoid, ptr: NullableCvoid) {
+        let mut allocations = arena(context).allocations.lock().unwrap();
+        let ptr = ptr.unwrap().cast::<u8>();
+        let index = allocations.iter().position(|(p, _)| *p == ptr).unwrap();
+        let (ptr, layout) = allocations.swap_remove(index);
+        unsafe { std::alloc::dealloc(ptr.as_ptr(), layout) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::test_utils::{allocated_str, TestArena};
+    use super::*;
+
+    #[test]
+    fn allocate_strings_in_arena() {
+        let arena = TestArena::default();
+        let allocator = arena.allocator();
+        let s = allocator.allocate_string("table/root").unwrap();
+        assert_eq!(unsafe { allocated_str(s) }, "table/root");
+
+        let array = allocator
+            .allocate_string_array(["a", "bc"].into_iter())
+            .unwrap();
+        let slots = array.as_ptr().cast::<NullableCvoid>();
+        let strings: Vec<_> = (0..2)
+            .map(|i| unsafe { allocated_str((*slots.add(i)).unwrap()) })
+            .collect();
+        assert_eq!(strings, ["a", "bc"]);
+        assert_eq!(arena.num_allocations(), 4);
+    }
+
+    #[test]
+    fn failed_allocation_frees_partial_array() {
+        let arena = TestArena {
+            fail_after: Some(2),
+            ..Default::default()
+        };
+        let allocator = arena.allocator();
+        assert!(allocator
+            .allocate_string_array(["a", "b", "c"].into_iter())
+            .is_none());
+        assert_eq!(arena.num_allocations(), 0);
+    }
+}
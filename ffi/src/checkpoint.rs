@@ -0,0 +1,334 @@
+//! Checkpoint and log compaction related ffi code
+//!
+//! A checkpoint is written in three steps, mirroring [`delta_kernel::checkpoint`]:
+//!
+//! 1. Create a checkpoint writer for a snapshot with [`checkpoint_snapshot`], and get the path the
+//!    checkpoint must be written to with [`checkpoint_path`]
+//! 2. Call [`checkpoint_next_batch_as_arrow`] until it returns `NULL`, writing every batch to a
+//!    single parquet file at that path
+//! 3. Once the file is fully written, call [`finalize_checkpoint`] with its size, which writes the
+//!    `_last_checkpoint` hint so readers find the new checkpoint
+//!
+//! Kernel picks the checkpoint spec from the table features: tables that support `v2Checkpoints`
+//! get a classic-named V2 checkpoint, all others a V1 checkpoint. Log compaction files are JSON,
+//! so kernel can write them itself with [`write_log_compaction`].
+
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::array::{BooleanArray, RecordBatch, StructArray};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::compute::filter_record_batch;
+use delta_kernel::checkpoint::{CheckpointDataIterator, CheckpointWriter};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine::arrow_data::ArrowEngineData;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine_data::FilteredEngineData;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::EngineData;
+use delta_kernel::{DeltaResult, FileMeta, SnapshotRef, Version};
+use delta_kernel_ffi_macros::handle_descriptor;
+
+#[cfg(feature = "default-engine-base")]
+use crate::engine_data::{array_data_to_arrow_ffi_data, ArrowFFIData};
+use crate::handle::Handle;
+use crate::{
+    kernel_string_slice, AllocateStringFn, ExternEngine, ExternResult, IntoExternResult,
+    NullableCvoid, SharedExternEngine, SharedSnapshot,
+};
+
+/// A checkpoint being written: the kernel writer, plus the data still to be handed to the engine.
+pub struct PendingCheckpoint {
+    writer: CheckpointWriter,
+    data: CheckpointDataIterator,
+}
+
+#[handle_descriptor(target=PendingCheckpoint, mutable=true, sized=true)]
+pub struct ExclusiveCheckpointWriter;
+
+/// Start writing a checkpoint of `snapshot`. The checkpoint is for the version of the snapshot,
+/// and includes the table state as of that version. It is the responsibility of the _engine_ to
+/// either finish the checkpoint with [`finalize_checkpoint`], or give up on it with
+/// [`free_checkpoint_writer`].
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedSnapshot` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn checkpoint_snapshot(
+    snapshot: Handle<SharedSnapshot>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<ExclusiveCheckpointWriter>> {
+    let snapshot = unsafe { snapshot.clone_as_arc() };
+    let engine = unsafe { engine.as_ref() };
+    checkpoint_snapshot_impl(snapshot, engine)
+        .map(|pending| Box::new(pending).into())
+        .into_extern_result(&engine)
+}
+
+fn checkpoint_snapshot_impl(
+    snapshot: SnapshotRef,
+    extern_engine: &dyn ExternEngine,
+) -> DeltaResult<PendingCheckpoint> {
+    let writer = snapshot.checkpoint()?;
+    let data = writer.checkpoint_data(extern_engine.engine().as_ref())?;
+    Ok(PendingCheckpoint { writer, data })
+}
+
+/// Get the full url of the parquet file the checkpoint must be written to.
+///
+/// # Safety
+/// Engine is responsible for passing valid `ExclusiveCheckpointWriter` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn checkpoint_path(
+    writer: Handle<ExclusiveCheckpointWriter>,
+    engine: Handle<SharedExternEngine>,
+    allocate_fn: AllocateStringFn,
+) -> ExternResult<NullableCvoid> {
+    let pending = unsafe { writer.as_ref() };
+    pending
+        .writer
+        .checkpoint_path()
+        .map(|path| {
+            let path = path.as_str();
+            allocate_fn(kernel_string_slice!(path))
+        })
+        .into_extern_result(&engine.as_ref())
+}
+
+/// Get the next batch of actions to write to the checkpoint file, as seen through the arrow [C Data
+/// Interface](https://arrow.apache.org/docs/format/CDataInterface.html). Returns `NULL` once all
+/// the data has been handed out. If this function returns a non-`NULL` `Ok` variant the _engine_
+/// must free the returned struct.
+///
+/// The batches hold the `add`, `remove`, `metaData`, `protocol`, `txn` and `sidecar` columns, except
+/// for the last batch of a V2 checkpoint, which only holds the `checkpointMetadata` column. The file
+/// must have all the columns of both, with each batch's missing columns written as nulls.
+///
+/// # Safety
+/// Engine is responsible for passing valid `ExclusiveCheckpointWriter` and engine handles.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn checkpoint_next_batch_as_arrow(
+    mut writer: Handle<ExclusiveCheckpointWriter>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<*mut ArrowFFIData> {
+    let pending = unsafe { writer.as_mut() };
+    checkpoint_next_batch_impl(pending)
+        .and_then(|batch| match batch {
+            Some(batch) => array_data_to_arrow_ffi_data(&StructArray::from(batch).into()),
+            None => Ok(std::ptr::null_mut()),
+        })
+        .into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn checkpoint_next_batch_impl(pending: &mut PendingCheckpoint) -> DeltaResult<Option<RecordBatch>> {
+    pending
+        .data
+        .next()
+        .map(|data| Ok(ArrowEngineData::try_from_engine_data(apply_selection(data?)?)?.into()))
+        .transpose()
+}
+
+/// Finish a checkpoint, after the engine has written all its data to [`checkpoint_path`]. `size`
+/// and `last_modified` (in milliseconds since the epoch) describe the written file. This fails if
+/// the engine hasn't fetched all the batches of the checkpoint yet. Either way, the writer is
+/// consumed and must not be used afterwards.
+///
+/// # Safety
+/// Engine is responsible for passing valid `ExclusiveCheckpointWriter` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn finalize_checkpoint(
+    writer: Handle<ExclusiveCheckpointWriter>,
+    engine: Handle<SharedExternEngine>,
+    size: u64,
+    last_modified: i64,
+) -> ExternResult<bool> {
+    let pending = unsafe { writer.into_inner() };
+    let engine = unsafe { engine.as_ref() };
+    finalize_checkpoint_impl(*pending, engine, size, last_modified).into_extern_result(&engine)
+}
+
+fn finalize_checkpoint_impl(
+    pending: PendingCheckpoint,
+    extern_engine: &dyn ExternEngine,
+    size: u64,
+    last_modified: i64,
+) -> DeltaResult<bool> {
+    let metadata = FileMeta::new(pending.writer.checkpoint_path()?, last_modified, size);
+    let engine = extern_engine.engine();
+    pending
+        .writer
+        .finalize(engine.as_ref(), &metadata, pending.data)?;
+    Ok(true)
+}
+
+/// Free a checkpoint writer without finishing the checkpoint.
+///
+/// # Safety
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_checkpoint_writer(writer: Handle<ExclusiveCheckpointWriter>) {
+    writer.drop_handle();
+}
+
+/// Write a log compaction file for the commits `start_version` through `end_version` (both
+/// inclusive) of `snapshot`'s table, which lets readers replay the log without reading each of
+/// those commits. `end_version` must be greater than `start_version`, and at most the version of
+/// `snapshot`. Fails if the log compaction file already exists.
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedSnapshot` and engine handles.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn write_log_compaction(
+    snapshot: Handle<SharedSnapshot>,
+    engine: Handle<SharedExternEngine>,
+    start_version: Version,
+    end_version: Version,
+) -> ExternResult<bool> {
+    let snapshot = unsafe { snapshot.clone_as_arc() };
+    let engine = unsafe { engine.as_ref() };
+    write_log_compaction_impl(snapshot, engine, start_version, end_version)
+        .into_extern_result(&engine)
+}
+
+#[cfg(feature = "default-engine-base")]
+fn write_log_compaction_impl(
+    snapshot: SnapshotRef,
+    extern_engine: &dyn ExternEngine,
+    start_version: Version,
+    end_version: Version,
+) -> DeltaResult<bool> {
+    let engine = extern_engine.engine();
+    let mut writer = snapshot.log_compaction_writer(start_version, end_version)?;
+    let data = writer
+        .compaction_data(engine.as_ref())?
+        .map(|data| apply_selection(data?));
+    engine
+        .json_handler()
+        .write_json_file(writer.compaction_path(), Box::new(data), false)?;
+    Ok(true)
+}
+
+// Drop the rows the selection vector deselects. Rows past the end of the selection vector are
+// selected.
+#[cfg(feature = "default-engine-base")]
+fn apply_selection(data: FilteredEngineData) -> DeltaResult<Box<dyn EngineData>> {
+    let num_rows = data.data.len();
+    let mut selection_vector = data.selection_vector;
+    if selection_vector.iter().take(num_rows).all(|keep| *keep) {
+        return Ok(data.data);
+    }
+    selection_vector.resize(num_rows, true);
+    let batch = ArrowEngineData::try_from_engine_data(data.data)?;
+    let filtered =
+        filter_record_batch(batch.record_batch(), &BooleanArray::from(selection_vector))?;
+    Ok(Box::new(ArrowEngineData::new(filtered)))
+}
+
+#[cfg(all(test, feature = "default-engine-base"))]
+mod tests {
+    use std::sync::Arc;
+
+    use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+    use delta_kernel::engine::default::DefaultEngine;
+    use delta_kernel::Snapshot;
+    use object_store::memory::InMemory;
+    use object_store::ObjectStore;
+    use test_utils::{
+        actions_to_string, add_commit, compacted_log_path_for_versions, delta_path_for_version,
+        record_batch_to_bytes, TestAction,
+    };
+    use url::Url;
+
+    use super::*;
+    use crate::engine_to_handle;
+    use crate::ffi_test_utils::allocate_err;
+
+    async fn three_commit_table() -> Result<Arc<InMemory>, Box<dyn std::error::Error>> {
+        let storage = Arc::new(InMemory::new());
+        let commits = [
+            vec![TestAction::Metadata, TestAction::Add("a.parquet".into())],
+            vec![TestAction::Add("b.parquet".into())],
+            vec![TestAction::Remove("a.parquet".into())],
+        ];
+        for (version, actions) in commits.into_iter().enumerate() {
+            add_commit(storage.as_ref(), version as u64, actions_to_string(actions)).await?;
+        }
+        Ok(storage)
+    }
+
+    #[tokio::test]
+    async fn checkpoint_is_found_by_new_snapshots() -> Result<(), Box<dyn std::error::Error>> {
+        let storage = three_commit_table().await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let engine = engine_to_handle(Arc::new(engine), allocate_err);
+        let extern_engine = unsafe { engine.as_ref() };
+        let table_root = Url::parse("memory:///")?;
+        let snapshot =
+            Snapshot::builder_for(table_root.clone()).build(extern_engine.engine().as_ref())?;
+
+        let mut pending = checkpoint_snapshot_impl(snapshot, extern_engine)?;
+        assert_eq!(
+            pending.writer.checkpoint_path()?.as_str(),
+            "memory:///_delta_log/00000000000000000002.checkpoint.parquet"
+        );
+        let mut batches = vec![];
+        while let Some(batch) = checkpoint_next_batch_impl(&mut pending)? {
+            batches.push(batch);
+        }
+        let batch = delta_kernel::arrow::compute::concat_batches(&batches[0].schema(), &batches)?;
+        let bytes = record_batch_to_bytes(&batch);
+        let size = bytes.len() as u64;
+        storage
+            .put(
+                &delta_path_for_version(2, "checkpoint.parquet"),
+                bytes.into(),
+            )
+            .await?;
+        finalize_checkpoint_impl(pending, extern_engine, size, 0)?;
+
+        let snapshot = Snapshot::builder_for(table_root).build(extern_engine.engine().as_ref())?;
+        assert_eq!(snapshot.log_segment().checkpoint_version, Some(2));
+        let scan = snapshot.scan_builder().build()?;
+        let num_files: usize = scan
+            .scan_metadata(extern_engine.engine().as_ref())?
+            .map(|metadata| {
+                metadata.map(|m| m.scan_files.selection_vector.iter().filter(|s| **s).count())
+            })
+            .sum::<DeltaResult<_>>()?;
+        assert_eq!(num_files, 1);
+        unsafe { crate::free_engine(engine) };
+        Ok(())
+    }
+
+    #[tokio::test]
+    async fn log_compaction_is_written() -> Result<(), Box<dyn std::error::Error>> {
+        let storage = three_commit_table().await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let engine = engine_to_handle(Arc::new(engine), allocate_err);
+        let extern_engine = unsafe { engine.as_ref() };
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root).build(extern_engine.engine().as_ref())?;
+
+        assert!(write_log_compaction_impl(
+            snapshot.clone(),
+            extern_engine,
+            0,
+            2
+        )?);
+        let compacted = storage
+            .get(&compacted_log_path_for_versions(0, 2, "json"))
+            .await?
+            .bytes()
+            .await?;
+        let compacted = String::from_utf8(compacted.to_vec())?;
+        // b.parquet is still live, a.parquet was removed
+        assert!(compacted.contains(r#""add":{"path":"b.parquet""#));
+        assert!(!compacted.contains(r#""add":{"path":"a.parquet""#));
+
+        // the compaction file is never overwritten
+        assert!(write_log_compaction_impl(snapshot, extern_engine, 0, 2).is_err());
+        unsafe { crate::free_engine(engine) };
+        Ok(())
+    }
+}
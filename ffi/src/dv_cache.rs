@@ -0,0 +1,391 @@
+//! An engine-wide cache of deletion vectors.
+//!
+//! Loading a deletion vector means fetching its file (or decoding it from the log, for inline DVs)
+//! and deserializing the roaring bitmap. Scans that run repeatedly against the same snapshot redo
+//! this for every file every time, so an engine built with the [`DV_CACHE_SIZE_OPTION`] builder
+//! option keeps the decoded bitmaps around. It also keeps the raw contents of the DV files it
+//! fetched, since one DV file usually holds the DVs of many data files at different offsets, and
+//! those can then be decoded without fetching the file again.
+
+use std::collections::{BTreeMap, HashMap};
+use std::sync::{Arc, Mutex};
+
+use bytes::Bytes;
+use delta_kernel::actions::deletion_vector::DeletionVectorDescriptor;
+use delta_kernel::scan::state::DvInfo;
+use delta_kernel::{DeltaResult, Error, FileMeta, FileSlice, StorageHandler};
+use roaring::RoaringTreemap;
+use url::Url;
+
+use crate::ExternEngine;
+
+/// The builder option that enables the deletion vector cache, and sets its size in bytes. The cache
+/// is disabled if the option is not set or is `0`.
+#[cfg(feature = "default-engine-base")]
+pub(crate) const DV_CACHE_SIZE_OPTION: &str = "deletion_vector_cache_size";
+
+#[derive(Clone, PartialEq, Eq, Hash)]
+enum CacheKey {
+    // A decoded DV, by table root and the DV's unique id
+    Decoded(Url, String),
+    // The contents of a DV file
+    File(Url),
+}
+
+#[derive(Clone)]
+enum CachedValue {
+    Decoded(Arc<RoaringTreemap>),
+    File(Bytes),
+}
+
+struct CacheEntry {
+    value: CachedValue,
+    size: usize,
+    last_used: u64,
+}
+
+#[derive(Default)]
+struct CacheState {
+    entries: HashMap<CacheKey, CacheEntry>,
+    // the key of every entry by its `last_used`, so the least recently used entry comes first
+    by_last_used: BTreeMap<u64, CacheKey>,
+    size: usize,
+    // bumped on every access, so every entry has a distinct `last_used`
+    clock: u64,
+}
+
+impl CacheState {
+    fn tick(&mut self) -> u64 {
+        self.clock += 1;
+        self.clock
+    }
+
+    fn remove(&mut self, key: &CacheKey) {
+        if let Some(entry) = self.entries.remove(key) {
+            self.by_last_used.remove(&entry.last_used);
+            self.size -= entry.size;
+        }
+    }
+}
+
+/// A size-bounded cache of deletion vectors, which evicts the least recently used entries first.
+/// Loads happen outside the cache lock, so concurrent scans never wait on each other's IO, at the
+/// price of occasionally loading the same DV twice.
+pub struct DvCache {
+    max_size: usize,
+    state: Mutex<CacheState>,
+}
+
+impl DvCache {
+    #[cfg(any(test, feature = "default-engine-base"))]
+    pub(crate) fn new(max_size: usize) -> Self {
+        Self {
+            max_size,
+            state: Mutex::default(),
+        }
+    }
+
+    /// Parse the value of the [`DV_CACHE_SIZE_OPTION`] builder option
+    #[cfg(feature = "default-engine-base")]
+    pub(crate) fn from_option(value: &str) -> DeltaResult<Option<Arc<Self>>> {
+        let max_size: usize = value
+            .parse()
+            .map_err(|_| Error::generic(format!("Invalid {DV_CACHE_SIZE_OPTION}: '{value}'")))?;
+        Ok((max_size > 0).then(|| Arc::new(Self::new(max_size))))
+    }
+
+    /// The rows deleted by `dv`, loaded with `storage` unless they are already cached
+    pub(crate) fn deleted_rows(
+        self: &Arc<Self>,
+        dv: &DeletionVectorDescriptor,
+        storage: Arc<dyn StorageHandler>,
+        table_root: &Url,
+    ) -> DeltaResult<Arc<RoaringTreemap>> {
+        let key = CacheKey::Decoded(table_root.clone(), dv.unique_id());
+        if let Some(CachedValue::Decoded(deleted)) = self.get(&key) {
+            return Ok(deleted);
+        }
+        let storage = Arc::new(CachingStorage {
+            inner: storage,
+            cache: self.clone(),
+        });
+        let deleted = Arc::new(dv.read(storage, table_root)?);
+        let size = deleted.serialized_size();
+        self.insert(key, CachedValue::Decoded(deleted.clone()), size);
+        Ok(deleted)
+    }
+
+    fn get(&self, key: &CacheKey) -> Option<CachedValue> {
+        let mut state = self.state.lock().ok()?;
+        let clock = state.tick();
+        let entry = state.entries.get_mut(key)?;
+        let last_used = std::mem::replace(&mut entry.last_used, clock);
+        let value = entry.value.clone();
+        let key = state.by_last_used.remove(&last_used)?;
+        state.by_last_used.insert(clock, key);
+        Some(value)
+    }
+
+    fn insert(&self, key: CacheKey, value: CachedValue, size: usize) {
+        if size > self.max_size {
+            return;
+        }
+        let Ok(mut state) = self.state.lock() else {
+            return;
+        };
+        state.remove(&key);
+        while state.size + size > self.max_size {
+            let Some((_, oldest)) = state.by_last_used.pop_first() else {
+                break;
+            };
+            if let Some(evicted) = state.entries.remove(&oldest) {
+                state.size -= evicted.size;
+            }
+        }
+        let last_used = state.tick();
+        state.size += size;
+        state.by_last_used.insert(last_used, key.clone());
+        let entry = CacheEntry {
+            value,
+            size,
+            last_used,
+        };
+        state.entries.insert(key, entry);
+    }
+}
+
+// Serves whole-file reads from the cache, so DVs that share a file only fetch it once. Deletion
+// vectors are always read as whole files, so ranged reads just go to the wrapped handler.
+struct CachingStorage {
+    inner: Arc<dyn StorageHandler>,
+    cache: Arc<DvCache>,
+}
+
+impl StorageHandler for CachingStorage {
+    fn list_from(
+        &self,
+        path: &Url,
+    ) -> DeltaResult<Box<dyn Iterator<Item = DeltaResult<FileMeta>>>> {
+        self.inner.list_from(path)
+    }
+
+    fn read_files(
+        &self,
+        files: Vec<FileSlice>,
+    ) -> DeltaResult<Box<dyn Iterator<Item = DeltaResult<Bytes>>>> {
+        if files.iter().any(|(_, range)| range.is_some()) {
+            return self.inner.read_files(files);
+        }
+        let data: Vec<_> = files
+            .into_iter()
+            .map(|(location, _)| self.read_file(location))
+            .collect();
+        Ok(Box::new(data.into_iter()))
+    }
+}
+
+impl CachingStorage {
+    fn read_file(&self, location: Url) -> DeltaResult<Bytes> {
+        let key = CacheKey::File(location.clone());
+        if let Some(CachedValue::File(data)) = self.cache.get(&key) {
+            return Ok(data);
+        }
+        let data = self
+            .inner
+            .read_files(vec![(location, None)])?
+            .next()
+            .ok_or(Error::missing_data("No deletion vector data"))??;
+        self.cache
+            .insert(key, CachedValue::File(data.clone()), data.len());
+        Ok(data)
+    }
+}
+
+/// The rows deleted by the DV of `dv_info`, if it has one. Uses the engine's DV cache, if it has
+/// one.
+pub(crate) fn deleted_rows(
+    dv_info: &DvInfo,
+    extern_engine: &dyn ExternEngine,
+    table_root: &Url,
+) -> DeltaResult<Option<Arc<RoaringTreemap>>> {
+    let Some(dv) = dv_info.deletion_vector() else {
+        return Ok(None);
+    };
+    let storage = extern_engine.engine().storage_handler();
+    let deleted = match extern_engine.dv_cache() {
+        Some(cache) => cache.deleted_rows(dv, storage, table_root)?,
+        None => Arc::new(dv.read(storage, table_root)?),
+    };
+    Ok(Some(deleted))
+}
+
+/// Same as [`DvInfo::get_selection_vector`], but uses the engine's DV cache, if it has one
+pub(crate) fn selection_vector(
+    dv_info: &DvInfo,
+    extern_engine: &dyn ExternEngine,
+    table_root: &Url,
+) -> DeltaResult<Option<Vec<bool>>> {
+    let Some(deleted) = deleted_rows(dv_info, extern_engine, table_root)? else {
+        return Ok(None);
+    };
+    // like kernel, an empty DV gives an empty selection vector: all rows selected
+    let len = deleted.max().map_or(0, |max| max as usize + 1);
+    let mut selection_vector = vec![true; len];
+    for row_index in deleted.iter() {
+        selection_vector[row_index as usize] = false;
+    }
+    Ok(Some(selection_vector))
+}
+
+/// Same as [`DvInfo::get_row_indexes`], but uses the engine's DV cache, if it has one
+pub(crate) fn row_indexes(
+    dv_info: &DvInfo,
+    extern_engine: &dyn ExternEngine,
+    table_root: &Url,
+) -> DeltaResult<Option<Vec<u64>>> {
+    let deleted = deleted_rows(dv_info, extern_engine, table_root)?;
+    Ok(deleted.map(|deleted| deleted.iter().collect()))
+}
+
+#[cfg(test)]
+mod tests {
+    use std::path::PathBuf;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    use super::*;
+
+    // Reads local files, counting every file read
+    #[derive(Default)]
+    struct CountingStorage {
+        reads: AtomicUsize,
+    }
+
+    impl StorageHandler for CountingStorage {
+        fn list_from(
+            &self,
+            _: &Url,
+        ) -> DeltaResult<Box<dyn Iterator<Item = DeltaResult<FileMeta>>>> {
+            unimplemented!()
+        }
+
+        fn read_files(
+            &self,
+            files: Vec<FileSlice>,
+        ) -> DeltaResult<Box<dyn Iterator<Item = DeltaResult<Bytes>>>> {
+            let data: Vec<_> = files
+                .into_iter()
+                .map(|(location, _)| {
+                    self.reads.fetch_add(1, Ordering::SeqCst);
+                    let path = location.to_file_path().unwrap();
+                    Ok(Bytes::from(std::fs::read(path).unwrap()))
+                })
+                .collect();
+            Ok(Box::new(data.into_iter()))
+        }
+    }
+
+    fn table_root() -> Url {
+        let path =
+            std::fs::canonicalize(PathBuf::from("../kernel/tests/data/table-with-dv-small/"))
+                .unwrap();
+        Url::from_directory_path(path).unwrap()
+    }
+
+    // the one DV in table-with-dv-small, which deletes rows 0 and 9
+    fn relative_dv() -> DeletionVectorDescriptor {
+        DeletionVectorDescriptor {
+            storage_type: "u".to_string(),
+            path_or_inline_dv: "vBn[lx{q8@P<9BNH/isA".to_string(),
+            offset: Some(1),
+            size_in_bytes: 36,
+            cardinality: 2,
+        }
+    }
+
+    // the same DV, referring to its file by absolute path, so it gets a different unique id
+    fn absolute_dv(table_root: &Url) -> DeletionVectorDescriptor {
+        let path = table_root
+            .join("deletion_vector_61d16c75-6994-46b7-a15b-8b538852e50e.bin")
+            .unwrap();
+        DeletionVectorDescriptor {
+            storage_type: "p".to_string(),
+            path_or_inline_dv: path.to_string(),
+            ..relative_dv()
+        }
+    }
+
+    #[test]
+    #[cfg_attr(miri, ignore)] // reads from the filesystem
+    fn cached_dvs_are_not_read_again() {
+        let storage = Arc::new(CountingStorage::default());
+        let cache = Arc::new(DvCache::new(1 << 20));
+        let root = table_root();
+
+        for _ in 0..3 {
+            let deleted = cache
+                .deleted_rows(&relative_dv(), storage.clone(), &root)
+                .unwrap();
+            assert_eq!(deleted.iter().collect::<Vec<_>>(), [0, 9]);
+        }
+        assert_eq!(storage.reads.load(Ordering::SeqCst), 1);
+
+        // a different DV in the same file is decoded from the cached file contents
+        let deleted = cache
+            .deleted_rows(&absolute_dv(&root), storage.clone(), &root)
+            .unwrap();
+        assert_eq!(deleted.iter().collect::<Vec<_>>(), [0, 9]);
+        assert_eq!(storage.reads.load(Ordering::SeqCst), 1);
+    }
+
+    #[test]
+    #[cfg_attr(miri, ignore)] // reads from the filesystem
+    fn cache_stays_within_size() {
+        let storage = Arc::new(CountingStorage::default());
+        // too small for the 45 byte DV file, so only the decoded DVs are kept, one at a time
+        let cache = Arc::new(DvCache::new(40));
+        let root = table_root();
+
+        let dvs = [relative_dv(), absolute_dv(&root), relative_dv()];
+        for dv in &dvs {
+            cache.deleted_rows(dv, storage.clone(), &root).unwrap();
+        }
+        // each DV evicted the one before it, so every lookup had to read the file
+        assert_eq!(storage.reads.load(Ordering::SeqCst), 3);
+        let state = cache.state.lock().unwrap();
+        assert_eq!(state.entries.len(), 1);
+        assert_eq!(state.by_last_used.len(), 1);
+        assert!(state.size <= 40);
+    }
+
+    #[test]
+    fn least_recently_used_entry_is_evicted() {
+        let cache = DvCache::new(20);
+        let key = |name: &str| CacheKey::File(Url::parse(&format!("memory:///{name}")).unwrap());
+        let value = || CachedValue::File(Bytes::from_static(&[0; 10]));
+        let cached = |name: &str| cache.get(&key(name)).is_some();
+
+        cache.insert(key("a"), value(), 10);
+        cache.insert(key("b"), value(), 10);
+        // using `a` makes `b` the least recently used, so it goes first
+        assert!(cached("a"));
+        cache.insert(key("c"), value(), 10);
+        assert!(!cached("b"));
+        assert!(cached("a") && cached("c"));
+        // re-inserting an entry replaces it rather than counting it twice
+        cache.insert(key("c"), value(), 10);
+        assert!(cached("a") && cached("c"));
+
+        let state = cache.state.lock().unwrap();
+        assert_eq!(state.entries.len(), 2);
+        assert_eq!(state.by_last_used.len(), 2);
+        assert_eq!(state.size, 20);
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[test]
+    fn invalid_cache_size_option() {
+        assert!(DvCache::from_option("0").unwrap().is_none());
+        assert!(DvCache::from_option("1024").unwrap().is_some());
+        assert!(DvCache::from_option("lots").is_err());
+    }
+}
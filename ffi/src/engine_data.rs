@@ -5,19 +5,33 @@ use delta_kernel::arrow;
 #[cfg(feature = "default-engine-base")]
 use delta_kernel::arrow::array::{
     ffi::{FFI_ArrowArray, FFI_ArrowSchema},
-    ArrayData, RecordBatch, StructArray,
+    ArrayData, RecordBatch, RecordBatchReader, StructArray,
 };
 #[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::datatypes::{Schema as ArrowSchema, SchemaRef as ArrowSchemaRef};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::error::ArrowError;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::ffi_stream::FFI_ArrowArrayStream;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine::arrow_conversion::TryFromKernel as _;
+#[cfg(feature = "default-engine-base")]
 use delta_kernel::engine::arrow_data::ArrowEngineData;
 #[cfg(feature = "default-engine-base")]
+use delta_kernel::schema::Schema;
+#[cfg(feature = "default-engine-base")]
 use delta_kernel::DeltaResult;
 use delta_kernel::EngineData;
 use std::ffi::c_void;
+#[cfg(feature = "default-engine-base")]
+use std::sync::Arc;
 
 #[cfg(feature = "default-engine-base")]
 use crate::error::AllocateErrorFn;
 use crate::ExclusiveEngineData;
 #[cfg(feature = "default-engine-base")]
+use crate::ExternEngine;
+#[cfg(feature = "default-engine-base")]
 use crate::{ExternResult, IntoExternResult, SharedExternEngine};
 
 use super::handle::Handle;
@@ -93,13 +107,86 @@ fn get_raw_arrow_data_impl(data: Box<dyn EngineData>) -> DeltaResult<*mut ArrowF
         .into();
     let sa: StructArray = record_batch.into();
     let array_data: ArrayData = sa.into();
+    array_data_to_arrow_ffi_data(&array_data)
+}
+
+/// Export `array_data` through the arrow C Data Interface, as a leaked [`ArrowFFIData`] that the
+/// engine must free.
+#[cfg(feature = "default-engine-base")]
+pub(crate) fn array_data_to_arrow_ffi_data(
+    array_data: &ArrayData,
+) -> DeltaResult<*mut ArrowFFIData> {
     // these call `clone`. is there a way to not copy anything and what exactly are they cloning?
-    let array = FFI_ArrowArray::new(&array_data);
+    let array = FFI_ArrowArray::new(array_data);
     let schema = FFI_ArrowSchema::try_from(array_data.data_type())?;
     let ret_data = Box::new(ArrowFFIData { array, schema });
     Ok(Box::leak(ret_data))
 }
 
+/// Adapts an iterator of arrow [`EngineData`] into an arrow [`RecordBatchReader`], so it can be
+/// exported through the arrow [C Stream
+/// Interface](https://arrow.apache.org/docs/format/CStreamInterface.html).
+#[cfg(feature = "default-engine-base")]
+struct EngineDataReader<I> {
+    data: I,
+    schema: ArrowSchemaRef,
+    // the iterator may need the engine to make progress (e.g. the default engine's parquet reads
+    // stop early once the last engine is dropped), so the stream keeps it alive
+    _engine: Arc<dyn ExternEngine>,
+}
+
+#[cfg(feature = "default-engine-base")]
+impl<I> Iterator for EngineDataReader<I>
+where
+    I: Iterator<Item = DeltaResult<Box<dyn EngineData>>>,
+{
+    type Item = Result<RecordBatch, ArrowError>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let batch = self.data.next()?.and_then(|data| {
+            let batch: RecordBatch = ArrowEngineData::try_from_engine_data(data)?.into();
+            if batch.schema() == self.schema {
+                return Ok(batch);
+            }
+            // a stream has a single schema, so don't let any differences in field metadata or
+            // nullability through
+            Ok(RecordBatch::try_new(
+                self.schema.clone(),
+                batch.columns().to_vec(),
+            )?)
+        });
+        Some(batch.map_err(|err| ArrowError::ExternalError(Box::new(err))))
+    }
+}
+
+#[cfg(feature = "default-engine-base")]
+impl<I> RecordBatchReader for EngineDataReader<I>
+where
+    I: Iterator<Item = DeltaResult<Box<dyn EngineData>>>,
+{
+    fn schema(&self) -> ArrowSchemaRef {
+        self.schema.clone()
+    }
+}
+
+/// Export `data`, whose batches all have the given `schema`, as a leaked [`FFI_ArrowArrayStream`]
+/// that the engine must free. Batches are only pulled from `data` when the engine asks the stream
+/// for them.
+#[cfg(feature = "default-engine-base")]
+pub(crate) fn engine_data_to_arrow_stream(
+    data: impl Iterator<Item = DeltaResult<Box<dyn EngineData>>> + Send + 'static,
+    schema: &Schema,
+    engine: Arc<dyn ExternEngine>,
+) -> DeltaResult<*mut FFI_ArrowArrayStream> {
+    let reader = EngineDataReader {
+        data,
+        schema: Arc::new(ArrowSchema::try_from_kernel(schema)?),
+        _engine: engine,
+    };
+    let stream = Box::new(FFI_ArrowArrayStream::new(Box::new(reader)));
+    Ok(Box::leak(stream))
+}
+
 /// Creates engine data from Arrow C Data Interface array and schema.
 ///
 /// Converts the provided Arrow C Data Interface array and schema into delta-kernel's internal
@@ -121,7 +208,7 @@ pub unsafe extern "C" fn get_engine_data(
 }
 
 #[cfg(feature = "default-engine-base")]
-unsafe fn get_engine_data_impl(
+pub(crate) unsafe fn get_engine_data_impl(
     array: FFI_ArrowArray,
     schema: &FFI_ArrowSchema,
 ) -> DeltaResult<Handle<ExclusiveEngineData>> {
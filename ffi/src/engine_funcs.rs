@@ -1,16 +1,39 @@
 //! Generate functions to perform the "normal" engine operations
 
+#[cfg(feature = "default-engine-base")]
+use std::collections::VecDeque;
 use std::sync::Arc;
+#[cfg(feature = "default-engine-base")]
+use std::task::Poll;
 
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::array::{BooleanArray, BooleanBufferBuilder};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::compute::filter_record_batch;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::ffi_stream::FFI_ArrowArrayStream;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine::arrow_data::ArrowEngineData;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::scan::state::DvInfo;
 use delta_kernel::schema::{DataType, Schema, SchemaRef};
 use delta_kernel::{
     DeltaResult, EngineData, Error, Expression, ExpressionEvaluator, ExpressionRef,
-    FileDataReadResultIterator,
+    FileDataReadResultIterator, PredicateRef,
 };
 use delta_kernel_ffi_macros::handle_descriptor;
 use tracing::debug;
 use url::Url;
 
+#[cfg(feature = "default-engine-base")]
+use crate::dv_cache;
+#[cfg(feature = "default-engine-base")]
+use crate::engine_data::engine_data_to_arrow_stream;
+use crate::expressions::{SharedExpression, SharedPredicate};
+#[cfg(feature = "default-engine-base")]
+use crate::poll::{start_blocking, Deferred, PollNext, PollStatus, PollWaker};
+#[cfg(feature = "default-engine-base")]
+use crate::unwrap_and_parse_path_as_url;
 use crate::{
     ExclusiveEngineData, ExternEngine, ExternResult, IntoExternResult, KernelStringSlice,
     NullableCvoid, SharedExternEngine, SharedSchema, TryFromStringSlice,
@@ -25,16 +48,29 @@ pub struct FileMeta {
     pub size: usize,
 }
 
+// The batches of a read, each tagged with the index of the file it came from
+type TaggedReadIterator =
+    Box<dyn Iterator<Item = DeltaResult<(usize, Box<dyn EngineData>)>> + Send>;
+
+// Tag all the batches of a single file read with file index 0
+fn tag_single_file(data: FileDataReadResultIterator) -> TaggedReadIterator {
+    Box::new(data.map(|batch| batch.map(|batch| (0, batch))))
+}
+
 // Intentionally opaque to the engine.
 pub struct FileReadResultIterator {
     // Box -> Wrap its unsized content this struct is fixed-size with thin pointers.
     // Item = Box<dyn EngineData>, see above, Vec<bool> -> can become a KernelBoolSlice
-    data: FileDataReadResultIterator,
+    data: TaggedReadIterator,
 
     // Also keep a reference to the external engine for its error allocator.
     // Parquet and Json handlers don't hold any reference to the tokio reactor, so the iterator
     // terminates early if the last engine goes out of scope.
     engine: Arc<dyn ExternEngine>,
+
+    // Set once the engine starts polling the iterator, at which point it owns the data
+    #[cfg(feature = "default-engine-base")]
+    poll: Option<PollNext<(usize, Box<dyn EngineData>)>>,
 }
 
 #[handle_descriptor(target=FileReadResultIterator, mutable=true, sized=true)]
@@ -79,7 +115,7 @@ fn read_result_next_impl(
         engine_data: Handle<ExclusiveEngineData>,
     ),
 ) -> DeltaResult<bool> {
-    if let Some(data) = iter.data.next().transpose()? {
+    if let Some((_, data)) = iter.data.next().transpose()? {
         (engine_visitor)(engine_context, data.into());
         Ok(true)
     } else {
@@ -87,6 +123,130 @@ fn read_result_next_impl(
     }
 }
 
+/// Like [`read_result_next`], but also pass the engine the index of the file the batch was read
+/// from, in the `files` passed to [`read_parquet_files`]. Batches of iterators returned by the
+/// single-file read functions have file index 0.
+///
+/// # Safety
+///
+/// The iterator must be valid (returned by [`read_parquet_file`] or [`read_parquet_files`]) and not
+/// yet freed by [`free_read_result_iter`]. The visitor function pointer must be non-null.
+#[no_mangle]
+pub unsafe extern "C" fn read_result_next_with_file_index(
+    mut data: Handle<ExclusiveFileReadResultIterator>,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        file_index: usize,
+        engine_data: Handle<ExclusiveEngineData>,
+    ),
+) -> ExternResult<bool> {
+    let iter = unsafe { data.as_mut() };
+    read_result_next_with_file_index_impl(iter, engine_context, engine_visitor)
+        .into_extern_result(iter.engine.error_allocator())
+}
+
+fn read_result_next_with_file_index_impl(
+    iter: &mut FileReadResultIterator,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        file_index: usize,
+        engine_data: Handle<ExclusiveEngineData>,
+    ),
+) -> DeltaResult<bool> {
+    if let Some((file_index, data)) = iter.data.next().transpose()? {
+        (engine_visitor)(engine_context, file_index, data.into());
+        Ok(true)
+    } else {
+        Ok(false)
+    }
+}
+
+/// Non-blocking version of [`read_result_next`]. If the next batch has already been read, call the
+/// engine back with it as [`read_result_next`] does and return [`PollStatus::Ready`], or return
+/// [`PollStatus::Done`] if there are no more batches. Otherwise start reading the next batch on the
+/// engine's executor and return [`PollStatus::Pending`]. Kernel calls `waker` once the batch is
+/// ready, after which the engine should poll again to get it. Once a poll returned
+/// [`PollStatus::Done`], every later poll returns it right away.
+///
+/// Once an iterator has been polled, the engine must only poll it: calling [`read_result_next`] or
+/// [`read_result_into_arrow_stream`] on it behaves as if it were exhausted. The iterator can be
+/// freed while a read is pending, in which case `waker` is not called.
+///
+/// # Safety
+///
+/// The iterator must be valid (returned by [`read_parquet_file`]) and not yet freed by
+/// [`free_read_result_iter`]. The visitor and waker function pointers must be non-null.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn read_result_poll(
+    mut data: Handle<ExclusiveFileReadResultIterator>,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        engine_data: Handle<ExclusiveEngineData>,
+    ),
+    waker: PollWaker,
+) -> ExternResult<PollStatus> {
+    let iter = unsafe { data.as_mut() };
+    read_result_poll_impl(iter, engine_context, engine_visitor, waker)
+        .into_extern_result(iter.engine.error_allocator())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn read_result_poll_impl(
+    iter: &mut FileReadResultIterator,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        engine_data: Handle<ExclusiveEngineData>,
+    ),
+    waker: PollWaker,
+) -> DeltaResult<PollStatus> {
+    let data = &mut iter.data;
+    let executor = iter.engine.executor().cloned();
+    let poll = iter.poll.get_or_insert_with(|| {
+        let data = std::mem::replace(data, Box::new(std::iter::empty()));
+        PollNext::new(data, executor)
+    });
+    let status = match poll.poll_next(waker)? {
+        Poll::Ready(Some((_, data))) => {
+            (engine_visitor)(engine_context, data.into());
+            PollStatus::Ready
+        }
+        Poll::Ready(None) => PollStatus::Done,
+        Poll::Pending => PollStatus::Pending,
+    };
+    Ok(status)
+}
+
+/// Turn a read result iterator into an arrow [`FFI_ArrowArrayStream`], as defined by the arrow [C
+/// Stream Interface](https://arrow.apache.org/docs/format/CStreamInterface.html). This consumes the
+/// iterator, so the engine must _not_ call [`read_result_next`] or [`free_read_result_iter`] on it
+/// afterwards. `schema` must be the schema the file was read with. Batches are only read when the
+/// engine pulls them from the stream, so at most one batch is in memory at a time. If this function
+/// returns an `Ok` variant the _engine_ must release the stream and free the returned struct.
+///
+/// # Safety
+///
+/// The iterator must be valid (returned by [`read_parquet_file`]) and not yet freed by
+/// [`free_read_result_iter`]. Caller is responsible for passing a valid schema handle.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn read_result_into_arrow_stream(
+    data: Handle<ExclusiveFileReadResultIterator>,
+    schema: Handle<SharedSchema>,
+) -> ExternResult<*mut FFI_ArrowArrayStream> {
+    let mut iter = unsafe { data.into_inner() };
+    let schema = unsafe { schema.as_ref() };
+    let engine = iter.engine.clone();
+    // can't move out of `iter`, since it implements `Drop`
+    let data = std::mem::replace(&mut iter.data, Box::new(std::iter::empty()));
+    let data = data.map(|batch| batch.map(|(_, batch)| batch));
+    engine_data_to_arrow_stream(data, schema, engine.clone()).into_extern_result(&engine.as_ref())
+}
+
 /// Free the memory from the passed read result iterator
 /// # Safety
 ///
@@ -99,18 +259,31 @@ pub unsafe extern "C" fn free_read_result_iter(data: Handle<ExclusiveFileReadRes
 
 /// Use the specified engine's [`delta_kernel::ParquetHandler`] to read the specified file.
 ///
+/// If `predicate` is not `NULL`, it is passed to the parquet handler as a hint, which the default
+/// engine uses to skip row groups whose footer statistics show they contain no matching rows. As
+/// with any data skipping, rows that don't match the predicate may still be returned, so the
+/// engine must still apply the predicate to the returned data if it needs exact results. The
+/// predicate must only reference columns of `physical_schema`. It is made from the engine's
+/// predicate by [`kernel_predicate_from_engine`], and is not freed by this call, so one predicate
+/// can be shared by all the reads of a scan.
+///
 /// # Safety
-/// Caller is responsible for calling with a valid `ExternEngineHandle` and `FileMeta`
+/// Caller is responsible for calling with a valid `ExternEngineHandle` and `FileMeta`, and a valid
+/// `SharedPredicate` or `NULL`
+///
+/// [`kernel_predicate_from_engine`]: crate::scan::kernel_predicate_from_engine
 #[no_mangle]
 pub unsafe extern "C" fn read_parquet_file(
     engine: Handle<SharedExternEngine>, // TODO Does this cause a free?
     file: &FileMeta,
     physical_schema: Handle<SharedSchema>,
+    predicate: Option<Handle<SharedPredicate>>,
 ) -> ExternResult<Handle<ExclusiveFileReadResultIterator>> {
     let engine = unsafe { engine.clone_as_arc() };
     let physical_schema = unsafe { physical_schema.clone_as_arc() };
     let path = unsafe { TryFromStringSlice::try_from_slice(&file.path) };
-    let res = read_parquet_file_impl(engine.clone(), path, file, physical_schema);
+    let predicate = predicate.map(|predicate| unsafe { predicate.clone_as_arc() });
+    let res = read_parquet_file_impl(engine.clone(), path, file, physical_schema, predicate);
     res.into_extern_result(&engine.as_ref())
 }
 
@@ -119,7 +292,31 @@ fn read_parquet_file_impl(
     path: DeltaResult<&str>,
     file: &FileMeta,
     physical_schema: Arc<Schema>,
+    predicate: Option<PredicateRef>,
 ) -> DeltaResult<Handle<ExclusiveFileReadResultIterator>> {
+    let data = read_parquet_file_data(
+        extern_engine.as_ref(),
+        path,
+        file,
+        physical_schema,
+        predicate,
+    )?;
+    let res = Box::new(FileReadResultIterator {
+        data: tag_single_file(data),
+        engine: extern_engine,
+        #[cfg(feature = "default-engine-base")]
+        poll: None,
+    });
+    Ok(res.into())
+}
+
+fn read_parquet_file_data(
+    extern_engine: &dyn ExternEngine,
+    path: DeltaResult<&str>,
+    file: &FileMeta,
+    physical_schema: Arc<Schema>,
+    predicate: Option<PredicateRef>,
+) -> DeltaResult<FileDataReadResultIterator> {
     let engine = extern_engine.engine();
     let parquet_handler = engine.parquet_handler();
     let location = Url::parse(path?)?;
@@ -131,15 +328,391 @@ fn read_parquet_file_impl(
             .try_into()
             .map_err(|_| Error::generic_err("unable to convert to FileSize"))?,
     };
-    // TODO: Plumb the predicate through the FFI?
-    let data = parquet_handler.read_parquet_files(&[delta_fm], physical_schema, None)?;
+    parquet_handler.read_parquet_files(&[delta_fm], physical_schema, predicate)
+}
+
+/// Use the specified engine's [`delta_kernel::ParquetHandler`] to read the specified file, dropping
+/// any rows deleted by the deletion vector described by `dv_info`. The batches returned by the
+/// iterator are already filtered, so the engine must _not_ apply the selection vector from
+/// [`selection_vector_from_dv`] to them again. If `dv_info` has no deletion vector this is
+/// equivalent to [`read_parquet_file`].
+///
+/// `predicate` is handled as in [`read_parquet_file`], except that it is ignored for files that
+/// have a deletion vector: the deletion vector is applied by row position, so no row groups may be
+/// skipped for those files.
+///
+/// The default parquet handler can't be asked to skip rows by position, so deleted rows are still
+/// decoded, and then dropped from each batch with an arrow filter. For a file with few deleted rows
+/// this costs little more than the read itself, but a file with most of its rows deleted is still
+/// decoded in full.
+///
+/// # Safety
+/// Caller is responsible for calling with a valid `ExternEngineHandle`, `FileMeta` and `DvInfo`,
+/// and a `root_url` that is the root of the table `dv_info` came from.
+///
+/// [`selection_vector_from_dv`]: crate::scan::selection_vector_from_dv
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn read_parquet_file_with_dv(
+    engine: Handle<SharedExternEngine>,
+    file: &FileMeta,
+    physical_schema: Handle<SharedSchema>,
+    dv_info: &DvInfo,
+    root_url: KernelStringSlice,
+    predicate: Option<Handle<SharedPredicate>>,
+) -> ExternResult<Handle<ExclusiveFileReadResultIterator>> {
+    let engine = unsafe { engine.clone_as_arc() };
+    let physical_schema = unsafe { physical_schema.clone_as_arc() };
+    let path = unsafe { TryFromStringSlice::try_from_slice(&file.path) };
+    let root_url = unsafe { unwrap_and_parse_path_as_url(root_url) };
+    let predicate = predicate.map(|predicate| unsafe { predicate.clone_as_arc() });
+    let res = read_parquet_file_with_dv_impl(
+        engine.clone(),
+        path,
+        file,
+        physical_schema,
+        dv_info,
+        root_url,
+        predicate,
+    );
+    res.into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn read_parquet_file_with_dv_impl(
+    extern_engine: Arc<dyn ExternEngine>,
+    path: DeltaResult<&str>,
+    file: &FileMeta,
+    physical_schema: Arc<Schema>,
+    dv_info: &DvInfo,
+    root_url: DeltaResult<Url>,
+    predicate: Option<PredicateRef>,
+) -> DeltaResult<Handle<ExclusiveFileReadResultIterator>> {
+    // Resolve the deletion vector before starting the read, so a bad DV fails the call rather than
+    // the first `read_result_next`
+    let selection_vector = dv_cache::selection_vector(dv_info, extern_engine.as_ref(), &root_url?)?;
+    let predicate = predicate.filter(|_| selection_vector.is_none());
+    let mut data = read_parquet_file_data(
+        extern_engine.as_ref(),
+        path,
+        file,
+        physical_schema,
+        predicate,
+    )?;
+    if let Some(selection_vector) = selection_vector {
+        data = filter_deleted_rows(data, selection_vector);
+    }
+    let res = Box::new(FileReadResultIterator {
+        data: tag_single_file(data),
+        engine: extern_engine,
+        #[cfg(feature = "default-engine-base")]
+        poll: None,
+    });
+    Ok(res.into())
+}
+
+/// A file to read with [`read_parquet_files`]
+#[cfg(feature = "default-engine-base")]
+#[repr(C)]
+pub struct ParquetFileToRead {
+    pub file: FileMeta,
+    /// The deletion vector of the file, or NULL. Rows it deletes are dropped, as with
+    /// [`read_parquet_file_with_dv`]
+    pub dv_info: *const DvInfo,
+    /// The transform that turns the physical data of the file into logical data, or NULL if the
+    /// file needs no transform
+    pub transform: *const Expression,
+}
+
+/// Options controlling how many files [`read_parquet_files`] reads at once
+#[cfg(feature = "default-engine-base")]
+#[repr(C)]
+pub struct ReadParquetFilesOptions {
+    /// The maximum number of files being read at once. 0 means one file at a time
+    pub concurrency: usize,
+    /// Don't start reading another file while the total size of the files being read would then
+    /// exceed this many bytes. A file is always read if no other file is. 0 means no limit.
+    ///
+    /// The sizes are the on-disk sizes of the files, which stand in for the memory their reads use:
+    /// kernel can't see how much of a file the parquet handler has fetched, decoded or buffered, so
+    /// a file counts in full from when it is opened until its last batch is returned. Decoded data
+    /// is usually larger than the file, so leave headroom
+    pub memory_budget: u64,
+}
+
+/// Use the specified engine's [`delta_kernel::ParquetHandler`] to read many files with one
+/// iterator. Up to `options.concurrency` files are read at once, so network round trips (e.g. for
+/// footers) and reads of different files overlap, but batches are still returned in file order.
+/// Use [`read_result_next_with_file_index`] to find out which file each batch was read from.
+///
+/// Each file may have a deletion vector, which is applied as in [`read_parquet_file_with_dv`],
+/// and a transform, in which case its batches are transformed to `logical_schema` before being
+/// returned. Both are copied, so the files they came from may be freed once this returns.
+/// `predicate` is handled as in [`read_parquet_file_with_dv`]. If the engine has an executor, a
+/// file's deletion vector is loaded on it while the file's read starts, rather than before, and is
+/// only waited for when the first batch of the file is needed.
+///
+/// Each file is still read by its own call to the parquet handler, so only the round trips of
+/// different files overlap: byte ranges of different files are never merged into one request.
+///
+/// # Safety
+/// Caller is responsible for calling with a valid `ExternEngineHandle`, `files` pointing to
+/// `num_files` valid entries, valid schemas, a `root_url` that is the root of the table the
+/// deletion vectors came from, and a valid `SharedPredicate` or `NULL`
+#[cfg(feature = "default-engine-base")]
+#[allow(clippy::too_many_arguments)]
+#[no_mangle]
+pub unsafe extern "C" fn read_parquet_files(
+    engine: Handle<SharedExternEngine>,
+    files: *const ParquetFileToRead,
+    num_files: usize,
+    physical_schema: Handle<SharedSchema>,
+    logical_schema: Handle<SharedSchema>,
+    root_url: KernelStringSlice,
+    predicate: Option<Handle<SharedPredicate>>,
+    options: ReadParquetFilesOptions,
+) -> ExternResult<Handle<ExclusiveFileReadResultIterator>> {
+    let engine = unsafe { engine.clone_as_arc() };
+    let files = match num_files {
+        0 => &[],
+        _ => unsafe { std::slice::from_raw_parts(files, num_files) },
+    };
+    let physical_schema = unsafe { physical_schema.clone_as_arc() };
+    let logical_schema = unsafe { logical_schema.clone_as_arc() };
+    let root_url = unsafe { unwrap_and_parse_path_as_url(root_url) };
+    let predicate = predicate.map(|predicate| unsafe { predicate.clone_as_arc() });
+    let res = read_parquet_files_impl(
+        engine.clone(),
+        files,
+        physical_schema,
+        logical_schema,
+        root_url,
+        predicate,
+        options,
+    );
+    res.into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn read_parquet_files_impl(
+    extern_engine: Arc<dyn ExternEngine>,
+    files: &[ParquetFileToRead],
+    physical_schema: SchemaRef,
+    logical_schema: SchemaRef,
+    root_url: DeltaResult<Url>,
+    predicate: Option<PredicateRef>,
+    options: ReadParquetFilesOptions,
+) -> DeltaResult<Handle<ExclusiveFileReadResultIterator>> {
+    let pending = files
+        .iter()
+        .enumerate()
+        .map(|(index, to_read)| -> DeltaResult<_> {
+            let path: DeltaResult<&str> =
+                unsafe { TryFromStringSlice::try_from_slice(&to_read.file.path) };
+            Ok(PendingFile {
+                index,
+                file: delta_kernel::FileMeta {
+                    location: Url::parse(path?)?,
+                    last_modified: to_read.file.last_modified,
+                    size: to_read
+                        .file
+                        .size
+                        .try_into()
+                        .map_err(|_| Error::generic_err("unable to convert to FileSize"))?,
+                },
+                dv_info: unsafe { to_read.dv_info.as_ref() }.cloned(),
+                transform: unsafe { to_read.transform.as_ref() }.map(|t| Arc::new(t.clone())),
+            })
+        })
+        .collect::<DeltaResult<_>>()?;
+    let read = MultiFileRead {
+        engine: extern_engine.clone(),
+        physical_schema,
+        logical_schema,
+        root_url: root_url?,
+        predicate,
+        concurrency: options.concurrency.max(1),
+        memory_budget: options.memory_budget,
+        pending,
+        open: VecDeque::new(),
+        open_bytes: 0,
+    };
     let res = Box::new(FileReadResultIterator {
-        data,
+        data: Box::new(read),
         engine: extern_engine,
+        poll: None,
     });
     Ok(res.into())
 }
 
+#[cfg(feature = "default-engine-base")]
+struct PendingFile {
+    index: usize,
+    file: delta_kernel::FileMeta,
+    dv_info: Option<DvInfo>,
+    transform: Option<ExpressionRef>,
+}
+
+// Reads a list of files in order, keeping the next few files open so their reads (which the
+// parquet handler starts in the background as soon as a file is opened) overlap
+#[cfg(feature = "default-engine-base")]
+struct MultiFileRead {
+    engine: Arc<dyn ExternEngine>,
+    physical_schema: SchemaRef,
+    logical_schema: SchemaRef,
+    root_url: Url,
+    predicate: Option<PredicateRef>,
+    concurrency: usize,
+    memory_budget: u64,
+    pending: VecDeque<PendingFile>,
+    // (file index, file size, batches) of the files being read, in file order
+    open: VecDeque<(usize, u64, FileDataReadResultIterator)>,
+    open_bytes: u64,
+}
+
+#[cfg(feature = "default-engine-base")]
+impl MultiFileRead {
+    fn open_files(&mut self) -> DeltaResult<()> {
+        while self.open.len() < self.concurrency {
+            let Some(next) = self.pending.front() else {
+                break;
+            };
+            let over_budget =
+                self.memory_budget > 0 && self.open_bytes + next.file.size > self.memory_budget;
+            if over_budget && !self.open.is_empty() {
+                break;
+            }
+            let Some(next) = self.pending.pop_front() else {
+                break;
+            };
+            let (index, size) = (next.index, next.file.size);
+            let data = self.open_file(next)?;
+            self.open.push_back((index, size, data));
+            self.open_bytes += size;
+        }
+        Ok(())
+    }
+
+    fn open_file(&self, to_read: PendingFile) -> DeltaResult<FileDataReadResultIterator> {
+        let engine = self.engine.engine();
+        let dv_info = to_read.dv_info.filter(DvInfo::has_vector);
+        // the deletion vector is loaded on the engine's executor while the parquet read starts, and
+        // is only waited for once the first batch of the file is wanted
+        let selection_vector = dv_info.map(|dv_info| {
+            let engine = self.engine.clone();
+            let root_url = self.root_url.clone();
+            let load = move || dv_cache::selection_vector(&dv_info, engine.as_ref(), &root_url);
+            match self.engine.executor() {
+                Some(executor) => Ok(start_blocking(executor.clone(), load)),
+                None => load().map(Deferred::ready),
+            }
+        });
+        let selection_vector = selection_vector.transpose()?;
+        let predicate = self
+            .predicate
+            .clone()
+            .filter(|_| selection_vector.is_none());
+        let data = engine.parquet_handler().read_parquet_files(
+            &[to_read.file],
+            self.physical_schema.clone(),
+            predicate,
+        )?;
+        let mut data = match selection_vector {
+            Some(selection_vector) => filter_deferred_deleted_rows(data, selection_vector),
+            None => data,
+        };
+        if let Some(transform) = to_read.transform {
+            let evaluator = engine.evaluation_handler().new_expression_evaluator(
+                self.physical_schema.clone(),
+                transform,
+                self.logical_schema.clone().into(),
+            );
+            data = Box::new(data.map(move |batch| evaluator.evaluate(batch?.as_ref())));
+        }
+        Ok(data)
+    }
+}
+
+#[cfg(feature = "default-engine-base")]
+impl Iterator for MultiFileRead {
+    type Item = DeltaResult<(usize, Box<dyn EngineData>)>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            if let Err(err) = self.open_files() {
+                // stop reading after the first failure
+                self.pending.clear();
+                self.open.clear();
+                return Some(Err(err));
+            }
+            let (index, _, data) = self.open.front_mut()?;
+            let index = *index;
+            match data.next() {
+                Some(batch) => return Some(batch.map(|batch| (index, batch))),
+                None => {
+                    if let Some((_, size, _)) = self.open.pop_front() {
+                        self.open_bytes -= size;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Like `filter_deleted_rows`, but for a selection vector that may still be loading. It is waited
+// for when the first batch is wanted
+#[cfg(feature = "default-engine-base")]
+fn filter_deferred_deleted_rows(
+    data: FileDataReadResultIterator,
+    selection_vector: Deferred<Option<Vec<bool>>>,
+) -> FileDataReadResultIterator {
+    let filtered = std::iter::once_with(move || -> FileDataReadResultIterator {
+        match selection_vector.wait() {
+            Ok(Some(selection_vector)) => filter_deleted_rows(data, selection_vector),
+            Ok(None) => data,
+            Err(err) => Box::new(std::iter::once(Err(err))),
+        }
+    });
+    Box::new(filtered.flatten())
+}
+
+/// Apply `selection_vector` to the batches of a single file, in file order. As with all selection
+/// vectors, rows past the end of the vector are selected. Batches with no deleted rows are passed
+/// through untouched, and batches with no selected rows are dropped entirely. The vector is packed
+/// into an arrow boolean array once, and each batch is filtered with a (zero-copy) slice of it.
+#[cfg(feature = "default-engine-base")]
+pub(crate) fn filter_deleted_rows(
+    data: FileDataReadResultIterator,
+    selection_vector: Vec<bool>,
+) -> FileDataReadResultIterator {
+    let selection_vector = BooleanArray::from(selection_vector);
+    let mut row_offset = 0;
+    let filtered = data.map(move |batch| -> DeltaResult<Box<dyn EngineData>> {
+        let batch = batch?;
+        let num_rows = batch.len();
+        let start = row_offset.min(selection_vector.len());
+        let end = (row_offset + num_rows).min(selection_vector.len());
+        row_offset += num_rows;
+        let selected = selection_vector.slice(start, end - start);
+        if selected.true_count() == selected.len() {
+            return Ok(batch);
+        }
+        // only the batch the vector ends in needs padding, so this copies at most once per file
+        let filter = if selected.len() == num_rows {
+            selected
+        } else {
+            let mut filter = BooleanBufferBuilder::new(num_rows);
+            filter.append_buffer(selected.values());
+            filter.append_n(num_rows - selected.len(), true);
+            BooleanArray::new(filter.finish(), None)
+        };
+        let batch = ArrowEngineData::try_from_engine_data(batch)?;
+        let filtered = filter_record_batch(batch.record_batch(), &filter)?;
+        Ok(Box::new(ArrowEngineData::new(filtered)))
+    });
+    Box::new(filtered.filter(|batch| !matches!(batch, Ok(batch) if batch.len() == 0)))
+}
+
 // Expression Eval
 
 #[handle_descriptor(target=dyn ExpressionEvaluator, mutable=false)]
@@ -178,6 +751,115 @@ fn new_expression_evaluator_impl(
     evaluator.into()
 }
 
+/// A "prepared" expression evaluator, which holds the engine, input schema and output type that
+/// many expressions will be evaluated with. Bind it to each expression by calling
+/// [`bind_prepared_expression_evaluator`].
+///
+/// This is useful when an engine needs to apply a different expression to each file of a scan
+/// (e.g. the per-file `transform` of a partitioned table), but the input and output schemas are the
+/// same for all files. Nothing is resolved ahead of time: binding asks the engine's
+/// `EvaluationHandler` for a new evaluator, with its own copy of the output type, just like
+/// [`new_expression_evaluator`] does (the default engine's evaluator only resolves columns when it
+/// evaluates a batch). The saving is in the expression, which
+/// [`bind_prepared_expression_evaluator_shared`] shares rather than copies.
+pub struct PreparedExpressionEvaluator {
+    engine: Arc<dyn ExternEngine>,
+    input_schema: SchemaRef,
+    output_type: DataType,
+}
+
+#[handle_descriptor(target=PreparedExpressionEvaluator, mutable=false, sized=true)]
+pub struct SharedPreparedExpressionEvaluator;
+
+/// Creates a new prepared expression evaluator for the passed engine's `EvaluationHandler`. Use
+/// [`bind_prepared_expression_evaluator`] to get an evaluator for a specific expression. It is the
+/// responsibility of the _engine_ to free the returned handle by calling
+/// [`free_prepared_expression_evaluator`].
+///
+/// `output_schema` is the schema of the struct every bound expression evaluates to.
+///
+/// # Safety
+/// Caller is responsible for calling with a valid `Engine` and `SharedSchema`s
+#[no_mangle]
+pub unsafe extern "C" fn new_prepared_expression_evaluator(
+    engine: Handle<SharedExternEngine>,
+    input_schema: Handle<SharedSchema>,
+    output_schema: Handle<SharedSchema>,
+) -> Handle<SharedPreparedExpressionEvaluator> {
+    let engine = unsafe { engine.clone_as_arc() };
+    let input_schema = unsafe { input_schema.clone_as_arc() };
+    let output_type: DataType = output_schema.as_ref().clone().into();
+    Arc::new(PreparedExpressionEvaluator {
+        engine,
+        input_schema,
+        output_type,
+    })
+    .into()
+}
+
+/// Get an evaluator for `expression` out of a prepared evaluator. The returned evaluator is
+/// equivalent to one returned by [`new_expression_evaluator`] with the input schema and output type
+/// the prepared evaluator was created with, and must be freed by calling
+/// [`free_expression_evaluator`]. The prepared evaluator can be bound (and freed) independently of
+/// any evaluators bound from it.
+///
+/// The evaluator outlives `expression`, so this makes a deep copy of it. Engines that bind many
+/// evaluators should get the expression as a [`SharedExpression`] handle where they can, and bind
+/// it with [`bind_prepared_expression_evaluator_shared`], which doesn't copy.
+///
+/// # Safety
+/// Caller is responsible for calling with a valid `SharedPreparedExpressionEvaluator` and
+/// `Expression`
+#[no_mangle]
+pub unsafe extern "C" fn bind_prepared_expression_evaluator(
+    prepared: Handle<SharedPreparedExpressionEvaluator>,
+    expression: &Expression,
+) -> Handle<SharedExpressionEvaluator> {
+    let prepared = unsafe { prepared.as_ref() };
+    bind_prepared_expression_evaluator_impl(prepared, Arc::new(expression.clone()))
+}
+
+/// Like [`bind_prepared_expression_evaluator`], but the returned evaluator shares the expression of
+/// `expression` instead of copying it. The engine still owns `expression`, and can free it as soon
+/// as this returns.
+///
+/// # Safety
+/// Caller is responsible for calling with a valid `SharedPreparedExpressionEvaluator` and
+/// `SharedExpression`
+#[no_mangle]
+pub unsafe extern "C" fn bind_prepared_expression_evaluator_shared(
+    prepared: Handle<SharedPreparedExpressionEvaluator>,
+    expression: &Handle<SharedExpression>,
+) -> Handle<SharedExpressionEvaluator> {
+    let prepared = unsafe { prepared.as_ref() };
+    let expression = unsafe { expression.clone_as_arc() };
+    bind_prepared_expression_evaluator_impl(prepared, expression)
+}
+
+fn bind_prepared_expression_evaluator_impl(
+    prepared: &PreparedExpressionEvaluator,
+    expression: ExpressionRef,
+) -> Handle<SharedExpressionEvaluator> {
+    new_expression_evaluator_impl(
+        prepared.engine.clone(),
+        prepared.input_schema.clone(),
+        expression,
+        prepared.output_type.clone(),
+    )
+}
+
+/// Free a prepared expression evaluator
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_prepared_expression_evaluator(
+    prepared: Handle<SharedPreparedExpressionEvaluator>,
+) {
+    debug!("engine released prepared expression evaluator");
+    prepared.drop_handle();
+}
+
 /// Free an expression evaluator
 /// # Safety
 ///
@@ -214,7 +896,12 @@ fn evaluate_expression_impl(
 
 #[cfg(test)]
 mod tests {
-    use super::{free_expression_evaluator, new_expression_evaluator};
+    use super::{
+        bind_prepared_expression_evaluator, bind_prepared_expression_evaluator_shared,
+        free_expression_evaluator, free_prepared_expression_evaluator, new_expression_evaluator,
+        new_prepared_expression_evaluator,
+    };
+    use crate::expressions::SharedExpression;
     use crate::{free_engine, handle::Handle, tests::get_default_engine, SharedSchema};
     use delta_kernel::{
         schema::{DataType, StructField, StructType},
@@ -244,4 +931,478 @@ mod tests {
             free_expression_evaluator(evaluator);
         }
     }
+
+    #[test]
+    fn test_prepared_expression_evaluator() {
+        let engine = get_default_engine("memory:///doesntmatter/foo");
+        let in_schema = Arc::new(
+            StructType::try_new(vec![StructField::new("a", DataType::LONG, true)]).unwrap(),
+        );
+        let output_type: Handle<SharedSchema> = in_schema.clone().into();
+        let in_schema_handle: Handle<SharedSchema> = in_schema.into();
+        unsafe {
+            let prepared = new_prepared_expression_evaluator(
+                engine.shallow_copy(),
+                in_schema_handle.shallow_copy(),
+                output_type.shallow_copy(),
+            );
+            in_schema_handle.drop_handle();
+            output_type.drop_handle();
+            free_engine(engine);
+            // bind the same prepared evaluator to several expressions, and free them in any order
+            let mut evaluators: Vec<_> = [1, 2, 3]
+                .into_iter()
+                .map(|i| {
+                    bind_prepared_expression_evaluator(
+                        prepared.shallow_copy(),
+                        &Expression::literal(i),
+                    )
+                })
+                .collect();
+            let shared: Handle<SharedExpression> = Arc::new(Expression::literal(4)).into();
+            evaluators.push(bind_prepared_expression_evaluator_shared(
+                prepared.shallow_copy(),
+                &shared,
+            ));
+            shared.drop_handle();
+            free_prepared_expression_evaluator(prepared);
+            for evaluator in evaluators {
+                free_expression_evaluator(evaluator);
+            }
+        }
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[test]
+    #[cfg_attr(miri, ignore)] // reads files from disk
+    fn test_read_parquet_files() {
+        use super::{
+            free_read_result_iter, read_parquet_files, read_result_next_with_file_index, FileMeta,
+            ParquetFileToRead, ReadParquetFilesOptions,
+        };
+        use crate::ffi_test_utils::ok_or_panic;
+        use crate::{kernel_string_slice, ExclusiveEngineData, NullableCvoid};
+        use delta_kernel::arrow::array::{Array, Int64Array, RecordBatch};
+        use delta_kernel::engine::arrow_data::ArrowEngineData;
+        use delta_kernel::parquet::arrow::arrow_writer::ArrowWriter;
+        use std::ffi::c_void;
+        use std::ptr::NonNull;
+        use url::Url;
+
+        type Batches = Vec<(usize, usize, Vec<i64>)>;
+        // record the file index, number of columns and first column of each batch
+        extern "C" fn visit_batch(
+            context: NullableCvoid,
+            file_index: usize,
+            data: Handle<ExclusiveEngineData>,
+        ) {
+            let batches = unsafe { &mut *(context.unwrap().as_ptr() as *mut Batches) };
+            let data = unsafe { data.into_inner() };
+            let data = ArrowEngineData::try_from_engine_data(data).unwrap();
+            let batch = data.record_batch();
+            let column = batch
+                .column(0)
+                .as_any()
+                .downcast_ref::<Int64Array>()
+                .unwrap();
+            batches.push((file_index, batch.num_columns(), column.values().to_vec()));
+        }
+
+        let dir = tempfile::tempdir().unwrap();
+        let paths: Vec<_> = (0..3)
+            .map(|i| {
+                let path = dir.path().join(format!("{i}.parquet"));
+                let values = Int64Array::from(vec![i * 10, i * 10 + 1]);
+                let batch = RecordBatch::try_from_iter([("a", Arc::new(values) as _)]).unwrap();
+                let file = std::fs::File::create(&path).unwrap();
+                let mut writer = ArrowWriter::try_new(file, batch.schema(), None).unwrap();
+                writer.write(&batch).unwrap();
+                writer.close().unwrap();
+                let size = std::fs::metadata(&path).unwrap().len() as usize;
+                (Url::from_file_path(&path).unwrap().to_string(), size)
+            })
+            .collect();
+        let physical_schema = Arc::new(
+            StructType::try_new(vec![StructField::nullable("a", DataType::LONG)]).unwrap(),
+        );
+        let logical_schema = Arc::new(
+            StructType::try_new(vec![
+                StructField::nullable("a", DataType::LONG),
+                StructField::nullable("b", DataType::LONG),
+            ])
+            .unwrap(),
+        );
+        // only the second file needs a transform
+        let transform =
+            Expression::struct_from([Expression::column(["a"]), Expression::literal(7i64)]);
+        let files: Vec<_> = paths
+            .iter()
+            .enumerate()
+            .map(|(i, (path, size))| ParquetFileToRead {
+                file: FileMeta {
+                    path: kernel_string_slice!(path),
+                    last_modified: 0,
+                    size: *size,
+                },
+                dv_info: std::ptr::null(),
+                transform: match i {
+                    1 => &transform,
+                    _ => std::ptr::null(),
+                },
+            })
+            .collect();
+
+        let root = Url::from_directory_path(dir.path()).unwrap().to_string();
+        let engine = get_default_engine(&root);
+        let physical: Handle<SharedSchema> = physical_schema.into();
+        let logical: Handle<SharedSchema> = logical_schema.into();
+        // a budget of one byte still reads one file at a time
+        for (concurrency, memory_budget) in [(0, 0), (2, 0), (3, 1)] {
+            let iter = ok_or_panic(unsafe {
+                read_parquet_files(
+                    engine.shallow_copy(),
+                    files.as_ptr(),
+                    files.len(),
+                    physical.shallow_copy(),
+                    logical.shallow_copy(),
+                    kernel_string_slice!(root),
+                    None,
+                    ReadParquetFilesOptions {
+                        concurrency,
+                        memory_budget,
+                    },
+                )
+            });
+            let mut batches: Batches = vec![];
+            let context = NonNull::new(&mut batches as *mut Batches as *mut c_void);
+            while ok_or_panic(unsafe {
+                read_result_next_with_file_index(iter.shallow_copy(), context, visit_batch)
+            }) {}
+            unsafe { free_read_result_iter(iter) };
+            let expected = vec![
+                (0, 1, vec![0, 1]),
+                (1, 2, vec![10, 11]),
+                (2, 1, vec![20, 21]),
+            ];
+            assert_eq!(batches, expected);
+        }
+        unsafe {
+            physical.drop_handle();
+            logical.drop_handle();
+            free_engine(engine);
+        }
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[test]
+    fn test_filter_deleted_rows() {
+        use super::filter_deleted_rows;
+        use delta_kernel::arrow::array::{Array, Int64Array, RecordBatch};
+        use delta_kernel::engine::arrow_data::ArrowEngineData;
+        use delta_kernel::{EngineData, FileDataReadResultIterator};
+
+        fn batch(values: Vec<i64>) -> delta_kernel::DeltaResult<Box<dyn EngineData>> {
+            let batch =
+                RecordBatch::try_from_iter([("a", Arc::new(Int64Array::from(values)) as _)])?;
+            Ok(Box::new(ArrowEngineData::new(batch)))
+        }
+        // second batch is fully deleted, and the vector ends partway through the third
+        let data: FileDataReadResultIterator = Box::new(
+            [
+                batch(vec![0, 1, 2]),
+                batch(vec![3, 4]),
+                batch(vec![5, 6, 7]),
+            ]
+            .into_iter(),
+        );
+        let selection_vector = vec![true, false, true, false, false, false];
+        let values: Vec<Vec<i64>> = filter_deleted_rows(data, selection_vector)
+            .map(|data| {
+                let data = ArrowEngineData::try_from_engine_data(data.unwrap()).unwrap();
+                let column = data.record_batch().column(0);
+                let column = column.as_any().downcast_ref::<Int64Array>().unwrap();
+                column.values().to_vec()
+            })
+            .collect();
+        assert_eq!(values, vec![vec![0, 2], vec![6, 7]]);
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    mod predicate_pushdown {
+        use super::super::{
+            free_read_result_iter, read_parquet_file, read_parquet_file_with_dv,
+            read_parquet_files, read_result_next, read_result_next_with_file_index, FileMeta,
+            ParquetFileToRead, ReadParquetFilesOptions,
+        };
+        use crate::expressions::free_kernel_predicate;
+        use crate::expressions::kernel_visitor::{
+            visit_expression_column, visit_expression_literal_int, visit_expression_literal_long,
+            visit_predicate_gt, KernelExpressionVisitorState,
+        };
+        use crate::ffi_test_utils::{allocate_err, ok_or_panic};
+        use crate::scan::{kernel_predicate_from_engine, EnginePredicate};
+        use crate::{
+            free_engine, handle::Handle, kernel_string_slice, tests::get_default_engine,
+            ExclusiveEngineData, ExclusiveFileReadResultIterator, NullableCvoid,
+            SharedExternEngine, SharedSchema,
+        };
+        use delta_kernel::actions::deletion_vector::DeletionVectorDescriptor;
+        use delta_kernel::arrow::array::{Int64Array, RecordBatch};
+        use delta_kernel::parquet::arrow::arrow_writer::ArrowWriter;
+        use delta_kernel::parquet::file::properties::WriterProperties;
+        use delta_kernel::scan::state::DvInfo;
+        use delta_kernel::schema::{DataType, StructField, StructType};
+        use delta_kernel::EngineData;
+        use std::ffi::c_void;
+        use std::ptr::NonNull;
+        use std::sync::Arc;
+        use url::Url;
+
+        // `a > 24`
+        extern "C" fn a_gt_24(_: *mut c_void, state: &mut KernelExpressionVisitorState) -> usize {
+            let column = "a";
+            let column = ok_or_panic(unsafe {
+                visit_expression_column(state, kernel_string_slice!(column), allocate_err)
+            });
+            let literal = visit_expression_literal_long(state, 24);
+            visit_predicate_gt(state, column, literal)
+        }
+
+        // `value > 100`, which no row of table-with-dv-small matches
+        extern "C" fn value_gt_100(
+            _: *mut c_void,
+            state: &mut KernelExpressionVisitorState,
+        ) -> usize {
+            let column = "value";
+            let column = ok_or_panic(unsafe {
+                visit_expression_column(state, kernel_string_slice!(column), allocate_err)
+            });
+            let literal = visit_expression_literal_int(state, 100);
+            visit_predicate_gt(state, column, literal)
+        }
+
+        extern "C" fn count_rows(context: NullableCvoid, data: Handle<ExclusiveEngineData>) {
+            let num_rows = unsafe { &mut *(context.unwrap().as_ptr() as *mut usize) };
+            *num_rows += unsafe { data.into_inner() }.len();
+        }
+
+        fn read_all(iter: Handle<ExclusiveFileReadResultIterator>) -> usize {
+            let mut num_rows = 0usize;
+            let context = NonNull::new(&mut num_rows as *mut usize as *mut c_void);
+            loop {
+                let more = unsafe { read_result_next(iter.shallow_copy(), context, count_rows) };
+                if !ok_or_panic(more) {
+                    break;
+                }
+            }
+            unsafe { free_read_result_iter(iter) };
+            num_rows
+        }
+
+        type PredicateVisitor =
+            extern "C" fn(*mut c_void, &mut KernelExpressionVisitorState) -> usize;
+
+        fn read(
+            engine: &Handle<SharedExternEngine>,
+            file: &FileMeta,
+            schema: &Handle<SharedSchema>,
+            dv: Option<(&DvInfo, &str)>,
+            visitor: Option<PredicateVisitor>,
+        ) -> usize {
+            let predicate = visitor.map(|visitor| {
+                let mut predicate = EnginePredicate {
+                    predicate: std::ptr::null_mut(),
+                    visitor,
+                };
+                ok_or_panic(unsafe {
+                    kernel_predicate_from_engine(engine.shallow_copy(), &mut predicate)
+                })
+            });
+            let iter = match dv {
+                Some((dv_info, root)) => unsafe {
+                    read_parquet_file_with_dv(
+                        engine.shallow_copy(),
+                        file,
+                        schema.shallow_copy(),
+                        dv_info,
+                        kernel_string_slice!(root),
+                        predicate.as_ref().map(|predicate| predicate.shallow_copy()),
+                    )
+                },
+                None => unsafe {
+                    read_parquet_file(
+                        engine.shallow_copy(),
+                        file,
+                        schema.shallow_copy(),
+                        predicate.as_ref().map(|predicate| predicate.shallow_copy()),
+                    )
+                },
+            };
+            if let Some(predicate) = predicate {
+                unsafe { free_kernel_predicate(predicate) };
+            }
+            read_all(ok_or_panic(iter))
+        }
+
+        #[test]
+        #[cfg_attr(miri, ignore)] // reads files from disk
+        fn predicate_skips_row_groups() {
+            // three row groups, with a in 0..10, 10..20 and 20..30
+            let dir = tempfile::tempdir().unwrap();
+            let path = dir.path().join("row-groups.parquet");
+            let batch = RecordBatch::try_from_iter([(
+                "a",
+                Arc::new(Int64Array::from_iter_values(0..30)) as _,
+            )])
+            .unwrap();
+            let props = WriterProperties::builder()
+                .set_max_row_group_size(10)
+                .build();
+            let writer_file = std::fs::File::create(&path).unwrap();
+            let mut writer =
+                ArrowWriter::try_new(writer_file, batch.schema(), Some(props)).unwrap();
+            writer.write(&batch).unwrap();
+            writer.close().unwrap();
+            let size = std::fs::metadata(&path).unwrap().len() as usize;
+            let location = Url::from_file_path(&path).unwrap().to_string();
+            let file = FileMeta {
+                path: kernel_string_slice!(location),
+                last_modified: 0,
+                size,
+            };
+
+            let root = Url::from_directory_path(dir.path()).unwrap().to_string();
+            let engine = get_default_engine(&root);
+            let schema: Handle<SharedSchema> = Arc::new(
+                StructType::try_new(vec![StructField::nullable("a", DataType::LONG)]).unwrap(),
+            )
+            .into();
+            assert_eq!(read(&engine, &file, &schema, None, None), 30);
+            // only the last row group can match
+            assert_eq!(read(&engine, &file, &schema, None, Some(a_gt_24)), 10);
+            unsafe {
+                schema.drop_handle();
+                free_engine(engine);
+            }
+        }
+
+        #[test]
+        #[cfg_attr(miri, ignore)] // reads files from disk
+        fn predicate_ignored_with_dv() {
+            let table_root =
+                std::fs::canonicalize("../kernel/tests/data/table-with-dv-small/").unwrap();
+            let root = Url::from_directory_path(&table_root).unwrap().to_string();
+            let location = Url::from_file_path(
+                table_root
+                    .join("part-00000-fae5310a-a37d-4e51-827b-c3d5516560ca-c000.snappy.parquet"),
+            )
+            .unwrap()
+            .to_string();
+            let file = FileMeta {
+                path: kernel_string_slice!(location),
+                last_modified: 0,
+                size: 635,
+            };
+            // the one DV of the table, which deletes 2 of the 10 rows of the file
+            let dv_info = DvInfo::from(DeletionVectorDescriptor {
+                storage_type: "u".to_string(),
+                path_or_inline_dv: "vBn[lx{q8@P<9BNH/isA".to_string(),
+                offset: Some(1),
+                size_in_bytes: 36,
+                cardinality: 2,
+            });
+
+            let engine = get_default_engine(&root);
+            let schema: Handle<SharedSchema> = Arc::new(
+                StructType::try_new(vec![StructField::nullable("value", DataType::INTEGER)])
+                    .unwrap(),
+            )
+            .into();
+            // without a DV the predicate skips the only row group
+            assert_eq!(read(&engine, &file, &schema, None, None), 10);
+            assert_eq!(read(&engine, &file, &schema, None, Some(value_gt_100)), 0);
+            // with one, skipping row groups would shift the rows the DV deletes, so it is ignored
+            let dv = Some((&dv_info, root.as_str()));
+            assert_eq!(read(&engine, &file, &schema, dv, None), 8);
+            assert_eq!(read(&engine, &file, &schema, dv, Some(value_gt_100)), 8);
+            unsafe {
+                schema.drop_handle();
+                free_engine(engine);
+            }
+        }
+
+        #[test]
+        #[cfg_attr(miri, ignore)] // reads files from disk
+        fn read_parquet_files_applies_dvs_loaded_in_the_background() {
+            extern "C" fn count_rows_per_file(
+                context: NullableCvoid,
+                file_index: usize,
+                data: Handle<ExclusiveEngineData>,
+            ) {
+                let num_rows = unsafe { &mut *(context.unwrap().as_ptr() as *mut [usize; 2]) };
+                num_rows[file_index] += unsafe { data.into_inner() }.len();
+            }
+
+            let table_root =
+                std::fs::canonicalize("../kernel/tests/data/table-with-dv-small/").unwrap();
+            let root = Url::from_directory_path(&table_root).unwrap().to_string();
+            let location = Url::from_file_path(
+                table_root
+                    .join("part-00000-fae5310a-a37d-4e51-827b-c3d5516560ca-c000.snappy.parquet"),
+            )
+            .unwrap()
+            .to_string();
+            let dv_info = DvInfo::from(DeletionVectorDescriptor {
+                storage_type: "u".to_string(),
+                path_or_inline_dv: "vBn[lx{q8@P<9BNH/isA".to_string(),
+                offset: Some(1),
+                size_in_bytes: 36,
+                cardinality: 2,
+            });
+            // the same file twice, once with its DV and once without
+            let files =
+                [&dv_info as *const DvInfo, std::ptr::null()].map(|dv_info| ParquetFileToRead {
+                    file: FileMeta {
+                        path: kernel_string_slice!(location),
+                        last_modified: 0,
+                        size: 635,
+                    },
+                    dv_info,
+                    transform: std::ptr::null(),
+                });
+
+            let engine = get_default_engine(&root);
+            let schema: Handle<SharedSchema> = Arc::new(
+                StructType::try_new(vec![StructField::nullable("value", DataType::INTEGER)])
+                    .unwrap(),
+            )
+            .into();
+            let iter = ok_or_panic(unsafe {
+                read_parquet_files(
+                    engine.shallow_copy(),
+                    files.as_ptr(),
+                    files.len(),
+                    schema.shallow_copy(),
+                    schema.shallow_copy(),
+                    kernel_string_slice!(root),
+                    None,
+                    ReadParquetFilesOptions {
+                        concurrency: 2,
+                        memory_budget: 0,
+                    },
+                )
+            });
+            let mut num_rows = [0usize; 2];
+            let context = NonNull::new(&mut num_rows as *mut [usize; 2] as *mut c_void);
+            while ok_or_panic(unsafe {
+                read_result_next_with_file_index(iter.shallow_copy(), context, count_rows_per_file)
+            }) {}
+            assert_eq!(num_rows, [8, 10]);
+            unsafe {
+                free_read_result_iter(iter);
+                schema.drop_handle();
+                free_engine(engine);
+            }
+        }
+    }
 }
@@ -0,0 +1,144 @@
+//! An executor that many default engines can share.
+//!
+//! Every engine built by [`builder_build`] or [`get_default_engine`] normally runs its IO on a
+//! background thread of its own. An engine that works with many tables at once can instead create
+//! one [`EngineExecutor`] with [`new_engine_executor`], and build all of its engines on it with
+//! [`set_builder_executor`], so that the IO of all of them shares a fixed number of threads.
+//!
+//! [`builder_build`]: crate::builder_build
+//! [`get_default_engine`]: crate::get_default_engine
+//! [`set_builder_executor`]: crate::set_builder_executor
+
+use std::future::Future;
+use std::pin::Pin;
+use std::sync::Arc;
+
+use delta_kernel::engine::default::executor::tokio::TokioMultiThreadExecutor;
+use delta_kernel::engine::default::executor::TaskExecutor;
+use delta_kernel::{DeltaResult, Error};
+use delta_kernel_ffi_macros::handle_descriptor;
+use tokio::runtime::Runtime;
+
+use crate::handle::Handle;
+use crate::{AllocateErrorFn, ExternResult, IntoExternResult};
+
+/// A multi-threaded runtime to run the IO of default engines on. Engines built on an executor keep
+/// it alive, so its handle can be freed as soon as the engines are built.
+pub struct EngineExecutor {
+    // only `None` while dropping
+    runtime: Option<Runtime>,
+    executor: TokioMultiThreadExecutor,
+}
+
+#[handle_descriptor(target=EngineExecutor, mutable=false, sized=true)]
+pub struct SharedEngineExecutor;
+
+impl EngineExecutor {
+    fn try_new(worker_threads: usize) -> DeltaResult<Self> {
+        if worker_threads == 0 {
+            return Err(Error::generic(
+                "An executor needs at least one worker thread",
+            ));
+        }
+        let runtime = tokio::runtime::Builder::new_multi_thread()
+            .worker_threads(worker_threads)
+            .thread_name("delta-kernel-io")
+            .enable_all()
+            .build()?;
+        let executor = TokioMultiThreadExecutor::new(runtime.handle().clone());
+        Ok(Self {
+            runtime: Some(runtime),
+            executor,
+        })
+    }
+}
+
+impl Drop for EngineExecutor {
+    fn drop(&mut self) {
+        // The last engine can be dropped from a task running on the runtime itself, where a
+        // blocking shutdown would panic
+        if let Some(runtime) = self.runtime.take() {
+            runtime.shutdown_background();
+        }
+    }
+}
+
+impl TaskExecutor for EngineExecutor {
+    fn block_on<T>(&self, task: T) -> T::Output
+    where
+        T: Future + Send + 'static,
+        T::Output: Send + 'static,
+    {
+        self.executor.block_on(task)
+    }
+
+    fn spawn<F>(&self, task: F)
+    where
+        F: Future<Output = ()> + Send + 'static,
+    {
+        self.executor.spawn(task)
+    }
+
+    fn spawn_blocking<T, R>(
+        &self,
+        task: T,
+    ) -> Pin<Box<dyn Future<Output = DeltaResult<R>> + Send + '_>>
+    where
+        T: FnOnce() -> R + Send + 'static,
+        R: Send + 'static,
+    {
+        self.executor.spawn_blocking(task)
+    }
+}
+
+/// Create an executor that runs IO on `worker_threads` threads, to build engines on with
+/// [`set_builder_executor`]. It is the responsibility of the _engine_ to free the returned handle
+/// by calling [`free_engine_executor`].
+///
+/// [`set_builder_executor`]: crate::set_builder_executor
+///
+/// # Safety
+/// Caller is responsible for passing a valid error allocator.
+#[no_mangle]
+pub unsafe extern "C" fn new_engine_executor(
+    worker_threads: usize,
+    allocate_error: AllocateErrorFn,
+) -> ExternResult<Handle<SharedEngineExecutor>> {
+    EngineExecutor::try_new(worker_threads)
+        .map(|executor| Arc::new(executor).into())
+        .into_extern_result(&allocate_error)
+}
+
+/// Free an executor. Engines already built on it keep running on it until they are freed as well.
+///
+/// # Safety
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_engine_executor(executor: Handle<SharedEngineExecutor>) {
+    executor.drop_handle();
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::error::KernelError;
+    use crate::ffi_test_utils::{allocate_err, assert_extern_result_error_with_message};
+
+    #[test]
+    fn executor_runs_tasks_after_handle_is_freed() {
+        let handle = EngineExecutor::try_new(2).unwrap();
+        let handle: Handle<SharedEngineExecutor> = Arc::new(handle).into();
+        let executor = unsafe { handle.clone_as_arc() };
+        unsafe { free_engine_executor(handle) };
+        assert_eq!(executor.block_on(async { 2 + 2 }), 4);
+    }
+
+    #[test]
+    fn executor_needs_worker_threads() {
+        assert_extern_result_error_with_message(
+            unsafe { new_engine_executor(0, allocate_err) },
+            KernelError::GenericError,
+            "Generic delta kernel error: An executor needs at least one worker thread",
+        );
+    }
+}
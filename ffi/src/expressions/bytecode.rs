@@ -0,0 +1,632 @@
+//! Defines [`ExpressionBytecode`], a flat serialization of the kernel's [`Expression`] or
+//! [`Predicate`]. Unlike the [`EngineExpressionVisitor`], which asks the engine to build its own
+//! tree one node (and one list) at a time, the bytecode is built by kernel into a handful of
+//! contiguous arrays that the engine can read directly.
+//!
+//! [`EngineExpressionVisitor`]: crate::expressions::engine_visitor::EngineExpressionVisitor
+use std::collections::HashMap;
+use std::sync::Arc;
+
+use delta_kernel::expressions::{
+    BinaryExpression, BinaryExpressionOp, BinaryPredicate, BinaryPredicateOp, Expression,
+    JunctionPredicate, JunctionPredicateOp, OpaqueExpression, OpaquePredicate, Predicate, Scalar,
+    Transform, UnaryExpression, UnaryExpressionOp, UnaryPredicate, UnaryPredicateOp,
+    VariadicExpression, VariadicExpressionOp,
+};
+use delta_kernel_ffi_macros::handle_descriptor;
+
+use crate::expressions::{
+    SharedExpression, SharedOpaqueExpressionOp, SharedOpaquePredicateOp, SharedPredicate,
+};
+use crate::handle::Handle;
+
+use ExpressionOpCode as Op;
+
+/// The operation of an [`ExpressionInstruction`]. Instructions are in postfix order: each one pops
+/// its `arity` operands off a stack of values (the first operand being the deepest) and pushes its
+/// result. The meaning of `arg` depends on the operation, as documented on each variant.
+///
+/// cbindgen:prefix-with-name
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ExpressionOpCode {
+    /// A 32bit `integer` literal. `arg` is the value, sign extended to 64 bits
+    LiteralInt,
+    /// A 64bit `long` literal. `arg` is the value
+    LiteralLong,
+    /// A 16bit `short` literal. `arg` is the value, sign extended to 64 bits
+    LiteralShort,
+    /// An 8bit `byte` literal. `arg` is the value, sign extended to 64 bits
+    LiteralByte,
+    /// A 32bit `float` literal. The low 32 bits of `arg` are the bits of the value
+    LiteralFloat,
+    /// A 64bit `double` literal. `arg` holds the bits of the value
+    LiteralDouble,
+    /// A `boolean` literal. `arg` is 1 for true and 0 for false
+    LiteralBool,
+    /// A timestamp literal in microseconds since the UNIX epoch, adjusted to UTC. `arg` is the value
+    LiteralTimestamp,
+    /// A timestamp literal in microseconds since the UNIX epoch, with no timezone. `arg` is the
+    /// value
+    LiteralTimestampNtz,
+    /// A `date` literal in days since the UNIX epoch. `arg` is the value, sign extended to 64 bits
+    LiteralDate,
+    /// A `string` literal. `arg` is its index in the string pool
+    LiteralString,
+    /// A binary literal. `arg` is the index of its bytes in the string pool
+    LiteralBinary,
+    /// A `decimal` literal. `arg` is its index in the decimal pool
+    LiteralDecimal,
+    /// A null literal
+    LiteralNull,
+    /// A struct literal. The operands are `arity / 2` pairs of a field name (as a string literal)
+    /// followed by the field's value
+    LiteralStruct,
+    /// An array literal. The operands are the elements of the array
+    LiteralArray,
+    /// A map literal. The operands are `arity / 2` pairs of a key followed by its value
+    LiteralMap,
+    /// A column reference. `arg` is the index of the column name in the string pool
+    Column,
+    /// An `and` of the operands
+    And,
+    /// An `or` of the operands
+    Or,
+    /// A `not` of the single operand
+    Not,
+    /// An `is_null` of the single operand
+    IsNull,
+    /// A `ToJson` of the single operand
+    ToJson,
+    /// The `LessThan` of the two operands
+    LessThan,
+    /// The `GreaterThan` of the two operands
+    GreaterThan,
+    /// The `Equal` of the two operands
+    Equal,
+    /// The `Distinct` of the two operands
+    Distinct,
+    /// The `In` of the two operands
+    In,
+    /// The `Add` of the two operands
+    Add,
+    /// The `Minus` of the two operands
+    Minus,
+    /// The `Multiply` of the two operands
+    Multiply,
+    /// The `Divide` of the two operands
+    Divide,
+    /// The `Coalesce` of the operands
+    Coalesce,
+    /// A `Struct` expression. The operands are the fields of the struct
+    Struct,
+    /// A `Transform` expression. If `arg` is 1, the first operand is the transform's input path as
+    /// a column reference. The remaining operands are the field transforms to apply, each the
+    /// result of a `FieldInsert` or `FieldReplace` instruction. Field transforms have the same
+    /// meaning as in `EngineExpressionVisitor::visit_field_transform`.
+    Transform,
+    /// A field transform that inserts the operands after the input field named by the string at
+    /// index `arg` of the string pool, or prepends them to the output if `arg` is `UINT64_MAX`.
+    FieldInsert,
+    /// A field transform that replaces the input field named by the string at index `arg` of the
+    /// string pool with the operands. The field is dropped if there are no operands.
+    FieldReplace,
+    /// An opaque expression applied to the operands. `arg` is the index of its op in the opaque
+    /// expression op pool
+    OpaqueExpression,
+    /// An opaque predicate applied to the operands. `arg` is the index of its op in the opaque
+    /// predicate op pool
+    OpaquePredicate,
+    /// An `Expression::Unknown` or `Predicate::Unknown`. `arg` is the index of its name in the
+    /// string pool
+    Unknown,
+}
+
+/// One instruction of an [`ExpressionBytecode`]. See [`ExpressionOpCode`].
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ExpressionInstruction {
+    pub op: ExpressionOpCode,
+    /// The number of operands this instruction pops off the stack
+    pub arity: u32,
+    pub arg: u64,
+}
+
+/// An entry of the string pool of an [`ExpressionBytecode`]: `len` bytes starting at `offset` in
+/// the `bytes` buffer. Each entry is followed by a NUL byte (not included in `len`), so string
+/// entries can be used directly as C strings. Binary literals may contain NUL bytes themselves,
+/// and so must always be read using `len`.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ExpressionString {
+    pub offset: usize,
+    pub len: usize,
+}
+
+/// An entry of the decimal pool of an [`ExpressionBytecode`]. The 128bit integer value is split
+/// into the most significant 64 bits in `value_ms`, and the least significant 64 bits in
+/// `value_ls`.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ExpressionDecimal {
+    pub value_ms: i64,
+    pub value_ls: u64,
+    pub precision: u8,
+    pub scale: u8,
+}
+
+/// A kernel expression or predicate serialized as postfix instructions, along with the pools the
+/// instructions refer to. Every string (column names, field names, string and binary literals) is
+/// stored once, no matter how often it appears in the expression. See [`get_expression_bytecode`].
+pub struct ExpressionBytecode {
+    instructions: Vec<ExpressionInstruction>,
+    bytes: Vec<u8>,
+    strings: Vec<ExpressionString>,
+    decimals: Vec<ExpressionDecimal>,
+    opaque_expression_ops: Vec<Handle<SharedOpaqueExpressionOp>>,
+    opaque_predicate_ops: Vec<Handle<SharedOpaquePredicateOp>>,
+    max_stack_depth: usize,
+}
+
+#[handle_descriptor(target=ExpressionBytecode, mutable=false, sized=true)]
+pub struct SharedExpressionBytecode;
+
+impl Drop for ExpressionBytecode {
+    fn drop(&mut self) {
+        for op in self.opaque_expression_ops.drain(..) {
+            unsafe { op.drop_handle() };
+        }
+        for op in self.opaque_predicate_ops.drain(..) {
+            unsafe { op.drop_handle() };
+        }
+    }
+}
+
+/// A read-only view of an [`ExpressionBytecode`]. All pointers remain valid until the bytecode is
+/// freed with [`free_expression_bytecode`]. The opaque op handles are owned by the bytecode, so the
+/// engine must not free them.
+#[repr(C)]
+pub struct ExpressionBytecodeView {
+    pub instructions: *const ExpressionInstruction,
+    pub num_instructions: usize,
+    /// The buffer all string pool entries point into
+    pub bytes: *const u8,
+    pub strings: *const ExpressionString,
+    pub num_strings: usize,
+    pub decimals: *const ExpressionDecimal,
+    pub num_decimals: usize,
+    pub opaque_expression_ops: *const Handle<SharedOpaqueExpressionOp>,
+    pub num_opaque_expression_ops: usize,
+    pub opaque_predicate_ops: *const Handle<SharedOpaquePredicateOp>,
+    pub num_opaque_predicate_ops: usize,
+    /// The deepest the value stack gets while evaluating the instructions, so that engines can
+    /// allocate it up front. Once all instructions are evaluated the stack holds a single value:
+    /// the top level expression.
+    pub max_stack_depth: usize,
+}
+
+/// Serialize the expression of the passed [`SharedExpression`] Handle. The returned bytecode must
+/// be freed with [`free_expression_bytecode`].
+///
+/// # Safety
+///
+/// The caller must pass a valid SharedExpression Handle
+#[no_mangle]
+pub unsafe extern "C" fn serialize_expression(
+    expression: &Handle<SharedExpression>,
+) -> Handle<SharedExpressionBytecode> {
+    let expression = unsafe { expression.as_ref() };
+    ExpressionBytecode::from_expression(expression).into()
+}
+
+/// Serialize the expression of the passed [`Expression`] pointer. The returned bytecode must be
+/// freed with [`free_expression_bytecode`].
+///
+/// # Safety
+///
+/// The caller must pass a valid Expression pointer
+#[no_mangle]
+pub unsafe extern "C" fn serialize_expression_ref(
+    expression: &Expression,
+) -> Handle<SharedExpressionBytecode> {
+    ExpressionBytecode::from_expression(expression).into()
+}
+
+/// Serialize the predicate of the passed [`SharedPredicate`] Handle. The returned bytecode must
+/// be freed with [`free_expression_bytecode`].
+///
+/// # Safety
+///
+/// The caller must pass a valid SharedPredicate Handle
+#[no_mangle]
+pub unsafe extern "C" fn serialize_predicate(
+    predicate: &Handle<SharedPredicate>,
+) -> Handle<SharedExpressionBytecode> {
+    let predicate = unsafe { predicate.as_ref() };
+    ExpressionBytecode::from_predicate(predicate).into()
+}
+
+/// Serialize the predicate of the passed [`Predicate`] pointer. The returned bytecode must be
+/// freed with [`free_expression_bytecode`].
+///
+/// # Safety
+///
+/// The caller must pass a valid Predicate pointer
+#[no_mangle]
+pub unsafe extern "C" fn serialize_predicate_ref(
+    predicate: &Predicate,
+) -> Handle<SharedExpressionBytecode> {
+    ExpressionBytecode::from_predicate(predicate).into()
+}
+
+/// Get a view of the instructions and pools of the passed bytecode
+///
+/// # Safety
+///
+/// The caller must pass a valid SharedExpressionBytecode Handle
+#[no_mangle]
+pub unsafe extern "C" fn get_expression_bytecode(
+    bytecode: &Handle<SharedExpressionBytecode>,
+) -> ExpressionBytecodeView {
+    let bytecode = unsafe { bytecode.as_ref() };
+    ExpressionBytecodeView {
+        instructions: bytecode.instructions.as_ptr(),
+        num_instructions: bytecode.instructions.len(),
+        bytes: bytecode.bytes.as_ptr(),
+        strings: bytecode.strings.as_ptr(),
+        num_strings: bytecode.strings.len(),
+        decimals: bytecode.decimals.as_ptr(),
+        num_decimals: bytecode.decimals.len(),
+        opaque_expression_ops: bytecode.opaque_expression_ops.as_ptr(),
+        num_opaque_expression_ops: bytecode.opaque_expression_ops.len(),
+        opaque_predicate_ops: bytecode.opaque_predicate_ops.as_ptr(),
+        num_opaque_predicate_ops: bytecode.opaque_predicate_ops.len(),
+        max_stack_depth: bytecode.max_stack_depth,
+    }
+}
+
+/// Free the passed bytecode. Any views of it are no longer valid afterwards.
+///
+/// # Safety
+///
+/// Engine is responsible for passing a valid SharedExpressionBytecode
+#[no_mangle]
+pub unsafe extern "C" fn free_expression_bytecode(bytecode: Handle<SharedExpressionBytecode>) {
+    bytecode.drop_handle();
+}
+
+/// Builds an [`ExpressionBytecode`] by walking an expression in postfix order
+#[derive(Default)]
+struct BytecodeBuilder {
+    instructions: Vec<ExpressionInstruction>,
+    bytes: Vec<u8>,
+    strings: Vec<ExpressionString>,
+    string_ids: HashMap<Vec<u8>, u64>,
+    decimals: Vec<ExpressionDecimal>,
+    opaque_expression_ops: Vec<Handle<SharedOpaqueExpressionOp>>,
+    opaque_predicate_ops: Vec<Handle<SharedOpaquePredicateOp>>,
+    stack_depth: usize,
+    max_stack_depth: usize,
+}
+
+impl ExpressionBytecode {
+    fn from_expression(expression: &Expression) -> Self {
+        let mut builder = BytecodeBuilder::default();
+        builder.expression(expression);
+        builder.finish()
+    }
+
+    fn from_predicate(predicate: &Predicate) -> Self {
+        let mut builder = BytecodeBuilder::default();
+        builder.predicate(predicate);
+        builder.finish()
+    }
+}
+
+impl BytecodeBuilder {
+    fn emit(&mut self, op: ExpressionOpCode, arity: usize, arg: u64) {
+        // every instruction pushes exactly one value, after popping its operands
+        self.stack_depth = self.stack_depth + 1 - arity;
+        self.max_stack_depth = self.max_stack_depth.max(self.stack_depth);
+        self.instructions.push(ExpressionInstruction {
+            op,
+            arity: arity as u32,
+            arg,
+        });
+    }
+
+    fn intern(&mut self, value: &[u8]) -> u64 {
+        if let Some(&id) = self.string_ids.get(value) {
+            return id;
+        }
+        let id = self.strings.len() as u64;
+        self.strings.push(ExpressionString {
+            offset: self.bytes.len(),
+            len: value.len(),
+        });
+        self.bytes.extend_from_slice(value);
+        self.bytes.push(0);
+        self.string_ids.insert(value.to_vec(), id);
+        id
+    }
+
+    fn string(&mut self, op: ExpressionOpCode, value: &[u8]) {
+        let id = self.intern(value);
+        self.emit(op, 0, id);
+    }
+
+    fn scalar(&mut self, scalar: &Scalar) {
+        match scalar {
+            Scalar::Integer(val) => self.emit(Op::LiteralInt, 0, *val as u64),
+            Scalar::Long(val) => self.emit(Op::LiteralLong, 0, *val as u64),
+            Scalar::Short(val) => self.emit(Op::LiteralShort, 0, *val as u64),
+            Scalar::Byte(val) => self.emit(Op::LiteralByte, 0, *val as u64),
+            Scalar::Float(val) => self.emit(Op::LiteralFloat, 0, val.to_bits().into()),
+            Scalar::Double(val) => self.emit(Op::LiteralDouble, 0, val.to_bits()),
+            Scalar::String(val) => self.string(Op::LiteralString, val.as_bytes()),
+            Scalar::Boolean(val) => self.emit(Op::LiteralBool, 0, *val as u64),
+            Scalar::Timestamp(val) => self.emit(Op::LiteralTimestamp, 0, *val as u64),
+            Scalar::TimestampNtz(val) => self.emit(Op::LiteralTimestampNtz, 0, *val as u64),
+            Scalar::Date(val) => self.emit(Op::LiteralDate, 0, *val as u64),
+            Scalar::Binary(buf) => self.string(Op::LiteralBinary, buf),
+            Scalar::Decimal(v) => {
+                let id = self.decimals.len() as u64;
+                self.decimals.push(ExpressionDecimal {
+                    value_ms: (v.bits() >> 64) as i64,
+                    value_ls: v.bits() as u64,
+                    precision: v.precision(),
+                    scale: v.scale(),
+                });
+                self.emit(Op::LiteralDecimal, 0, id);
+            }
+            Scalar::Null(_) => self.emit(Op::LiteralNull, 0, 0),
+            Scalar::Struct(struct_data) => {
+                for (field, value) in struct_data.fields().iter().zip(struct_data.values()) {
+                    self.string(Op::LiteralString, field.name().as_bytes());
+                    self.scalar(value);
+                }
+                self.emit(Op::LiteralStruct, 2 * struct_data.fields().len(), 0);
+            }
+            Scalar::Array(array) => {
+                #[allow(deprecated)]
+                let elements = array.array_elements();
+                for element in elements {
+                    self.scalar(element);
+                }
+                self.emit(Op::LiteralArray, elements.len(), 0);
+            }
+            Scalar::Map(map_data) => {
+                let pairs = map_data.pairs();
+                for (key, val) in pairs {
+                    self.scalar(key);
+                    self.scalar(val);
+                }
+                self.emit(Op::LiteralMap, 2 * pairs.len(), 0);
+            }
+        }
+    }
+
+    fn expressions<'a>(&mut self, exprs: impl IntoIterator<Item = &'a Expression>) -> usize {
+        let mut count = 0;
+        for expr in exprs {
+            self.expression(expr);
+            count += 1;
+        }
+        count
+    }
+
+    fn transform(&mut self, transform: &Transform) {
+        let Transform {
+            input_path,
+            field_transforms,
+            prepended_fields,
+        } = transform;
+
+        let has_input_path = input_path.is_some();
+        if let Some(column_name) = input_path {
+            self.string(Op::Column, column_name.to_string().as_bytes());
+        }
+        // one field transform for the prepended fields (if any), plus one per named input field
+        let mut num_field_transforms = 0;
+        if !prepended_fields.is_empty() {
+            let arity = self.expressions(prepended_fields.iter().map(Arc::as_ref));
+            self.emit(Op::FieldInsert, arity, u64::MAX);
+            num_field_transforms += 1;
+        }
+        for (field_name, field_transform) in field_transforms {
+            let arity = self.expressions(field_transform.exprs.iter().map(Arc::as_ref));
+            let op = if field_transform.is_replace {
+                Op::FieldReplace
+            } else {
+                Op::FieldInsert
+            };
+            let name_id = self.intern(field_name.as_bytes());
+            self.emit(op, arity, name_id);
+            num_field_transforms += 1;
+        }
+        self.emit(
+            Op::Transform,
+            has_input_path as usize + num_field_transforms,
+            has_input_path as u64,
+        );
+    }
+
+    fn expression(&mut self, expression: &Expression) {
+        match expression {
+            Expression::Literal(scalar) => self.scalar(scalar),
+            Expression::Column(name) => self.string(Op::Column, name.to_string().as_bytes()),
+            Expression::Struct(exprs) => {
+                let arity = self.expressions(exprs.iter().map(Arc::as_ref));
+                self.emit(Op::Struct, arity, 0);
+            }
+            Expression::Transform(transform) => self.transform(transform),
+            Expression::Predicate(pred) => self.predicate(pred),
+            Expression::Unary(UnaryExpression { op, expr }) => {
+                self.expression(expr);
+                let op = match op {
+                    UnaryExpressionOp::ToJson => Op::ToJson,
+                };
+                self.emit(op, 1, 0);
+            }
+            Expression::Binary(BinaryExpression { op, left, right }) => {
+                self.expression(left);
+                self.expression(right);
+                let op = match op {
+                    BinaryExpressionOp::Plus => Op::Add,
+                    BinaryExpressionOp::Minus => Op::Minus,
+                    BinaryExpressionOp::Multiply => Op::Multiply,
+                    BinaryExpressionOp::Divide => Op::Divide,
+                };
+                self.emit(op, 2, 0);
+            }
+            Expression::Variadic(VariadicExpression { op, exprs }) => {
+                let arity = self.expressions(exprs);
+                let op = match op {
+                    VariadicExpressionOp::Coalesce => Op::Coalesce,
+                };
+                self.emit(op, arity, 0);
+            }
+            Expression::Opaque(OpaqueExpression { op, exprs }) => {
+                let arity = self.expressions(exprs);
+                let id = self.opaque_expression_ops.len() as u64;
+                self.opaque_expression_ops.push(op.clone().into());
+                self.emit(Op::OpaqueExpression, arity, id);
+            }
+            Expression::Unknown(name) => self.string(Op::Unknown, name.as_bytes()),
+        }
+    }
+
+    fn predicate(&mut self, predicate: &Predicate) {
+        match predicate {
+            Predicate::BooleanExpression(expr) => self.expression(expr),
+            Predicate::Not(pred) => {
+                self.predicate(pred);
+                self.emit(Op::Not, 1, 0);
+            }
+            Predicate::Unary(UnaryPredicate { op, expr }) => {
+                self.expression(expr);
+                let op = match op {
+                    UnaryPredicateOp::IsNull => Op::IsNull,
+                };
+                self.emit(op, 1, 0);
+            }
+            Predicate::Binary(BinaryPredicate { op, left, right }) => {
+                self.expression(left);
+                self.expression(right);
+                let op = match op {
+                    BinaryPredicateOp::LessThan => Op::LessThan,
+                    BinaryPredicateOp::GreaterThan => Op::GreaterThan,
+                    BinaryPredicateOp::Equal => Op::Equal,
+                    BinaryPredicateOp::Distinct => Op::Distinct,
+                    BinaryPredicateOp::In => Op::In,
+                };
+                self.emit(op, 2, 0);
+            }
+            Predicate::Junction(JunctionPredicate { op, preds }) => {
+                for pred in preds {
+                    self.predicate(pred);
+                }
+                let op = match op {
+                    JunctionPredicateOp::And => Op::And,
+                    JunctionPredicateOp::Or => Op::Or,
+                };
+                self.emit(op, preds.len(), 0);
+            }
+            Predicate::Opaque(OpaquePredicate { op, exprs }) => {
+                let arity = self.expressions(exprs);
+                let id = self.opaque_predicate_ops.len() as u64;
+                self.opaque_predicate_ops.push(op.clone().into());
+                self.emit(Op::OpaquePredicate, arity, id);
+            }
+            Predicate::Unknown(name) => self.string(Op::Unknown, name.as_bytes()),
+        }
+    }
+
+    fn finish(self) -> ExpressionBytecode {
+        ExpressionBytecode {
+            instructions: self.instructions,
+            bytes: self.bytes,
+            strings: self.strings,
+            decimals: self.decimals,
+            opaque_expression_ops: self.opaque_expression_ops,
+            opaque_predicate_ops: self.opaque_predicate_ops,
+            max_stack_depth: self.max_stack_depth,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use delta_kernel::expressions::{column_expr, Expression as Expr, Predicate as Pred};
+
+    fn instruction(op: Op, arity: u32, arg: u64) -> ExpressionInstruction {
+        ExpressionInstruction { op, arity, arg }
+    }
+
+    #[test]
+    fn serializes_in_postfix_order_with_interned_strings() {
+        let pred = Pred::and(
+            Pred::lt(column_expr!("a.b"), Expr::literal(-3)),
+            Pred::or(
+                Pred::eq(column_expr!("a.b"), Expr::literal("a.b")),
+                Pred::is_null(column_expr!("c")),
+            ),
+        );
+        let bytecode = ExpressionBytecode::from_predicate(&pred);
+        assert_eq!(
+            bytecode.instructions,
+            [
+                instruction(Op::Column, 0, 0),
+                instruction(Op::LiteralInt, 0, -3i64 as u64),
+                instruction(Op::LessThan, 2, 0),
+                instruction(Op::Column, 0, 0),
+                instruction(Op::LiteralString, 0, 0),
+                instruction(Op::Equal, 2, 0),
+                instruction(Op::Column, 0, 1),
+                instruction(Op::IsNull, 1, 0),
+                instruction(Op::Or, 2, 0),
+                instruction(Op::And, 2, 0),
+            ]
+        );
+        assert_eq!(bytecode.bytes, b"a.b\0c\0");
+        assert_eq!(
+            bytecode.strings,
+            [
+                ExpressionString { offset: 0, len: 3 },
+                ExpressionString { offset: 4, len: 1 },
+            ]
+        );
+        assert_eq!(bytecode.max_stack_depth, 3);
+    }
+
+    #[test]
+    fn serializes_decimal_and_struct_literals() {
+        let decimal = Scalar::decimal((1i128 << 64) + 2, 20, 3).unwrap();
+        let expr = Expr::struct_from([
+            Expr::literal(1.5f64),
+            decimal.into(),
+            Expr::null_literal(delta_kernel::schema::DataType::LONG),
+        ]);
+        let bytecode = ExpressionBytecode::from_expression(&expr);
+        assert_eq!(
+            bytecode.instructions,
+            [
+                instruction(Op::LiteralDouble, 0, 1.5f64.to_bits()),
+                instruction(Op::LiteralDecimal, 0, 0),
+                instruction(Op::LiteralNull, 0, 0),
+                instruction(Op::Struct, 3, 0),
+            ]
+        );
+        assert_eq!(
+            bytecode.decimals,
+            [ExpressionDecimal {
+                value_ms: 1,
+                value_ls: 2,
+                precision: 20,
+                scale: 3,
+            }]
+        );
+        assert_eq!(bytecode.max_stack_depth, 3);
+    }
+}
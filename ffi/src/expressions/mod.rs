@@ -8,6 +8,7 @@ use delta_kernel_ffi_macros::handle_descriptor;
 
 use crate::{handle::Handle, kernel_string_slice, KernelStringSlice};
 
+pub mod bytecode;
 pub mod engine_visitor;
 pub mod kernel_visitor;
 
@@ -1,11 +1,13 @@
 //! FFI functions to allow engines to receive log and tracing events from kernel
 
-use std::sync::{Arc, Mutex};
+use std::sync::{Arc, LazyLock, Mutex};
+use std::time::Instant;
 use std::{fmt, io};
 
 use delta_kernel::{DeltaResult, Error};
 use tracing::{
     field::{Field as TracingField, Visit},
+    span::{Attributes, Id, Record},
     Event as TracingEvent, Subscriber,
 };
 use tracing_subscriber::fmt::MakeWriter;
@@ -96,6 +98,65 @@ pub unsafe extern "C" fn enable_event_tracing(callback: TracingEventFn, max_leve
     setup_event_subscriber(callback, max_level).is_ok()
 }
 
+/// A `SpanEvent` reports that kernel entered or exited a span. Spans mark phases of kernel's work,
+/// such as listing the log, reading a checkpoint, or replaying a batch of log actions. A span can
+/// be entered and exited more than once, e.g. a span for a lazily read file is entered each time
+/// kernel reads more of it, so the time a span was active is the sum of its enter/exit intervals.
+#[repr(C)]
+pub struct SpanEvent {
+    /// The name of the span, e.g. `list_log_files`
+    name: KernelStringSlice,
+    /// Level that the span was created at
+    level: Level,
+    /// A string that specifies in what part of the system the span was created
+    target: KernelStringSlice,
+    /// Id of the span. Ids are unique among open spans, but may be reused once a span is closed
+    id: u64,
+    /// Id of the span this span was created inside of, or 0 (zero) if it has no parent
+    parent_id: u64,
+    /// Monotonic time of the enter or exit in nanoseconds, counted from when span tracing was
+    /// enabled
+    timestamp_ns: u64,
+    /// The fields recorded on the span so far, as space separated `name=value` pairs. For example
+    /// `parts=1 bytes=5120 rows=200`. Fields that are only known once the span's work is done
+    /// (e.g. row counts) may only be present on exit
+    fields: KernelStringSlice,
+    /// The file or directory the span works on, e.g. the checkpoint a `read_checkpoint` span reads,
+    /// or empty if the span has none. This is the span's `location` field, which is also part of
+    /// `fields`
+    location: KernelStringSlice,
+}
+
+pub type TracingSpanFn = extern "C" fn(span: SpanEvent);
+
+/// Enable getting called back for tracing events, as with [`enable_event_tracing`], and also when
+/// kernel enters and exits a span. `max_level` applies to both events and spans.
+///
+/// Note that setting up such a call back can only be done ONCE. Calling this function or any of
+/// `enable_event_tracing`, `enable_log_line_tracing`, or `enable_formatted_log_line_tracing` more
+/// than once is a no-op.
+///
+/// Returns `true` if the callbacks were setup successfully, false on failure (i.e. if called a
+/// second time)
+///
+/// # Safety
+/// Caller must pass valid function pointers for the callbacks
+#[no_mangle]
+pub unsafe extern "C" fn enable_event_and_span_tracing(
+    event_callback: TracingEventFn,
+    span_enter_callback: TracingSpanFn,
+    span_exit_callback: TracingSpanFn,
+    max_level: Level,
+) -> bool {
+    setup_event_and_span_subscriber(
+        event_callback,
+        span_enter_callback,
+        span_exit_callback,
+        max_level,
+    )
+    .is_ok()
+}
+
 pub type TracingLogLineFn = extern "C" fn(line: KernelStringSlice);
 
 /// Format to use for log lines. These correspond to the formats from [`tracing_subscriber`
@@ -288,6 +349,160 @@ fn setup_event_subscriber(callback: TracingEventFn, max_level: Level) -> DeltaRe
     set_global_default(dispatch)
 }
 
+// utility code below for setting up the tracing subscriber for spans
+
+// the point span timestamps are counted from
+static SPAN_EPOCH: LazyLock<Instant> = LazyLock::new(Instant::now);
+
+// the fields recorded on a span so far, in the order they were first recorded
+#[derive(Default)]
+struct SpanFields {
+    fields: Vec<(&'static str, String)>,
+}
+
+impl SpanFields {
+    fn set(&mut self, name: &'static str, value: String) {
+        match self.fields.iter_mut().find(|(field, _)| *field == name) {
+            Some((_, old_value)) => *old_value = value,
+            None => self.fields.push((name, value)),
+        }
+    }
+
+    fn get(&self, name: &str) -> Option<&str> {
+        self.fields
+            .iter()
+            .find(|(field, _)| *field == name)
+            .map(|(_, value)| value.as_str())
+    }
+
+    fn format(&self) -> String {
+        self.fields
+            .iter()
+            .map(|(name, value)| format!("{name}={value}"))
+            .collect::<Vec<_>>()
+            .join(" ")
+    }
+}
+
+impl Visit for SpanFields {
+    fn record_debug(&mut self, field: &TracingField, value: &dyn fmt::Debug) {
+        self.set(field.name(), format!("{value:?}"));
+    }
+
+    fn record_str(&mut self, field: &TracingField, value: &str) {
+        self.set(field.name(), value.to_string());
+    }
+}
+
+struct SpanLayer {
+    enter_callback: TracingSpanFn,
+    exit_callback: TracingSpanFn,
+}
+
+impl SpanLayer {
+    fn report<S>(&self, callback: TracingSpanFn, id: &Id, context: Context<'_, S>)
+    where
+        S: Subscriber + for<'a> LookupSpan<'a>,
+    {
+        // take the time first, so looking up the span isn't counted as part of it
+        let timestamp_ns = SPAN_EPOCH.elapsed().as_nanos() as u64;
+        let Some(span) = context.span(id) else {
+            return;
+        };
+        let metadata = span.metadata();
+        let name = metadata.name();
+        let target = metadata.target();
+        // copy the fields out, so the span's extensions aren't locked while the engine is called
+        let (fields, location) = match span.extensions().get::<SpanFields>() {
+            Some(fields) => {
+                let location = fields.get("location").unwrap_or_default().to_string();
+                (fields.format(), location)
+            }
+            None => Default::default(),
+        };
+        let span_event = SpanEvent {
+            name: kernel_string_slice!(name),
+            level: metadata.level().into(),
+            target: kernel_string_slice!(target),
+            id: id.into_u64(),
+            parent_id: span.parent().map_or(0, |parent| parent.id().into_u64()),
+            timestamp_ns,
+            fields: kernel_string_slice!(fields),
+            location: kernel_string_slice!(location),
+        };
+        callback(span_event);
+    }
+}
+
+impl<S> Layer<S> for SpanLayer
+where
+    S: Subscriber + for<'a> LookupSpan<'a>,
+{
+    fn on_new_span(&self, attrs: &Attributes<'_>, id: &Id, context: Context<'_, S>) {
+        if let Some(span) = context.span(id) {
+            let mut fields = SpanFields::default();
+            attrs.record(&mut fields);
+            span.extensions_mut().insert(fields);
+        }
+    }
+
+    fn on_record(&self, id: &Id, values: &Record<'_>, context: Context<'_, S>) {
+        if let Some(span) = context.span(id) {
+            if let Some(fields) = span.extensions_mut().get_mut::<SpanFields>() {
+                values.record(fields);
+            }
+        }
+    }
+
+    fn on_enter(&self, id: &Id, context: Context<'_, S>) {
+        self.report(self.enter_callback, id, context);
+    }
+
+    fn on_exit(&self, id: &Id, context: Context<'_, S>) {
+        self.report(self.exit_callback, id, context);
+    }
+}
+
+fn get_event_and_span_dispatcher(
+    event_callback: TracingEventFn,
+    span_enter_callback: TracingSpanFn,
+    span_exit_callback: TracingSpanFn,
+    max_level: Level,
+) -> tracing_core::Dispatch {
+    use tracing_subscriber::{layer::SubscriberExt, registry::Registry};
+    LazyLock::force(&SPAN_EPOCH);
+    let filter: LevelFilter = max_level.into();
+    let event_layer = EventLayer {
+        callback: event_callback,
+    };
+    let span_layer = SpanLayer {
+        enter_callback: span_enter_callback,
+        exit_callback: span_exit_callback,
+    };
+    let subscriber = Registry::default()
+        .with(event_layer.with_filter(filter))
+        .with(span_layer.with_filter(filter));
+    tracing_core::Dispatch::new(subscriber)
+}
+
+fn setup_event_and_span_subscriber(
+    event_callback: TracingEventFn,
+    span_enter_callback: TracingSpanFn,
+    span_exit_callback: TracingSpanFn,
+    max_level: Level,
+) -> DeltaResult<()> {
+    if !max_level.is_valid() {
+        return Err(Error::generic("max_level out of range"));
+    }
+    let dispatch = get_event_and_span_dispatcher(
+        event_callback,
+        span_enter_callback,
+        span_exit_callback,
+        max_level,
+    );
+    set_global_default(dispatch)
+}
+
 // utility code below for setting up the tracing subscriber for log lines
 
 type SharedBuffer = Arc<Mutex<Vec<u8>>>;
@@ -608,6 +823,87 @@ mod tests {
         }
     }
 
+    // (enter, name, id, parent_id, timestamp_ns, fields, location) for each span callback
+    type SpanRecord = (bool, String, u64, u64, u64, String, String);
+    static SPANS: Mutex<Option<Vec<SpanRecord>>> = Mutex::new(None);
+
+    fn record_span(enter: bool, span: SpanEvent) {
+        let name: &str = unsafe { TryFromStringSlice::try_from_slice(&span.name).unwrap() };
+        let fields: &str = unsafe { TryFromStringSlice::try_from_slice(&span.fields).unwrap() };
+        let location: &str = unsafe { TryFromStringSlice::try_from_slice(&span.location).unwrap() };
+        let record = (
+            enter,
+            name.to_string(),
+            span.id,
+            span.parent_id,
+            span.timestamp_ns,
+            fields.to_string(),
+            location.to_string(),
+        );
+        let mut lock = SPANS.lock().unwrap();
+        if let Some(ref mut spans) = *lock {
+            spans.push(record);
+        }
+    }
+
+    extern "C" fn span_enter_callback(span: SpanEvent) {
+        record_span(true, span);
+    }
+
+    extern "C" fn span_exit_callback(span: SpanEvent) {
+        record_span(false, span);
+    }
+
+    extern "C" fn ignore_event_callback(_event: Event) {}
+
+    #[test]
+    fn span_tracking() {
+        let _lock = TEST_LOCK.lock().unwrap();
+        *SPANS.lock().unwrap() = Some(vec![]);
+        let dispatch = get_event_and_span_dispatcher(
+            ignore_event_callback,
+            span_enter_callback,
+            span_exit_callback,
+            Level::DEBUG,
+        );
+        tracing_core::dispatcher::with_default(&dispatch, || {
+            let outer = tracing::info_span!(
+                "outer",
+                location = "a/b.parquet",
+                rows = tracing::field::Empty
+            );
+            let _outer = outer.enter();
+            {
+                let _inner = tracing::debug_span!("inner", bytes = 10).entered();
+            }
+            // filtered out by the level, and shouldn't affect the parent of later spans
+            let _ignored = tracing::trace_span!("ignored").entered();
+            outer.record("rows", 5);
+        });
+        let spans = SPANS.lock().unwrap().take().unwrap();
+        let summary: Vec<_> = spans
+            .iter()
+            .map(|(enter, name, _, _, _, fields, location)| {
+                (*enter, name.as_str(), fields.as_str(), location.as_str())
+            })
+            .collect();
+        assert_eq!(
+            summary,
+            [
+                (true, "outer", "location=a/b.parquet", "a/b.parquet"),
+                (true, "inner", "bytes=10", ""),
+                (false, "inner", "bytes=10", ""),
+                (false, "outer", "location=a/b.parquet rows=5", "a/b.parquet"),
+            ]
+        );
+        let (outer_id, inner_id, inner_parent) = (spans[0].2, spans[1].2, spans[1].3);
+        assert_ne!(outer_id, 0);
+        assert_eq!(spans[0].3, 0, "outer span has no parent");
+        assert_eq!(inner_parent, outer_id);
+        assert_ne!(inner_id, outer_id);
+        assert!(spans.windows(2).all(|w| w[0].4 <= w[1].4));
+    }
+
     #[test]
     fn level_from_impl() {
         let trace: Level = (&tracing::Level::TRACE).into();
@@ -25,27 +25,44 @@ pub mod handle;
 #[cfg(not(feature = "internal-api"))]
 pub(crate) mod handle;
 
+use allocator::EngineAllocator;
+use dv_cache::DvCache;
+#[cfg(feature = "default-engine-base")]
+use dv_cache::DV_CACHE_SIZE_OPTION;
+#[cfg(feature = "default-engine-base")]
+use executor::{EngineExecutor, SharedEngineExecutor};
 use handle::Handle;
+#[cfg(feature = "default-engine-base")]
+use poll::BackgroundExecutor;
 
 // The handle_descriptor macro needs this, because it needs to emit fully qualified type names. THe
 // actual prod code could use `crate::`, but doc tests can't because they're not "inside" the crate.
 // relies on `crate::`
 extern crate self as delta_kernel_ffi;
 
+pub mod allocator;
+pub mod checkpoint;
 mod domain_metadata;
+mod dv_cache;
 pub use domain_metadata::get_domain_metadata;
 pub mod engine_data;
 pub mod engine_funcs;
 pub mod error;
+#[cfg(feature = "default-engine-base")]
+pub mod executor;
 use error::{AllocateError, AllocateErrorFn, ExternResult, IntoExternResult};
 pub mod expressions;
 #[cfg(feature = "tracing")]
 pub mod ffi_tracing;
+#[cfg(feature = "default-engine-base")]
+pub mod poll;
 pub mod scan;
 pub mod schema;
+pub mod serialization;
 
 #[cfg(test)]
 mod ffi_test_utils;
+pub mod table_changes;
 #[cfg(feature = "test-ffi")]
 pub mod test_ffi;
 pub mod transaction;
@@ -357,6 +374,16 @@ pub unsafe extern "C" fn free_engine_data(engine_data: Handle<ExclusiveEngineDat
 pub trait ExternEngine: Send + Sync {
     fn engine(&self) -> Arc<dyn Engine>;
     fn error_allocator(&self) -> &dyn AllocateError;
+    /// The cache kernel keeps decoded deletion vectors in, if the engine has one
+    fn dv_cache(&self) -> Option<&Arc<DvCache>> {
+        None
+    }
+    /// The executor the engine runs its IO on, which kernel also runs polled and prefetched
+    /// iterators on, if the engine has one
+    #[cfg(feature = "default-engine-base")]
+    fn executor(&self) -> Option<&Arc<dyn BackgroundExecutor>> {
+        None
+    }
 }
 
 #[handle_descriptor(target=dyn ExternEngine, mutable=false)]
@@ -367,6 +394,8 @@ struct ExternEngineVtable {
     // Actual engine instance to use
     engine: Arc<dyn Engine>,
     allocate_error: AllocateErrorFn,
+    dv_cache: Option<Arc<DvCache>>,
+    executor: Option<Arc<dyn BackgroundExecutor>>,
 }
 
 #[cfg(feature = "default-engine-base")]
@@ -403,6 +432,12 @@ impl ExternEngine for ExternEngineVtable {
     fn error_allocator(&self) -> &dyn AllocateError {
         &self.allocate_error
     }
+    fn dv_cache(&self) -> Option<&Arc<DvCache>> {
+        self.dv_cache.as_ref()
+    }
+    fn executor(&self) -> Option<&Arc<dyn BackgroundExecutor>> {
+        self.executor.as_ref()
+    }
 }
 
 /// # Safety
@@ -419,6 +454,18 @@ pub struct EngineBuilder {
     url: Url,
     allocate_fn: AllocateErrorFn,
     options: HashMap<String, String>,
+    config: EngineConfig,
+}
+
+/// The settings of a default engine that aren't object store options
+#[cfg(feature = "default-engine-base")]
+#[derive(Default)]
+struct EngineConfig {
+    // run IO on this shared executor, instead of on a background thread of the engine's own
+    executor: Option<Arc<EngineExecutor>>,
+    // 0 means no limit
+    max_concurrent_requests: usize,
+    readahead: Option<usize>,
 }
 
 #[cfg(feature = "default-engine-base")]
@@ -453,11 +500,14 @@ fn get_engine_builder_impl(
         url: url?,
         allocate_fn,
         options: HashMap::default(),
+        config: EngineConfig::default(),
     });
     Ok(Box::into_raw(builder))
 }
 
-/// Set an option on the builder
+/// Set an option on the builder. Most options configure the object store the default engine reads
+/// the table with. In addition, `deletion_vector_cache_size` makes the engine cache deletion
+/// vectors across scans, using up to the given number of bytes.
 ///
 /// # Safety
 ///
@@ -475,6 +525,56 @@ pub unsafe extern "C" fn set_builder_option(
     builder.set_option(key.unwrap(), value.unwrap());
 }
 
+/// Build the engine on `executor` (see [`new_engine_executor`]), rather than giving it a
+/// background thread of its own to run IO on. Any number of engines can share an executor. The
+/// engine's polled ([`scan_metadata_poll`], [`read_result_poll`]) and prefetched scan metadata
+/// iterators run on the executor as well.
+///
+/// [`scan_metadata_poll`]: crate::scan::scan_metadata_poll
+/// [`read_result_poll`]: crate::engine_funcs::read_result_poll
+/// [`new_engine_executor`]: crate::executor::new_engine_executor
+///
+/// # Safety
+///
+/// Caller must pass a valid EngineBuilder pointer and executor handle
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn set_builder_executor(
+    builder: &mut EngineBuilder,
+    executor: Handle<SharedEngineExecutor>,
+) {
+    builder.config.executor = Some(unsafe { executor.clone_as_arc() });
+}
+
+/// Limit the number of requests the engine has in flight to its object store at once. `0`, the
+/// default, means no limit. Engines sharing an executor still each have their own limit.
+///
+/// # Safety
+///
+/// Caller must pass a valid EngineBuilder pointer
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn set_builder_max_concurrent_requests(
+    builder: &mut EngineBuilder,
+    max_requests: usize,
+) {
+    builder.config.max_concurrent_requests = max_requests;
+}
+
+/// Set how many files (for [`read_parquet_file`] and friends, how many batches) the engine reads
+/// ahead of the one being consumed. Must be at least `1`, and defaults to `10`.
+///
+/// [`read_parquet_file`]: crate::engine_funcs::read_parquet_file
+///
+/// # Safety
+///
+/// Caller must pass a valid EngineBuilder pointer
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn set_builder_readahead(builder: &mut EngineBuilder, readahead: usize) {
+    builder.config.readahead = Some(readahead);
+}
+
 /// Consume the builder and return a `default` engine. After calling, the passed pointer is _no
 /// longer valid_. Note that this _consumes_ and frees the builder, so there is no need to
 /// drop/free it afterwards.
@@ -492,6 +592,7 @@ pub unsafe extern "C" fn builder_build(
     get_default_engine_impl(
         builder_box.url,
         builder_box.options,
+        builder_box.config,
         builder_box.allocate_fn,
     )
     .into_extern_result(&builder_box.allocate_fn)
@@ -516,7 +617,7 @@ fn get_default_default_engine_impl(
     url: DeltaResult<Url>,
     allocate_error: AllocateErrorFn,
 ) -> DeltaResult<Handle<SharedExternEngine>> {
-    get_default_engine_impl(url?, Default::default(), allocate_error)
+    get_default_engine_impl(url?, Default::default(), Default::default(), allocate_error)
 }
 
 /// Safety
@@ -526,10 +627,22 @@ fn get_default_default_engine_impl(
 fn engine_to_handle(
     engine: Arc<dyn Engine>,
     allocate_error: AllocateErrorFn,
+) -> Handle<SharedExternEngine> {
+    engine_to_handle_with_parts(engine, allocate_error, None, None)
+}
+
+#[cfg(feature = "default-engine-base")]
+fn engine_to_handle_with_parts(
+    engine: Arc<dyn Engine>,
+    allocate_error: AllocateErrorFn,
+    dv_cache: Option<Arc<DvCache>>,
+    executor: Option<Arc<dyn BackgroundExecutor>>,
 ) -> Handle<SharedExternEngine> {
     let engine: Arc<dyn ExternEngine> = Arc::new(ExternEngineVtable {
         engine,
         allocate_error,
+        dv_cache,
+        executor,
     });
     engine.into()
 }
@@ -537,17 +650,57 @@ fn engine_to_handle(
 #[cfg(feature = "default-engine-base")]
 fn get_default_engine_impl(
     url: Url,
-    options: HashMap<String, String>,
+    mut options: HashMap<String, String>,
+    config: EngineConfig,
     allocate_error: AllocateErrorFn,
 ) -> DeltaResult<Handle<SharedExternEngine>> {
     use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+    use delta_kernel::engine::default::executor::TaskExecutor;
+    use delta_kernel::engine::default::storage::parse_url_opts;
     use delta_kernel::engine::default::DefaultEngine;
-    let engine = DefaultEngine::<TokioBackgroundExecutor>::try_new(
-        &url,
-        options,
-        Arc::new(TokioBackgroundExecutor::new()),
-    );
-    Ok(engine_to_handle(Arc::new(engine?), allocate_error))
+    use object_store::limit::LimitStore;
+    use object_store::DynObjectStore;
+
+    fn configure<E: TaskExecutor>(
+        engine: DefaultEngine<E>,
+        readahead: Option<usize>,
+    ) -> Arc<dyn Engine> {
+        match readahead {
+            Some(readahead) => Arc::new(engine.with_readahead(readahead)),
+            None => Arc::new(engine),
+        }
+    }
+
+    if config.readahead == Some(0) {
+        return Err(delta_kernel::Error::generic("readahead must be at least 1"));
+    }
+    // this one is for the engine itself rather than for its object store
+    let dv_cache = match options.remove(DV_CACHE_SIZE_OPTION) {
+        Some(size) => DvCache::from_option(&size)?,
+        None => None,
+    };
+    let (store, _path) = parse_url_opts(&url, options)?;
+    let store: Arc<DynObjectStore> = match config.max_concurrent_requests {
+        0 => store.into(),
+        max_requests => Arc::new(LimitStore::new(store, max_requests)),
+    };
+    let (engine, executor): (_, Arc<dyn BackgroundExecutor>) = match config.executor {
+        Some(executor) => {
+            let engine = DefaultEngine::new(store, executor.clone());
+            (configure(engine, config.readahead), executor)
+        }
+        None => {
+            let executor = Arc::new(TokioBackgroundExecutor::new());
+            let engine = DefaultEngine::new(store, executor.clone());
+            (configure(engine, config.readahead), executor)
+        }
+    };
+    Ok(engine_to_handle_with_parts(
+        engine,
+        allocate_error,
+        dv_cache,
+        Some(executor),
+    ))
 }
 
 /// # Safety
@@ -612,6 +765,59 @@ fn snapshot_impl(
     Ok(snapshot.into())
 }
 
+/// Get the latest snapshot of the table `snapshot` belongs to, reusing the work already done to load
+/// `snapshot`: only commits newer than its log segment's checkpoint are listed, and its protocol and
+/// metadata are kept unless a newer commit changes them. This is much cheaper than [`snapshot`] for
+/// engines that keep a table open and periodically refresh it.
+///
+/// If the table hasn't changed, the returned handle refers to the same snapshot as `snapshot` (and
+/// so compares equal to it), but is still a new handle that must be freed separately.
+///
+/// # Safety
+///
+/// Caller is responsible for passing valid handles.
+#[no_mangle]
+pub unsafe extern "C" fn snapshot_update(
+    snapshot: Handle<SharedSnapshot>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<SharedSnapshot>> {
+    let snapshot = unsafe { snapshot.clone_as_arc() };
+    let engine = unsafe { engine.as_ref() };
+    snapshot_update_impl(snapshot, engine, None).into_extern_result(&engine)
+}
+
+/// Like [`snapshot_update`], but get the snapshot at `version`. Fails if `version` is older than the
+/// version of `snapshot`.
+///
+/// # Safety
+///
+/// Caller is responsible for passing valid handles.
+#[no_mangle]
+pub unsafe extern "C" fn snapshot_update_at_version(
+    snapshot: Handle<SharedSnapshot>,
+    engine: Handle<SharedExternEngine>,
+    version: Version,
+) -> ExternResult<Handle<SharedSnapshot>> {
+    let snapshot = unsafe { snapshot.clone_as_arc() };
+    let engine = unsafe { engine.as_ref() };
+    snapshot_update_impl(snapshot, engine, version.into()).into_extern_result(&engine)
+}
+
+fn snapshot_update_impl(
+    snapshot: Arc<Snapshot>,
+    extern_engine: &dyn ExternEngine,
+    version: Option<Version>,
+) -> DeltaResult<Handle<SharedSnapshot>> {
+    let builder = Snapshot::builder_from(snapshot);
+    let builder = if let Some(v) = version {
+        builder.at_version(v)
+    } else {
+        builder
+    };
+    let snapshot = builder.build(extern_engine.engine().as_ref())?;
+    Ok(snapshot.into())
+}
+
 /// # Safety
 ///
 /// Caller is responsible for passing a valid handle.
@@ -668,6 +874,21 @@ pub unsafe extern "C" fn snapshot_table_root(
     allocate_fn(kernel_string_slice!(table_root))
 }
 
+/// Get the resolved root of the table, as with [`snapshot_table_root`], as a nul-terminated string
+/// allocated with `allocator`. Returns NULL if the allocation fails.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid snapshot handle and allocator.
+#[no_mangle]
+pub unsafe extern "C" fn snapshot_table_root_in(
+    snapshot: Handle<SharedSnapshot>,
+    allocator: &EngineAllocator,
+) -> NullableCvoid {
+    let snapshot = unsafe { snapshot.as_ref() };
+    allocator.allocate_string(snapshot.table_root().as_str())
+}
+
 /// Get a count of the number of partition columns for this snapshot
 ///
 /// # Safety
@@ -692,6 +913,22 @@ pub unsafe extern "C" fn get_partition_columns(
     iter.into()
 }
 
+/// Get the partition columns of this snapshot as an array of [`get_partition_column_count`]
+/// nul-terminated strings. The array and each string are allocated with `allocator`. Returns NULL
+/// if an allocation fails, in which case anything already allocated is freed again.
+///
+/// # Safety
+/// Caller is responsible for passing a valid snapshot handle and allocator.
+#[no_mangle]
+pub unsafe extern "C" fn get_partition_columns_in(
+    snapshot: Handle<SharedSnapshot>,
+    allocator: &EngineAllocator,
+) -> NullableCvoid {
+    let snapshot = unsafe { snapshot.as_ref() };
+    let partition_columns = snapshot.metadata().partition_columns();
+    allocator.allocate_string_array(partition_columns.iter().map(String::as_str))
+}
+
 type StringIter = dyn Iterator<Item = String> + Send;
 
 #[handle_descriptor(target=StringIter, mutable=true, sized=false)]
@@ -792,7 +1029,7 @@ mod tests {
     use crate::error::{EngineError, KernelError};
     use crate::ffi_test_utils::{
         allocate_err, allocate_str, assert_extern_result_error_with_message, ok_or_panic,
-        recover_string,
+        recover_error, recover_string,
     };
     use delta_kernel::engine::default::{executor::tokio::TokioBackgroundExecutor, DefaultEngine};
     use object_store::memory::InMemory;
@@ -832,6 +1069,63 @@ mod tests {
         }
     }
 
+    #[test]
+    fn engine_builder_dv_cache_option() {
+        let build = |size: &str| {
+            let path = "memory:///doesntmatter/foo";
+            let key = DV_CACHE_SIZE_OPTION;
+            unsafe {
+                let builder =
+                    ok_or_panic(get_engine_builder(kernel_string_slice!(path), allocate_err));
+                set_builder_option(
+                    &mut *builder,
+                    kernel_string_slice!(key),
+                    kernel_string_slice!(size),
+                );
+                builder_build(builder)
+            }
+        };
+        let engine = unsafe { ok_or_panic(build("1048576")) };
+        assert!(unsafe { engine.as_ref() }.dv_cache().is_some());
+        unsafe { free_engine(engine) };
+
+        assert_extern_result_error_with_message(
+            build("lots"),
+            KernelError::GenericError,
+            "Generic delta kernel error: Invalid deletion_vector_cache_size: 'lots'",
+        );
+    }
+
+    #[test]
+    fn engines_share_executor() {
+        let path = "memory:///doesntmatter/foo";
+        let executor = unsafe { ok_or_panic(executor::new_engine_executor(2, allocate_err)) };
+        let build = |readahead: usize| unsafe {
+            let builder = ok_or_panic(get_engine_builder(kernel_string_slice!(path), allocate_err));
+            set_builder_executor(&mut *builder, executor.shallow_copy());
+            set_builder_max_concurrent_requests(&mut *builder, 4);
+            set_builder_readahead(&mut *builder, readahead);
+            builder_build(builder)
+        };
+        assert_extern_result_error_with_message(
+            build(0),
+            KernelError::GenericError,
+            "Generic delta kernel error: readahead must be at least 1",
+        );
+        let engines = [build(1), build(16)].map(|engine| unsafe { ok_or_panic(engine) });
+        // the engines keep the executor alive
+        unsafe { executor::free_engine_executor(executor) };
+        for engine in engines {
+            // there is no table, but looking for one runs IO on the executor
+            let result = unsafe { snapshot(kernel_string_slice!(path), engine.shallow_copy()) };
+            let ExternResult::Err(err) = result else {
+                panic!("Got a snapshot of an empty store");
+            };
+            unsafe { recover_error(err) };
+            unsafe { free_engine(engine) };
+        }
+    }
+
     #[tokio::test]
     async fn test_snapshot() -> Result<(), Box<dyn std::error::Error>> {
         let storage = Arc::new(InMemory::new());
@@ -878,6 +1172,80 @@ mod tests {
         Ok(())
     }
 
+    #[tokio::test]
+    async fn test_snapshot_update() -> Result<(), Box<dyn std::error::Error>> {
+        let storage = Arc::new(InMemory::new());
+        add_commit(
+            storage.as_ref(),
+            0,
+            actions_to_string(vec![TestAction::Metadata]),
+        )
+        .await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let engine = engine_to_handle(Arc::new(engine), allocate_err);
+        let path = "memory:///";
+
+        let snapshot1 =
+            unsafe { ok_or_panic(snapshot(kernel_string_slice!(path), engine.shallow_copy())) };
+
+        // Nothing changed, so we get the same snapshot back
+        let unchanged = unsafe {
+            ok_or_panic(snapshot_update(
+                snapshot1.shallow_copy(),
+                engine.shallow_copy(),
+            ))
+        };
+        assert_eq!(unsafe { version(unchanged.shallow_copy()) }, 0);
+        assert!(unsafe { Arc::ptr_eq(&unchanged.clone_as_arc(), &snapshot1.clone_as_arc()) });
+
+        add_commit(
+            storage.as_ref(),
+            1,
+            actions_to_string(vec![TestAction::Add("file1.parquet".into())]),
+        )
+        .await?;
+        add_commit(
+            storage.as_ref(),
+            2,
+            actions_to_string(vec![TestAction::Add("file2.parquet".into())]),
+        )
+        .await?;
+
+        let snapshot2 = unsafe {
+            ok_or_panic(snapshot_update_at_version(
+                snapshot1.shallow_copy(),
+                engine.shallow_copy(),
+                1,
+            ))
+        };
+        assert_eq!(unsafe { version(snapshot2.shallow_copy()) }, 1);
+        let latest = unsafe {
+            ok_or_panic(snapshot_update(
+                snapshot2.shallow_copy(),
+                engine.shallow_copy(),
+            ))
+        };
+        assert_eq!(unsafe { version(latest.shallow_copy()) }, 2);
+
+        // Can't update to an older version
+        let older =
+            unsafe { snapshot_update_at_version(latest.shallow_copy(), engine.shallow_copy(), 1) };
+        assert_extern_result_error_with_message(
+            older,
+            KernelError::GenericError,
+            "Generic delta kernel error: Requested snapshot version 1 is older than snapshot hint version 2",
+        );
+
+        unsafe {
+            free_snapshot(snapshot1);
+            free_snapshot(unchanged);
+            free_snapshot(snapshot2);
+            free_snapshot(latest);
+            free_engine(engine);
+        }
+        Ok(())
+    }
+
     #[tokio::test]
     async fn test_snapshot_partition_cols() -> Result<(), Box<dyn std::error::Error>> {
         let storage = Arc::new(InMemory::new());
@@ -914,6 +1282,38 @@ mod tests {
         Ok(())
     }
 
+    #[tokio::test]
+    async fn test_snapshot_strings_in_allocator() -> Result<(), Box<dyn std::error::Error>> {
+        use crate::allocator::test_utils::{allocated_str, TestArena};
+
+        let storage = Arc::new(InMemory::new());
+        add_commit(
+            storage.as_ref(),
+            0,
+            actions_to_string_partitioned(vec![TestAction::Metadata]),
+        )
+        .await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let engine = engine_to_handle(Arc::new(engine), allocate_err);
+        let path = "memory:///";
+        let snapshot =
+            unsafe { ok_or_panic(snapshot(kernel_string_slice!(path), engine.shallow_copy())) };
+
+        let arena = TestArena::default();
+        let allocator = arena.allocator();
+        let table_root = unsafe { snapshot_table_root_in(snapshot.shallow_copy(), &allocator) };
+        assert_eq!(unsafe { allocated_str(table_root.unwrap()) }, path);
+        let columns = unsafe { get_partition_columns_in(snapshot.shallow_copy(), &allocator) };
+        let column = unsafe { *columns.unwrap().as_ptr().cast::<NullableCvoid>() };
+        assert_eq!(unsafe { allocated_str(column.unwrap()) }, "val");
+        // the root, the array and its one column, all released when the arena is dropped
+        assert_eq!(arena.num_allocations(), 3);
+
+        unsafe { free_snapshot(snapshot) }
+        unsafe { free_engine(engine) }
+        Ok(())
+    }
+
     #[tokio::test]
     async fn allocate_null_err_okay() -> Result<(), Box<dyn std::error::Error>> {
         let storage = Arc::new(InMemory::new());
@@ -0,0 +1,383 @@
+//! Support for advancing kernel iterators without blocking the calling thread.
+//!
+//! Kernel's iterators are synchronous: getting the next item may wait for the default engine to
+//! fetch and decode data. [`PollNext`] instead runs each `next` call on the engine's executor, and
+//! tells the engine through a [`PollWaker`] when the item is ready to be picked up. That way a
+//! single engine thread can drive many reads at once.
+//!
+//! [`prefetch`] instead keeps the iterator running ahead of the engine, so the items are (usually)
+//! ready by the time the engine asks for them, and [`start_blocking`] does the same for a single
+//! piece of work.
+//!
+//! All of them run on the executor the engine does its IO on (see [`ExternEngine::executor`]), so
+//! the executor settings of the engine builder cover them as well.
+//!
+//! [`ExternEngine::executor`]: crate::ExternEngine::executor
+
+use std::any::Any;
+use std::future::Future;
+use std::pin::Pin;
+use std::sync::{Arc, Mutex, MutexGuard};
+use std::task::Poll;
+
+use delta_kernel::engine::default::executor::TaskExecutor;
+use delta_kernel::{DeltaResult, Error};
+
+use crate::NullableCvoid;
+
+/// The result of polling an iterator for its next item
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum PollStatus {
+    /// The next item isn't available yet. The waker passed to the poll call will be called once it
+    /// is, after which the engine should poll again.
+    Pending,
+    /// The next item was passed to the engine's visitor
+    Ready,
+    /// The iterator is exhausted
+    Done,
+}
+
+/// A callback kernel uses to tell the engine that a pending poll can make progress. `wake` is
+/// called with `context` at most once per pending poll, from a kernel thread, and possibly before
+/// the poll call that returned [`PollStatus::Pending`] has returned. Calling `wake` only means the
+/// engine should poll again; the item itself is handed over by the next poll call.
+#[repr(C)]
+pub struct PollWaker {
+    pub context: NullableCvoid,
+    pub wake: extern "C" fn(context: NullableCvoid),
+}
+
+// Safety: the engine is responsible for `context` being usable from the kernel thread that wakes it
+unsafe impl Send for PollWaker {}
+
+impl PollWaker {
+    fn wake(self) {
+        (self.wake)(self.context)
+    }
+}
+
+type BoxedIterator<T> = Box<dyn Iterator<Item = DeltaResult<T>> + Send>;
+type BoxedFuture<'a, T> = Pin<Box<dyn Future<Output = T> + Send + 'a>>;
+type BlockingTask = Box<dyn FnOnce() -> Box<dyn Any + Send> + Send>;
+
+/// The parts of a [`TaskExecutor`] polling and prefetching need, in a form that can be used
+/// without knowing the type of the executor. Every [`TaskExecutor`] is one.
+pub trait BackgroundExecutor: Send + Sync {
+    fn spawn(&self, task: BoxedFuture<'static, ()>);
+    fn spawn_blocking(
+        &self,
+        task: BlockingTask,
+    ) -> BoxedFuture<'_, DeltaResult<Box<dyn Any + Send>>>;
+}
+
+impl<E: TaskExecutor> BackgroundExecutor for E {
+    fn spawn(&self, task: BoxedFuture<'static, ()>) {
+        TaskExecutor::spawn(self, task)
+    }
+
+    fn spawn_blocking(
+        &self,
+        task: BlockingTask,
+    ) -> BoxedFuture<'_, DeltaResult<Box<dyn Any + Send>>> {
+        TaskExecutor::spawn_blocking(self, task)
+    }
+}
+
+// Run `task` on the blocking threads of `executor`, rather than on one of the threads that drive
+// its IO
+async fn run_blocking<R: Send + 'static>(
+    executor: &dyn BackgroundExecutor,
+    task: impl FnOnce() -> R + Send + 'static,
+) -> DeltaResult<R> {
+    let result = executor
+        .spawn_blocking(Box::new(move || Box::new(task()) as Box<dyn Any + Send>))
+        .await?;
+    result
+        .downcast()
+        .map(|result| *result)
+        .map_err(|_| Error::internal_error("blocking task returned an unexpected type"))
+}
+
+// One `next` call of an iterator: the iterator, to make the next call with, and the item
+fn next_item<T>(mut iter: BoxedIterator<T>) -> (BoxedIterator<T>, Option<DeltaResult<T>>) {
+    let item = iter.next();
+    (iter, item)
+}
+
+// If a `next` call panicked the iterator is lost, so report the failure and appear exhausted after
+fn lost_iterator<T: 'static>(err: Error) -> (BoxedIterator<T>, Option<DeltaResult<T>>) {
+    (Box::new(std::iter::empty()), Some(Err(err)))
+}
+
+struct PollState<T> {
+    // The iterator, or None while a background fetch has it
+    iter: Option<BoxedIterator<T>>,
+    // The result of the last fetch, if the engine hasn't picked it up yet. `Some(None)` means the
+    // iterator is exhausted
+    ready: Option<Option<DeltaResult<T>>>,
+    // Set once the engine has been told the iterator is exhausted, after which no more fetches are
+    // made
+    done: bool,
+    // The waker of the last pending poll, if any
+    waker: Option<PollWaker>,
+}
+
+/// An iterator that can be polled for its next item without blocking. At most one `next` call is
+/// in flight at a time, so items are still produced in iterator order.
+pub(crate) struct PollNext<T> {
+    state: Arc<Mutex<PollState<T>>>,
+    // Runs the `next` calls. Without one, they are made by the poll call itself
+    executor: Option<Arc<dyn BackgroundExecutor>>,
+}
+
+impl<T: Send + 'static> PollNext<T> {
+    pub(crate) fn new(
+        iter: BoxedIterator<T>,
+        executor: Option<Arc<dyn BackgroundExecutor>>,
+    ) -> Self {
+        let state = PollState {
+            iter: Some(iter),
+            ready: None,
+            done: false,
+            waker: None,
+        };
+        Self {
+            state: Arc::new(Mutex::new(state)),
+            executor,
+        }
+    }
+
+    /// Return the next item if it has already been fetched. Otherwise start fetching it in the
+    /// background if that isn't already happening, and return `Pending`. `waker` is called once the
+    /// item is ready, and replaces the waker of any earlier pending poll. Once the iterator is
+    /// exhausted, every poll returns `Ready(None)` right away.
+    pub(crate) fn poll_next(&self, waker: PollWaker) -> DeltaResult<Poll<Option<T>>> {
+        let mut state = self.lock_state()?;
+        if state.done {
+            return Ok(Poll::Ready(None));
+        }
+        if let Some(ready) = state.ready.take() {
+            state.done = ready.is_none();
+            return ready.transpose().map(Poll::Ready);
+        }
+        let Some(iter) = state.iter.take() else {
+            // a fetch is already in flight. It will wake whoever polled last
+            state.waker = Some(waker);
+            return Ok(Poll::Pending);
+        };
+        let Some(executor) = &self.executor else {
+            let (iter, item) = next_item(iter);
+            state.iter = Some(iter);
+            state.done = item.is_none();
+            return item.transpose().map(Poll::Ready);
+        };
+        state.waker = Some(waker);
+        drop(state);
+
+        let shared = self.state.clone();
+        let fetcher = executor.clone();
+        let task = async move {
+            let fetched = run_blocking(fetcher.as_ref(), move || next_item(iter)).await;
+            let (iter, item) = fetched.unwrap_or_else(lost_iterator);
+            let Ok(mut state) = shared.lock() else {
+                return;
+            };
+            state.iter = Some(iter);
+            state.ready = Some(item);
+            let waker = state.waker.take();
+            drop(state);
+            if let Some(waker) = waker {
+                waker.wake();
+            }
+        };
+        executor.spawn(Box::pin(task));
+        Ok(Poll::Pending)
+    }
+
+    fn lock_state(&self) -> DeltaResult<MutexGuard<'_, PollState<T>>> {
+        self.state
+            .lock()
+            .map_err(|_| Error::generic("poisoned mutex"))
+    }
+}
+
+/// Produce the items of `iter` on `executor`, up to `depth` items ahead of whoever consumes the
+/// returned iterator. The items are returned in the same order. Each `next` call runs on one of the
+/// executor's blocking threads, but the producer waits for room in the queue without holding a
+/// thread. Once the returned iterator is dropped the producer stops after the item it is producing,
+/// if any. The returned iterator blocks while waiting for an item, so it must not be consumed from
+/// a task running on an async runtime.
+pub(crate) fn prefetch<T: Send + 'static>(
+    iter: BoxedIterator<T>,
+    depth: usize,
+    executor: Arc<dyn BackgroundExecutor>,
+) -> BoxedIterator<T> {
+    let (sender, mut receiver) = tokio::sync::mpsc::channel(depth.max(1));
+    let producer = executor.clone();
+    let task = async move {
+        let mut iter = iter;
+        loop {
+            let fetched = run_blocking(producer.as_ref(), move || next_item(iter)).await;
+            let (rest, item) = fetched.unwrap_or_else(lost_iterator);
+            // sending waits while the queue is full, and fails once the receiver is gone
+            match item {
+                Some(item) if sender.send(item).await.is_ok() => iter = rest,
+                _ => break,
+            }
+        }
+    };
+    executor.spawn(Box::pin(task));
+    Box::new(std::iter::from_fn(move || receiver.blocking_recv()))
+}
+
+/// The result of a task started with [`start_blocking`], to be waited for once it is needed
+pub(crate) struct Deferred<R>(tokio::sync::oneshot::Receiver<DeltaResult<R>>);
+
+impl<R> Deferred<R> {
+    /// A result that is already there, for when there is no executor to start the task on
+    pub(crate) fn ready(result: R) -> Self {
+        let (sender, receiver) = tokio::sync::oneshot::channel();
+        // the receiver is right here, so this can't fail
+        let _ = sender.send(Ok(result));
+        Self(receiver)
+    }
+
+    /// Wait for the task to finish, and return its result. As with [`prefetch`], this blocks, so it
+    /// must not be called from a task running on an async runtime.
+    pub(crate) fn wait(self) -> DeltaResult<R> {
+        self.0
+            .blocking_recv()
+            .map_err(|_| Error::generic("background task was dropped before it finished"))?
+    }
+}
+
+/// Start running `task` on one of the blocking threads of `executor` right away, so that it runs
+/// while the caller does other work. Dropping the returned [`Deferred`] doesn't stop the task, but
+/// its result is then thrown away.
+pub(crate) fn start_blocking<R: Send + 'static>(
+    executor: Arc<dyn BackgroundExecutor>,
+    task: impl FnOnce() -> DeltaResult<R> + Send + 'static,
+) -> Deferred<R> {
+    let (sender, receiver) = tokio::sync::oneshot::channel();
+    let runner = executor.clone();
+    let task = async move {
+        let result = run_blocking(runner.as_ref(), task)
+            .await
+            .and_then(|result| result);
+        // fails only if the `Deferred` was dropped, in which case nobody wants the result
+        let _ = sender.send(result);
+    };
+    executor.spawn(Box::pin(task));
+    Deferred(receiver)
+}
+
+impl<T> Drop for PollNext<T> {
+    fn drop(&mut self) {
+        // a fetch may still be in flight, but the engine is done with this iterator and must not be
+        // woken for it anymore
+        if let Ok(mut state) = self.state.lock() {
+            state.waker = None;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::ffi::c_void;
+    use std::ptr::NonNull;
+    use std::sync::mpsc::{channel, Sender};
+    use std::time::Duration;
+
+    use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+
+    use super::*;
+
+    fn executor() -> Arc<dyn BackgroundExecutor> {
+        Arc::new(TokioBackgroundExecutor::new())
+    }
+
+    extern "C" fn wake_channel(context: NullableCvoid) {
+        let sender = context.unwrap().as_ptr() as *const Sender<()>;
+        unsafe { &*sender }.send(()).unwrap();
+    }
+
+    #[test]
+    fn poll_next_yields_items_in_order() {
+        let (sender, receiver) = channel();
+        let waker = || PollWaker {
+            context: NonNull::new(&sender as *const Sender<()> as *mut c_void),
+            wake: wake_channel,
+        };
+        let items = (0..3).map(|i| {
+            // make sure the first poll can't find the item ready
+            std::thread::sleep(Duration::from_millis(10));
+            Ok(i)
+        });
+        let poll = PollNext::new(Box::new(items), Some(executor()));
+
+        let mut results = vec![];
+        loop {
+            match poll.poll_next(waker()).unwrap() {
+                Poll::Ready(Some(item)) => results.push(item),
+                Poll::Ready(None) => break,
+                Poll::Pending => receiver.recv_timeout(Duration::from_secs(10)).unwrap(),
+            }
+        }
+        assert_eq!(results, [0, 1, 2]);
+        // once exhausted, it stays exhausted without going through the executor again
+        for _ in 0..2 {
+            assert!(matches!(poll.poll_next(waker()), Ok(Poll::Ready(None))));
+        }
+        assert!(receiver.try_recv().is_err());
+    }
+
+    #[test]
+    fn poll_next_without_executor_is_ready_right_away() {
+        extern "C" fn never_wake(_context: NullableCvoid) {
+            panic!("a poll without an executor should never be pending");
+        }
+        let waker = || PollWaker {
+            context: None,
+            wake: never_wake,
+        };
+        let poll = PollNext::new(Box::new((0..2).map(Ok)), None);
+        assert!(matches!(poll.poll_next(waker()), Ok(Poll::Ready(Some(0)))));
+        assert!(matches!(poll.poll_next(waker()), Ok(Poll::Ready(Some(1)))));
+        assert!(matches!(poll.poll_next(waker()), Ok(Poll::Ready(None))));
+        assert!(matches!(poll.poll_next(waker()), Ok(Poll::Ready(None))));
+    }
+
+    #[test]
+    fn start_blocking_runs_before_it_is_waited_for() {
+        let (sender, receiver) = channel();
+        let deferred = start_blocking(executor(), move || {
+            sender.send(()).unwrap();
+            Ok(42)
+        });
+        // the task runs without anyone waiting for it
+        receiver.recv_timeout(Duration::from_secs(10)).unwrap();
+        assert_eq!(deferred.wait().unwrap(), 42);
+
+        let failed: Deferred<()> = start_blocking(executor(), || Err(Error::generic("no luck")));
+        assert!(failed.wait().is_err());
+    }
+
+    #[test]
+    fn prefetch_stays_within_depth() {
+        let produced = Arc::new(Mutex::new(0));
+        let counter = produced.clone();
+        let items = (0..10).map(move |i| {
+            *counter.lock().unwrap() += 1;
+            Ok(i)
+        });
+        let mut prefetched = prefetch(Box::new(items), 2, executor());
+        assert_eq!(prefetched.next().unwrap().unwrap(), 0);
+        // give the producer time to fill the queue
+        std::thread::sleep(Duration::from_millis(50));
+        // two items queued, plus at most one waiting to be
+        assert!(*produced.lock().unwrap() <= 4);
+        let rest: Vec<_> = prefetched.map(Result::unwrap).collect();
+        assert_eq!(rest, (1..10).collect::<Vec<_>>());
+    }
+}
@@ -2,18 +2,38 @@
 
 use std::collections::HashMap;
 use std::ffi::c_void;
-use std::sync::{Arc, Mutex};
+use std::hash::{DefaultHasher, Hash, Hasher};
+#[cfg(feature = "default-engine-base")]
+use std::sync::OnceLock;
+use std::sync::{Arc, LazyLock, Mutex};
+#[cfg(feature = "default-engine-base")]
+use std::task::Poll;
 
-use delta_kernel::scan::state::DvInfo;
-use delta_kernel::scan::{Scan, ScanMetadata};
+use delta_kernel::actions::deletion_vector::DeletionVectorDescriptor;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::array::{Array, BooleanArray, BooleanBufferBuilder};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::ffi_stream::FFI_ArrowArrayStream;
+use delta_kernel::engine_data::{GetData, MapItem, TypedGetData as _};
+use delta_kernel::expressions::{column_name, ColumnName, Scalar};
+use delta_kernel::scan::state::{DvInfo, Stats};
+use delta_kernel::scan::{get_transform_for_row, Scan, ScanMetadata};
+use delta_kernel::schema::{DataType, MapType, SchemaRef, StructField, StructType};
 use delta_kernel::snapshot::SnapshotRef;
-use delta_kernel::{DeltaResult, Error, Expression, ExpressionRef};
+use delta_kernel::{DeltaResult, Error, Expression, ExpressionRef, Predicate, RowVisitor};
 use delta_kernel_ffi_macros::handle_descriptor;
-use tracing::debug;
+use itertools::Itertools;
+use tracing::{debug, warn};
 use url::Url;
 
+use crate::allocator::EngineAllocator;
+use crate::dv_cache;
+#[cfg(feature = "default-engine-base")]
+use crate::engine_data::{array_data_to_arrow_ffi_data, ArrowFFIData};
 use crate::expressions::kernel_visitor::{unwrap_kernel_predicate, KernelExpressionVisitorState};
-use crate::expressions::SharedExpression;
+use crate::expressions::{SharedExpression, SharedPredicate};
+#[cfg(feature = "default-engine-base")]
+use crate::poll::{prefetch, PollNext, PollStatus, PollWaker};
 use crate::{
     kernel_string_slice, unwrap_and_parse_path_as_url, AllocateStringFn, ExternEngine,
     ExternResult, IntoExternResult, KernelBoolSlice, KernelRowIndexArray, KernelStringSlice,
@@ -48,6 +68,42 @@ pub struct EnginePredicate {
         extern "C" fn(predicate: *mut c_void, state: &mut KernelExpressionVisitorState) -> usize,
 }
 
+/// Have the engine visit its predicate into a kernel [`Predicate`]. Returns `None` if the visitor
+/// did not produce a valid predicate.
+pub(crate) fn visit_engine_predicate(predicate: &mut EnginePredicate) -> Option<Predicate> {
+    let mut visitor_state = KernelExpressionVisitorState::default();
+    let pred_id = (predicate.visitor)(predicate.predicate, &mut visitor_state);
+    unwrap_kernel_predicate(&mut visitor_state, pred_id)
+}
+
+/// Have the engine visit its predicate into a kernel predicate, once. The returned predicate can
+/// be passed to [`read_parquet_file`] and friends by any number of threads at the same time, which
+/// an [`EnginePredicate`] can't: each read would visit it again, through the same `&mut`. It is
+/// the responsibility of the _engine_ to free it by calling [`free_kernel_predicate`]. Fails if
+/// the visitor did not produce a valid predicate.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid engine pointer and `EnginePredicate`
+///
+/// [`read_parquet_file`]: crate::engine_funcs::read_parquet_file
+/// [`free_kernel_predicate`]: crate::expressions::free_kernel_predicate
+#[no_mangle]
+pub unsafe extern "C" fn kernel_predicate_from_engine(
+    engine: Handle<SharedExternEngine>,
+    predicate: &mut EnginePredicate,
+) -> ExternResult<Handle<SharedPredicate>> {
+    kernel_predicate_from_engine_impl(predicate).into_extern_result(&engine.as_ref())
+}
+
+fn kernel_predicate_from_engine_impl(
+    predicate: &mut EnginePredicate,
+) -> DeltaResult<Handle<SharedPredicate>> {
+    let predicate = visit_engine_predicate(predicate)
+        .ok_or_else(|| Error::generic("engine predicate visitor returned an invalid predicate"))?;
+    Ok(Arc::new(predicate).into())
+}
+
 /// Drop a `SharedScanMetadata`.
 ///
 /// # Safety
@@ -77,6 +133,33 @@ fn selection_vector_from_scan_metadata_impl(
     Ok(scan_metadata.scan_files.selection_vector.clone().into())
 }
 
+/// Get the selection vector out of a [`SharedScanMetadata`] struct as an arrow boolean array. This
+/// is equivalent to [`selection_vector_from_scan_metadata`], but the result is bit-packed in arrow
+/// layout and can be imported by the engine through the arrow [C Data
+/// Interface](https://arrow.apache.org/docs/format/CDataInterface.html) without any copies. If this
+/// function returns an `Ok` variant the _engine_ must free the returned struct.
+///
+/// # Safety
+/// Engine is responsible for providing valid pointers for each argument
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn selection_vector_from_scan_metadata_as_arrow(
+    scan_metadata: Handle<SharedScanMetadata>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<*mut ArrowFFIData> {
+    let scan_metadata = unsafe { scan_metadata.as_ref() };
+    selection_vector_from_scan_metadata_as_arrow_impl(scan_metadata)
+        .into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn selection_vector_from_scan_metadata_as_arrow_impl(
+    scan_metadata: &ScanMetadata,
+) -> DeltaResult<*mut ArrowFFIData> {
+    let selection_vector = BooleanArray::from(scan_metadata.scan_files.selection_vector.clone());
+    array_data_to_arrow_ffi_data(&selection_vector.into_data())
+}
+
 /// Drops a scan.
 ///
 /// # Safety
@@ -99,18 +182,101 @@ pub unsafe extern "C" fn scan(
     predicate: Option<&mut EnginePredicate>,
 ) -> ExternResult<Handle<SharedScan>> {
     let snapshot = unsafe { snapshot.clone_as_arc() };
-    scan_impl(snapshot, predicate).into_extern_result(&engine.as_ref())
+    scan_impl(snapshot, predicate, None, None).into_extern_result(&engine.as_ref())
+}
+
+/// Get a [`Scan`] over the table specified by the passed snapshot, which only reads the top-level
+/// columns named in `columns`, in that order. `columns` must point to `num_columns` string slices
+/// (it may be `NULL` if `num_columns` is zero, which selects no columns at all). Fails if any
+/// column doesn't exist in the table's schema. As with [`scan`], it is the responsibility of the
+/// _engine_ to free this scan when complete by calling [`free_scan`].
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid snapshot pointer, engine pointer, and `columns` array
+#[no_mangle]
+pub unsafe extern "C" fn scan_with_columns(
+    snapshot: Handle<SharedSnapshot>,
+    engine: Handle<SharedExternEngine>,
+    predicate: Option<&mut EnginePredicate>,
+    columns: *const KernelStringSlice,
+    num_columns: usize,
+) -> ExternResult<Handle<SharedScan>> {
+    let snapshot = unsafe { snapshot.clone_as_arc() };
+    let columns = match num_columns {
+        0 => &[],
+        _ => unsafe { std::slice::from_raw_parts(columns, num_columns) },
+    };
+    let columns: DeltaResult<Vec<&str>> = columns
+        .iter()
+        .map(|column| unsafe { TryFromStringSlice::try_from_slice(column) })
+        .collect();
+    scan_with_columns_impl(snapshot, predicate, Some(columns), None)
+        .into_extern_result(&engine.as_ref())
+}
+
+/// Get a [`Scan`] over the table specified by the passed snapshot, which only needs to return
+/// `limit` rows. Once the files selected by the scan are known from their statistics to contain at
+/// least `limit` rows, the scan's metadata iterator selects no more files and stops replaying the
+/// log. The engine must still apply the limit to the rows it reads, since the selected files
+/// usually contain more rows than that. The limit is ignored if `predicate` is not `NULL`.
+///
+/// `columns` and `num_columns` select the columns to read as for [`scan_with_columns`], except that
+/// if `columns` is `NULL` all the columns of the table are read. As with [`scan`], it is the
+/// responsibility of the _engine_ to free this scan when complete by calling [`free_scan`].
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid snapshot pointer, engine pointer, and `columns` array
+#[no_mangle]
+pub unsafe extern "C" fn scan_with_limit(
+    snapshot: Handle<SharedSnapshot>,
+    engine: Handle<SharedExternEngine>,
+    predicate: Option<&mut EnginePredicate>,
+    columns: *const KernelStringSlice,
+    num_columns: usize,
+    limit: u64,
+) -> ExternResult<Handle<SharedScan>> {
+    let snapshot = unsafe { snapshot.clone_as_arc() };
+    let columns = match (columns.is_null(), num_columns) {
+        (true, _) => None,
+        (false, 0) => Some(&[][..]),
+        (false, _) => Some(unsafe { std::slice::from_raw_parts(columns, num_columns) }),
+    };
+    let columns: Option<DeltaResult<Vec<&str>>> = columns.map(|columns| {
+        columns
+            .iter()
+            .map(|column| unsafe { TryFromStringSlice::try_from_slice(column) })
+            .collect()
+    });
+    scan_with_columns_impl(snapshot, predicate, columns, Some(limit))
+        .into_extern_result(&engine.as_ref())
+}
+
+fn scan_with_columns_impl(
+    snapshot: SnapshotRef,
+    predicate: Option<&mut EnginePredicate>,
+    columns: Option<DeltaResult<Vec<&str>>>,
+    limit: Option<u64>,
+) -> DeltaResult<Handle<SharedScan>> {
+    let schema = columns
+        .map(|columns| snapshot.schema().project(&columns?))
+        .transpose()?;
+    scan_impl(snapshot, predicate, schema, limit)
 }
 
 fn scan_impl(
     snapshot: SnapshotRef,
     predicate: Option<&mut EnginePredicate>,
+    schema: Option<SchemaRef>,
+    limit: Option<u64>,
 ) -> DeltaResult<Handle<SharedScan>> {
-    let mut scan_builder = snapshot.scan_builder();
+    let mut scan_builder = snapshot
+        .scan_builder()
+        .with_schema_opt(schema)
+        .with_limit(limit);
     if let Some(predicate) = predicate {
-        let mut visitor_state = KernelExpressionVisitorState::default();
-        let pred_id = (predicate.visitor)(predicate.predicate, &mut visitor_state);
-        let predicate = unwrap_kernel_predicate(&mut visitor_state, pred_id);
+        let predicate = visit_engine_predicate(predicate);
         debug!("Got predicate: {:#?}", predicate);
         scan_builder = scan_builder.with_predicate(predicate.map(Arc::new));
     }
@@ -132,6 +298,20 @@ pub unsafe extern "C" fn scan_table_root(
     allocate_fn(kernel_string_slice!(table_root))
 }
 
+/// Get the table root of a scan, as a nul-terminated string allocated with `allocator`. Returns
+/// NULL if the allocation fails.
+///
+/// # Safety
+/// Engine is responsible for providing a valid scan pointer and allocator
+#[no_mangle]
+pub unsafe extern "C" fn scan_table_root_in(
+    scan: Handle<SharedScan>,
+    allocator: &EngineAllocator,
+) -> NullableCvoid {
+    let scan = unsafe { scan.as_ref() };
+    allocator.allocate_string(scan.table_root().as_str())
+}
+
 /// Get the logical (i.e. output) schema of a scan.
 ///
 /// # Safety
@@ -153,6 +333,72 @@ pub unsafe extern "C" fn scan_physical_schema(scan: Handle<SharedScan>) -> Handl
     scan.physical_schema().clone().into()
 }
 
+/// Counters describing the work a scan has done so far. See [`scan_metrics`]. Times are in
+/// nanoseconds.
+#[repr(C)]
+pub struct ScanMetrics {
+    /// Number of commit (and compacted commit) files log replay opened
+    pub commit_files_read: u64,
+    /// Number of checkpoint parts log replay opened, not including sidecar files
+    pub checkpoint_parts_read: u64,
+    /// Number of sidecar files of v2 checkpoints log replay opened
+    pub sidecar_files_read: u64,
+    /// Total size in bytes of the log files log replay opened. Data files and deletion vectors are
+    /// read by the engine, so their bytes are not included
+    pub log_bytes_read: u64,
+    /// Number of actions (rows of log data) replayed
+    pub actions_replayed: u64,
+    /// Number of add actions log replay considered, before any skipping or deduplication
+    pub files_considered: u64,
+    /// Number of add actions skipped by data skipping (i.e. using file statistics)
+    pub files_skipped_by_stats: u64,
+    /// Number of add actions skipped by partition pruning
+    pub files_skipped_by_partition: u64,
+    /// Number of files selected for the scan
+    pub files_selected: u64,
+    /// Number of selected files that have a deletion vector, i.e. how many deletion vectors
+    /// reading the files will load
+    pub files_with_deletion_vector: u64,
+    /// Time spent reading and parsing log files
+    pub log_read_ns: u64,
+    /// Time spent evaluating data skipping predicates
+    pub data_skipping_ns: u64,
+    /// Time spent replaying actions, not including data skipping
+    pub log_replay_ns: u64,
+}
+
+impl From<delta_kernel::scan::ScanMetrics> for ScanMetrics {
+    fn from(metrics: delta_kernel::scan::ScanMetrics) -> Self {
+        Self {
+            commit_files_read: metrics.commit_files_read,
+            checkpoint_parts_read: metrics.checkpoint_parts_read,
+            sidecar_files_read: metrics.sidecar_files_read,
+            log_bytes_read: metrics.log_bytes_read,
+            actions_replayed: metrics.actions_replayed,
+            files_considered: metrics.files_considered,
+            files_skipped_by_stats: metrics.files_skipped_by_stats,
+            files_skipped_by_partition: metrics.files_skipped_by_partition,
+            files_selected: metrics.files_selected,
+            files_with_deletion_vector: metrics.files_with_deletion_vector,
+            log_read_ns: metrics.log_read_time.as_nanos() as u64,
+            data_skipping_ns: metrics.data_skipping_time.as_nanos() as u64,
+            log_replay_ns: metrics.log_replay_time.as_nanos() as u64,
+        }
+    }
+}
+
+/// Get the metrics of a scan so far. Metrics are collected as the scan's metadata is iterated, and
+/// cover all the [`SharedScanMetadataIterator`]s created from the scan. They are only complete once
+/// every such iterator has been exhausted.
+///
+/// # Safety
+/// Engine is responsible for providing a valid `SharedScan` handle
+#[no_mangle]
+pub unsafe extern "C" fn scan_metrics(scan: Handle<SharedScan>) -> ScanMetrics {
+    let scan = unsafe { scan.as_ref() };
+    scan.metrics().into()
+}
+
 // Intentionally opaque to the engine.
 //
 // TODO: This approach liberates the engine from having to worry about mutual exclusion, but that
@@ -169,6 +415,10 @@ pub struct ScanMetadataIterator {
     // Json handlers don't hold any reference to the tokio reactor they rely on, so the iterator
     // terminates early if the last engine goes out of scope.
     engine: Arc<dyn ExternEngine>,
+
+    // Set once the engine starts polling the iterator, at which point it owns the data
+    #[cfg(feature = "default-engine-base")]
+    poll: OnceLock<PollNext<ScanMetadata>>,
 }
 
 #[handle_descriptor(target=ScanMetadataIterator, mutable=false, sized=true)]
@@ -197,6 +447,69 @@ pub unsafe extern "C" fn scan_metadata_iter_init(
     scan_metadata_iter_init_impl(&engine, scan).into_extern_result(&engine.as_ref())
 }
 
+/// Like [`scan_metadata_iter_init`], but the returned iterator runs log replay (including reading
+/// commit files and checkpoint parts) on the executor the engine does its IO on, up to `prefetch`
+/// items ahead of the engine. That way producing the next scan metadata item overlaps with whatever
+/// the engine does with the current one, e.g. reading its files. At most `prefetch` items are held
+/// in memory waiting to be picked up. If `prefetch` is 0 this is the same as
+/// [`scan_metadata_iter_init`].
+///
+/// # Safety
+///
+/// Engine is responsible for passing a valid [`SharedExternEngine`] and [`SharedScan`]
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn scan_metadata_iter_init_with_prefetch(
+    engine: Handle<SharedExternEngine>,
+    scan: Handle<SharedScan>,
+    prefetch: usize,
+) -> ExternResult<Handle<SharedScanMetadataIterator>> {
+    let engine = unsafe { engine.clone_as_arc() };
+    let scan = unsafe { scan.as_ref() };
+    scan_metadata_iter_init_with_prefetch_impl(&engine, scan, prefetch)
+        .into_extern_result(&engine.as_ref())
+}
+
+/// An iterator that keeps the engine it reads through alive. The producer of [`prefetch`] may still
+/// be replaying the log after the engine freed the iterator handle (and with it the iterator's own
+/// reference to the engine), and the engine must outlive that replay.
+#[cfg(feature = "default-engine-base")]
+struct WithEngine<I> {
+    // declared first so it is dropped before the engine
+    iter: I,
+    _engine: Arc<dyn ExternEngine>,
+}
+
+#[cfg(feature = "default-engine-base")]
+impl<I: Iterator> Iterator for WithEngine<I> {
+    type Item = I::Item;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.iter.next()
+    }
+}
+
+#[cfg(feature = "default-engine-base")]
+fn scan_metadata_iter_init_with_prefetch_impl(
+    engine: &Arc<dyn ExternEngine>,
+    scan: &Scan,
+    depth: usize,
+) -> DeltaResult<Handle<SharedScanMetadataIterator>> {
+    let Some(executor) = engine.executor().filter(|_| depth > 0) else {
+        return scan_metadata_iter_init_impl(engine, scan);
+    };
+    let scan_metadata = WithEngine {
+        iter: scan.scan_metadata(engine.engine().as_ref())?,
+        _engine: engine.clone(),
+    };
+    let data = ScanMetadataIterator {
+        data: Mutex::new(prefetch(Box::new(scan_metadata), depth, executor.clone())),
+        engine: engine.clone(),
+        poll: OnceLock::new(),
+    };
+    Ok(Arc::new(data).into())
+}
+
 fn scan_metadata_iter_init_impl(
     engine: &Arc<dyn ExternEngine>,
     scan: &Scan,
@@ -205,6 +518,8 @@ fn scan_metadata_iter_init_impl(
     let data = ScanMetadataIterator {
         data: Mutex::new(Box::new(scan_metadata)),
         engine: engine.clone(),
+        #[cfg(feature = "default-engine-base")]
+        poll: OnceLock::new(),
     };
     Ok(Arc::new(data).into())
 }
@@ -254,6 +569,66 @@ fn scan_metadata_next_impl(
     }
 }
 
+/// Non-blocking version of [`scan_metadata_next`]. If the next scan metadata item is ready, call
+/// the `engine_visitor` with it as [`scan_metadata_next`] does and return [`PollStatus::Ready`], or
+/// return [`PollStatus::Done`] if there are no more items. Otherwise start producing the next item
+/// on the engine's executor and return [`PollStatus::Pending`]. Kernel calls `waker` once the item
+/// is ready, after which the engine should poll again to get it. Once a poll returned
+/// [`PollStatus::Done`], every later poll returns it right away.
+///
+/// Once an iterator has been polled, the engine must only poll it: calling [`scan_metadata_next`]
+/// on it behaves as if it were exhausted. The iterator can be freed while an item is pending, in
+/// which case `waker` is not called.
+///
+/// # Safety
+///
+/// The iterator must be valid (returned by [scan_metadata_iter_init]) and not yet freed by
+/// [`free_scan_metadata_iter`]. The visitor and waker function pointers must be non-null.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn scan_metadata_poll(
+    data: Handle<SharedScanMetadataIterator>,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        scan_metadata: Handle<SharedScanMetadata>,
+    ),
+    waker: PollWaker,
+) -> ExternResult<PollStatus> {
+    let data = unsafe { data.as_ref() };
+    scan_metadata_poll_impl(data, engine_context, engine_visitor, waker)
+        .into_extern_result(&data.engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn scan_metadata_poll_impl(
+    data: &ScanMetadataIterator,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        scan_metadata: Handle<SharedScanMetadata>,
+    ),
+    waker: PollWaker,
+) -> DeltaResult<PollStatus> {
+    let poll = data.poll.get_or_init(|| {
+        let iter: Box<dyn Iterator<Item = DeltaResult<ScanMetadata>> + Send> =
+            match data.data.lock() {
+                Ok(mut iter) => std::mem::replace(&mut *iter, Box::new(std::iter::empty())),
+                Err(_) => Box::new(std::iter::once(Err(Error::generic("poisoned mutex")))),
+            };
+        PollNext::new(iter, data.engine.executor().cloned())
+    });
+    let status = match poll.poll_next(waker)? {
+        Poll::Ready(Some(scan_metadata)) => {
+            (engine_visitor)(engine_context, Arc::new(scan_metadata).into());
+            PollStatus::Ready
+        }
+        Poll::Ready(None) => PollStatus::Done,
+        Poll::Pending => PollStatus::Pending,
+    };
+    Ok(status)
+}
+
 /// # Safety
 ///
 /// Caller is responsible for (at most once) passing a valid pointer returned by a call to
@@ -265,7 +640,8 @@ pub unsafe extern "C" fn free_scan_metadata_iter(data: Handle<SharedScanMetadata
     data.drop_handle();
 }
 
-/// Give engines an easy way to consume stats
+/// Give engines an easy way to consume stats. The per-column statistics of the files (with the
+/// `default-engine-base` feature) are available through [`scan_metadata_stats_as_arrow`].
 #[repr(C)]
 pub struct Stats {
     /// For any file where the deletion vector is not present (see [`DvInfo::has_vector`]), the
@@ -340,6 +716,26 @@ pub unsafe extern "C" fn get_from_string_map(
         .and_then(|v| allocate_fn(kernel_string_slice!(v)))
 }
 
+/// Probe into a CStringMap, as with [`get_from_string_map`], but return the value as a
+/// nul-terminated string allocated with `allocator`. Returns NULL if the key is not in the map, or
+/// the allocation fails.
+///
+/// # Safety
+///
+/// The engine is responsible for providing a valid [`CStringMap`] pointer, [`KernelStringSlice`]
+/// and allocator
+#[no_mangle]
+pub unsafe extern "C" fn get_from_string_map_in(
+    map: &CStringMap,
+    key: KernelStringSlice,
+    allocator: &EngineAllocator,
+) -> NullableCvoid {
+    let string_key: &str = unsafe { TryFromStringSlice::try_from_slice(&key) }.ok()?;
+    map.values
+        .get(string_key)
+        .and_then(|v| allocator.allocate_string(v))
+}
+
 /// Visit all values in a CStringMap. The callback will be called once for each element of the map
 ///
 /// # Safety
@@ -418,12 +814,75 @@ fn selection_vector_from_dv_impl(
     extern_engine: &dyn ExternEngine,
     root_url: DeltaResult<Url>,
 ) -> DeltaResult<KernelBoolSlice> {
-    match dv_info.get_selection_vector(extern_engine.engine().as_ref(), &root_url?)? {
+    match dv_cache::selection_vector(dv_info, extern_engine, &root_url?)? {
         Some(v) => Ok(v.into()),
         None => Ok(KernelBoolSlice::empty()),
     }
 }
 
+/// Copy a [`DvInfo`]. The copy stays valid after the scan metadata or scan file batch the original
+/// came from is freed, so the engine can load the deletion vector later, e.g. on the thread that
+/// reads the file. It is the responsibility of the _engine_ to free the copy by calling
+/// [`free_dv_info`].
+///
+/// # Safety
+/// Engine is responsible for passing a valid `DvInfo`
+#[no_mangle]
+pub unsafe extern "C" fn copy_dv_info(dv_info: &DvInfo) -> *mut DvInfo {
+    Box::into_raw(Box::new(dv_info.clone()))
+}
+
+/// Free a `DvInfo` copied by [`copy_dv_info`].
+///
+/// # Safety
+/// Engine is responsible for passing a pointer returned by [`copy_dv_info`], and not using it after
+/// this call
+#[no_mangle]
+pub unsafe extern "C" fn free_dv_info(dv_info: *mut DvInfo) {
+    drop(unsafe { Box::from_raw(dv_info) });
+}
+
+/// Get a selection vector out of a [`DvInfo`] struct as an arrow boolean array. This is equivalent
+/// to [`selection_vector_from_dv`], but the result is bit-packed in arrow layout and can be imported
+/// by the engine through the arrow [C Data
+/// Interface](https://arrow.apache.org/docs/format/CDataInterface.html) without any copies. As with
+/// [`selection_vector_from_dv`], an empty array indicates all rows are selected, and rows past the
+/// end of the array are also selected. If this function returns an `Ok` variant the _engine_ must
+/// free the returned struct.
+///
+/// # Safety
+/// Engine is responsible for providing valid pointers for each argument
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn selection_vector_from_dv_as_arrow(
+    dv_info: &DvInfo,
+    engine: Handle<SharedExternEngine>,
+    root_url: KernelStringSlice,
+) -> ExternResult<*mut ArrowFFIData> {
+    let engine = unsafe { engine.as_ref() };
+    let root_url = unsafe { unwrap_and_parse_path_as_url(root_url) };
+    selection_vector_from_dv_as_arrow_impl(dv_info, engine, root_url).into_extern_result(&engine)
+}
+
+#[cfg(feature = "default-engine-base")]
+fn selection_vector_from_dv_as_arrow_impl(
+    dv_info: &DvInfo,
+    extern_engine: &dyn ExternEngine,
+    root_url: DeltaResult<Url>,
+) -> DeltaResult<*mut ArrowFFIData> {
+    // Build the bitmap straight from the deleted row indexes, rather than materializing one bool
+    // per row first. Deletion vectors are usually sparse, so this is mostly a memset.
+    let deleted = dv_cache::deleted_rows(dv_info, extern_engine, &root_url?)?.unwrap_or_default();
+    let len = deleted.max().map_or(0, |max| max as usize + 1);
+    let mut builder = BooleanBufferBuilder::new(len);
+    builder.append_n(len, true);
+    for row_index in deleted.iter() {
+        builder.set_bit(row_index as usize, false);
+    }
+    let selection_vector = BooleanArray::new(builder.finish(), None);
+    array_data_to_arrow_ffi_data(&selection_vector.into_data())
+}
+
 /// Get a vector of row indexes out of a [`DvInfo`] struct
 ///
 /// # Safety
@@ -444,7 +903,7 @@ fn row_indexes_from_dv_impl(
     extern_engine: &dyn ExternEngine,
     root_url: DeltaResult<Url>,
 ) -> DeltaResult<KernelRowIndexArray> {
-    match dv_info.get_row_indexes(extern_engine.engine().as_ref(), &root_url?)? {
+    match dv_cache::row_indexes(dv_info, extern_engine, &root_url?)? {
         Some(v) => Ok(v.into()),
         None => Ok(KernelRowIndexArray::empty()),
     }
@@ -512,11 +971,749 @@ pub unsafe extern "C" fn visit_scan_metadata(
         .unwrap();
 }
 
+/// The files selected by one [`SharedScanMetadata`], in columnar form. This is an alternative to
+/// [`visit_scan_metadata`] that hands the engine all the files of a scan metadata chunk at once,
+/// rather than making one callback per file. Use [`scan_file_batch_as_arrow`] to get the file
+/// information as an arrow record batch, which has one row per file with the columns:
+///
+/// * `path` (`utf8`, not null): the full url of the file, with the table root already joined
+/// * `size` (`int64`, not null): the size of the file in bytes
+/// * `num_records` (`uint64`, nullable): the number of records in the file, if stats are present
+/// * `dv_index` (`uint32`, nullable): if the file has a deletion vector, its index for
+///   [`scan_file_batch_dv_info`]
+/// * `transform_id` (`uint32`, nullable): if the file needs a transform, the id of its transform
+///   for [`scan_file_batch_transform`]. Files of the batch with the same partition values and the
+///   same transform share an id, so an engine can prepare one evaluator per id rather than per file
+///
+/// The partition values of the files are already parsed into their logical types, and can be
+/// fetched with [`scan_file_batch_partition_values_as_arrow`]. They are also the parameters of the
+/// scan's [`scan_transform_template`], which can be applied instead of the per-file transforms.
+///
+/// A batch can be sent to another process with [`crate::serialization::serialize_scan_file_batch`].
+#[cfg_attr(test, derive(Debug, PartialEq))]
+pub struct ScanFileBatch {
+    pub(crate) paths: Vec<String>,
+    pub(crate) sizes: Vec<i64>,
+    pub(crate) num_records: Vec<Option<u64>>,
+    pub(crate) dv_indexes: Vec<Option<u32>>,
+    pub(crate) transform_ids: Vec<Option<u32>>,
+    pub(crate) dv_infos: Vec<DvInfo>,
+    // the distinct transforms of the batch, indexed by transform id
+    pub(crate) transforms: Vec<ExpressionRef>,
+    // the partition columns of the table, in the same order as `get_partition_columns`
+    pub(crate) partition_fields: Vec<StructField>,
+    // the parsed partition values, one `Vec` per entry of `partition_fields`
+    pub(crate) partition_values: Vec<Vec<Scalar>>,
+}
+
+#[handle_descriptor(target=ScanFileBatch, mutable=false, sized=true)]
+pub struct SharedScanFileBatch;
+
+/// Collect the files selected by `scan_metadata` into a [`ScanFileBatch`]. `scan` must be the scan
+/// that produced `scan_metadata`, and is used to resolve file paths against the table root. It is
+/// the responsibility of the _engine_ to free the returned batch by calling
+/// [`free_scan_file_batch`].
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScanMetadata`, `SharedScan` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch(
+    scan_metadata: Handle<SharedScanMetadata>,
+    scan: Handle<SharedScan>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<SharedScanFileBatch>> {
+    let scan_metadata = unsafe { scan_metadata.as_ref() };
+    let scan = unsafe { scan.as_ref() };
+    scan_file_batch_impl(scan_metadata, scan).into_extern_result(&engine.as_ref())
+}
+
+pub(crate) fn scan_file_batch_impl(
+    scan_metadata: &ScanMetadata,
+    scan: &Scan,
+) -> DeltaResult<Handle<SharedScanFileBatch>> {
+    let partition_fields = partition_fields(scan.snapshot())?;
+    let mut visitor = ScanFileBatchVisitor {
+        table_root: scan.table_root(),
+        selection_vector: &scan_metadata.scan_files.selection_vector,
+        transforms: &scan_metadata.scan_file_transforms,
+        batch: ScanFileBatch {
+            paths: vec![],
+            sizes: vec![],
+            num_records: vec![],
+            dv_indexes: vec![],
+            transform_ids: vec![],
+            dv_infos: vec![],
+            transforms: vec![],
+            partition_values: vec![vec![]; partition_fields.len()],
+            partition_fields,
+        },
+        transform_ids_by_partition: HashMap::new(),
+    };
+    visitor.visit_rows_of(scan_metadata.scan_files.data.as_ref())?;
+    Ok(Arc::new(visitor.batch).into())
+}
+
+// Builds a `ScanFileBatch` straight from the columns of the scan metadata, rather than through
+// `visit_scan_files`, which materializes the partition values of every file as a `HashMap`. Here
+// each partition value is looked up in the file's map and parsed in place.
+struct ScanFileBatchVisitor<'a> {
+    table_root: &'a Url,
+    selection_vector: &'a [bool],
+    transforms: &'a [Option<ExpressionRef>],
+    batch: ScanFileBatch,
+    // the ids of the transforms of the files with each hash of raw partition values. The
+    // transforms of files with the same values are usually equal, so this narrows down which
+    // transforms a new one has to be compared with. Transforms are still compared in full, so a
+    // hash collision only costs a comparison
+    transform_ids_by_partition: HashMap<u64, Vec<u32>>,
+}
+
+impl RowVisitor for ScanFileBatchVisitor<'_> {
+    fn selected_column_names_and_types(&self) -> (&'static [ColumnName], &'static [DataType]) {
+        static NAMES_AND_TYPES: LazyLock<(Vec<ColumnName>, Vec<DataType>)> = LazyLock::new(|| {
+            const STRING: DataType = DataType::STRING;
+            const INTEGER: DataType = DataType::INTEGER;
+            const LONG: DataType = DataType::LONG;
+            let ss_map: DataType = MapType::new(STRING, STRING, true).into();
+            let types_and_names = vec![
+                (STRING, column_name!("path")),
+                (LONG, column_name!("size")),
+                (STRING, column_name!("stats")),
+                (STRING, column_name!("deletionVector.storageType")),
+                (STRING, column_name!("deletionVector.pathOrInlineDv")),
+                (INTEGER, column_name!("deletionVector.offset")),
+                (INTEGER, column_name!("deletionVector.sizeInBytes")),
+                (LONG, column_name!("deletionVector.cardinality")),
+                (ss_map, column_name!("fileConstantValues.partitionValues")),
+            ];
+            let (types, names) = types_and_names.into_iter().unzip();
+            (names, types)
+        });
+        (&NAMES_AND_TYPES.0, &NAMES_AND_TYPES.1)
+    }
+
+    fn visit<'a>(&mut self, row_count: usize, getters: &[&'a dyn GetData<'a>]) -> DeltaResult<()> {
+        if getters.len() != 9 {
+            return Err(Error::InternalError(format!(
+                "Wrong number of ScanFileBatchVisitor getters: {}",
+                getters.len()
+            )));
+        }
+        for row in 0..row_count {
+            if !self.selection_vector.get(row).copied().unwrap_or(true) {
+                continue;
+            }
+            // the path column is required, so it tells us whether the row is a file at all
+            let Some(path): Option<&str> = getters[0].get_opt(row, "path")? else {
+                continue;
+            };
+            self.visit_file(row, path, getters)?;
+        }
+        Ok(())
+    }
+}
+
+impl ScanFileBatchVisitor<'_> {
+    fn visit_file<'a>(
+        &mut self,
+        row: usize,
+        path: &str,
+        getters: &[&'a dyn GetData<'a>],
+    ) -> DeltaResult<()> {
+        let path = self.table_root.join(path)?;
+        let size: i64 = getters[1].get(row, "size")?;
+        let stats: Option<&str> = getters[2].get_opt(row, "stats")?;
+        let num_records = stats.and_then(|json| match serde_json::from_str::<Stats>(json) {
+            Ok(stats) => Some(stats.num_records),
+            Err(err) => {
+                warn!("Invalid stats string in Add file {json}: {err}");
+                None
+            }
+        });
+        let storage_type: Option<String> = getters[3].get_opt(row, "deletionVector.storageType")?;
+        let dv_info = match storage_type {
+            Some(storage_type) => DvInfo::from(DeletionVectorDescriptor {
+                storage_type,
+                path_or_inline_dv: getters[4].get(row, "deletionVector.pathOrInlineDv")?,
+                offset: getters[5].get_opt(row, "deletionVector.offset")?,
+                size_in_bytes: getters[6].get(row, "deletionVector.sizeInBytes")?,
+                cardinality: getters[7].get(row, "deletionVector.cardinality")?,
+            }),
+            None => DvInfo::default(),
+        };
+        let partition_values: Option<MapItem<'_>> =
+            getters[8].get_opt(row, "fileConstantValues.partitionValues")?;
+
+        // an error fails the whole batch, so the columns can be appended to as we go
+        let batch = &mut self.batch;
+        let mut partition_hasher = DefaultHasher::new();
+        for (field, column) in batch
+            .partition_fields
+            .iter()
+            .zip(batch.partition_values.iter_mut())
+        {
+            let value = partition_values
+                .as_ref()
+                .and_then(|values| values.get(field.physical_name()));
+            value.hash(&mut partition_hasher);
+            let value = match (value, field.data_type().as_primitive_opt()) {
+                (Some(value), Some(primitive)) => primitive.parse_scalar(value)?,
+                (Some(_), None) => {
+                    return Err(Error::generic(format!(
+                        "Unexpected partition column type: {:?}",
+                        field.data_type()
+                    )))
+                }
+                (None, _) => Scalar::Null(field.data_type().clone()),
+            };
+            column.push(value);
+        }
+        batch.paths.push(path.into());
+        batch.sizes.push(size);
+        batch.num_records.push(num_records);
+        let dv_index = dv_info.has_vector().then(|| {
+            batch.dv_infos.push(dv_info);
+            batch.dv_infos.len() as u32 - 1
+        });
+        batch.dv_indexes.push(dv_index);
+        let transform_id = get_transform_for_row(row, self.transforms).map(|transform| {
+            let ids = self
+                .transform_ids_by_partition
+                .entry(partition_hasher.finish())
+                .or_default();
+            let existing = ids
+                .iter()
+                .copied()
+                .find(|id| batch.transforms[*id as usize] == transform);
+            existing.unwrap_or_else(|| {
+                batch.transforms.push(transform);
+                let id = batch.transforms.len() as u32 - 1;
+                ids.push(id);
+                id
+            })
+        });
+        batch.transform_ids.push(transform_id);
+        Ok(())
+    }
+}
+
+// The partition columns of the table, in the same order as `get_partition_columns`
+fn partition_fields(snapshot: &SnapshotRef) -> DeltaResult<Vec<StructField>> {
+    let schema = snapshot.schema();
+    snapshot
+        .metadata()
+        .partition_columns()
+        .iter()
+        .map(|column| {
+            schema.field(column).cloned().ok_or_else(|| {
+                Error::generic(format!(
+                    "Partition column {column} not found in table schema"
+                ))
+            })
+        })
+        .try_collect()
+}
+
+/// Get the number of files in a [`ScanFileBatch`].
+///
+/// # Safety
+/// Engine is responsible for passing a valid `SharedScanFileBatch`.
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch_len(batch: Handle<SharedScanFileBatch>) -> usize {
+    let batch = unsafe { batch.as_ref() };
+    batch.paths.len()
+}
+
+/// Get the file information of a [`ScanFileBatch`] as an arrow record batch, as seen through the
+/// arrow [C Data Interface](https://arrow.apache.org/docs/format/CDataInterface.html). See
+/// [`ScanFileBatch`] for the columns of the record batch. If this function returns an `Ok` variant
+/// the _engine_ must free the returned struct.
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScanFileBatch` and engine handles.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch_as_arrow(
+    batch: Handle<SharedScanFileBatch>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<*mut ArrowFFIData> {
+    let batch = unsafe { batch.as_ref() };
+    scan_file_batch_as_arrow_impl(batch).into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn scan_file_batch_as_arrow_impl(batch: &ScanFileBatch) -> DeltaResult<*mut ArrowFFIData> {
+    use delta_kernel::arrow::array::{
+        ArrayRef, Int64Array, RecordBatch, StringArray, StructArray, UInt32Array, UInt64Array,
+    };
+    let columns: [(&str, ArrayRef); 5] = [
+        (
+            "path",
+            Arc::new(StringArray::from_iter_values(&batch.paths)),
+        ),
+        ("size", Arc::new(Int64Array::from(batch.sizes.clone()))),
+        (
+            "num_records",
+            Arc::new(UInt64Array::from(batch.num_records.clone())),
+        ),
+        (
+            "dv_index",
+            Arc::new(UInt32Array::from(batch.dv_indexes.clone())),
+        ),
+        (
+            "transform_id",
+            Arc::new(UInt32Array::from(batch.transform_ids.clone())),
+        ),
+    ];
+    let record_batch = RecordBatch::try_from_iter(columns)?;
+    let array: StructArray = record_batch.into();
+    array_data_to_arrow_ffi_data(&array.into_data())
+}
+
+/// Get the partition values of the files of a [`ScanFileBatch`] as an arrow struct array, as seen
+/// through the arrow [C Data Interface](https://arrow.apache.org/docs/format/CDataInterface.html).
+/// The array has one row per file, in the same order as [`scan_file_batch_as_arrow`], and one child
+/// array per partition column, in the same order as [`get_partition_columns`]. Each child is named
+/// after its (logical) column and has the type of that column, with a null for each file that has
+/// no value for it. If this function returns an `Ok` variant the _engine_ must free the returned
+/// struct.
+///
+/// [`get_partition_columns`]: crate::get_partition_columns
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScanFileBatch` and engine handles.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch_partition_values_as_arrow(
+    batch: Handle<SharedScanFileBatch>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<*mut ArrowFFIData> {
+    let batch = unsafe { batch.as_ref() };
+    scan_file_batch_partition_values_impl(batch)
+        .and_then(|array| array_data_to_arrow_ffi_data(&array.into_data()))
+        .into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn scan_file_batch_partition_values_impl(
+    batch: &ScanFileBatch,
+) -> DeltaResult<delta_kernel::arrow::array::StructArray> {
+    use delta_kernel::arrow::array::{self as array, ArrayBuilder, ArrayRef, StructArray};
+    use delta_kernel::arrow::datatypes::{DataType as ArrowDataType, Field};
+    use delta_kernel::engine::arrow_conversion::TryFromKernel as _;
+    use delta_kernel::schema::PrimitiveType;
+
+    // Partition values are always primitive, so each column is built in one pass by appending to
+    // the concrete builder `make_builder` creates for its type (which already carries any decimal
+    // precision/scale or timestamp timezone).
+    fn append(builder: &mut dyn ArrayBuilder, value: &Scalar) -> DeltaResult<()> {
+        macro_rules! builder_as {
+            ($t:ty) => {
+                builder.as_any_mut().downcast_mut::<$t>().ok_or_else(|| {
+                    Error::generic(format!("Invalid builder for {}", value.data_type()))
+                })?
+            };
+        }
+        match value {
+            Scalar::Integer(v) => builder_as!(array::Int32Builder).append_value(*v),
+            Scalar::Long(v) => builder_as!(array::Int64Builder).append_value(*v),
+            Scalar::Short(v) => builder_as!(array::Int16Builder).append_value(*v),
+            Scalar::Byte(v) => builder_as!(array::Int8Builder).append_value(*v),
+            Scalar::Float(v) => builder_as!(array::Float32Builder).append_value(*v),
+            Scalar::Double(v) => builder_as!(array::Float64Builder).append_value(*v),
+            Scalar::String(v) => builder_as!(array::StringBuilder).append_value(v),
+            Scalar::Boolean(v) => builder_as!(array::BooleanBuilder).append_value(*v),
+            Scalar::Timestamp(v) | Scalar::TimestampNtz(v) => {
+                builder_as!(array::TimestampMicrosecondBuilder).append_value(*v)
+            }
+            Scalar::Date(v) => builder_as!(array::Date32Builder).append_value(*v),
+            Scalar::Binary(v) => builder_as!(array::BinaryBuilder).append_value(v),
+            Scalar::Decimal(v) => builder_as!(array::Decimal128Builder).append_value(v.bits()),
+            Scalar::Null(DataType::Primitive(primitive)) => match primitive {
+                PrimitiveType::Integer => builder_as!(array::Int32Builder).append_null(),
+                PrimitiveType::Long => builder_as!(array::Int64Builder).append_null(),
+                PrimitiveType::Short => builder_as!(array::Int16Builder).append_null(),
+                PrimitiveType::Byte => builder_as!(array::Int8Builder).append_null(),
+                PrimitiveType::Float => builder_as!(array::Float32Builder).append_null(),
+                PrimitiveType::Double => builder_as!(array::Float64Builder).append_null(),
+                PrimitiveType::String => builder_as!(array::StringBuilder).append_null(),
+                PrimitiveType::Boolean => builder_as!(array::BooleanBuilder).append_null(),
+                PrimitiveType::Timestamp | PrimitiveType::TimestampNtz => {
+                    builder_as!(array::TimestampMicrosecondBuilder).append_null()
+                }
+                PrimitiveType::Date => builder_as!(array::Date32Builder).append_null(),
+                PrimitiveType::Binary => builder_as!(array::BinaryBuilder).append_null(),
+                PrimitiveType::Decimal(_) => builder_as!(array::Decimal128Builder).append_null(),
+            },
+            _ => {
+                return Err(Error::generic(format!(
+                    "Unsupported partition value type {}",
+                    value.data_type()
+                )))
+            }
+        }
+        Ok(())
+    }
+
+    if batch.partition_fields.is_empty() {
+        return Ok(StructArray::new_empty_fields(batch.paths.len(), None));
+    }
+    let columns: Vec<(Arc<Field>, ArrayRef)> = batch
+        .partition_fields
+        .iter()
+        .zip(&batch.partition_values)
+        .map(|(field, values)| {
+            let data_type = ArrowDataType::try_from_kernel(field.data_type())?;
+            let mut builder = array::make_builder(&data_type, values.len());
+            for value in values {
+                append(builder.as_mut(), value)?;
+            }
+            let field = Field::new(field.name(), data_type, true);
+            Ok((Arc::new(field), builder.finish()))
+        })
+        .collect::<DeltaResult<_>>()?;
+    Ok(StructArray::from(columns))
+}
+
+/// Get the statistics of the files selected by `scan_metadata` as an arrow struct array, as seen
+/// through the arrow [C Data Interface](https://arrow.apache.org/docs/format/CDataInterface.html).
+/// The array has one row per file, in the same order as [`scan_file_batch`] and the callbacks of
+/// [`visit_scan_metadata`], with the children:
+///
+/// * `numRecords` (`int64`): the number of records in the file
+/// * `nullCount` (`struct`): the number of nulls in each column, as an `int64`
+/// * `minValues` (`struct`): the smallest value of each column, with the type of the column
+/// * `maxValues` (`struct`): the largest value of each column, with the type of the column
+///
+/// The columns are the top-level (logical) columns named by `columns`, or all the columns of the
+/// scan if `num_columns` is 0. Struct columns get a struct of stats for their fields. Everything is
+/// nullable, since a file may have no stats at all, or no stats for some columns (e.g. partition
+/// columns never have stats). `scan` must be the scan that produced `scan_metadata`. If this
+/// function returns an `Ok` variant the _engine_ must free the returned struct.
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScanMetadata`, `SharedScan` and engine handles,
+/// and a `columns` array of `num_columns` valid string slices.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn scan_metadata_stats_as_arrow(
+    scan_metadata: Handle<SharedScanMetadata>,
+    scan: Handle<SharedScan>,
+    engine: Handle<SharedExternEngine>,
+    columns: *const KernelStringSlice,
+    num_columns: usize,
+) -> ExternResult<*mut ArrowFFIData> {
+    let scan_metadata = unsafe { scan_metadata.as_ref() };
+    let scan = unsafe { scan.as_ref() };
+    let engine = unsafe { engine.as_ref() };
+    let columns = match num_columns {
+        0 => &[],
+        _ => unsafe { std::slice::from_raw_parts(columns, num_columns) },
+    };
+    let columns: DeltaResult<Vec<&str>> = columns
+        .iter()
+        .map(|column| unsafe { TryFromStringSlice::try_from_slice(column) })
+        .collect();
+    scan_metadata_stats_impl(scan_metadata, scan, engine.engine().as_ref(), columns)
+        .and_then(|array| array_data_to_arrow_ffi_data(&array.into_data()))
+        .into_extern_result(&engine)
+}
+
+#[cfg(feature = "default-engine-base")]
+fn scan_metadata_stats_impl(
+    scan_metadata: &ScanMetadata,
+    scan: &Scan,
+    engine: &dyn delta_kernel::Engine,
+    columns: DeltaResult<Vec<&str>>,
+) -> DeltaResult<delta_kernel::arrow::array::StructArray> {
+    use delta_kernel::arrow::array::{RecordBatch, StructArray};
+    use delta_kernel::arrow::compute::filter_record_batch;
+    use delta_kernel::engine::arrow_data::ArrowEngineData;
+    use delta_kernel::expressions::{column_expr, Transform};
+    use delta_kernel::scan::{file_stats_schema, scan_row_schema};
+
+    let columns = columns?;
+    let snapshot = scan.snapshot();
+    let logical_schema = match columns.is_empty() {
+        true => scan.logical_schema().clone(),
+        false => snapshot.schema().project(&columns)?,
+    };
+    // the stats are keyed by physical name, so parse them with the physical schema, and then apply
+    // the logical one
+    let physical_schema = logical_schema.make_physical(snapshot.column_mapping_mode());
+    let physical_stats_schema = file_stats_schema(&physical_schema)?;
+    let logical_stats_type: DataType = file_stats_schema(&logical_schema)?.into();
+
+    let evaluation = engine.evaluation_handler();
+    let scan_files = &scan_metadata.scan_files;
+    let stats = evaluation
+        .new_expression_evaluator(
+            scan_row_schema(),
+            Arc::new(column_expr!("stats")),
+            DataType::STRING,
+        )
+        .evaluate(scan_files.data.as_ref())?;
+    let stats = engine
+        .json_handler()
+        .parse_json(stats, physical_stats_schema.clone())?;
+    let stats = evaluation
+        .new_expression_evaluator(
+            physical_stats_schema,
+            Arc::new(Expression::Transform(Transform::new_top_level())),
+            logical_stats_type,
+        )
+        .evaluate(stats.as_ref())?;
+    let stats: RecordBatch = ArrowEngineData::try_from_engine_data(stats)?.into();
+    let selected = BooleanArray::from(scan_files.selection_vector.clone());
+    Ok(StructArray::from(filter_record_batch(&stats, &selected)?))
+}
+
+/// Get the [`DvInfo`] of the file with the given `dv_index` in a [`ScanFileBatch`], or `NULL` if
+/// there is no such deletion vector. The returned pointer can be passed to any function that takes
+/// a `DvInfo`, and is valid until the batch is freed.
+///
+/// # Safety
+/// Engine is responsible for passing a valid `SharedScanFileBatch`.
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch_dv_info(
+    batch: Handle<SharedScanFileBatch>,
+    dv_index: u32,
+) -> *const DvInfo {
+    let batch = unsafe { batch.as_ref() };
+    batch
+        .dv_infos
+        .get(dv_index as usize)
+        .map_or(std::ptr::null(), |dv_info| dv_info as *const DvInfo)
+}
+
+/// Get the transform with the given `transform_id` in a [`ScanFileBatch`], or `NULL` if there is no
+/// such transform. As with [`visit_scan_metadata`], the transform _must_ be applied to the physical
+/// data of every file with this `transform_id` to convert it to the correct logical format. The
+/// returned pointer is valid until the batch is freed.
+///
+/// # Safety
+/// Engine is responsible for passing a valid `SharedScanFileBatch`.
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch_transform(
+    batch: Handle<SharedScanFileBatch>,
+    transform_id: u32,
+) -> *const Expression {
+    let batch = unsafe { batch.as_ref() };
+    batch
+        .transforms
+        .get(transform_id as usize)
+        .map_or(std::ptr::null(), |transform| {
+            transform.as_ref() as *const Expression
+        })
+}
+
+/// Like [`scan_file_batch_transform`], but returns a new handle to the transform, which shares it
+/// rather than pointing into the batch. Pass it to `bind_prepared_expression_evaluator_shared` to
+/// get an evaluator for the transform without copying it. It is the responsibility of the _engine_
+/// to free the handle by calling [`free_kernel_expression`], which it may do before or after
+/// freeing the batch.
+///
+/// # Safety
+/// Engine is responsible for passing a valid `SharedScanFileBatch`.
+///
+/// [`free_kernel_expression`]: crate::expressions::free_kernel_expression
+#[no_mangle]
+pub unsafe extern "C" fn scan_file_batch_transform_handle(
+    batch: Handle<SharedScanFileBatch>,
+    transform_id: u32,
+) -> Option<Handle<SharedExpression>> {
+    let batch = unsafe { batch.as_ref() };
+    batch
+        .transforms
+        .get(transform_id as usize)
+        .map(|transform| transform.clone().into())
+}
+
+/// Get the transform template of a scan: one expression that applies the transform of any file of
+/// the scan, so that an engine can compile it once and reuse it for every file, rather than handle
+/// a new expression per file. A file needs the template applied if and only if it has a transform
+/// (see the `transform_id` column of [`scan_file_batch_as_arrow`]).
+///
+/// Where the transform of a file inserts the file's partition values as literals, the template
+/// reads them from parameter columns instead. Its input is the physical data of the file, with the
+/// file's partition values appended as one column per partition column of the table: the children
+/// of [`scan_file_batch_partition_values_as_arrow`], with the file's value repeated for every row.
+/// [`scan_transform_template_input_schema`] is the schema of that input. As with the per-file
+/// transforms, the result of the template is in the logical schema of the scan. It is the
+/// responsibility of the _engine_ to free the returned expression by calling
+/// [`free_kernel_expression`].
+///
+/// [`free_kernel_expression`]: crate::expressions::free_kernel_expression
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScan` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn scan_transform_template(
+    scan: Handle<SharedScan>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<SharedExpression>> {
+    let scan = unsafe { scan.as_ref() };
+    transform_template_impl(scan)
+        .map(|template| Arc::new(template).into())
+        .into_extern_result(&engine.as_ref())
+}
+
+fn transform_template_impl(scan: &Scan) -> DeltaResult<Expression> {
+    let mut transform = scan.transform_template()?;
+    // the parameter columns are not part of the output
+    for field in partition_fields(scan.snapshot())? {
+        transform = transform.with_dropped_field(field.name().clone());
+    }
+    Ok(Expression::Transform(transform))
+}
+
+/// Get the input schema of the transform template of a scan (see [`scan_transform_template`]): the
+/// physical schema of the scan, followed by one nullable field per partition column of the table,
+/// with its logical name and type. It is the responsibility of the _engine_ to free the returned
+/// schema by calling [`free_schema`].
+///
+/// [`free_schema`]: crate::free_schema
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScan` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn scan_transform_template_input_schema(
+    scan: Handle<SharedScan>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<SharedSchema>> {
+    let scan = unsafe { scan.as_ref() };
+    transform_template_input_schema_impl(scan)
+        .map(|schema| Arc::new(schema).into())
+        .into_extern_result(&engine.as_ref())
+}
+
+fn transform_template_input_schema_impl(scan: &Scan) -> DeltaResult<StructType> {
+    let parameters = partition_fields(scan.snapshot())?
+        .into_iter()
+        .map(|field| StructField::nullable(field.name(), field.data_type().clone()));
+    StructType::try_new(scan.physical_schema().fields().cloned().chain(parameters))
+}
+
+/// Free a [`ScanFileBatch`].
+///
+/// # Safety
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_scan_file_batch(batch: Handle<SharedScanFileBatch>) {
+    batch.drop_handle();
+}
+
+/// Get the data of a whole scan as an arrow [`FFI_ArrowArrayStream`], as defined by the arrow [C
+/// Stream Interface](https://arrow.apache.org/docs/format/CStreamInterface.html). The batches of
+/// the stream are in the logical schema of the scan (see [`scan_logical_schema`]), with deleted
+/// rows already dropped and all transforms already applied, so the engine can consume them as is.
+///
+/// Files are read lazily, one at a time, as the engine pulls batches from the stream, so only the
+/// batch being returned (plus the deletion vector of the file it came from) is held in memory. If
+/// this function returns an `Ok` variant the _engine_ must release the stream and free the returned
+/// struct.
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScan` and engine handles.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn scan_into_arrow_stream(
+    scan: Handle<SharedScan>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<*mut FFI_ArrowArrayStream> {
+    let scan = unsafe { scan.clone_as_arc() };
+    let engine = unsafe { engine.clone_as_arc() };
+    scan_into_arrow_stream_impl(scan, engine.clone()).into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn scan_into_arrow_stream_impl(
+    scan: Arc<Scan>,
+    extern_engine: Arc<dyn ExternEngine>,
+) -> DeltaResult<*mut FFI_ArrowArrayStream> {
+    use delta_kernel::scan::state::{transform_to_logical, Stats};
+    use delta_kernel::{EngineData, FileMeta};
+
+    use crate::engine_data::engine_data_to_arrow_stream;
+    use crate::engine_funcs::filter_deleted_rows;
+
+    struct ScanFile {
+        path: String,
+        size: i64,
+        dv_info: DvInfo,
+        transform: Option<ExpressionRef>,
+    }
+    fn push_scan_file(
+        files: &mut Vec<ScanFile>,
+        path: &str,
+        size: i64,
+        _: Option<Stats>,
+        dv_info: DvInfo,
+        transform: Option<ExpressionRef>,
+        _: HashMap<String, String>,
+    ) {
+        files.push(ScanFile {
+            path: path.to_string(),
+            size,
+            dv_info,
+            transform,
+        });
+    }
+
+    let engine = extern_engine.engine();
+    let logical_schema = scan.logical_schema().clone();
+    let scan_files = scan
+        .scan_metadata(engine.as_ref())?
+        .map(|scan_metadata| scan_metadata?.visit_scan_files(vec![], push_scan_file))
+        .flatten_ok();
+    let dv_engine = extern_engine.clone();
+    let data = scan_files
+        .map(move |scan_file| -> DeltaResult<_> {
+            let scan_file = scan_file?;
+            let table_root = scan.table_root();
+            let selection_vector =
+                dv_cache::selection_vector(&scan_file.dv_info, dv_engine.as_ref(), table_root)?;
+            let meta = FileMeta {
+                location: table_root.join(&scan_file.path)?,
+                last_modified: 0,
+                size: scan_file.size.try_into().map_err(|_| {
+                    Error::generic("Unable to convert scan file size into FileSize")
+                })?,
+            };
+            // As in `Scan::execute`, we don't push the predicate down until row indexes are
+            // supported, since skipping row groups would break the deletion vector
+            let mut file_data = engine.parquet_handler().read_parquet_files(
+                &[meta],
+                scan.physical_schema().clone(),
+                None,
+            )?;
+            if let Some(selection_vector) = selection_vector {
+                file_data = filter_deleted_rows(file_data, selection_vector);
+            }
+            let engine = engine.clone();
+            let scan = scan.clone();
+            Ok(
+                file_data.map(move |physical| -> DeltaResult<Box<dyn EngineData>> {
+                    transform_to_logical(
+                        engine.as_ref(),
+                        physical?,
+                        scan.physical_schema(),
+                        scan.logical_schema(),
+                        scan_file.transform.clone(),
+                    )
+                }),
+            )
+        })
+        .flatten_ok()
+        .map(|data| data?);
+    engine_data_to_arrow_stream(data, &logical_schema, extern_engine)
+}
+
 #[cfg(test)]
 mod tests {
     use std::{collections::HashMap, ptr::NonNull};
 
-    use crate::{KernelStringSlice, NullableCvoid, TryFromStringSlice};
+    use crate::{kernel_string_slice, KernelStringSlice, NullableCvoid, TryFromStringSlice};
 
     extern "C" fn visit_entry(
         engine_context: NullableCvoid,
@@ -549,4 +1746,455 @@ mod tests {
         let final_map: HashMap<String, String> = *unsafe { Box::from_raw(map_ptr) };
         assert_eq!(test_map, final_map);
     }
+
+    #[test]
+    fn copy_and_free_dv_info() {
+        use delta_kernel::scan::state::DvInfo;
+
+        let dv_info = DvInfo::default();
+        let copy = unsafe { super::copy_dv_info(&dv_info) };
+        assert_eq!(unsafe { &*copy }, &dv_info);
+        unsafe { super::free_dv_info(copy) };
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[test]
+    fn selection_vector_from_dv_as_arrow_without_dv() {
+        use crate::ffi_test_utils::ok_or_panic;
+        use crate::tests::get_default_engine;
+        use delta_kernel::scan::state::DvInfo;
+
+        let engine = get_default_engine("memory:///");
+        let root = "memory:///";
+        let dv_info = DvInfo::default();
+        let arrow_data = unsafe {
+            ok_or_panic(super::selection_vector_from_dv_as_arrow(
+                &dv_info,
+                engine.shallow_copy(),
+                kernel_string_slice!(root),
+            ))
+        };
+        // no deletion vector => empty selection vector, i.e. all rows selected
+        let arrow_data = unsafe { Box::from_raw(arrow_data) };
+        assert_eq!(arrow_data.array.len(), 0);
+        unsafe { crate::free_engine(engine) }
+    }
+
+    #[tokio::test]
+    async fn scan_with_columns_projects_schema() -> Result<(), Box<dyn std::error::Error>> {
+        use std::sync::Arc;
+
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use delta_kernel::schema::{DataType, StructField, StructType};
+        use object_store::memory::InMemory;
+        use test_utils::{actions_to_string, add_commit, TestAction};
+
+        use crate::ffi_test_utils::{allocate_err, ok_or_panic};
+        use crate::{engine_to_handle, free_engine, free_snapshot, snapshot};
+
+        let storage = Arc::new(InMemory::new());
+        add_commit(
+            storage.as_ref(),
+            0,
+            actions_to_string(vec![TestAction::Metadata]),
+        )
+        .await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let engine = engine_to_handle(Arc::new(engine), allocate_err);
+        let path = "memory:///";
+        let snapshot =
+            unsafe { ok_or_panic(snapshot(kernel_string_slice!(path), engine.shallow_copy())) };
+
+        // columns are returned in the order requested, not table order
+        let (val, id) = ("val", "id");
+        let columns = [kernel_string_slice!(val), kernel_string_slice!(id)];
+        let scan = unsafe {
+            ok_or_panic(super::scan_with_columns(
+                snapshot.shallow_copy(),
+                engine.shallow_copy(),
+                None,
+                columns.as_ptr(),
+                columns.len(),
+            ))
+        };
+        let expected = StructType::try_new([
+            StructField::nullable("val", DataType::STRING),
+            StructField::nullable("id", DataType::INTEGER),
+        ])?;
+        assert_eq!(
+            unsafe { scan.as_ref() }.logical_schema().as_ref(),
+            &expected
+        );
+
+        let missing = "missing";
+        let columns = [kernel_string_slice!(missing)];
+        let res = unsafe {
+            super::scan_with_columns(
+                snapshot.shallow_copy(),
+                engine.shallow_copy(),
+                None,
+                columns.as_ptr(),
+                columns.len(),
+            )
+        };
+        assert!(res.is_err());
+
+        unsafe {
+            super::free_scan(scan);
+            free_snapshot(snapshot);
+            free_engine(engine);
+        }
+        Ok(())
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[tokio::test]
+    async fn scan_into_arrow_stream_reads_all_files() -> Result<(), Box<dyn std::error::Error>> {
+        use std::sync::Arc;
+
+        use delta_kernel::arrow::array::{RecordBatch, RecordBatchReader};
+        use delta_kernel::arrow::ffi_stream::ArrowArrayStreamReader;
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use object_store::{memory::InMemory, path::Path, ObjectStore};
+        use test_utils::{
+            actions_to_string, add_commit, generate_simple_batch, record_batch_to_bytes, TestAction,
+        };
+
+        use crate::ffi_test_utils::{allocate_err, ok_or_panic};
+        use crate::{engine_to_handle, free_engine, free_snapshot, snapshot};
+
+        let batch = generate_simple_batch()?;
+        let storage = Arc::new(InMemory::new());
+        add_commit(
+            storage.as_ref(),
+            0,
+            actions_to_string(vec![
+                TestAction::Metadata,
+                TestAction::Add("a.parquet".into()),
+                TestAction::Add("b.parquet".into()),
+            ]),
+        )
+        .await?;
+        for path in ["a.parquet", "b.parquet"] {
+            storage
+                .put(&Path::from(path), record_batch_to_bytes(&batch).into())
+                .await?;
+        }
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let engine = engine_to_handle(Arc::new(engine), allocate_err);
+        let path = "memory:///";
+        let snapshot =
+            unsafe { ok_or_panic(snapshot(kernel_string_slice!(path), engine.shallow_copy())) };
+        let scan = unsafe {
+            ok_or_panic(super::scan(
+                snapshot.shallow_copy(),
+                engine.shallow_copy(),
+                None,
+            ))
+        };
+        let stream = unsafe {
+            ok_or_panic(super::scan_into_arrow_stream(
+                scan.shallow_copy(),
+                engine.shallow_copy(),
+            ))
+        };
+        // the scan and engine handles can go away, the stream holds on to what it needs
+        unsafe {
+            super::free_scan(scan);
+            free_snapshot(snapshot);
+            free_engine(engine);
+        }
+
+        let stream = unsafe { *Box::from_raw(stream) };
+        let reader = ArrowArrayStreamReader::try_new(stream)?;
+        assert_eq!(reader.schema(), batch.schema());
+        let batches: Vec<RecordBatch> = reader.collect::<Result<_, _>>()?;
+        assert_eq!(batches, [batch.clone(), batch]);
+        Ok(())
+    }
+
+    #[tokio::test]
+    async fn scan_file_batch_collects_selected_files() -> Result<(), Box<dyn std::error::Error>> {
+        use std::sync::Arc;
+
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use delta_kernel::Snapshot;
+        use object_store::memory::InMemory;
+        use test_utils::{actions_to_string, add_commit, TestAction};
+        use url::Url;
+
+        let storage = Arc::new(InMemory::new());
+        add_commit(
+            storage.as_ref(),
+            0,
+            actions_to_string(vec![
+                TestAction::Metadata,
+                TestAction::Add("a.parquet".into()),
+                TestAction::Add("b.parquet".into()),
+            ]),
+        )
+        .await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root).build(&engine)?;
+        let scan = snapshot.scan_builder().build()?;
+
+        let mut paths = vec![];
+        for scan_metadata in scan.scan_metadata(&engine)? {
+            let handle = super::scan_file_batch_impl(&scan_metadata?, &scan)?;
+            let batch = unsafe { handle.as_ref() };
+            assert!(batch.dv_infos.is_empty() && batch.transforms.is_empty());
+            assert!(batch.dv_indexes.iter().all(Option::is_none));
+            assert!(batch.num_records.iter().all(|n| *n == Some(2)));
+            paths.extend(batch.paths.iter().cloned());
+            unsafe { super::free_scan_file_batch(handle) };
+        }
+        paths.sort();
+        assert_eq!(paths, ["memory:///a.parquet", "memory:///b.parquet"]);
+        Ok(())
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[tokio::test]
+    async fn scan_file_batch_parses_partition_values() -> Result<(), Box<dyn std::error::Error>> {
+        use std::sync::Arc;
+
+        use delta_kernel::arrow::array::{Array, AsArray};
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use delta_kernel::Snapshot;
+        use object_store::memory::InMemory;
+        use test_utils::{add_commit, METADATA_WITH_PARTITION_COLS};
+        use url::Url;
+
+        let add = |path: &str, partition_values: &str| {
+            format!(
+                r#"{{"add":{{"path":"{path}","partitionValues":{partition_values},"size":262,"modificationTime":1587968586000,"dataChange":true}}}}"#
+            )
+        };
+        let commit = [
+            METADATA_WITH_PARTITION_COLS.to_string(),
+            add("val=a/a.parquet", r#"{"val":"a"}"#),
+            add("b.parquet", "{}"),
+        ]
+        .join("\n");
+        let storage = Arc::new(InMemory::new());
+        add_commit(storage.as_ref(), 0, commit).await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root).build(&engine)?;
+        let scan = snapshot.scan_builder().build()?;
+
+        let mut values = vec![];
+        for scan_metadata in scan.scan_metadata(&engine)? {
+            let handle = super::scan_file_batch_impl(&scan_metadata?, &scan)?;
+            let batch = unsafe { handle.as_ref() };
+            let array = super::scan_file_batch_partition_values_impl(batch)?;
+            assert_eq!(array.len(), batch.paths.len());
+            assert_eq!(array.num_columns(), 1);
+            let column = array.column_by_name("val").unwrap().as_string::<i32>();
+            for (path, value) in batch.paths.iter().zip(column.iter()) {
+                values.push((path.clone(), value.map(String::from)));
+            }
+            unsafe { super::free_scan_file_batch(handle) };
+        }
+        values.sort();
+        assert_eq!(
+            values,
+            [
+                ("memory:///b.parquet".to_string(), None),
+                (
+                    "memory:///val=a/a.parquet".to_string(),
+                    Some("a".to_string())
+                ),
+            ]
+        );
+        Ok(())
+    }
+
+    #[tokio::test]
+    async fn scan_file_batch_shares_transform_ids() -> Result<(), Box<dyn std::error::Error>> {
+        use std::collections::HashMap;
+        use std::sync::Arc;
+
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use delta_kernel::Snapshot;
+        use object_store::memory::InMemory;
+        use test_utils::{add_commit, METADATA_WITH_PARTITION_COLS};
+        use url::Url;
+
+        let add = |path: &str, value: &str| {
+            format!(
+                r#"{{"add":{{"path":"{path}","partitionValues":{{"val":"{value}"}},"size":262,"modificationTime":1587968586000,"dataChange":true}}}}"#
+            )
+        };
+        let commit = [
+            METADATA_WITH_PARTITION_COLS.to_string(),
+            add("val=a/a1.parquet", "a"),
+            add("val=b/b.parquet", "b"),
+            add("val=a/a2.parquet", "a"),
+        ]
+        .join("\n");
+        let storage = Arc::new(InMemory::new());
+        add_commit(storage.as_ref(), 0, commit).await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root).build(&engine)?;
+        let scan = snapshot.scan_builder().build()?;
+
+        let mut ids = HashMap::new();
+        for scan_metadata in scan.scan_metadata(&engine)? {
+            let handle = super::scan_file_batch_impl(&scan_metadata?, &scan)?;
+            let batch = unsafe { handle.as_ref() };
+            for (path, id) in batch.paths.iter().zip(&batch.transform_ids) {
+                ids.insert(path.clone(), id.unwrap());
+            }
+            // one transform per partition
+            assert_eq!(batch.transforms.len(), 2);
+            // handles share the transform with the batch, rather than copying it
+            let transform =
+                unsafe { super::scan_file_batch_transform_handle(handle.shallow_copy(), 1) };
+            let transform = transform.unwrap();
+            let shared = unsafe { transform.clone_as_arc() };
+            assert!(Arc::ptr_eq(&shared, &batch.transforms[1]));
+            let missing =
+                unsafe { super::scan_file_batch_transform_handle(handle.shallow_copy(), 2) };
+            assert!(missing.is_none());
+            unsafe {
+                crate::expressions::free_kernel_expression(transform);
+                super::free_scan_file_batch(handle);
+            }
+        }
+        assert_eq!(ids.len(), 3);
+        assert_eq!(
+            ids["memory:///val=a/a1.parquet"],
+            ids["memory:///val=a/a2.parquet"]
+        );
+        assert_ne!(
+            ids["memory:///val=a/a1.parquet"],
+            ids["memory:///val=b/b.parquet"]
+        );
+        Ok(())
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[tokio::test]
+    async fn transform_template_matches_file_transforms() -> Result<(), Box<dyn std::error::Error>>
+    {
+        use std::sync::Arc;
+
+        use delta_kernel::arrow::array::{ArrayRef, Int32Array, RecordBatch, StringArray};
+        use delta_kernel::engine::arrow_data::ArrowEngineData;
+        use delta_kernel::engine::arrow_expression::ArrowEvaluationHandler;
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use delta_kernel::{EvaluationHandler, Snapshot};
+        use object_store::memory::InMemory;
+        use test_utils::{add_commit, METADATA_WITH_PARTITION_COLS};
+        use url::Url;
+
+        let add = r#"{"add":{"path":"val=a/a.parquet","partitionValues":{"val":"a"},"size":262,"modificationTime":1587968586000,"dataChange":true}}"#;
+        let commit = [METADATA_WITH_PARTITION_COLS, add].join("\n");
+        let storage = Arc::new(InMemory::new());
+        add_commit(storage.as_ref(), 0, commit).await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root).build(&engine)?;
+        let scan = snapshot.scan_builder().build()?;
+
+        let template = Arc::new(super::transform_template_impl(&scan)?);
+        let input_schema = Arc::new(super::transform_template_input_schema_impl(&scan)?);
+        let field_names: Vec<_> = input_schema.fields().map(|field| field.name()).collect();
+        assert_eq!(field_names, ["id", "val"]);
+
+        let ids: ArrayRef = Arc::new(Int32Array::from(vec![1, 2]));
+        let physical = RecordBatch::try_from_iter([("id", ids.clone())])?;
+        let values: ArrayRef = Arc::new(StringArray::from(vec!["a", "a"]));
+        let with_parameters = RecordBatch::try_from_iter([("id", ids), ("val", values)])?;
+        let output_type = scan.logical_schema().clone().into();
+        let evaluation = ArrowEvaluationHandler;
+        let templated = evaluation
+            .new_expression_evaluator(input_schema, template, output_type)
+            .evaluate(&ArrowEngineData::new(with_parameters))?;
+        let templated: RecordBatch = ArrowEngineData::try_from_engine_data(templated)?.into();
+
+        let mut files = 0;
+        for scan_metadata in scan.scan_metadata(&engine)? {
+            let handle = super::scan_file_batch_impl(&scan_metadata?, &scan)?;
+            let batch = unsafe { handle.as_ref() };
+            for transform in &batch.transforms {
+                let output_type = scan.logical_schema().clone().into();
+                let transformed = evaluation
+                    .new_expression_evaluator(
+                        scan.physical_schema().clone(),
+                        transform.clone(),
+                        output_type,
+                    )
+                    .evaluate(&ArrowEngineData::new(physical.clone()))?;
+                let transformed: RecordBatch =
+                    ArrowEngineData::try_from_engine_data(transformed)?.into();
+                assert_eq!(transformed, templated);
+                files += 1;
+            }
+            unsafe { super::free_scan_file_batch(handle) };
+        }
+        assert_eq!(files, 1);
+        Ok(())
+    }
+
+    #[cfg(feature = "default-engine-base")]
+    #[tokio::test]
+    async fn scan_metadata_stats_are_parsed() -> Result<(), Box<dyn std::error::Error>> {
+        use std::sync::Arc;
+
+        use delta_kernel::arrow::array::{Array, AsArray};
+        use delta_kernel::arrow::datatypes::{Int32Type, Int64Type};
+        use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+        use delta_kernel::engine::default::DefaultEngine;
+        use delta_kernel::Snapshot;
+        use object_store::memory::InMemory;
+        use test_utils::{actions_to_string, add_commit, TestAction};
+        use url::Url;
+
+        let storage = Arc::new(InMemory::new());
+        add_commit(
+            storage.as_ref(),
+            0,
+            actions_to_string(vec![
+                TestAction::Metadata,
+                TestAction::Add("a.parquet".into()),
+                TestAction::Add("b.parquet".into()),
+            ]),
+        )
+        .await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root).build(&engine)?;
+        let scan = snapshot.scan_builder().build()?;
+
+        let mut num_files = 0;
+        for scan_metadata in scan.scan_metadata(&engine)? {
+            let stats =
+                super::scan_metadata_stats_impl(&scan_metadata?, &scan, &engine, Ok(vec!["id"]))?;
+            let stat = |name: &str| stats.column_by_name(name).unwrap().as_struct();
+            let num_records = stats.column_by_name("numRecords").unwrap();
+            let null_count = stat("nullCount").column_by_name("id").unwrap();
+            let min = stat("minValues").column_by_name("id").unwrap();
+            let max = stat("maxValues").column_by_name("id").unwrap();
+            assert!(stat("minValues").column_by_name("val").is_none());
+            for i in 0..stats.len() {
+                assert_eq!(num_records.as_primitive::<Int64Type>().value(i), 2);
+                assert_eq!(null_count.as_primitive::<Int64Type>().value(i), 0);
+                assert_eq!(min.as_primitive::<Int32Type>().value(i), 1);
+                assert_eq!(max.as_primitive::<Int32Type>().value(i), 3);
+            }
+            num_files += stats.len();
+        }
+        assert_eq!(num_files, 2);
+        Ok(())
+    }
 }
@@ -3,7 +3,17 @@ use std::os::raw::c_void;
 use crate::handle::Handle;
 use crate::scan::CStringMap;
 use crate::{kernel_string_slice, KernelStringSlice, SharedSchema};
+#[cfg(feature = "default-engine-base")]
+use crate::{ExternResult, IntoExternResult, SharedExternEngine};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::array::ffi::FFI_ArrowSchema;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::datatypes::Schema as ArrowSchema;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine::arrow_conversion::TryFromKernel as _;
 use delta_kernel::schema::{ArrayType, DataType, MapType, PrimitiveType, StructType};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::DeltaResult;
 
 /// The `EngineSchemaVisitor` defines a visitor system to allow engines to build their own
 /// representation of a schema from a particular schema within kernel.
@@ -333,3 +343,96 @@ fn visit_schema_impl(schema: &StructType, visitor: &mut EngineSchemaVisitor) ->
 
     visit_struct_fields(visitor, schema)
 }
+
+/// Export the given `schema` through the arrow [C Data
+/// Interface](https://arrow.apache.org/docs/format/CDataInterface.html), as a struct schema whose
+/// children are the top level columns. Field metadata (including the column mapping id and physical
+/// name of each field) is exported as arrow field metadata, with non-string values encoded as
+/// JSON. This works for any schema handle, e.g. those returned by [`crate::logical_schema`],
+/// [`crate::scan::scan_logical_schema`] and [`crate::scan::scan_physical_schema`], and is a cheaper
+/// alternative to [`visit_schema`] for engines that use arrow.
+///
+/// If this function returns an `Ok` variant the _engine_ must release the schema and free the
+/// returned struct.
+///
+/// # Safety
+///
+/// Caller is responsible for passing valid schema and engine handles.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn schema_as_arrow(
+    schema: Handle<SharedSchema>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<*mut FFI_ArrowSchema> {
+    let schema = unsafe { schema.as_ref() };
+    schema_as_arrow_impl(schema).into_extern_result(&engine.as_ref())
+}
+
+#[cfg(feature = "default-engine-base")]
+fn schema_as_arrow_impl(schema: &StructType) -> DeltaResult<*mut FFI_ArrowSchema> {
+    let arrow_schema = ArrowSchema::try_from_kernel(schema)?;
+    let ffi_schema = Box::new(FFI_ArrowSchema::try_from(&arrow_schema)?);
+    Ok(Box::leak(ffi_schema))
+}
+
+#[cfg(all(test, feature = "default-engine-base"))]
+mod tests {
+    use super::*;
+    use crate::ffi_test_utils::ok_or_panic;
+    use crate::{free_engine, tests::get_default_engine};
+    use delta_kernel::arrow::datatypes::{DataType as ArrowDataType, Field as ArrowField};
+    use delta_kernel::schema::{ColumnMetadataKey, MetadataValue, StructField};
+    use std::sync::Arc;
+
+    #[test]
+    fn schema_as_arrow_keeps_field_metadata() {
+        let engine = get_default_engine("memory:///doesntmatter/foo");
+        let field = |name: &str, data_type, id: i64| {
+            StructField::nullable(name, data_type).with_metadata([
+                (
+                    ColumnMetadataKey::ColumnMappingId.as_ref(),
+                    MetadataValue::Number(id),
+                ),
+                (
+                    ColumnMetadataKey::ColumnMappingPhysicalName.as_ref(),
+                    MetadataValue::String(format!("col-{id}")),
+                ),
+            ])
+        };
+        let nested = StructType::try_new([field("b", DataType::LONG, 2)]).unwrap();
+        let schema = Arc::new(
+            StructType::try_new([field("a", DataType::Struct(Box::new(nested)), 1)]).unwrap(),
+        );
+        let schema: Handle<SharedSchema> = schema.into();
+
+        let ffi_schema = unsafe {
+            ok_or_panic(schema_as_arrow(
+                schema.shallow_copy(),
+                engine.shallow_copy(),
+            ))
+        };
+        let ffi_schema = unsafe { Box::from_raw(ffi_schema) };
+        let arrow_schema = ArrowSchema::try_from(ffi_schema.as_ref()).unwrap();
+
+        let with_metadata = |field: ArrowField, id: i64| {
+            field.with_metadata(
+                [
+                    ("delta.columnMapping.id".to_string(), id.to_string()),
+                    (
+                        "delta.columnMapping.physicalName".to_string(),
+                        format!("col-{id}"),
+                    ),
+                ]
+                .into(),
+            )
+        };
+        let b = with_metadata(ArrowField::new("b", ArrowDataType::Int64, true), 2);
+        let a = ArrowField::new_struct("a", vec![b], true);
+        assert_eq!(arrow_schema, ArrowSchema::new(vec![with_metadata(a, 1)]));
+
+        unsafe {
+            schema.drop_handle();
+            free_engine(engine);
+        }
+    }
+}
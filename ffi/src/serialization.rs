@@ -0,0 +1,786 @@
+//! Compact serialization of scan state and scan file batches.
+//!
+//! This supports engines that plan a scan in one process (the "coordinator") and read its files in
+//! others (the "workers"). The coordinator serializes the state of the scan once with
+//! [`serialize_scan_state`], and each [`ScanFileBatch`] it wants to hand out with
+//! [`serialize_scan_file_batch`]. A worker deserializes both and has everything it needs to read
+//! its files: the table root and read schemas, plus per file the path, deletion vector and
+//! transform. In particular, the worker never builds a snapshot or reads the `_delta_log`.
+//!
+//! The encoding is a private little endian binary format. It is only meant to be read back by the
+//! same version of kernel that wrote it, and deserialization rejects data with a different format
+//! version.
+
+use std::collections::HashMap;
+use std::sync::Arc;
+
+use delta_kernel::actions::deletion_vector::DeletionVectorDescriptor;
+use delta_kernel::expressions::{ColumnName, FieldTransform, Scalar, Transform};
+use delta_kernel::scan::state::DvInfo;
+use delta_kernel::scan::Scan;
+use delta_kernel::schema::{SchemaRef, StructType};
+use delta_kernel::{DeltaResult, Error, Expression};
+use delta_kernel_ffi_macros::handle_descriptor;
+use url::Url;
+
+use crate::handle::Handle;
+use crate::scan::{ScanFileBatch, SharedScan, SharedScanFileBatch};
+use crate::{
+    kernel_string_slice, AllocateStringFn, ExternResult, IntoExternResult, NullableCvoid,
+    SharedExternEngine, SharedSchema,
+};
+
+const SCAN_STATE_MAGIC: &[u8; 4] = b"DKSS";
+const SCAN_FILE_BATCH_MAGIC: &[u8; 4] = b"DKFB";
+const FORMAT_VERSION: u8 = 1;
+/// How deeply serialized expressions may nest. Kernel's transforms are only a few levels deep
+const MAX_EXPRESSION_DEPTH: usize = 64;
+
+/// A callback the kernel uses to hand serialized bytes to the engine. The bytes are only valid for
+/// the duration of the call, so the engine must copy them if it needs them afterwards.
+pub type VisitBytesFn = extern "C" fn(engine_context: NullableCvoid, bytes: *const u8, len: usize);
+
+/// The state a worker needs to read the files of a scan, without the snapshot the scan was built
+/// from. See [`deserialize_scan_state`].
+pub struct ScanState {
+    table_root: Url,
+    logical_schema: SchemaRef,
+    physical_schema: SchemaRef,
+}
+
+#[handle_descriptor(target=ScanState, mutable=false, sized=true)]
+pub struct SharedScanState;
+
+/// Serialize the state of `scan` that is needed to read its files: the table root and the logical
+/// and physical schemas. The predicate of the scan is not included, since it only matters while
+/// planning. The serialized bytes are passed to `visitor` along with `engine_context`.
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScan` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn serialize_scan_state(
+    scan: Handle<SharedScan>,
+    engine: Handle<SharedExternEngine>,
+    engine_context: NullableCvoid,
+    visitor: VisitBytesFn,
+) -> ExternResult<bool> {
+    let scan = unsafe { scan.as_ref() };
+    serialize_scan_state_impl(scan)
+        .map(|bytes| {
+            visitor(engine_context, bytes.as_ptr(), bytes.len());
+            true
+        })
+        .into_extern_result(&engine.as_ref())
+}
+
+fn serialize_scan_state_impl(scan: &Scan) -> DeltaResult<Vec<u8>> {
+    let mut writer = Writer::new(SCAN_STATE_MAGIC);
+    writer.str(scan.table_root().as_str());
+    writer.json("schema", scan.logical_schema().as_ref())?;
+    writer.json("schema", scan.physical_schema().as_ref())?;
+    Ok(writer.finish())
+}
+
+/// Deserialize a scan state serialized by [`serialize_scan_state`]. It is the responsibility of the
+/// _engine_ to free the returned state by calling [`free_scan_state`].
+///
+/// # Safety
+/// Engine is responsible for passing a valid engine handle, and `bytes` must point to `len` valid
+/// bytes.
+#[no_mangle]
+pub unsafe extern "C" fn deserialize_scan_state(
+    bytes: *const u8,
+    len: usize,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<SharedScanState>> {
+    let bytes = unsafe { bytes_from_raw(bytes, len) };
+    deserialize_scan_state_impl(bytes)
+        .map(|state| Arc::new(state).into())
+        .into_extern_result(&engine.as_ref())
+}
+
+fn deserialize_scan_state_impl(bytes: &[u8]) -> DeltaResult<ScanState> {
+    let mut reader = Reader::new(bytes, SCAN_STATE_MAGIC)?;
+    let table_root = Url::parse(reader.str()?)?;
+    let logical_schema: StructType = reader.json("schema")?;
+    let physical_schema: StructType = reader.json("schema")?;
+    reader.finish()?;
+    Ok(ScanState {
+        table_root,
+        logical_schema: logical_schema.into(),
+        physical_schema: physical_schema.into(),
+    })
+}
+
+/// Get the table root of a deserialized scan state, as with [`crate::scan::scan_table_root`].
+///
+/// # Safety
+/// Engine is responsible for providing a valid `SharedScanState` handle
+#[no_mangle]
+pub unsafe extern "C" fn scan_state_table_root(
+    state: Handle<SharedScanState>,
+    allocate_fn: AllocateStringFn,
+) -> NullableCvoid {
+    let state = unsafe { state.as_ref() };
+    let table_root = state.table_root.as_str();
+    allocate_fn(kernel_string_slice!(table_root))
+}
+
+/// Get the logical schema of a deserialized scan state, as with
+/// [`crate::scan::scan_logical_schema`].
+///
+/// # Safety
+/// Engine is responsible for providing a valid `SharedScanState` handle
+#[no_mangle]
+pub unsafe extern "C" fn scan_state_logical_schema(
+    state: Handle<SharedScanState>,
+) -> Handle<SharedSchema> {
+    let state = unsafe { state.as_ref() };
+    state.logical_schema.clone().into()
+}
+
+/// Get the physical schema of a deserialized scan state, as with
+/// [`crate::scan::scan_physical_schema`].
+///
+/// # Safety
+/// Engine is responsible for providing a valid `SharedScanState` handle
+#[no_mangle]
+pub unsafe extern "C" fn scan_state_physical_schema(
+    state: Handle<SharedScanState>,
+) -> Handle<SharedSchema> {
+    let state = unsafe { state.as_ref() };
+    state.physical_schema.clone().into()
+}
+
+/// Free a [`ScanState`].
+///
+/// # Safety
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_scan_state(state: Handle<SharedScanState>) {
+    state.drop_handle();
+}
+
+/// Serialize a [`ScanFileBatch`], including the deletion vector descriptors, transforms and
+/// partition values of its files. The serialized bytes are passed to `visitor` along with
+/// `engine_context`. This fails if a transform contains an expression kernel doesn't produce for
+/// scans, such as an opaque expression.
+///
+/// # Safety
+/// Engine is responsible for passing valid `SharedScanFileBatch` and engine handles.
+#[no_mangle]
+pub unsafe extern "C" fn serialize_scan_file_batch(
+    batch: Handle<SharedScanFileBatch>,
+    engine: Handle<SharedExternEngine>,
+    engine_context: NullableCvoid,
+    visitor: VisitBytesFn,
+) -> ExternResult<bool> {
+    let batch = unsafe { batch.as_ref() };
+    serialize_scan_file_batch_impl(batch)
+        .map(|bytes| {
+            visitor(engine_context, bytes.as_ptr(), bytes.len());
+            true
+        })
+        .into_extern_result(&engine.as_ref())
+}
+
+fn serialize_scan_file_batch_impl(batch: &ScanFileBatch) -> DeltaResult<Vec<u8>> {
+    let mut writer = Writer::new(SCAN_FILE_BATCH_MAGIC);
+    writer.len(batch.paths.len());
+    let files = batch.paths.iter().zip(&batch.sizes).zip(&batch.num_records);
+    let files = files.zip(&batch.dv_indexes).zip(&batch.transform_ids);
+    for ((((path, size), num_records), dv_index), transform_id) in files {
+        writer.str(path);
+        writer.i64(*size);
+        writer.option(*num_records, Writer::u64);
+        writer.option(*dv_index, Writer::u32);
+        writer.option(*transform_id, Writer::u32);
+    }
+    writer.len(batch.dv_infos.len());
+    for dv_info in &batch.dv_infos {
+        let dv = dv_info
+            .deletion_vector()
+            .ok_or_else(|| Error::internal_error("Scan file batch has an empty deletion vector"))?;
+        writer.str(&dv.storage_type);
+        writer.str(&dv.path_or_inline_dv);
+        writer.option(dv.offset, Writer::i32);
+        writer.i32(dv.size_in_bytes);
+        writer.i64(dv.cardinality);
+    }
+    writer.len(batch.transforms.len());
+    for transform in &batch.transforms {
+        writer.expression(transform)?;
+    }
+    writer.json("partition fields", &batch.partition_fields)?;
+    for values in &batch.partition_values {
+        for value in values {
+            writer.scalar(value)?;
+        }
+    }
+    Ok(writer.finish())
+}
+
+/// Deserialize a scan file batch serialized by [`serialize_scan_file_batch`]. The returned batch
+/// supports all the same functions as one returned by [`crate::scan::scan_file_batch`]. It is the
+/// responsibility of the _engine_ to free the returned batch by calling
+/// [`crate::scan::free_scan_file_batch`].
+///
+/// # Safety
+/// Engine is responsible for passing a valid engine handle, and `bytes` must point to `len` valid
+/// bytes.
+#[no_mangle]
+pub unsafe extern "C" fn deserialize_scan_file_batch(
+    bytes: *const u8,
+    len: usize,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<Handle<SharedScanFileBatch>> {
+    let bytes = unsafe { bytes_from_raw(bytes, len) };
+    deserialize_scan_file_batch_impl(bytes)
+        .map(|batch| Arc::new(batch).into())
+        .into_extern_result(&engine.as_ref())
+}
+
+fn deserialize_scan_file_batch_impl(bytes: &[u8]) -> DeltaResult<ScanFileBatch> {
+    let mut reader = Reader::new(bytes, SCAN_FILE_BATCH_MAGIC)?;
+    let num_files = reader.len()?;
+    let mut batch = ScanFileBatch {
+        paths: Vec::with_capacity(num_files),
+        sizes: Vec::with_capacity(num_files),
+        num_records: Vec::with_capacity(num_files),
+        dv_indexes: Vec::with_capacity(num_files),
+        transform_ids: Vec::with_capacity(num_files),
+        dv_infos: vec![],
+        transforms: vec![],
+        partition_fields: vec![],
+        partition_values: vec![],
+    };
+    for _ in 0..num_files {
+        batch.paths.push(reader.str()?.to_string());
+        batch.sizes.push(reader.i64()?);
+        batch.num_records.push(reader.option(Reader::u64)?);
+        batch.dv_indexes.push(reader.option(Reader::u32)?);
+        batch.transform_ids.push(reader.option(Reader::u32)?);
+    }
+    for _ in 0..reader.len()? {
+        let dv = DeletionVectorDescriptor {
+            storage_type: reader.str()?.to_string(),
+            path_or_inline_dv: reader.str()?.to_string(),
+            offset: reader.option(Reader::i32)?,
+            size_in_bytes: reader.i32()?,
+            cardinality: reader.i64()?,
+        };
+        batch.dv_infos.push(DvInfo::from(dv));
+    }
+    for _ in 0..reader.len()? {
+        batch.transforms.push(Arc::new(reader.expression(0)?));
+    }
+    batch.partition_fields = reader.json("partition fields")?;
+    batch.partition_values = (0..batch.partition_fields.len())
+        .map(|_| {
+            (0..num_files)
+                .map(|_| reader.scalar())
+                .collect::<DeltaResult<_>>()
+        })
+        .collect::<DeltaResult<_>>()?;
+    reader.finish()?;
+
+    // the accessors index into these without checking, so make sure they are consistent
+    let dv_index_ok =
+        |index: &Option<u32>| index.is_none_or(|i| (i as usize) < batch.dv_infos.len());
+    let transform_id_ok =
+        |id: &Option<u32>| id.is_none_or(|id| (id as usize) < batch.transforms.len());
+    if !batch.dv_indexes.iter().all(dv_index_ok) || !batch.transform_ids.iter().all(transform_id_ok)
+    {
+        return Err(Error::generic("Invalid serialized scan file batch"));
+    }
+    Ok(batch)
+}
+
+/// # Safety
+/// `bytes` must point to `len` valid bytes, or be NULL if `len` is 0.
+unsafe fn bytes_from_raw<'a>(bytes: *const u8, len: usize) -> &'a [u8] {
+    if len == 0 {
+        &[]
+    } else {
+        unsafe { std::slice::from_raw_parts(bytes, len) }
+    }
+}
+
+// Tags of the expressions and scalars we know how to serialize. Scan transforms only ever contain
+// columns, primitive literals and (nested) structs or transforms of those.
+mod tag {
+    pub(super) const LITERAL: u8 = 0;
+    pub(super) const COLUMN: u8 = 1;
+    pub(super) const STRUCT: u8 = 2;
+    pub(super) const TRANSFORM: u8 = 3;
+
+    pub(super) const INTEGER: u8 = 0;
+    pub(super) const LONG: u8 = 1;
+    pub(super) const SHORT: u8 = 2;
+    pub(super) const BYTE: u8 = 3;
+    pub(super) const FLOAT: u8 = 4;
+    pub(super) const DOUBLE: u8 = 5;
+    pub(super) const STRING: u8 = 6;
+    pub(super) const BOOLEAN: u8 = 7;
+    pub(super) const TIMESTAMP: u8 = 8;
+    pub(super) const TIMESTAMP_NTZ: u8 = 9;
+    pub(super) const DATE: u8 = 10;
+    pub(super) const BINARY: u8 = 11;
+    pub(super) const DECIMAL: u8 = 12;
+    pub(super) const NULL: u8 = 13;
+}
+
+struct Writer {
+    buf: Vec<u8>,
+}
+
+impl Writer {
+    fn new(magic: &[u8; 4]) -> Self {
+        let mut buf = magic.to_vec();
+        buf.push(FORMAT_VERSION);
+        Self { buf }
+    }
+
+    fn finish(self) -> Vec<u8> {
+        self.buf
+    }
+
+    fn u8(&mut self, value: u8) {
+        self.buf.push(value);
+    }
+
+    fn u32(&mut self, value: u32) {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn i32(&mut self, value: i32) {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn u64(&mut self, value: u64) {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn i64(&mut self, value: i64) {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn len(&mut self, len: usize) {
+        self.u64(len as u64);
+    }
+
+    fn bytes(&mut self, bytes: &[u8]) {
+        self.len(bytes.len());
+        self.buf.extend_from_slice(bytes);
+    }
+
+    fn str(&mut self, value: &str) {
+        self.bytes(value.as_bytes());
+    }
+
+    fn option<T>(&mut self, value: Option<T>, write: impl FnOnce(&mut Self, T)) {
+        match value {
+            Some(value) => {
+                self.u8(1);
+                write(self, value);
+            }
+            None => self.u8(0),
+        }
+    }
+
+    // Schemas and data types are rare (once per batch at most) and already have a stable JSON
+    // form in the delta protocol, so they are written as JSON rather than re-encoded
+    fn json<T: serde::Serialize + ?Sized>(&mut self, what: &str, value: &T) -> DeltaResult<()> {
+        let json = serde_json::to_string(value)
+            .map_err(|err| Error::generic(format!("Failed to serialize {what}: {err}")))?;
+        self.str(&json);
+        Ok(())
+    }
+
+    fn expressions<'a>(
+        &mut self,
+        exprs: impl ExactSizeIterator<Item = &'a Expression>,
+    ) -> DeltaResult<()> {
+        self.len(exprs.len());
+        exprs.map(|expr| self.expression(expr)).collect()
+    }
+
+    fn expression(&mut self, expr: &Expression) -> DeltaResult<()> {
+        match expr {
+            Expression::Literal(scalar) => {
+                self.u8(tag::LITERAL);
+                self.scalar(scalar)?;
+            }
+            Expression::Column(name) => {
+                self.u8(tag::COLUMN);
+                self.column_name(name);
+            }
+            Expression::Struct(fields) => {
+                self.u8(tag::STRUCT);
+                self.expressions(fields.iter().map(AsRef::as_ref))?;
+            }
+            Expression::Transform(transform) => {
+                self.u8(tag::TRANSFORM);
+                self.option(transform.input_path.as_ref(), Self::column_name);
+                self.expressions(transform.prepended_fields.iter().map(AsRef::as_ref))?;
+                self.len(transform.field_transforms.len());
+                for (name, field_transform) in &transform.field_transforms {
+                    self.str(name);
+                    self.u8(field_transform.is_replace as u8);
+                    self.expressions(field_transform.exprs.iter().map(AsRef::as_ref))?;
+                }
+            }
+            _ => {
+                return Err(Error::generic(format!(
+                    "Cannot serialize transform expression {expr}"
+                )))
+            }
+        }
+        Ok(())
+    }
+
+    fn column_name(&mut self, name: &ColumnName) {
+        self.len(name.path().len());
+        for field in name.path() {
+            self.str(field);
+        }
+    }
+
+    fn scalar(&mut self, scalar: &Scalar) -> DeltaResult<()> {
+        match scalar {
+            Scalar::Integer(v) => {
+                self.u8(tag::INTEGER);
+                self.i32(*v);
+            }
+            Scalar::Long(v) => {
+                self.u8(tag::LONG);
+                self.i64(*v);
+            }
+            Scalar::Short(v) => {
+                self.u8(tag::SHORT);
+                self.i32(*v as i32);
+            }
+            Scalar::Byte(v) => {
+                self.u8(tag::BYTE);
+                self.i32(*v as i32);
+            }
+            Scalar::Float(v) => {
+                self.u8(tag::FLOAT);
+                self.u32(v.to_bits());
+            }
+            Scalar::Double(v) => {
+                self.u8(tag::DOUBLE);
+                self.u64(v.to_bits());
+            }
+            Scalar::String(v) => {
+                self.u8(tag::STRING);
+                self.str(v);
+            }
+            Scalar::Boolean(v) => {
+                self.u8(tag::BOOLEAN);
+                self.u8(*v as u8);
+            }
+            Scalar::Timestamp(v) => {
+                self.u8(tag::TIMESTAMP);
+                self.i64(*v);
+            }
+            Scalar::TimestampNtz(v) => {
+                self.u8(tag::TIMESTAMP_NTZ);
+                self.i64(*v);
+            }
+            Scalar::Date(v) => {
+                self.u8(tag::DATE);
+                self.i32(*v);
+            }
+            Scalar::Binary(v) => {
+                self.u8(tag::BINARY);
+                self.bytes(v);
+            }
+            Scalar::Decimal(v) => {
+                self.u8(tag::DECIMAL);
+                self.buf.extend_from_slice(&v.bits().to_le_bytes());
+                self.u8(v.precision());
+                self.u8(v.scale());
+            }
+            Scalar::Null(data_type) => {
+                self.u8(tag::NULL);
+                self.json("data type", data_type)?;
+            }
+            Scalar::Struct(_) | Scalar::Array(_) | Scalar::Map(_) => {
+                return Err(Error::generic(format!(
+                    "Cannot serialize nested literal {scalar}"
+                )))
+            }
+        }
+        Ok(())
+    }
+}
+
+struct Reader<'a> {
+    bytes: &'a [u8],
+}
+
+impl<'a> Reader<'a> {
+    fn new(bytes: &'a [u8], magic: &[u8; 4]) -> DeltaResult<Self> {
+        let mut reader = Self { bytes };
+        if reader.take(magic.len())? != magic {
+            return Err(Error::generic(
+                "Not a serialized scan state or scan file batch",
+            ));
+        }
+        let version = reader.u8()?;
+        if version != FORMAT_VERSION {
+            return Err(Error::generic(format!(
+                "Unsupported serialization format version {version}, expected {FORMAT_VERSION}"
+            )));
+        }
+        Ok(reader)
+    }
+
+    fn finish(self) -> DeltaResult<()> {
+        match self.bytes.len() {
+            0 => Ok(()),
+            n => Err(Error::generic(format!(
+                "{n} unexpected trailing bytes in serialized data"
+            ))),
+        }
+    }
+
+    fn take(&mut self, len: usize) -> DeltaResult<&'a [u8]> {
+        if len > self.bytes.len() {
+            return Err(Error::generic("Serialized data is truncated"));
+        }
+        let (taken, rest) = self.bytes.split_at(len);
+        self.bytes = rest;
+        Ok(taken)
+    }
+
+    fn array<const N: usize>(&mut self) -> DeltaResult<[u8; N]> {
+        Ok(self.take(N)?.try_into().expect("took exactly N bytes"))
+    }
+
+    fn u8(&mut self) -> DeltaResult<u8> {
+        Ok(self.array::<1>()?[0])
+    }
+
+    fn u32(&mut self) -> DeltaResult<u32> {
+        self.array().map(u32::from_le_bytes)
+    }
+
+    fn i32(&mut self) -> DeltaResult<i32> {
+        self.array().map(i32::from_le_bytes)
+    }
+
+    fn u64(&mut self) -> DeltaResult<u64> {
+        self.array().map(u64::from_le_bytes)
+    }
+
+    fn i64(&mut self) -> DeltaResult<i64> {
+        self.array().map(i64::from_le_bytes)
+    }
+
+    fn len(&mut self) -> DeltaResult<usize> {
+        let len = self.u64()?;
+        // every serialized item takes at least one byte, so this also rejects absurd lengths
+        // before anything is allocated for them
+        match usize::try_from(len) {
+            Ok(len) if len <= self.bytes.len() => Ok(len),
+            _ => Err(Error::generic("Serialized data is truncated")),
+        }
+    }
+
+    fn bytes(&mut self) -> DeltaResult<&'a [u8]> {
+        let len = self.len()?;
+        self.take(len)
+    }
+
+    fn str(&mut self) -> DeltaResult<&'a str> {
+        std::str::from_utf8(self.bytes()?)
+            .map_err(|err| Error::generic(format!("Invalid string in serialized data: {err}")))
+    }
+
+    fn bool(&mut self) -> DeltaResult<bool> {
+        match self.u8()? {
+            0 => Ok(false),
+            1 => Ok(true),
+            other => Err(Error::generic(format!(
+                "Invalid boolean in serialized data: {other}"
+            ))),
+        }
+    }
+
+    fn option<T>(
+        &mut self,
+        read: impl FnOnce(&mut Self) -> DeltaResult<T>,
+    ) -> DeltaResult<Option<T>> {
+        self.bool()?.then(|| read(self)).transpose()
+    }
+
+    fn json<T: serde::de::DeserializeOwned>(&mut self, what: &str) -> DeltaResult<T> {
+        serde_json::from_str(self.str()?)
+            .map_err(|err| Error::generic(format!("Failed to deserialize {what}: {err}")))
+    }
+
+    fn expressions(&mut self, depth: usize) -> DeltaResult<Vec<Arc<Expression>>> {
+        (0..self.len()?)
+            .map(|_| self.expression(depth).map(Arc::new))
+            .collect()
+    }
+
+    /// Read an expression nested `depth` levels deep. Nesting is bounded so that malformed (or
+    /// malicious) data can't overflow the stack
+    fn expression(&mut self, depth: usize) -> DeltaResult<Expression> {
+        if depth >= MAX_EXPRESSION_DEPTH {
+            return Err(Error::generic(format!(
+                "Serialized expression is nested more than {MAX_EXPRESSION_DEPTH} levels deep"
+            )));
+        }
+        let expr = match self.u8()? {
+            tag::LITERAL => Expression::Literal(self.scalar()?),
+            tag::COLUMN => Expression::Column(self.column_name()?),
+            tag::STRUCT => Expression::Struct(self.expressions(depth + 1)?),
+            tag::TRANSFORM => {
+                let input_path = self.option(Self::column_name)?;
+                let prepended_fields = self.expressions(depth + 1)?;
+                let field_transforms = (0..self.len()?)
+                    .map(|_| {
+                        let name = self.str()?.to_string();
+                        let is_replace = self.bool()?;
+                        let exprs = self.expressions(depth + 1)?;
+                        Ok((name, FieldTransform { exprs, is_replace }))
+                    })
+                    .collect::<DeltaResult<HashMap<_, _>>>()?;
+                Expression::Transform(Transform {
+                    input_path,
+                    field_transforms,
+                    prepended_fields,
+                })
+            }
+            other => {
+                return Err(Error::generic(format!(
+                    "Invalid expression tag in serialized data: {other}"
+                )))
+            }
+        };
+        Ok(expr)
+    }
+
+    fn column_name(&mut self) -> DeltaResult<ColumnName> {
+        let path: Vec<_> = (0..self.len()?)
+            .map(|_| self.str().map(str::to_string))
+            .collect::<DeltaResult<_>>()?;
+        Ok(ColumnName::new(path))
+    }
+
+    fn scalar(&mut self) -> DeltaResult<Scalar> {
+        let scalar = match self.u8()? {
+            tag::INTEGER => Scalar::Integer(self.i32()?),
+            tag::LONG => Scalar::Long(self.i64()?),
+            tag::SHORT => Scalar::Short(self.i32()? as i16),
+            tag::BYTE => Scalar::Byte(self.i32()? as i8),
+            tag::FLOAT => Scalar::Float(f32::from_bits(self.u32()?)),
+            tag::DOUBLE => Scalar::Double(f64::from_bits(self.u64()?)),
+            tag::STRING => Scalar::String(self.str()?.to_string()),
+            tag::BOOLEAN => Scalar::Boolean(self.bool()?),
+            tag::TIMESTAMP => Scalar::Timestamp(self.i64()?),
+            tag::TIMESTAMP_NTZ => Scalar::TimestampNtz(self.i64()?),
+            tag::DATE => Scalar::Date(self.i32()?),
+            tag::BINARY => Scalar::Binary(self.bytes()?.to_vec()),
+            tag::DECIMAL => {
+                let bits = i128::from_le_bytes(self.array()?);
+                Scalar::decimal(bits, self.u8()?, self.u8()?)?
+            }
+            tag::NULL => Scalar::Null(self.json("data type")?),
+            other => {
+                return Err(Error::generic(format!(
+                    "Invalid literal tag in serialized data: {other}"
+                )))
+            }
+        };
+        Ok(scalar)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::sync::Arc;
+
+    use delta_kernel::engine::default::executor::tokio::TokioBackgroundExecutor;
+    use delta_kernel::engine::default::DefaultEngine;
+    use delta_kernel::Snapshot;
+    use object_store::memory::InMemory;
+    use test_utils::{add_commit, METADATA_WITH_PARTITION_COLS};
+    use url::Url;
+
+    use super::*;
+
+    #[tokio::test]
+    async fn scan_state_and_file_batches_round_trip() -> Result<(), Box<dyn std::error::Error>> {
+        let add = |path: &str, partition_values: &str, extra: &str| {
+            format!(
+                r#"{{"add":{{"path":"{path}","partitionValues":{partition_values},"size":262,"modificationTime":1587968586000,"dataChange":true{extra}}}}}"#
+            )
+        };
+        let dv = r#","deletionVector":{"storageType":"u","pathOrInlineDv":"vBn[lx{q8@P<9BNH/isA","offset":1,"sizeInBytes":36,"cardinality":2}"#;
+        let commit = [
+            METADATA_WITH_PARTITION_COLS.to_string(),
+            add("val=a/a.parquet", r#"{"val":"a"}"#, dv),
+            add("b.parquet", "{}", r#","stats":"{\"numRecords\":3}""#),
+        ]
+        .join("\n");
+        let storage = Arc::new(InMemory::new());
+        add_commit(storage.as_ref(), 0, commit).await?;
+        let engine = DefaultEngine::new(storage.clone(), Arc::new(TokioBackgroundExecutor::new()));
+        let table_root = Url::parse("memory:///")?;
+        let snapshot = Snapshot::builder_for(table_root.clone()).build(&engine)?;
+        let scan = snapshot.scan_builder().build()?;
+
+        let state = deserialize_scan_state_impl(&serialize_scan_state_impl(&scan)?)?;
+        assert_eq!(state.table_root, table_root);
+        assert_eq!(state.logical_schema, *scan.logical_schema());
+        assert_eq!(state.physical_schema, *scan.physical_schema());
+
+        let mut num_files = 0;
+        for scan_metadata in scan.scan_metadata(&engine)? {
+            let handle = crate::scan::scan_file_batch_impl(&scan_metadata?, &scan)?;
+            let batch = unsafe { handle.as_ref() };
+            let bytes = serialize_scan_file_batch_impl(batch)?;
+            let deserialized = deserialize_scan_file_batch_impl(&bytes)?;
+            assert_eq!(&deserialized, batch);
+            assert!(!deserialized.dv_infos.is_empty());
+            assert!(!deserialized.transforms.is_empty());
+            num_files += deserialized.paths.len();
+
+            // anything but the exact bytes is rejected
+            assert!(deserialize_scan_file_batch_impl(&bytes[..bytes.len() - 1]).is_err());
+            assert!(deserialize_scan_state_impl(&bytes).is_err());
+            unsafe { crate::scan::free_scan_file_batch(handle) };
+        }
+        assert_eq!(num_files, 2);
+        Ok(())
+    }
+
+    #[test]
+    fn deeply_nested_expressions_are_rejected() {
+        // `depth` structs, each holding the next, around a column
+        let nested = |depth: usize| {
+            let mut bytes = vec![];
+            for _ in 0..depth {
+                bytes.push(tag::STRUCT);
+                bytes.extend_from_slice(&1u64.to_le_bytes());
+            }
+            bytes.push(tag::COLUMN);
+            bytes.extend_from_slice(&0u64.to_le_bytes());
+            bytes
+        };
+        let bytes = nested(MAX_EXPRESSION_DEPTH - 1);
+        let mut reader = Reader { bytes: &bytes };
+        assert!(reader.expression(0).is_ok());
+        reader.finish().unwrap();
+
+        let bytes = nested(100_000);
+        let mut reader = Reader { bytes: &bytes };
+        let err = reader.expression(0).unwrap_err();
+        assert!(err.to_string().contains("nested more than"), "{err}");
+    }
+}
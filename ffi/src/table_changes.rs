@@ -0,0 +1,604 @@
+//! Change data feed related ffi code
+//!
+//! Reading the changes a range of commits made to a table mirrors reading a snapshot:
+//!
+//! 1. Create a [`TableChanges`] for the range of versions with [`table_changes_from_version`] or
+//!    [`table_changes_between_versions`]
+//! 2. Build a scan over it with [`table_changes_scan`], optionally with a predicate
+//! 3. Iterate the files of the scan with [`table_changes_scan_files_init`] and
+//!    [`table_changes_scan_files_next`]. Every file comes with the schema to read it with, the rows
+//!    of it that belong to the change data feed, and a transform that converts its physical data
+//!    into the logical schema of the scan, filling in the `_change_type`, `_commit_version` and
+//!    `_commit_timestamp` columns.
+
+use std::sync::{Arc, Mutex};
+
+use delta_kernel::table_changes::scan::{TableChangesScan, TableChangesScanFile};
+use delta_kernel::table_changes::TableChanges;
+use delta_kernel::{DeltaResult, Error, Expression, Version};
+use delta_kernel_ffi_macros::handle_descriptor;
+use tracing::debug;
+use url::Url;
+
+use crate::handle::Handle;
+use crate::scan::{visit_engine_predicate, EnginePredicate};
+use crate::{
+    kernel_string_slice, unwrap_and_parse_path_as_url, AllocateStringFn, ExternEngine,
+    ExternResult, IntoExternResult, KernelBoolSlice, KernelStringSlice, NullableCvoid,
+    SharedExternEngine, SharedSchema, TryFromStringSlice,
+};
+
+#[handle_descriptor(target=TableChanges, mutable=false, sized=true)]
+pub struct SharedTableChanges;
+
+#[handle_descriptor(target=TableChangesScan, mutable=false, sized=true)]
+pub struct SharedTableChangesScan;
+
+#[handle_descriptor(target=TableChangesScanFile, mutable=false, sized=true)]
+pub struct SharedTableChangesScanFile;
+
+/// Get the changes made to the specified table by every commit from `start_version` to the latest
+/// version. It is the responsibility of the _engine_ to free the returned handle by calling
+/// [`free_table_changes`].
+///
+/// # Safety
+///
+/// Caller is responsible for passing valid handles and path pointer.
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_from_version(
+    path: KernelStringSlice,
+    engine: Handle<SharedExternEngine>,
+    start_version: Version,
+) -> ExternResult<Handle<SharedTableChanges>> {
+    let url = unsafe { unwrap_and_parse_path_as_url(path) };
+    let engine = unsafe { engine.as_ref() };
+    table_changes_impl(url, engine, start_version, None).into_extern_result(&engine)
+}
+
+/// Get the changes made to the specified table by every commit from `start_version` to
+/// `end_version`, inclusive. It is the responsibility of the _engine_ to free the returned handle
+/// by calling [`free_table_changes`].
+///
+/// # Safety
+///
+/// Caller is responsible for passing valid handles and path pointer.
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_between_versions(
+    path: KernelStringSlice,
+    engine: Handle<SharedExternEngine>,
+    start_version: Version,
+    end_version: Version,
+) -> ExternResult<Handle<SharedTableChanges>> {
+    let url = unsafe { unwrap_and_parse_path_as_url(path) };
+    let engine = unsafe { engine.as_ref() };
+    table_changes_impl(url, engine, start_version, end_version.into()).into_extern_result(&engine)
+}
+
+fn table_changes_impl(
+    url: DeltaResult<Url>,
+    extern_engine: &dyn ExternEngine,
+    start_version: Version,
+    end_version: Option<Version>,
+) -> DeltaResult<Handle<SharedTableChanges>> {
+    let engine = extern_engine.engine();
+    let table_changes = TableChanges::try_new(url?, engine.as_ref(), start_version, end_version)?;
+    Ok(Arc::new(table_changes).into())
+}
+
+/// Drop a `SharedTableChanges`.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_table_changes(table_changes: Handle<SharedTableChanges>) {
+    table_changes.drop_handle();
+}
+
+/// Get the first version of the table changes.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_start_version(
+    table_changes: Handle<SharedTableChanges>,
+) -> Version {
+    let table_changes = unsafe { table_changes.as_ref() };
+    table_changes.start_version()
+}
+
+/// Get the last version of the table changes. If no end version was given, this is the latest
+/// version of the table when the table changes were created.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_end_version(
+    table_changes: Handle<SharedTableChanges>,
+) -> Version {
+    let table_changes = unsafe { table_changes.as_ref() };
+    table_changes.end_version()
+}
+
+/// Get the logical schema of the change data feed: the schema of the table plus the
+/// `_change_type`, `_commit_version` and `_commit_timestamp` columns.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_schema(
+    table_changes: Handle<SharedTableChanges>,
+) -> Handle<SharedSchema> {
+    let table_changes = unsafe { table_changes.as_ref() };
+    Arc::new(table_changes.schema().clone()).into()
+}
+
+/// Get the table root of the table changes.
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle and allocate_fn (for allocating the string)
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_table_root(
+    table_changes: Handle<SharedTableChanges>,
+    allocate_fn: AllocateStringFn,
+) -> NullableCvoid {
+    let table_changes = unsafe { table_changes.as_ref() };
+    let table_root = table_changes.table_root().to_string();
+    allocate_fn(kernel_string_slice!(table_root))
+}
+
+/// Get a [`TableChangesScan`] over the passed table changes. The predicate is applied to the data
+/// of the table, so it must not reference the `_change_type`, `_commit_version` and
+/// `_commit_timestamp` columns. It is the responsibility of the _engine_ to free this scan when
+/// complete by calling [`free_table_changes_scan`].
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid table changes pointer, and engine pointer
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan(
+    table_changes: Handle<SharedTableChanges>,
+    engine: Handle<SharedExternEngine>,
+    predicate: Option<&mut EnginePredicate>,
+) -> ExternResult<Handle<SharedTableChangesScan>> {
+    let table_changes = unsafe { table_changes.clone_as_arc() };
+    table_changes_scan_impl(table_changes, predicate, None).into_extern_result(&engine.as_ref())
+}
+
+/// Get a [`TableChangesScan`] over the passed table changes, which only reads the top-level columns
+/// named in `columns`, in that order. See [`scan_with_columns`] for the arguments, and
+/// [`table_changes_scan`] for the predicate.
+///
+/// [`scan_with_columns`]: crate::scan::scan_with_columns
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid table changes pointer, engine pointer, and `columns`
+/// array
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_with_columns(
+    table_changes: Handle<SharedTableChanges>,
+    engine: Handle<SharedExternEngine>,
+    predicate: Option<&mut EnginePredicate>,
+    columns: *const KernelStringSlice,
+    num_columns: usize,
+) -> ExternResult<Handle<SharedTableChangesScan>> {
+    let table_changes = unsafe { table_changes.clone_as_arc() };
+    let columns = match num_columns {
+        0 => &[],
+        _ => unsafe { std::slice::from_raw_parts(columns, num_columns) },
+    };
+    let columns: DeltaResult<Vec<&str>> = columns
+        .iter()
+        .map(|column| unsafe { TryFromStringSlice::try_from_slice(column) })
+        .collect();
+    table_changes_scan_impl(table_changes, predicate, Some(columns))
+        .into_extern_result(&engine.as_ref())
+}
+
+fn table_changes_scan_impl(
+    table_changes: Arc<TableChanges>,
+    predicate: Option<&mut EnginePredicate>,
+    columns: Option<DeltaResult<Vec<&str>>>,
+) -> DeltaResult<Handle<SharedTableChangesScan>> {
+    let schema = columns
+        .map(|columns| table_changes.schema().project(&columns?))
+        .transpose()?;
+    let mut scan_builder = table_changes.scan_builder().with_schema(schema);
+    if let Some(predicate) = predicate {
+        let predicate = visit_engine_predicate(predicate);
+        debug!("Got predicate: {:#?}", predicate);
+        scan_builder = scan_builder.with_predicate(predicate.map(Arc::new));
+    }
+    Ok(Arc::new(scan_builder.build()?).into())
+}
+
+/// Drops a table changes scan.
+///
+/// # Safety
+/// Caller is responsible for passing a valid scan handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_table_changes_scan(scan: Handle<SharedTableChangesScan>) {
+    scan.drop_handle();
+}
+
+/// Get the logical (i.e. output) schema of a table changes scan.
+///
+/// # Safety
+/// Engine is responsible for providing a valid `SharedTableChangesScan` handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_logical_schema(
+    scan: Handle<SharedTableChangesScan>,
+) -> Handle<SharedSchema> {
+    let scan = unsafe { scan.as_ref() };
+    scan.logical_schema().clone().into()
+}
+
+/// Get the physical schema of a table changes scan. Change data files are read with this schema
+/// plus the `_change_type` column, so engines should read every file with the schema from
+/// [`table_changes_scan_file_physical_schema`] instead.
+///
+/// # Safety
+/// Engine is responsible for providing a valid `SharedTableChangesScan` handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_physical_schema(
+    scan: Handle<SharedTableChangesScan>,
+) -> Handle<SharedSchema> {
+    let scan = unsafe { scan.as_ref() };
+    scan.physical_schema().clone().into()
+}
+
+/// Get the table root of a table changes scan.
+///
+/// # Safety
+/// Engine is responsible for providing a valid scan pointer and allocate_fn (for allocating the
+/// string)
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_table_root(
+    scan: Handle<SharedTableChangesScan>,
+    allocate_fn: AllocateStringFn,
+) -> NullableCvoid {
+    let scan = unsafe { scan.as_ref() };
+    let table_root = scan.table_root().to_string();
+    allocate_fn(kernel_string_slice!(table_root))
+}
+
+// Intentionally opaque to the engine. Like `ScanMetadataIterator`, kernel handles the mutual
+// exclusion.
+pub struct TableChangesScanFileIterator {
+    data: Mutex<Box<dyn Iterator<Item = DeltaResult<TableChangesScanFile>> + Send>>,
+
+    // Also keep a reference to the external engine for its error allocator, and to keep the
+    // engine alive while the iterator reads the log
+    engine: Arc<dyn ExternEngine>,
+}
+
+#[handle_descriptor(target=TableChangesScanFileIterator, mutable=false, sized=true)]
+pub struct SharedTableChangesScanFileIterator;
+
+/// Get an iterator over the files to read for a table changes scan, in commit order. This returns a
+/// [`TableChangesScanFileIterator`] which can be passed to [`table_changes_scan_files_next`] to get
+/// the files.
+///
+/// # Safety
+///
+/// Engine is responsible for passing a valid [`SharedExternEngine`] and [`SharedTableChangesScan`]
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_files_init(
+    engine: Handle<SharedExternEngine>,
+    scan: Handle<SharedTableChangesScan>,
+) -> ExternResult<Handle<SharedTableChangesScanFileIterator>> {
+    let engine = unsafe { engine.clone_as_arc() };
+    let scan = unsafe { scan.as_ref() };
+    table_changes_scan_files_init_impl(&engine, scan).into_extern_result(&engine.as_ref())
+}
+
+fn table_changes_scan_files_init_impl(
+    engine: &Arc<dyn ExternEngine>,
+    scan: &TableChangesScan,
+) -> DeltaResult<Handle<SharedTableChangesScanFileIterator>> {
+    let scan_files = scan.scan_files(engine.engine())?;
+    let data = TableChangesScanFileIterator {
+        data: Mutex::new(Box::new(scan_files)),
+        engine: engine.clone(),
+    };
+    Ok(Arc::new(data).into())
+}
+
+/// Call the provided `engine_visitor` on the next file to read for a table changes scan, and return
+/// true. Return false without calling the visitor if there are no more files. It is the
+/// responsibility of the _engine_ to free the file passed to the visitor by calling
+/// [`free_table_changes_scan_file`].
+///
+/// # Safety
+///
+/// The iterator must be valid (returned by [`table_changes_scan_files_init`]) and not yet freed by
+/// [`free_table_changes_scan_files_iter`]. The visitor function pointer must be non-null.
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_files_next(
+    data: Handle<SharedTableChangesScanFileIterator>,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        scan_file: Handle<SharedTableChangesScanFile>,
+    ),
+) -> ExternResult<bool> {
+    let data = unsafe { data.as_ref() };
+    table_changes_scan_files_next_impl(data, engine_context, engine_visitor)
+        .into_extern_result(&data.engine.as_ref())
+}
+
+fn table_changes_scan_files_next_impl(
+    data: &TableChangesScanFileIterator,
+    engine_context: NullableCvoid,
+    engine_visitor: extern "C" fn(
+        engine_context: NullableCvoid,
+        scan_file: Handle<SharedTableChangesScanFile>,
+    ),
+) -> DeltaResult<bool> {
+    let mut data = data
+        .data
+        .lock()
+        .map_err(|_| Error::generic("poisoned mutex"))?;
+    if let Some(scan_file) = data.next().transpose()? {
+        (engine_visitor)(engine_context, Arc::new(scan_file).into());
+        Ok(true)
+    } else {
+        Ok(false)
+    }
+}
+
+/// Free an iterator over the files of a table changes scan.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_table_changes_scan_files_iter(
+    data: Handle<SharedTableChangesScanFileIterator>,
+) {
+    data.drop_handle();
+}
+
+/// Drop a `SharedTableChangesScanFile`.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle.
+#[no_mangle]
+pub unsafe extern "C" fn free_table_changes_scan_file(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) {
+    scan_file.drop_handle();
+}
+
+/// Get the url of a file to read, which can be passed to [`read_parquet_file`] as is.
+///
+/// [`read_parquet_file`]: crate::engine_funcs::read_parquet_file
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle and allocate_fn (for allocating the string)
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_location(
+    scan_file: Handle<SharedTableChangesScanFile>,
+    allocate_fn: AllocateStringFn,
+) -> NullableCvoid {
+    let scan_file = unsafe { scan_file.as_ref() };
+    let location = scan_file.location.to_string();
+    allocate_fn(kernel_string_slice!(location))
+}
+
+/// Get the version of the commit a file's changes were made in.
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_commit_version(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) -> i64 {
+    let scan_file = unsafe { scan_file.as_ref() };
+    scan_file.commit_version
+}
+
+/// Get the timestamp of the commit a file's changes were made in, in milliseconds since the epoch.
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_commit_timestamp(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) -> i64 {
+    let scan_file = unsafe { scan_file.as_ref() };
+    scan_file.commit_timestamp
+}
+
+/// Get the schema to read a file with. This is the physical schema of the scan, plus the
+/// `_change_type` column for change data files.
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_physical_schema(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) -> Handle<SharedSchema> {
+    let scan_file = unsafe { scan_file.as_ref() };
+    scan_file.physical_schema.clone().into()
+}
+
+/// Get the transform of a file, which _must_ be applied to the data read with the schema from
+/// [`table_changes_scan_file_physical_schema`] to convert it to the logical schema of the scan. The
+/// returned pointer is valid until the file is freed.
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_transform(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) -> *const Expression {
+    let scan_file = unsafe { scan_file.as_ref() };
+    scan_file.transform.as_ref()
+}
+
+/// Get the rows of a file that belong to the change data feed: row `i` does if the returned vector
+/// is true at index `i`. The vector may be shorter than the file, in which case the remaining rows
+/// belong to the change data feed exactly when [`table_changes_scan_file_rows_past_end_selected`]
+/// returns true. It is the responsibility of the _engine_ to free the returned slice by calling
+/// [`free_bool_slice`].
+///
+/// [`free_bool_slice`]: crate::free_bool_slice
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_selection_vector(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) -> KernelBoolSlice {
+    let scan_file = unsafe { scan_file.as_ref() };
+    match &scan_file.selection_vector {
+        Some(selection_vector) => selection_vector.clone().into(),
+        None => KernelBoolSlice::empty(),
+    }
+}
+
+/// Whether the rows of a file past the end of its selection vector (see
+/// [`table_changes_scan_file_selection_vector`]) belong to the change data feed.
+///
+/// # Safety
+/// Engine is responsible for providing a valid handle
+#[no_mangle]
+pub unsafe extern "C" fn table_changes_scan_file_rows_past_end_selected(
+    scan_file: Handle<SharedTableChangesScanFile>,
+) -> bool {
+    let scan_file = unsafe { scan_file.as_ref() };
+    // without a selection vector, every row is selected
+    scan_file.selection_vector.is_none() || scan_file.rows_past_end_selected
+}
+
+#[cfg(all(test, feature = "default-engine-base"))]
+mod tests {
+    use std::ptr::NonNull;
+
+    use delta_kernel::schema::DataType;
+
+    use super::*;
+    use crate::error::KernelError;
+    use crate::ffi_test_utils::{allocate_str, ok_or_panic, recover_error, recover_string};
+    use crate::tests::get_default_engine;
+    use crate::{free_bool_slice, free_engine, free_schema};
+
+    fn table_path() -> String {
+        let path = std::fs::canonicalize("../kernel/tests/data/table-with-cdf/").unwrap();
+        Url::from_directory_path(path).unwrap().to_string()
+    }
+
+    type Files = Vec<(String, i64, Vec<String>)>;
+
+    extern "C" fn collect_file(
+        engine_context: NullableCvoid,
+        scan_file: Handle<SharedTableChangesScanFile>,
+    ) {
+        let files = unsafe { engine_context.unwrap().cast::<Files>().as_mut() };
+        unsafe {
+            let location = table_changes_scan_file_location(scan_file.shallow_copy(), allocate_str);
+            let schema = table_changes_scan_file_physical_schema(scan_file.shallow_copy());
+            let fields = schema.as_ref().fields().map(|f| f.name().clone()).collect();
+            files.push((
+                recover_string(location.unwrap()),
+                table_changes_scan_file_commit_version(scan_file.shallow_copy()),
+                fields,
+            ));
+            assert!(table_changes_scan_file_rows_past_end_selected(
+                scan_file.shallow_copy()
+            ));
+            free_bool_slice(table_changes_scan_file_selection_vector(
+                scan_file.shallow_copy(),
+            ));
+            free_schema(schema);
+            free_table_changes_scan_file(scan_file);
+        }
+    }
+
+    #[test]
+    #[cfg_attr(miri, ignore)] // reads from the filesystem
+    fn table_changes_scan_files() {
+        let path = table_path();
+        let engine = get_default_engine(&path);
+        let table_changes = ok_or_panic(unsafe {
+            table_changes_between_versions(kernel_string_slice!(path), engine.shallow_copy(), 0, 1)
+        });
+        assert_eq!(
+            unsafe { table_changes_end_version(table_changes.shallow_copy()) },
+            1
+        );
+        let schema = unsafe { table_changes_schema(table_changes.shallow_copy()) };
+        let field = unsafe { schema.as_ref() }.field("_commit_version").unwrap();
+        assert_eq!(field.data_type(), &DataType::LONG);
+        unsafe { free_schema(schema) };
+
+        let scan = ok_or_panic(unsafe {
+            table_changes_scan(table_changes.shallow_copy(), engine.shallow_copy(), None)
+        });
+        let iter = ok_or_panic(unsafe {
+            table_changes_scan_files_init(engine.shallow_copy(), scan.shallow_copy())
+        });
+        let mut files: Files = vec![];
+        let context = NonNull::new(&mut files as *mut Files).map(NonNull::cast);
+        while ok_or_panic(unsafe {
+            table_changes_scan_files_next(iter.shallow_copy(), context, collect_file)
+        }) {}
+
+        // the add of version 0, and the change data file of version 1, which replaces its remove.
+        // Change data files store their change type
+        let read_fields = ["part", "id"].map(String::from).to_vec();
+        let with_change_type = ["part", "id", "_change_type"].map(String::from).to_vec();
+        let expected = vec![
+            (format!("{path}fake/path/1"), 0, read_fields),
+            (format!("{path}fake/path/2"), 1, with_change_type),
+        ];
+        assert_eq!(files, expected);
+
+        unsafe {
+            free_table_changes_scan_files_iter(iter);
+            free_table_changes_scan(scan);
+            free_table_changes(table_changes);
+            free_engine(engine);
+        }
+    }
+
+    #[test]
+    #[cfg_attr(miri, ignore)] // reads from the filesystem
+    fn invalid_table_changes() {
+        let path = table_path();
+        let engine = get_default_engine(&path);
+        let res = unsafe {
+            table_changes_between_versions(kernel_string_slice!(path), engine.shallow_copy(), 3, 1)
+        };
+        assert!(res.is_err());
+        let (id, missing) = ("id", "missing");
+        let table_changes = ok_or_panic(unsafe {
+            table_changes_between_versions(kernel_string_slice!(path), engine.shallow_copy(), 0, 1)
+        });
+        let columns = [kernel_string_slice!(id), kernel_string_slice!(missing)];
+        let res = unsafe {
+            table_changes_scan_with_columns(
+                table_changes.shallow_copy(),
+                engine.shallow_copy(),
+                None,
+                columns.as_ptr(),
+                columns.len(),
+            )
+        };
+        let ExternResult::Err(err) = res else {
+            panic!("Projecting a missing column should fail");
+        };
+        let err = unsafe { recover_error(err) };
+        assert_eq!(err.etype, KernelError::MissingColumnError);
+        unsafe {
+            free_table_changes(table_changes);
+            free_engine(engine);
+        }
+    }
+}
@@ -227,3 +227,19 @@ pub unsafe extern "C" fn get_testing_kernel_predicate() -> Handle<SharedPredicat
 
     Arc::new(Pred::and_from(sub_exprs)).into()
 }
+
+/// Constructs a kernel transform like the ones kernel uses to insert partition values: it turns a
+/// batch of `{id: long, name: string}` into `{id: long, part: int, name: string}`, with `part` set
+/// to `partition_value`. Used to test `ffi/examples/visit-expression/transform_plan.h`.
+///
+/// # Safety
+/// The caller is responsible for freeing the returned memory, either by calling
+/// [`crate::expressions::free_kernel_expression`], or [`crate::handle::Handle::drop_handle`].
+#[no_mangle]
+pub unsafe extern "C" fn get_testing_kernel_transform(
+    partition_value: i32,
+) -> Handle<SharedExpression> {
+    let transform = Transform::new_top_level()
+        .with_inserted_field(Some("id"), Expr::literal(partition_value).into());
+    Arc::new(Expr::transform(transform)).into()
+}
@@ -7,7 +7,19 @@ use crate::KernelStringSlice;
 use crate::{unwrap_and_parse_path_as_url, TryFromStringSlice};
 use crate::{DeltaResult, ExternEngine, Snapshot, Url};
 use crate::{ExclusiveEngineData, SharedExternEngine};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::array::ffi::{FFI_ArrowArray, FFI_ArrowSchema};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::arrow::datatypes::DataType as ArrowDataType;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine::arrow_conversion::TryFromKernel as _;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::engine::arrow_data::ArrowEngineData;
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::transaction::add_files_schema;
 use delta_kernel::transaction::{CommitResult, Transaction};
+#[cfg(feature = "default-engine-base")]
+use delta_kernel::EngineData as _;
 use delta_kernel_ffi_macros::handle_descriptor;
 
 /// A handle representing an exclusive transaction on a Delta table. (Similar to a Box<_>)
@@ -94,6 +106,62 @@ pub unsafe extern "C" fn add_files(
     txn.add_files(write_metadata);
 }
 
+/// Add file metadata for written files to the transaction, as with [`add_files`], but taking the
+/// metadata straight from the arrow [C Data
+/// Interface](https://arrow.apache.org/docs/format/CDataInterface.html). The arrays are imported
+/// without copying, so engines should pass the metadata of many files (e.g. all the files of a
+/// commit) as one large batch, rather than calling this once per file. The batch must have the
+/// columns of [`delta_kernel::transaction::add_files_schema`]. Returns the number of files added.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid transaction handle and valid arrow data, whose
+/// ownership moves to kernel.
+#[cfg(feature = "default-engine-base")]
+#[no_mangle]
+pub unsafe extern "C" fn add_files_arrow(
+    mut txn: Handle<ExclusiveTransaction>,
+    array: FFI_ArrowArray,
+    schema: &FFI_ArrowSchema,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<usize> {
+    let txn = unsafe { txn.as_mut() };
+    let engine = unsafe { engine.as_ref() };
+    let write_metadata = unsafe { crate::engine_data::get_engine_data_impl(array, schema) };
+    add_files_arrow_impl(txn, write_metadata).into_extern_result(&engine)
+}
+
+#[cfg(feature = "default-engine-base")]
+fn add_files_arrow_impl(
+    txn: &mut Transaction,
+    write_metadata: DeltaResult<Handle<ExclusiveEngineData>>,
+) -> DeltaResult<usize> {
+    let write_metadata = unsafe { write_metadata?.into_inner() };
+    let batch = ArrowEngineData::try_from_engine_data(write_metadata)?;
+    // check the columns now, rather than failing the whole commit later. Nested field names (e.g.
+    // of map entries) differ between arrow implementations, so only the types must match
+    let arrow_schema = batch.record_batch().schema();
+    for field in add_files_schema().fields() {
+        let Ok(arrow_field) = arrow_schema.field_with_name(field.name()) else {
+            return Err(delta_kernel::Error::generic(format!(
+                "File metadata is missing the '{}' column",
+                field.name()
+            )));
+        };
+        let expected = ArrowDataType::try_from_kernel(field.data_type())?;
+        if !arrow_field.data_type().equals_datatype(&expected) {
+            return Err(delta_kernel::Error::generic(format!(
+                "The '{}' column of the file metadata has type {}, expected {expected}",
+                field.name(),
+                arrow_field.data_type()
+            )));
+        }
+    }
+    let num_files = batch.len();
+    txn.add_files(batch);
+    Ok(num_files)
+}
+
 /// Attempt to commit a transaction to the table. Returns version number if successful.
 /// Returns error if the commit fails.
 ///
@@ -108,20 +176,73 @@ pub unsafe extern "C" fn commit(
 ) -> ExternResult<u64> {
     let txn = unsafe { txn.into_inner() };
     let extern_engine = unsafe { engine.as_ref() };
+    commit_impl(*txn, extern_engine)
+        .map(|hint| hint.version)
+        .into_extern_result(&extern_engine)
+}
+
+/// The table's checkpoint interval when it doesn't set `delta.checkpointInterval`
+const DEFAULT_CHECKPOINT_INTERVAL: u64 = 10;
+
+/// What a successful commit tells the engine about the maintenance the table is due for. See
+/// [`commit_with_post_commit_hint`].
+#[repr(C)]
+pub struct PostCommitHint {
+    /// The version that was committed
+    pub version: u64,
+    /// The number of commits since the table was last checkpointed, including this one. Commit 0
+    /// counts as a checkpoint.
+    pub commits_since_checkpoint: u64,
+    /// The number of commits since the log was last compacted or checkpointed, including this one
+    pub commits_since_log_compaction: u64,
+    /// Whether the table's checkpoint interval (`delta.checkpointInterval`, 10 by default) has
+    /// passed since the last checkpoint, i.e. whether the engine should now checkpoint the
+    /// committed version with [`crate::checkpoint::checkpoint_snapshot`]
+    pub checkpoint_due: bool,
+}
+
+/// Attempt to commit a transaction to the table, as with [`commit`]. On success, returns the
+/// committed version along with a hint on whether the table should now be checkpointed or have its
+/// log compacted. Kernel never does either on its own, so engines that commit often should use this
+/// to keep snapshot loading fast.
+///
+/// # Safety
+///
+/// Caller is responsible for passing a valid handle. And MUST NOT USE transaction after this
+/// method is called.
+#[no_mangle]
+pub unsafe extern "C" fn commit_with_post_commit_hint(
+    txn: Handle<ExclusiveTransaction>,
+    engine: Handle<SharedExternEngine>,
+) -> ExternResult<PostCommitHint> {
+    let txn = unsafe { txn.into_inner() };
+    let extern_engine = unsafe { engine.as_ref() };
+    commit_impl(*txn, extern_engine).into_extern_result(&extern_engine)
+}
+
+fn commit_impl(txn: Transaction, extern_engine: &dyn ExternEngine) -> DeltaResult<PostCommitHint> {
+    let checkpoint_interval = txn
+        .read_snapshot()
+        .table_properties()
+        .checkpoint_interval
+        .map_or(DEFAULT_CHECKPOINT_INTERVAL, |interval| interval.get());
     let engine = extern_engine.engine();
     // TODO: for now this removes the enum, which prevents doing any conflict resolution. We should fix
     //       this by making the commit function return the enum somehow.
-    match txn.commit(engine.as_ref()) {
-        Ok(CommitResult::Committed {
-            version: v,
-            post_commit_stats: _,
-        }) => Ok(v),
-        Ok(CommitResult::Conflict(_, v)) => Err(delta_kernel::Error::Generic(format!(
+    match txn.commit(engine.as_ref())? {
+        CommitResult::Committed {
+            version,
+            post_commit_stats,
+        } => Ok(PostCommitHint {
+            version,
+            commits_since_checkpoint: post_commit_stats.commits_since_checkpoint,
+            commits_since_log_compaction: post_commit_stats.commits_since_log_compaction,
+            checkpoint_due: post_commit_stats.commits_since_checkpoint >= checkpoint_interval,
+        }),
+        CommitResult::Conflict(_, v) => Err(delta_kernel::Error::Generic(format!(
             "commit conflict at version {v}"
         ))),
-        Err(e) => Err(e),
     }
-    .into_extern_result(&extern_engine)
 }
 
 #[cfg(test)]
@@ -381,4 +502,124 @@ mod tests {
 
         Ok(())
     }
+
+    #[tokio::test]
+    #[cfg_attr(miri, ignore)] // FIXME: re-enable miri (can't call foreign function `linkat` on OS `linux`)
+    async fn test_post_commit_hint() -> Result<(), Box<dyn std::error::Error>> {
+        let schema = Arc::new(StructType::try_new(vec![StructField::nullable(
+            "number",
+            DataType::INTEGER,
+        )])?);
+        let tmp_test_dir = tempdir()?;
+        let tmp_dir_local_url = Url::from_directory_path(tmp_test_dir.path()).unwrap();
+
+        for (table_url, _engine, _store, _table_name) in
+            setup_test_tables(schema, &[], Some(&tmp_dir_local_url), "test_table").await?
+        {
+            let table_path = table_url.to_file_path().unwrap();
+            let table_path_str = table_path.to_str().unwrap();
+            let engine = get_default_engine(table_path_str);
+
+            // the table is created at version 0, and the default checkpoint interval is 10
+            for version in 1..=10 {
+                let txn = ok_or_panic(unsafe {
+                    transaction(kernel_string_slice!(table_path_str), engine.shallow_copy())
+                });
+                let hint = ok_or_panic(unsafe {
+                    commit_with_post_commit_hint(txn, engine.shallow_copy())
+                });
+                assert_eq!(hint.version, version);
+                assert_eq!(hint.commits_since_checkpoint, version);
+                assert_eq!(hint.commits_since_log_compaction, version);
+                assert_eq!(hint.checkpoint_due, version == 10);
+            }
+            unsafe { free_engine(engine) };
+        }
+        Ok(())
+    }
+
+    #[tokio::test]
+    #[cfg_attr(miri, ignore)] // FIXME: re-enable miri (can't call foreign function `linkat` on OS `linux`)
+    async fn test_add_files_arrow() -> Result<(), Box<dyn std::error::Error>> {
+        use delta_kernel::arrow::datatypes::{DataType as ArrowDataType, Field};
+        use delta_kernel_ffi::error::KernelError;
+        use delta_kernel_ffi::ffi_test_utils::assert_extern_result_error_with_message;
+
+        let schema = Arc::new(StructType::try_new(vec![StructField::nullable(
+            "number",
+            DataType::INTEGER,
+        )])?);
+        let tmp_test_dir = tempdir()?;
+        let tmp_dir_local_url = Url::from_directory_path(tmp_test_dir.path()).unwrap();
+
+        for (table_url, _engine, _store, _table_name) in
+            setup_test_tables(schema, &[], Some(&tmp_dir_local_url), "test_table").await?
+        {
+            let table_path = table_url.to_file_path().unwrap();
+            let table_path_str = table_path.to_str().unwrap();
+            let engine = get_default_engine(table_path_str);
+            let txn = ok_or_panic(unsafe {
+                transaction(kernel_string_slice!(table_path_str), engine.shallow_copy())
+            });
+
+            let path_only = ArrowSchema::new(vec![Field::new("path", ArrowDataType::Utf8, false)]);
+            let file_info = create_arrow_ffi_from_json(path_only, r#"{"path": "a.parquet"}"#)?;
+            let res = unsafe {
+                add_files_arrow(
+                    txn.shallow_copy(),
+                    file_info.array,
+                    &file_info.schema,
+                    engine.shallow_copy(),
+                )
+            };
+            assert_extern_result_error_with_message(
+                res,
+                KernelError::GenericError,
+                "Generic delta kernel error: File metadata is missing the 'partitionValues' column",
+            );
+
+            // all the columns, but with the size as a string
+            let schema: ArrowSchema = add_files_schema().as_ref().try_into_arrow()?;
+            let fields = schema
+                .fields()
+                .iter()
+                .map(|field| match field.name().as_str() {
+                    "size" => Field::new("size", ArrowDataType::Utf8, false),
+                    _ => field.as_ref().clone(),
+                })
+                .collect::<Vec<_>>();
+            let file_info = create_arrow_ffi_from_json(
+                ArrowSchema::new(fields),
+                r#"{"path": "a.parquet", "partitionValues": {}, "size": "3", "modificationTime": 0, "dataChange": true}"#,
+            )?;
+            let res = unsafe {
+                add_files_arrow(
+                    txn.shallow_copy(),
+                    file_info.array,
+                    &file_info.schema,
+                    engine.shallow_copy(),
+                )
+            };
+            assert_extern_result_error_with_message(
+                res,
+                KernelError::GenericError,
+                "Generic delta kernel error: The 'size' column of the file metadata has type Utf8, expected Int64",
+            );
+
+            let file_info = create_file_metadata("b.parquet", 3)?;
+            let res = unsafe {
+                add_files_arrow(
+                    txn.shallow_copy(),
+                    file_info.array,
+                    &file_info.schema,
+                    engine.shallow_copy(),
+                )
+            };
+            assert_eq!(ok_or_panic(res), 1);
+            let version = ok_or_panic(unsafe { commit(txn, engine.shallow_copy()) });
+            assert_eq!(version, 1);
+            unsafe { free_engine(engine) };
+        }
+        Ok(())
+    }
 }
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+set -euo pipefail
+
+# Generate tables shaped like large production tables into the given directory (unless they already
+# exist there), then benchmark each of them, writing the results to <dir>/results/<table>.json.
+# Run from the metadata-bench build directory, e.g. with `make bench_large_tables`.
+OUT_DIR=$1
+RUNS=${RUNS:-3}
+mkdir -p "$OUT_DIR/results"
+
+generate() {
+  local name=$1
+  shift
+  if [ ! -d "$OUT_DIR/$name" ]; then
+    echo "Generating $name"
+    ./generate_table "$@" "$OUT_DIR/$name"
+  fi
+}
+
+# 10^6 files in 10^4 commits, with a checkpoint every 1000 commits
+generate many_files --commits 10000 --files-per-commit 100 --checkpoint-interval 1000 \
+  --partitions 100
+# 10^6 files, with 10^4 commits on top of the only checkpoint
+generate long_tail --commits 20000 --files-per-commit 50 --checkpoint-interval 10000
+# 10^5 files of a wide table, with deeply nested columns
+generate wide_nested --commits 1000 --files-per-commit 100 --checkpoint-interval 500 \
+  --columns 200 --nesting 3
+# 2 * 10^5 files, half of which get a deletion vector over time
+generate heavy_dvs --commits 2000 --files-per-commit 100 --checkpoint-interval 500 \
+  --dv-updates-per-commit 50
+
+for table in many_files long_tail wide_nested heavy_dvs; do
+  echo "Benchmarking $table"
+  ./bench_metadata --runs "$RUNS" --json "$OUT_DIR/results/$table.json" "$OUT_DIR/$table"
+  cat "$OUT_DIR/results/$table.json"
+done
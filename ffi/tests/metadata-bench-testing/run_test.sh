@@ -0,0 +1,19 @@
+#!/bin/bash
+
+set -euxo pipefail
+
+# Generate a table with the given generate_table options, and check that every run of the benchmark
+# finds all of its files
+TABLE_DIR=$(mktemp -d)
+RESULTS=$(mktemp)
+GENERATED=$(./generate_table "$@" "$TABLE_DIR/table")
+echo "$GENERATED"
+VERSION=$(echo "$GENERATED" | sed -n 's/^version: //p')
+FILES=$(echo "$GENERATED" | sed -n 's/^files: //p')
+FILES_WITH_DV=$(echo "$GENERATED" | sed -n 's/^files_with_dv: //p')
+./bench_metadata --runs 2 --json "$RESULTS" "$TABLE_DIR/table"
+cat "$RESULTS"
+grep -q "^  \"version\": $VERSION,$" "$RESULTS"
+test "$(grep -c "^      \"files\": $FILES,$" "$RESULTS")" -eq 2
+test "$(grep -c "^      \"files_with_dv\": $FILES_WITH_DV,$" "$RESULTS")" -eq 2
+rm -r "$TABLE_DIR" "$RESULTS"
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+set -euxo pipefail
+
+# Extract the table tarball given as the first argument, and compare the changes read from it with
+# the expected output. Kernel returns the changes of a commit in no particular order, so both are
+# sorted first. Any arguments after the table tarball and expected output are passed through to
+# read_table_changes
+TABLE_DIR=$(mktemp -d)
+OUT_FILE=$(mktemp)
+tar --zstd -xf "$1" -C "$TABLE_DIR"
+TABLE_NAME=$(basename "$1" .tar.zst)
+./read_table_changes "${@:3}" "$TABLE_DIR/$TABLE_NAME" | tee "$OUT_FILE"
+diff -s <(sort "$OUT_FILE") <(sort "$2")
+DIFF_EXIT_CODE=$?
+echo "Diff exited with $DIFF_EXIT_CODE"
+rm -r "$OUT_FILE" "$TABLE_DIR"
+exit "$DIFF_EXIT_CODE"
@@ -2,8 +2,9 @@
 
 set -euxo pipefail
 
+# any arguments after the table path and expected output are passed through to read_table
 OUT_FILE=$(mktemp)
-./read_table "$1" | tee "$OUT_FILE"
+./read_table "${@:3}" "$1" | tee "$OUT_FILE"
 diff -s "$OUT_FILE" "$2"
 DIFF_EXIT_CODE=$?
 echo "Diff exited with $DIFF_EXIT_CODE"
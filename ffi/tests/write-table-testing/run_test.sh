@@ -0,0 +1,58 @@
+#!/bin/bash
+
+set -euxo pipefail
+
+# Append the data of a table to a copy of itself, using read_table to produce the input.
+# Arguments are the path to the read_table binary and the table, then options for write_table
+READ_TABLE=$1
+TABLE_DIR=$(mktemp -d)
+INPUT_FILE=$(mktemp)
+cp -r "$2"/. "$TABLE_DIR"
+
+# The rows of the data read_table prints, one per line with tab separated values, sorted. Each
+# column is printed as a list of values, one per line
+sorted_rows() {
+  echo "$1" | awk '
+    /^[^ ].*:  \[$/ { col++; row = 0; next }
+    /^\]$/ { next }
+    col > 0 && /^  / {
+      sub(/^  /, ""); sub(/,$/, "")
+      rows[row] = col == 1 ? $0 : rows[row] "\t" $0
+      if (++row > num_rows) num_rows = row
+    }
+    END { for (r = 0; r < num_rows; r++) print rows[r] }' | sort
+}
+
+"$READ_TABLE" --ipc "$INPUT_FILE" "$TABLE_DIR"
+OLD_OUT=$("$READ_TABLE" "$TABLE_DIR")
+VERSION=$(echo "$OLD_OUT" | sed -n 's/^version: //p')
+./write_table "${@:3}" "$INPUT_FILE" "$TABLE_DIR"
+# the appended table must be readable, at the next version
+NEW_OUT=$("$READ_TABLE" "$TABLE_DIR")
+echo "$NEW_OUT"
+echo "$NEW_OUT" | grep -q "^version: $((VERSION + 1))$"
+# and hold every row of the original table twice
+OLD_ROWS=$(sorted_rows "$OLD_OUT")
+diff <(printf '%s\n%s\n' "$OLD_ROWS" "$OLD_ROWS" | sort) <(sorted_rows "$NEW_OUT")
+
+# kernel reads partition values from the log, so also check each new file was written to the
+# directory of its partition values, with the names and values escaped as in Hive
+python3 - "$TABLE_DIR/_delta_log/$(printf '%020d' $((VERSION + 1))).json" <<'EOF'
+import json, re, sys, urllib.parse
+
+def unescape(name):
+    return re.sub(r"%([0-9A-F]{2})", lambda m: chr(int(m.group(1), 16)), name)
+
+for line in open(sys.argv[1]):
+    add = json.loads(line).get("add")
+    if add is None:
+        continue
+    dirs = urllib.parse.unquote(add["path"]).split("/")[:-1]
+    values = {unescape(k): unescape(v) for k, v in (d.split("=", 1) for d in dirs)}
+    expected = {
+        k: "__HIVE_DEFAULT_PARTITION__" if v is None else v
+        for k, v in add["partitionValues"].items()
+    }
+    assert values == expected, f"{add['path']} has partition values {add['partitionValues']}"
+EOF
+rm -r "$TABLE_DIR" "$INPUT_FILE"
@@ -36,6 +36,7 @@ pub mod storage;
 #[derive(Debug)]
 pub struct DefaultEngine<E: TaskExecutor> {
     object_store: Arc<DynObjectStore>,
+    task_executor: Arc<E>,
     storage: Arc<ObjectStoreStorageHandler<E>>,
     json: Arc<DefaultJsonHandler<E>>,
     parquet: Arc<DefaultParquetHandler<E>>,
@@ -82,13 +83,29 @@ impl<E: TaskExecutor> DefaultEngine<E> {
             )),
             parquet: Arc::new(DefaultParquetHandler::new(
                 object_store.clone(),
-                task_executor,
+                task_executor.clone(),
             )),
             object_store,
+            task_executor,
             evaluation: Arc::new(ArrowEvaluationHandler {}),
         }
     }
 
+    /// Set how many files the storage handler, and how many batches the parquet handler, read
+    /// ahead of the one being consumed. See [`ObjectStoreStorageHandler::with_readahead`] and
+    /// [`DefaultParquetHandler::with_readahead`].
+    pub fn with_readahead(self, readahead: usize) -> Self {
+        let storage =
+            ObjectStoreStorageHandler::new(self.object_store.clone(), self.task_executor.clone());
+        let parquet =
+            DefaultParquetHandler::new(self.object_store.clone(), self.task_executor.clone());
+        Self {
+            storage: Arc::new(storage.with_readahead(readahead)),
+            parquet: Arc::new(parquet.with_readahead(readahead)),
+            ..self
+        }
+    }
+
     pub fn get_object_store_for_url(&self, _url: &Url) -> Option<Arc<DynObjectStore>> {
         Some(self.object_store.clone())
     }
@@ -183,6 +200,16 @@ mod tests {
         test_arrow_engine(&engine, &url);
     }
 
+    #[test]
+    fn test_default_engine_with_readahead() {
+        let tmp = tempfile::tempdir().unwrap();
+        let url = Url::from_directory_path(tmp.path()).unwrap();
+        let object_store = Arc::new(LocalFileSystem::new());
+        let engine = DefaultEngine::new(object_store, Arc::new(TokioBackgroundExecutor::new()))
+            .with_readahead(1);
+        test_arrow_engine(&engine, &url);
+    }
+
     #[test]
     fn test_pre_signed_url() {
         let url = Url::parse("https://example.com?X-Amz-Signature=foo").unwrap();
@@ -21,7 +21,8 @@ use crate::{DeltaResult, Error, StorageHandler, Version};
 use delta_kernel_derive::internal_api;
 
 use itertools::Itertools;
-use tracing::{info, warn};
+use tracing::field::Empty;
+use tracing::{info, info_span, warn};
 use url::Url;
 
 /// A struct to hold the result of listing log files. The commit and compaction files are guaranteed
@@ -248,11 +249,20 @@ impl ListedLogFiles {
         start_version: Option<Version>,
         end_version: Option<Version>,
     ) -> DeltaResult<Self> {
+        let span = info_span!(
+            "list_log_files",
+            location = %log_root,
+            ?start_version,
+            ?end_version,
+            commits = Empty,
+            checkpoint_parts = Empty,
+        )
+        .entered();
         // TODO: plumb through a log_tail provided by our caller
         let log_tail = vec![];
         let log_files = list_log_files(storage, log_root, log_tail, start_version, end_version)?;
 
-        log_files.process_results(|iter| {
+        let listed_files = log_files.process_results(|iter| {
             let mut ascending_commit_files = Vec::new();
             let mut ascending_compaction_files = Vec::new();
             let mut checkpoint_parts = vec![];
@@ -308,7 +318,10 @@ impl ListedLogFiles {
                 checkpoint_parts,
                 latest_crc_file,
             )
-        })?
+        })??;
+        span.record("commits", listed_files.ascending_commit_files.len());
+        span.record("checkpoint_parts", listed_files.checkpoint_parts.len());
+        Ok(listed_files)
     }
 
     /// List all commit and checkpoint files after the provided checkpoint. It is guaranteed that all
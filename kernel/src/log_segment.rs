@@ -14,8 +14,8 @@ use crate::path::{LogPathFileType, ParsedLogPath};
 use crate::schema::SchemaRef;
 use crate::utils::require;
 use crate::{
-    DeltaResult, Engine, EngineData, Error, Expression, FileMeta, ParquetHandler, Predicate,
-    PredicateRef, RowVisitor, StorageHandler, Version,
+    DeltaResult, Engine, EngineData, Error, Expression, FileDataReadResultIterator, FileMeta,
+    ParquetHandler, Predicate, PredicateRef, RowVisitor, StorageHandler, Version,
 };
 use delta_kernel_derive::internal_api;
 
@@ -25,12 +25,68 @@ pub use crate::listed_log_files::ListedLogFiles;
 use crate::listed_log_files::ListedLogFiles;
 
 use itertools::Itertools;
-use tracing::{debug, warn};
+use tracing::field::{display, Empty};
+use tracing::{debug, info_span, warn, Span};
 use url::Url;
 
 #[cfg(test)]
 mod tests;
 
+/// The kinds of log file [`LogSegment::read_actions_tracked`] reports opening
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum LogFileKind {
+    /// A commit or compacted commit file
+    Commit,
+    /// A part of a (possibly single part) checkpoint
+    CheckpointPart,
+    /// A sidecar file of a v2 checkpoint
+    Sidecar,
+}
+
+/// Called with each log file [`LogSegment::read_actions_tracked`] reads, right before it is opened
+pub(crate) type LogFileCallback = Arc<dyn Fn(LogFileKind, &FileMeta) + Send + Sync>;
+
+// Read `files` with `read`. Without `on_open` they are all read with one call, so the engine can
+// read them concurrently. With it, each file gets a call of its own, made (right after telling
+// `on_open` about the file) once the file before it has been read.
+fn read_log_files(
+    files: Vec<FileMeta>,
+    kind: LogFileKind,
+    on_open: Option<LogFileCallback>,
+    read: impl Fn(&[FileMeta]) -> DeltaResult<FileDataReadResultIterator> + Send + 'static,
+) -> DeltaResult<FileDataReadResultIterator> {
+    let Some(on_open) = on_open else {
+        return read(&files);
+    };
+    let batches = files
+        .into_iter()
+        .map(move |file| {
+            on_open(kind, &file);
+            read(std::slice::from_ref(&file))
+        })
+        .flatten_ok()
+        .map(|result| result?); // result-result to result
+    Ok(Box::new(batches))
+}
+
+// Advance `actions` inside `span`, counting the rows read so far in its `rows` field. Log files are
+// read lazily, so the span is entered each time the iterator is advanced rather than just once
+fn read_in_span(
+    span: Span,
+    mut actions: impl Iterator<Item = DeltaResult<ActionsBatch>> + Send,
+) -> impl Iterator<Item = DeltaResult<ActionsBatch>> + Send {
+    let mut rows = 0;
+    std::iter::from_fn(move || {
+        let _entered = span.enter();
+        let next = actions.next();
+        if let Some(Ok(batch)) = &next {
+            rows += batch.actions.len();
+            span.record("rows", rows);
+        }
+        next
+    })
+}
+
 /// A [`LogSegment`] represents a contiguous section of the log and is made of checkpoint files
 /// and commit files and guarantees the following:
 ///     1. Commit file versions will not have any gaps between them.
@@ -277,20 +333,76 @@ impl LogSegment {
         commit_read_schema: SchemaRef,
         checkpoint_read_schema: SchemaRef,
         meta_predicate: Option<PredicateRef>,
+    ) -> DeltaResult<impl Iterator<Item = DeltaResult<ActionsBatch>> + Send> {
+        self.read_actions_inner(
+            engine,
+            commit_read_schema,
+            checkpoint_read_schema,
+            meta_predicate,
+            None,
+        )
+    }
+
+    /// Like [`LogSegment::read_actions`], but tells `on_open` about each log file (commits,
+    /// checkpoint parts and sidecars) right before it is opened. To make that possible the files
+    /// are read one at a time, each once the one before it has been read in full, so a replay that
+    /// stops early (or is dropped) never opens the files it didn't get to.
+    pub(crate) fn read_actions_tracked(
+        &self,
+        engine: &dyn Engine,
+        commit_read_schema: SchemaRef,
+        checkpoint_read_schema: SchemaRef,
+        meta_predicate: Option<PredicateRef>,
+        on_open: LogFileCallback,
+    ) -> DeltaResult<impl Iterator<Item = DeltaResult<ActionsBatch>> + Send> {
+        self.read_actions_inner(
+            engine,
+            commit_read_schema,
+            checkpoint_read_schema,
+            meta_predicate,
+            Some(on_open),
+        )
+    }
+
+    fn read_actions_inner(
+        &self,
+        engine: &dyn Engine,
+        commit_read_schema: SchemaRef,
+        checkpoint_read_schema: SchemaRef,
+        meta_predicate: Option<PredicateRef>,
+        on_open: Option<LogFileCallback>,
     ) -> DeltaResult<impl Iterator<Item = DeltaResult<ActionsBatch>> + Send> {
         // `replay` expects commit files to be sorted in descending order, so the return value here is correct
         let commits_and_compactions = self.find_commit_cover();
-        let commit_stream = engine
-            .json_handler()
-            .read_json_files(
-                &commits_and_compactions,
-                commit_read_schema,
-                meta_predicate.clone(),
-            )?
-            .map_ok(|batch| ActionsBatch::new(batch, true));
+        // `location` is the newest commit, which is read first
+        let commit_span = info_span!(
+            "read_commits",
+            files = commits_and_compactions.len(),
+            bytes = commits_and_compactions.iter().map(|f| f.size).sum::<u64>(),
+            location = commits_and_compactions
+                .first()
+                .map(|f| display(&f.location)),
+            rows = Empty,
+        );
+        let json_handler = engine.json_handler();
+        let commit_predicate = meta_predicate.clone();
+        let commit_stream = read_log_files(
+            commits_and_compactions,
+            LogFileKind::Commit,
+            on_open.clone(),
+            move |files| {
+                json_handler.read_json_files(
+                    files,
+                    commit_read_schema.clone(),
+                    commit_predicate.clone(),
+                )
+            },
+        )?
+        .map_ok(|batch| ActionsBatch::new(batch, true));
+        let commit_stream = read_in_span(commit_span, commit_stream);
 
         let checkpoint_stream =
-            self.create_checkpoint_stream(engine, checkpoint_read_schema, meta_predicate)?;
+            self.create_checkpoint_stream(engine, checkpoint_read_schema, meta_predicate, on_open)?;
 
         Ok(commit_stream.chain(checkpoint_stream))
     }
@@ -300,7 +412,7 @@ impl LogSegment {
     /// returns files is DESCENDING ORDER, as that's what `replay` expects. This function assumes
     /// that all files in `self.ascending_commit_files` and `self.ascending_compaction_files` are in
     /// range for this log segment. This invariant is maintained by our listing code.
-    fn find_commit_cover(&self) -> Vec<FileMeta> {
+    pub(crate) fn find_commit_cover(&self) -> Vec<FileMeta> {
         // Create an iterator sorted in ascending order by (initial version, end version), e.g.
         // [00.json, 00.09.compacted.json, 00.99.compacted.json, 01.json, 02.json, ..., 10.json,
         //  10.19.compacted.json, 11.json, ...]
@@ -354,6 +466,7 @@ impl LogSegment {
         engine: &dyn Engine,
         checkpoint_read_schema: SchemaRef,
         meta_predicate: Option<PredicateRef>,
+        on_open: Option<LogFileCallback>,
     ) -> DeltaResult<impl Iterator<Item = DeltaResult<ActionsBatch>> + Send> {
         let need_file_actions = checkpoint_read_schema.contains(ADD_NAME)
             || checkpoint_read_schema.contains(REMOVE_NAME);
@@ -380,20 +493,40 @@ impl LogSegment {
         // but it was removed to avoid unnecessary coupling. This is a concrete case
         // where it *could* have been useful, but for now, we're keeping them separate.
         // If similar patterns start appearing elsewhere, we should reconsider that decision.
+        let part_kind = LogFileKind::CheckpointPart;
+        let part_schema = checkpoint_read_schema.clone();
+        let part_predicate = meta_predicate.clone();
         let actions = match self.checkpoint_parts.first() {
             Some(parsed_log_path) if parsed_log_path.extension == "json" => {
-                engine.json_handler().read_json_files(
-                    &checkpoint_file_meta,
-                    checkpoint_read_schema.clone(),
-                    meta_predicate.clone(),
+                let json_handler = engine.json_handler();
+                read_log_files(
+                    checkpoint_file_meta.clone(),
+                    part_kind,
+                    on_open.clone(),
+                    move |files| {
+                        json_handler.read_json_files(
+                            files,
+                            part_schema.clone(),
+                            part_predicate.clone(),
+                        )
+                    },
+                )?
+            }
+            Some(parsed_log_path) if parsed_log_path.extension == "parquet" => {
+                let parquet_handler = parquet_handler.clone();
+                read_log_files(
+                    checkpoint_file_meta.clone(),
+                    part_kind,
+                    on_open.clone(),
+                    move |files| {
+                        parquet_handler.read_parquet_files(
+                            files,
+                            part_schema.clone(),
+                            part_predicate.clone(),
+                        )
+                    },
                 )?
             }
-            Some(parsed_log_path) if parsed_log_path.extension == "parquet" => parquet_handler
-                .read_parquet_files(
-                    &checkpoint_file_meta,
-                    checkpoint_read_schema.clone(),
-                    meta_predicate.clone(),
-                )?,
             Some(parsed_log_path) => {
                 return Err(Error::generic(format!(
                     "Unsupported checkpoint file type: {}",
@@ -407,6 +540,15 @@ impl LogSegment {
 
         let log_root = self.log_root.clone();
 
+        // for a multi-part checkpoint, `location` is its first part
+        let span = info_span!(
+            "read_checkpoint",
+            parts = checkpoint_file_meta.len(),
+            bytes = checkpoint_file_meta.iter().map(|f| f.size).sum::<u64>(),
+            location = checkpoint_file_meta.first().map(|f| display(&f.location)),
+            rows = Empty,
+        );
+
         let actions_iter = actions
             .map(move |checkpoint_batch_result| -> DeltaResult<_> {
                 let checkpoint_batch = checkpoint_batch_result?;
@@ -425,6 +567,7 @@ impl LogSegment {
                         checkpoint_batch.as_ref(),
                         checkpoint_read_schema.clone(),
                         meta_predicate.clone(),
+                        on_open.clone(),
                     )?
                 } else {
                     None
@@ -441,7 +584,8 @@ impl LogSegment {
             .flatten_ok()
             .map(|result| result?); // result-result to result
 
-        Ok(actions_iter)
+        // the checkpoint and any sidecars are all read inside the one span
+        Ok(read_in_span(span, actions_iter))
     }
 
     /// Processes sidecar files for the given checkpoint batch.
@@ -454,6 +598,7 @@ impl LogSegment {
         batch: &dyn EngineData,
         checkpoint_read_schema: SchemaRef,
         meta_predicate: Option<PredicateRef>,
+        on_open: Option<LogFileCallback>,
     ) -> DeltaResult<Option<impl Iterator<Item = DeltaResult<Box<dyn EngineData>>> + Send>> {
         // Visit the rows of the checkpoint batch to extract sidecar file references
         let mut visitor = SidecarVisitor::default();
@@ -471,10 +616,17 @@ impl LogSegment {
             .try_collect()?;
 
         // Read the sidecar files and return an iterator of sidecar file batches
-        Ok(Some(parquet_handler.read_parquet_files(
-            &sidecar_files,
-            checkpoint_read_schema,
-            meta_predicate,
+        Ok(Some(read_log_files(
+            sidecar_files,
+            LogFileKind::Sidecar,
+            on_open,
+            move |files| {
+                parquet_handler.read_parquet_files(
+                    files,
+                    checkpoint_read_schema.clone(),
+                    meta_predicate.clone(),
+                )
+            },
         )?))
     }
 
@@ -1017,6 +1017,7 @@ fn test_create_checkpoint_stream_errors_when_schema_has_remove_but_no_sidecar_ac
         &engine,
         get_log_schema().project(&[REMOVE_NAME])?,
         None,
+        None,
     );
 
     // Errors because the schema has an REMOVE action but no SIDECAR action.
@@ -1044,7 +1045,8 @@ fn test_create_checkpoint_stream_errors_when_schema_has_add_but_no_sidecar_actio
         log_root,
         None,
     )?;
-    let result = log_segment.create_checkpoint_stream(&engine, get_log_add_schema().clone(), None);
+    let result =
+        log_segment.create_checkpoint_stream(&engine, get_log_add_schema().clone(), None, None);
 
     // Errors because the schema has an ADD action but no SIDECAR action.
     assert_result_error_with_message(result, "Invalid Checkpoint: If the checkpoint read schema contains file actions, it must contain the sidecar column");
@@ -1080,8 +1082,12 @@ fn test_create_checkpoint_stream_returns_checkpoint_batches_as_is_if_schema_has_
         log_root,
         None,
     )?;
-    let mut iter =
-        log_segment.create_checkpoint_stream(&engine, v2_checkpoint_read_schema.clone(), None)?;
+    let mut iter = log_segment.create_checkpoint_stream(
+        &engine,
+        v2_checkpoint_read_schema.clone(),
+        None,
+        None,
+    )?;
 
     // Assert that the first batch returned is from reading checkpoint file 1
     let ActionsBatch {
@@ -1142,8 +1148,12 @@ fn test_create_checkpoint_stream_returns_checkpoint_batches_if_checkpoint_is_mul
         log_root,
         None,
     )?;
-    let mut iter =
-        log_segment.create_checkpoint_stream(&engine, v2_checkpoint_read_schema.clone(), None)?;
+    let mut iter = log_segment.create_checkpoint_stream(
+        &engine,
+        v2_checkpoint_read_schema.clone(),
+        None,
+        None,
+    )?;
 
     // Assert the correctness of batches returned
     for expected_sidecar in ["sidecar1.parquet", "sidecar2.parquet"].iter() {
@@ -1193,8 +1203,12 @@ fn test_create_checkpoint_stream_reads_parquet_checkpoint_batch_without_sidecars
         log_root,
         None,
     )?;
-    let mut iter =
-        log_segment.create_checkpoint_stream(&engine, v2_checkpoint_read_schema.clone(), None)?;
+    let mut iter = log_segment.create_checkpoint_stream(
+        &engine,
+        v2_checkpoint_read_schema.clone(),
+        None,
+        None,
+    )?;
 
     // Assert that the first batch returned is from reading checkpoint file 1
     let ActionsBatch {
@@ -1240,7 +1254,7 @@ fn test_create_checkpoint_stream_reads_json_checkpoint_batch_without_sidecars()
         None,
     )?;
     let mut iter =
-        log_segment.create_checkpoint_stream(&engine, v2_checkpoint_read_schema, None)?;
+        log_segment.create_checkpoint_stream(&engine, v2_checkpoint_read_schema, None, None)?;
 
     // Assert that the first batch returned is from reading checkpoint file 1
     let ActionsBatch {
@@ -1258,6 +1272,80 @@ fn test_create_checkpoint_stream_reads_json_checkpoint_batch_without_sidecars()
     Ok(())
 }
 
+// Tracked reads report each log file right before it is opened, so a checkpoint's sidecars are only
+// reported once the checkpoint batch referencing them is replayed
+#[test]
+fn test_create_checkpoint_stream_reports_files_as_they_are_opened() -> DeltaResult<()> {
+    let (store, log_root) = new_in_memory_store();
+    let engine = DefaultEngine::new(store.clone(), Arc::new(TokioBackgroundExecutor::new()));
+
+    add_checkpoint_to_store(
+        &store,
+        sidecar_batch_with_given_paths(
+            vec!["sidecarfile1.parquet", "sidecarfile2.parquet"],
+            get_log_schema().clone(),
+        ),
+        "00000000000000000001.checkpoint.parquet",
+    )?;
+    for sidecar in ["sidecarfile1.parquet", "sidecarfile2.parquet"] {
+        add_sidecar_to_store(
+            &store,
+            add_batch_simple(get_log_schema().project(&[ADD_NAME, REMOVE_NAME])?),
+            sidecar,
+        )?;
+    }
+    let checkpoint_file_path = log_root
+        .join("00000000000000000001.checkpoint.parquet")?
+        .to_string();
+    let log_segment = LogSegment::try_new(
+        ListedLogFiles::try_new(
+            vec![],
+            vec![],
+            vec![create_log_path(&checkpoint_file_path)],
+            None,
+        )?,
+        log_root,
+        None,
+    )?;
+
+    let opened = Arc::new(std::sync::Mutex::new(vec![]));
+    let record = opened.clone();
+    let on_open: LogFileCallback = Arc::new(move |kind, file: &FileMeta| {
+        let name = file.location.path_segments().unwrap().next_back().unwrap();
+        record.lock().unwrap().push((kind, name.to_string()));
+    });
+    let read_schema = get_log_schema().project(&[ADD_NAME, SIDECAR_NAME])?;
+    let mut iter =
+        log_segment.create_checkpoint_stream(&engine, read_schema, None, Some(on_open))?;
+    assert!(opened.lock().unwrap().is_empty());
+
+    iter.next().unwrap()?;
+    let checkpoint = (
+        LogFileKind::CheckpointPart,
+        "00000000000000000001.checkpoint.parquet".to_string(),
+    );
+    assert_eq!(*opened.lock().unwrap(), [checkpoint.clone()]);
+
+    // each sidecar is opened once the one before it has been read
+    iter.next().unwrap()?;
+    let sidecar = |name: &str| (LogFileKind::Sidecar, name.to_string());
+    assert_eq!(
+        *opened.lock().unwrap(),
+        [checkpoint.clone(), sidecar("sidecarfile1.parquet")]
+    );
+    assert_eq!(iter.count(), 1);
+    assert_eq!(
+        *opened.lock().unwrap(),
+        [
+            checkpoint,
+            sidecar("sidecarfile1.parquet"),
+            sidecar("sidecarfile2.parquet")
+        ]
+    );
+
+    Ok(())
+}
+
 // Tests the end-to-end process of creating a checkpoint stream.
 // Verifies that:
 // - The checkpoint file is read and produces batches containing references to sidecar files.
@@ -1306,8 +1394,12 @@ fn test_create_checkpoint_stream_reads_checkpoint_file_and_returns_sidecar_batch
         log_root,
         None,
     )?;
-    let mut iter =
-        log_segment.create_checkpoint_stream(&engine, v2_checkpoint_read_schema.clone(), None)?;
+    let mut iter = log_segment.create_checkpoint_stream(
+        &engine,
+        v2_checkpoint_read_schema.clone(),
+        None,
+        None,
+    )?;
 
     // Assert that the first batch returned is from reading checkpoint file 1
     let ActionsBatch {
@@ -2,7 +2,8 @@ use std::borrow::Cow;
 use std::cmp::Ordering;
 use std::sync::{Arc, LazyLock};
 
-use tracing::debug;
+use tracing::field::Empty;
+use tracing::{debug, debug_span};
 
 use crate::actions::get_log_add_schema;
 use crate::actions::visitors::SelectionVectorVisitor;
@@ -50,6 +51,57 @@ fn as_sql_data_skipping_predicate(pred: &Pred) -> Option<Pred> {
     DataSkippingPredicateCreator.eval_sql_where(pred)
 }
 
+/// The schema the JSON `stats` of an add action parse into, for the columns of `referenced_schema`.
+/// Stats are keyed by physical column name, so `referenced_schema` must be physical.
+pub(crate) fn stats_schema(referenced_schema: &StructType) -> Option<SchemaRef> {
+    // Convert all fields into nullable, as stats may not be available for all columns
+    // (and usually aren't for partition columns).
+    struct NullableStatsTransform;
+    impl<'a> SchemaTransform<'a> for NullableStatsTransform {
+        fn transform_struct_field(
+            &mut self,
+            field: &'a StructField,
+        ) -> Option<Cow<'a, StructField>> {
+            use Cow::*;
+            let field = match self.transform(&field.data_type)? {
+                Borrowed(_) if field.is_nullable() => Borrowed(field),
+                data_type => Owned(StructField {
+                    name: field.name.clone(),
+                    data_type: data_type.into_owned(),
+                    nullable: true,
+                    metadata: field.metadata.clone(),
+                }),
+            };
+            Some(field)
+        }
+    }
+
+    // Convert a min/max stats schema into a nullcount schema (all leaf fields are LONG)
+    struct NullCountStatsTransform;
+    impl<'a> SchemaTransform<'a> for NullCountStatsTransform {
+        fn transform_primitive(
+            &mut self,
+            _ptype: &'a PrimitiveType,
+        ) -> Option<Cow<'a, PrimitiveType>> {
+            Some(Cow::Owned(PrimitiveType::Long))
+        }
+    }
+
+    let stats_schema = NullableStatsTransform
+        .transform_struct(referenced_schema)?
+        .into_owned();
+
+    let nullcount_schema = NullCountStatsTransform
+        .transform_struct(&stats_schema)?
+        .into_owned();
+    Some(Arc::new(StructType::new_unchecked([
+        StructField::nullable("numRecords", DataType::LONG),
+        StructField::nullable("nullCount", nullcount_schema),
+        StructField::nullable("minValues", stats_schema.clone()),
+        StructField::nullable("maxValues", stats_schema),
+    ])))
+}
+
 pub(crate) struct DataSkippingFilter {
     stats_schema: SchemaRef,
     select_stats_evaluator: Arc<dyn ExpressionEvaluator>,
@@ -76,52 +128,7 @@ impl DataSkippingFilter {
         let (predicate, referenced_schema) = physical_predicate?;
         debug!("Creating a data skipping filter for {:#?}", predicate);
 
-        // Convert all fields into nullable, as stats may not be available for all columns
-        // (and usually aren't for partition columns).
-        struct NullableStatsTransform;
-        impl<'a> SchemaTransform<'a> for NullableStatsTransform {
-            fn transform_struct_field(
-                &mut self,
-                field: &'a StructField,
-            ) -> Option<Cow<'a, StructField>> {
-                use Cow::*;
-                let field = match self.transform(&field.data_type)? {
-                    Borrowed(_) if field.is_nullable() => Borrowed(field),
-                    data_type => Owned(StructField {
-                        name: field.name.clone(),
-                        data_type: data_type.into_owned(),
-                        nullable: true,
-                        metadata: field.metadata.clone(),
-                    }),
-                };
-                Some(field)
-            }
-        }
-
-        // Convert a min/max stats schema into a nullcount schema (all leaf fields are LONG)
-        struct NullCountStatsTransform;
-        impl<'a> SchemaTransform<'a> for NullCountStatsTransform {
-            fn transform_primitive(
-                &mut self,
-                _ptype: &'a PrimitiveType,
-            ) -> Option<Cow<'a, PrimitiveType>> {
-                Some(Cow::Owned(PrimitiveType::Long))
-            }
-        }
-
-        let stats_schema = NullableStatsTransform
-            .transform_struct(&referenced_schema)?
-            .into_owned();
-
-        let nullcount_schema = NullCountStatsTransform
-            .transform_struct(&stats_schema)?
-            .into_owned();
-        let stats_schema = Arc::new(StructType::new_unchecked([
-            StructField::nullable("numRecords", DataType::LONG),
-            StructField::nullable("nullCount", nullcount_schema),
-            StructField::nullable("minValues", stats_schema.clone()),
-            StructField::nullable("maxValues", stats_schema),
-        ]));
+        let stats_schema = stats_schema(&referenced_schema)?;
 
         // Skipping happens in several steps:
         //
@@ -162,6 +169,7 @@ impl DataSkippingFilter {
     /// Apply the DataSkippingFilter to an EngineData batch of actions. Returns a selection vector
     /// which can be applied to the actions to find those that passed data skipping.
     pub(crate) fn apply(&self, actions: &dyn EngineData) -> DeltaResult<Vec<bool>> {
+        let span = debug_span!("data_skipping", rows = actions.len(), selected = Empty).entered();
         // retrieve and parse stats from actions data
         let stats = self.select_stats_evaluator.evaluate(actions)?;
         assert_eq!(stats.len(), actions.len());
@@ -181,6 +189,8 @@ impl DataSkippingFilter {
         // visit the engine's selection vector to produce a Vec<bool>
         let mut visitor = SelectionVectorVisitor::default();
         visitor.visit_rows_of(selection_vector.as_ref())?;
+        let selected = visitor.selection_vector.iter().filter(|&&sel| sel).count();
+        span.record("selected", selected);
         Ok(visitor.selection_vector)
 
         // TODO(zach): add some debug info about data skipping that occurred
@@ -1,8 +1,13 @@
 use std::clone::Clone;
 use std::collections::{HashMap, HashSet};
 use std::sync::{Arc, LazyLock};
+use std::time::Instant;
+
+use tracing::debug_span;
+use tracing::field::Empty;
 
 use super::data_skipping::DataSkippingFilter;
+use super::metrics::{BatchMetrics, ScanMetricsCollector};
 use super::ScanMetadata;
 use crate::actions::deletion_vector::DeletionVectorDescriptor;
 use crate::actions::get_log_add_schema;
@@ -49,6 +54,7 @@ pub(crate) struct ScanLogReplayProcessor {
     /// far in the log. This is used to filter out files with Remove actions as
     /// well as duplicate entries in the log.
     seen_file_keys: HashSet<FileActionKey>,
+    metrics: Arc<ScanMetricsCollector>,
 }
 
 impl ScanLogReplayProcessor {
@@ -58,6 +64,7 @@ impl ScanLogReplayProcessor {
         physical_predicate: Option<(PredicateRef, SchemaRef)>,
         logical_schema: SchemaRef,
         transform_spec: Option<Arc<TransformSpec>>,
+        metrics: Arc<ScanMetricsCollector>,
     ) -> Self {
         Self {
             partition_filter: physical_predicate.as_ref().map(|(e, _)| e.clone()),
@@ -70,6 +77,7 @@ impl ScanLogReplayProcessor {
             seen_file_keys: Default::default(),
             logical_schema,
             transform_spec,
+            metrics,
         }
     }
 }
@@ -85,6 +93,7 @@ struct AddRemoveDedupVisitor<'seen> {
     transform_spec: Option<Arc<TransformSpec>>,
     partition_filter: Option<PredicateRef>,
     row_transform_exprs: Vec<Option<ExpressionRef>>,
+    metrics: BatchMetrics,
 }
 
 impl AddRemoveDedupVisitor<'_> {
@@ -118,6 +127,7 @@ impl AddRemoveDedupVisitor<'_> {
             transform_spec,
             partition_filter,
             row_transform_exprs: Vec::new(),
+            metrics: BatchMetrics::default(),
         }
     }
 
@@ -156,6 +166,9 @@ impl AddRemoveDedupVisitor<'_> {
         else {
             return Ok(false);
         };
+        if is_add {
+            self.metrics.files_considered += 1;
+        }
 
         // Apply partition pruning (to adds only) before deduplication, so that we don't waste memory
         // tracking pruned files. Removes don't get pruned and we'll still have to track them.
@@ -170,6 +183,7 @@ impl AddRemoveDedupVisitor<'_> {
                 let partition_values =
                     parse_partition_values(&self.logical_schema, transform, &partition_values)?;
                 if self.is_file_partition_pruned(&partition_values) {
+                    self.metrics.files_skipped_by_partition += 1;
                     return Ok(false);
                 }
                 partition_values
@@ -178,9 +192,14 @@ impl AddRemoveDedupVisitor<'_> {
         };
 
         // Check both adds and removes (skipping already-seen), but only transform and return adds
+        let has_dv = file_key.dv_unique_id.is_some();
         if self.deduplicator.check_and_record_seen(file_key) || !is_add {
             return Ok(false);
         }
+        self.metrics.files_selected += 1;
+        if has_dv {
+            self.metrics.files_with_deletion_vector += 1;
+        }
         let transform = self
             .transform_spec
             .as_ref()
@@ -311,11 +330,22 @@ impl LogReplayProcessor for ScanLogReplayProcessor {
             actions,
             is_log_batch,
         } = actions_batch;
+        let span = debug_span!(
+            "scan_log_replay_batch",
+            rows = actions.len(),
+            is_log_batch,
+            selected = Empty,
+        )
+        .entered();
+        let start = Instant::now();
         // Build an initial selection vector for the batch which has had the data skipping filter
         // applied. The selection vector is further updated by the deduplication visitor to remove
         // rows that are not valid adds.
         let selection_vector = self.build_selection_vector(actions.as_ref())?;
         assert_eq!(selection_vector.len(), actions.len());
+        let data_skipping_time = start.elapsed();
+        // only adds have stats, so any row data skipping deselected is a skipped add
+        let files_skipped_by_stats = selection_vector.iter().filter(|&&sel| !sel).count();
 
         let mut visitor = AddRemoveDedupVisitor::new(
             &mut self.seen_file_keys,
@@ -329,6 +359,16 @@ impl LogReplayProcessor for ScanLogReplayProcessor {
 
         // TODO: Teach expression eval to respect the selection vector we just computed so carefully!
         let result = self.add_transform.evaluate(actions.as_ref())?;
+        let mut metrics = visitor.metrics;
+        metrics.files_considered += files_skipped_by_stats;
+        metrics.files_skipped_by_stats = files_skipped_by_stats;
+        span.record("selected", metrics.files_selected);
+        self.metrics.record_batch(
+            actions.len(),
+            metrics,
+            data_skipping_time,
+            start.elapsed().saturating_sub(data_skipping_time),
+        );
         Ok(ScanMetadata::new(
             result,
             visitor.selection_vector,
@@ -355,9 +395,16 @@ pub(crate) fn scan_action_iter(
     logical_schema: SchemaRef,
     transform_spec: Option<Arc<TransformSpec>>,
     physical_predicate: Option<(PredicateRef, SchemaRef)>,
+    metrics: Arc<ScanMetricsCollector>,
 ) -> impl Iterator<Item = DeltaResult<ScanMetadata>> {
-    ScanLogReplayProcessor::new(engine, physical_predicate, logical_schema, transform_spec)
-        .process_actions_iter(action_iter)
+    ScanLogReplayProcessor::new(
+        engine,
+        physical_predicate,
+        logical_schema,
+        transform_spec,
+        metrics,
+    )
+    .process_actions_iter(action_iter)
 }
 
 #[cfg(test)]
@@ -441,6 +488,7 @@ mod tests {
             logical_schema,
             None,
             None,
+            Default::default(),
         );
         for res in iter {
             let scan_metadata = res.unwrap();
@@ -470,6 +518,7 @@ mod tests {
             schema,
             static_transform,
             None,
+            Default::default(),
         );
 
         fn validate_transform(transform: Option<&ExpressionRef>, expected_date_offset: i32) {
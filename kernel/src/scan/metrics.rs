@@ -0,0 +1,158 @@
+//! Metrics describing the work a [`Scan`] did to produce its scan metadata.
+//!
+//! [`Scan`]: crate::scan::Scan
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use crate::log_segment::{LogFileCallback, LogFileKind};
+use crate::FileMeta;
+
+/// A point in time view of the work a [`Scan`] has done so far. Metrics are updated as the
+/// iterators returned by [`Scan::scan_metadata`] (or [`Scan::execute`]) are consumed, and cover all
+/// such iterators created from the same scan.
+///
+/// [`Scan`]: crate::scan::Scan
+/// [`Scan::scan_metadata`]: crate::scan::Scan::scan_metadata
+/// [`Scan::execute`]: crate::scan::Scan::execute
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ScanMetrics {
+    /// Number of commit (and compacted commit) files log replay opened
+    pub commit_files_read: u64,
+    /// Number of checkpoint parts log replay opened. Does not include sidecar files
+    pub checkpoint_parts_read: u64,
+    /// Number of sidecar files of v2 checkpoints log replay opened
+    pub sidecar_files_read: u64,
+    /// Total size in bytes of the log files (commits, checkpoint parts and sidecars) log replay
+    /// opened. Kernel does not read data files or deletion vectors to produce scan metadata, so
+    /// their bytes are not included
+    pub log_bytes_read: u64,
+    /// Number of actions (rows of log data) replayed
+    pub actions_replayed: u64,
+    /// Number of add actions log replay considered, before any skipping or deduplication
+    pub files_considered: u64,
+    /// Number of add actions skipped by data skipping (i.e. using file statistics)
+    pub files_skipped_by_stats: u64,
+    /// Number of add actions skipped by partition pruning
+    pub files_skipped_by_partition: u64,
+    /// Number of files selected for the scan
+    pub files_selected: u64,
+    /// Number of selected files that have a deletion vector. The deletion vectors themselves are
+    /// only loaded when the files are read, so this is how many will have to be loaded
+    pub files_with_deletion_vector: u64,
+    /// Time spent reading and parsing log files
+    pub log_read_time: Duration,
+    /// Time spent evaluating data skipping predicates
+    pub data_skipping_time: Duration,
+    /// Time spent replaying actions, not including data skipping
+    pub log_replay_time: Duration,
+}
+
+/// The shared, thread safe counters behind [`ScanMetrics`]
+#[derive(Debug, Default)]
+pub(crate) struct ScanMetricsCollector {
+    commit_files_read: AtomicU64,
+    checkpoint_parts_read: AtomicU64,
+    sidecar_files_read: AtomicU64,
+    log_bytes_read: AtomicU64,
+    actions_replayed: AtomicU64,
+    files_considered: AtomicU64,
+    files_skipped_by_stats: AtomicU64,
+    files_skipped_by_partition: AtomicU64,
+    files_selected: AtomicU64,
+    files_with_deletion_vector: AtomicU64,
+    log_read_ns: AtomicU64,
+    data_skipping_ns: AtomicU64,
+    log_replay_ns: AtomicU64,
+}
+
+fn add(counter: &AtomicU64, value: usize) {
+    counter.fetch_add(value as u64, Ordering::Relaxed);
+}
+
+fn add_duration(counter: &AtomicU64, duration: Duration) {
+    counter.fetch_add(duration.as_nanos() as u64, Ordering::Relaxed);
+}
+
+fn load_duration(counter: &AtomicU64) -> Duration {
+    Duration::from_nanos(counter.load(Ordering::Relaxed))
+}
+
+/// Counts of what happened to the add actions of one batch during replay
+#[derive(Debug, Default)]
+pub(crate) struct BatchMetrics {
+    pub(crate) files_considered: usize,
+    pub(crate) files_skipped_by_stats: usize,
+    pub(crate) files_skipped_by_partition: usize,
+    pub(crate) files_selected: usize,
+    pub(crate) files_with_deletion_vector: usize,
+}
+
+impl ScanMetricsCollector {
+    /// A callback for [`LogSegment::read_actions_tracked`] that records each log file replay opens
+    ///
+    /// [`LogSegment::read_actions_tracked`]: crate::log_segment::LogSegment::read_actions_tracked
+    pub(crate) fn log_file_callback(self: &Arc<Self>) -> LogFileCallback {
+        let metrics = self.clone();
+        Arc::new(move |kind, file| metrics.record_log_file(kind, file))
+    }
+
+    fn record_log_file(&self, kind: LogFileKind, file: &FileMeta) {
+        match kind {
+            LogFileKind::Commit => add(&self.commit_files_read, 1),
+            LogFileKind::CheckpointPart => add(&self.checkpoint_parts_read, 1),
+            LogFileKind::Sidecar => add(&self.sidecar_files_read, 1),
+        }
+        self.log_bytes_read.fetch_add(file.size, Ordering::Relaxed);
+    }
+
+    /// Record the time spent producing a batch of actions, started at `start`
+    pub(crate) fn record_log_read(&self, start: Instant) {
+        add_duration(&self.log_read_ns, start.elapsed());
+    }
+
+    /// Record the replay of a batch of `num_actions` actions, which spent `data_skipping_time` in
+    /// data skipping and `replay_time` on the rest of replay
+    pub(crate) fn record_batch(
+        &self,
+        num_actions: usize,
+        batch: BatchMetrics,
+        data_skipping_time: Duration,
+        replay_time: Duration,
+    ) {
+        add(&self.actions_replayed, num_actions);
+        add(&self.files_considered, batch.files_considered);
+        add(&self.files_skipped_by_stats, batch.files_skipped_by_stats);
+        add(
+            &self.files_skipped_by_partition,
+            batch.files_skipped_by_partition,
+        );
+        add(&self.files_selected, batch.files_selected);
+        add(
+            &self.files_with_deletion_vector,
+            batch.files_with_deletion_vector,
+        );
+        add_duration(&self.data_skipping_ns, data_skipping_time);
+        add_duration(&self.log_replay_ns, replay_time);
+    }
+
+    pub(crate) fn snapshot(&self) -> ScanMetrics {
+        let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        ScanMetrics {
+            commit_files_read: load(&self.commit_files_read),
+            checkpoint_parts_read: load(&self.checkpoint_parts_read),
+            sidecar_files_read: load(&self.sidecar_files_read),
+            log_bytes_read: load(&self.log_bytes_read),
+            actions_replayed: load(&self.actions_replayed),
+            files_considered: load(&self.files_considered),
+            files_skipped_by_stats: load(&self.files_skipped_by_stats),
+            files_skipped_by_partition: load(&self.files_skipped_by_partition),
+            files_selected: load(&self.files_selected),
+            files_with_deletion_vector: load(&self.files_with_deletion_vector),
+            log_read_time: load_duration(&self.log_read_ns),
+            data_skipping_time: load_duration(&self.data_skipping_ns),
+            log_replay_time: load_duration(&self.log_replay_ns),
+        }
+    }
+}
@@ -3,6 +3,7 @@
 use std::borrow::Cow;
 use std::collections::{HashMap, HashSet};
 use std::sync::{Arc, LazyLock};
+use std::time::Instant;
 
 use delta_kernel_derive::internal_api;
 use itertools::Itertools;
@@ -16,11 +17,14 @@ use crate::actions::deletion_vector::{
 use crate::actions::{get_log_schema, ADD_NAME, REMOVE_NAME, SIDECAR_NAME};
 use crate::engine_data::FilteredEngineData;
 use crate::expressions::transforms::ExpressionTransform;
-use crate::expressions::{ColumnName, ExpressionRef, Predicate, PredicateRef, Scalar};
+use crate::expressions::{
+    ColumnName, Expression, ExpressionRef, Predicate, PredicateRef, Scalar, Transform,
+};
 use crate::kernel_predicates::{DefaultKernelPredicateEvaluator, EmptyColumnResolver};
 use crate::listed_log_files::ListedLogFiles;
 use crate::log_replay::{ActionsBatch, HasSelectionVector};
 use crate::log_segment::LogSegment;
+use crate::scan::metrics::ScanMetricsCollector;
 use crate::scan::state::{DvInfo, Stats};
 use crate::schema::ToSchema as _;
 use crate::schema::{
@@ -29,15 +33,18 @@ use crate::schema::{
 };
 use crate::snapshot::SnapshotRef;
 use crate::table_features::ColumnMappingMode;
-use crate::transforms::{get_transform_spec, ColumnType};
+use crate::transforms::{get_transform_spec, ColumnType, FieldTransformSpec};
 use crate::{DeltaResult, Engine, EngineData, Error, FileMeta, Version};
 
 use self::log_replay::scan_action_iter;
 
 pub(crate) mod data_skipping;
 pub mod log_replay;
+mod metrics;
 pub mod state;
 
+pub use metrics::ScanMetrics;
+
 // safety: we define get_log_schema() and _know_ it contains ADD_NAME and REMOVE_NAME
 #[allow(clippy::unwrap_used)]
 static COMMIT_READ_SCHEMA: LazyLock<SchemaRef> =
@@ -52,6 +59,7 @@ pub struct ScanBuilder {
     snapshot: SnapshotRef,
     schema: Option<SchemaRef>,
     predicate: Option<PredicateRef>,
+    limit: Option<u64>,
 }
 
 impl std::fmt::Debug for ScanBuilder {
@@ -59,6 +67,7 @@ impl std::fmt::Debug for ScanBuilder {
         f.debug_struct("ScanBuilder")
             .field("schema", &self.schema)
             .field("predicate", &self.predicate)
+            .field("limit", &self.limit)
             .finish()
     }
 }
@@ -70,6 +79,7 @@ impl ScanBuilder {
             snapshot: snapshot.into(),
             schema: None,
             predicate: None,
+            limit: None,
         }
     }
 
@@ -107,6 +117,20 @@ impl ScanBuilder {
         self
     }
 
+    /// Optionally provide the number of rows the scan needs to return. Once the files selected so
+    /// far are known (from their `numRecords` statistic, less the rows their deletion vectors
+    /// remove) to contain at least `limit` rows, the scan selects no more files and stops
+    /// replaying the log. If `limit` is `None`, this is a no-op.
+    ///
+    /// NOTE: The limit only prunes whole files, so the selected files will usually contain more
+    /// than `limit` rows, and the engine must still apply the limit to the rows it reads. Files
+    /// without statistics don't count towards the limit. The limit is ignored if the scan has a
+    /// predicate, since the rows of the selected files may not satisfy it.
+    pub fn with_limit(mut self, limit: impl Into<Option<u64>>) -> Self {
+        self.limit = limit.into();
+        self
+    }
+
     /// Build the [`Scan`].
     ///
     /// This does not scan the table at this point, but does do some work to ensure that the
@@ -126,6 +150,12 @@ impl ScanBuilder {
             Some(predicate) => PhysicalPredicate::try_new(&predicate, &logical_schema)?,
             None => PhysicalPredicate::None,
         };
+        // we can't know how many of the rows of a file satisfy a predicate, so we can only count
+        // rows towards the limit without one
+        let limit = match physical_predicate {
+            PhysicalPredicate::None => self.limit,
+            _ => None,
+        };
 
         Ok(Scan {
             snapshot: self.snapshot,
@@ -134,6 +164,8 @@ impl ScanBuilder {
             physical_predicate,
             all_fields: Arc::new(state_info.all_fields),
             have_partition_cols: state_info.have_partition_cols,
+            limit,
+            metrics: Default::default(),
         })
     }
 }
@@ -362,6 +394,62 @@ impl HasSelectionVector for ScanMetadata {
     }
 }
 
+impl ScanMetadata {
+    /// Deselect the files that come after the first selected files known to contain at least
+    /// `limit` rows. Returns the number of rows the files that remain selected are known to contain.
+    fn apply_limit(&mut self, limit: u64) -> DeltaResult<u64> {
+        fn count_rows(
+            rows: &mut Vec<u64>,
+            _: &str,
+            _: i64,
+            stats: Option<Stats>,
+            dv_info: DvInfo,
+            _: Option<ExpressionRef>,
+            _: HashMap<String, String>,
+        ) {
+            let deleted = dv_info
+                .deletion_vector
+                .map_or(0, |dv| dv.cardinality.max(0) as u64);
+            rows.push(stats.map_or(0, |stats| stats.num_records.saturating_sub(deleted)));
+        }
+        // the visitor calls back once for each selected file, in order
+        let mut rows = self.visit_scan_files(vec![], count_rows)?.into_iter();
+        let mut covered = 0;
+        for selected in self.scan_files.selection_vector.iter_mut().filter(|s| **s) {
+            if covered >= limit {
+                *selected = false;
+            } else {
+                covered += rows.next().unwrap_or(0);
+            }
+        }
+        Ok(covered)
+    }
+}
+
+/// Stop `scan_metadata` once the files it selected are known to contain `limit` rows. See
+/// [`ScanBuilder::with_limit`]. The underlying iterator (and so log replay) is not advanced any
+/// further once the limit is reached.
+fn limit_scan_metadata(
+    mut scan_metadata: impl Iterator<Item = DeltaResult<ScanMetadata>>,
+    limit: Option<u64>,
+) -> impl Iterator<Item = DeltaResult<ScanMetadata>> {
+    let mut remaining = limit;
+    std::iter::from_fn(move || {
+        let Some(limit) = remaining else {
+            return scan_metadata.next();
+        };
+        if limit == 0 {
+            return None;
+        }
+        let result = scan_metadata.next()?.and_then(|mut metadata| {
+            let covered = metadata.apply_limit(limit)?;
+            remaining = Some(limit.saturating_sub(covered));
+            Ok(metadata)
+        });
+        Some(result)
+    })
+}
+
 /// The result of building a scan over a table. This can be used to get the actual data from
 /// scanning the table.
 pub struct Scan {
@@ -371,6 +459,8 @@ pub struct Scan {
     physical_predicate: PhysicalPredicate,
     all_fields: Arc<Vec<ColumnType>>,
     have_partition_cols: bool,
+    limit: Option<u64>,
+    metrics: Arc<ScanMetricsCollector>,
 }
 
 impl std::fmt::Debug for Scan {
@@ -378,6 +468,7 @@ impl std::fmt::Debug for Scan {
         f.debug_struct("Scan")
             .field("schema", &self.logical_schema)
             .field("predicate", &self.physical_predicate)
+            .field("limit", &self.limit)
             .finish()
     }
 }
@@ -426,6 +517,48 @@ impl Scan {
         }
     }
 
+    /// Get the transform of this scan, in which (like in [`Scan::scan_metadata`]'s per-file
+    /// transforms) each partition column is inserted into the physical data, but as a reference to
+    /// a column of the partition column's logical name rather than as the literal partition value
+    /// of one file. A single such transform can therefore be applied to every file of the scan, by
+    /// an engine that adds the file's partition values to its data as extra columns.
+    #[internal_api]
+    pub(crate) fn transform_template(&self) -> DeltaResult<Transform> {
+        let mut transform = Transform::new_top_level();
+        for field_transform in get_transform_spec(&self.all_fields) {
+            use FieldTransformSpec::*;
+            transform = match field_transform {
+                StaticInsert { insert_after, expr } => {
+                    transform.with_inserted_field(insert_after, expr)
+                }
+                StaticReplace { field_name, expr } => {
+                    transform.with_replaced_field(field_name, expr)
+                }
+                StaticDrop { field_name } => transform.with_dropped_field(field_name),
+                PartitionColumn {
+                    field_index,
+                    insert_after,
+                } => {
+                    let Some(field) = self.logical_schema.field_at_index(field_index) else {
+                        return Err(Error::internal_error(format!(
+                            "out of bounds partition column field index {field_index}"
+                        )));
+                    };
+                    let column = Arc::new(Expression::column([field.name()]));
+                    transform.with_inserted_field(insert_after, column)
+                }
+            };
+        }
+        Ok(transform)
+    }
+
+    /// Get the [`ScanMetrics`] of this scan so far. Metrics are collected as scan metadata is
+    /// produced, so they are only complete once all the iterators returned by
+    /// [`Scan::scan_metadata`] (or [`Scan::execute`]) have been exhausted.
+    pub fn metrics(&self) -> ScanMetrics {
+        self.metrics.snapshot()
+    }
+
     /// Get an iterator of [`ScanMetadata`]s that should be used to facilitate a scan. This handles
     /// log-replay, reconciling Add and Remove actions, and applying data skipping (if possible).
     /// Each item in the returned iterator is a struct of:
@@ -573,11 +706,12 @@ impl Scan {
         )?;
 
         let it = new_log_segment
-            .read_actions(
+            .read_actions_tracked(
                 engine,
                 COMMIT_READ_SCHEMA.clone(),
                 CHECKPOINT_READ_SCHEMA.clone(),
                 None,
+                self.metrics.log_file_callback(),
             )?
             .chain(existing_data.into_iter().map(apply_transform));
 
@@ -587,7 +721,7 @@ impl Scan {
     fn scan_metadata_inner(
         &self,
         engine: &dyn Engine,
-        action_batch_iter: impl Iterator<Item = DeltaResult<ActionsBatch>>,
+        mut action_batch_iter: impl Iterator<Item = DeltaResult<ActionsBatch>>,
     ) -> DeltaResult<impl Iterator<Item = DeltaResult<ScanMetadata>>> {
         // Compute the static part of the transformation. This is `None` if no transformation is
         // needed. We need transforms for:
@@ -601,13 +735,22 @@ impl Scan {
             PhysicalPredicate::Some(predicate, schema) => Some((predicate, schema)),
             PhysicalPredicate::None => None,
         };
+        let metrics = self.metrics.clone();
+        let timed_action_batch_iter = std::iter::from_fn(move || {
+            let start = Instant::now();
+            let next = action_batch_iter.next();
+            metrics.record_log_read(start);
+            next
+        });
         let it = scan_action_iter(
             engine,
-            action_batch_iter,
+            timed_action_batch_iter,
             self.logical_schema.clone(),
             static_transform,
             physical_predicate,
+            self.metrics.clone(),
         );
+        let it = limit_scan_metadata(it, self.limit);
         Ok(Some(it).into_iter().flatten())
     }
 
@@ -618,11 +761,12 @@ impl Scan {
     ) -> DeltaResult<impl Iterator<Item = DeltaResult<ActionsBatch>> + Send> {
         // NOTE: We don't pass any meta-predicate because we expect no meaningful row group skipping
         // when ~every checkpoint file will contain the adds and removes we are looking for.
-        self.snapshot.log_segment().read_actions(
+        self.snapshot.log_segment().read_actions_tracked(
             engine,
             COMMIT_READ_SCHEMA.clone(),
             CHECKPOINT_READ_SCHEMA.clone(),
             None,
+            self.metrics.log_file_callback(),
         )
     }
 
@@ -764,6 +908,25 @@ pub fn scan_row_schema() -> SchemaRef {
     log_replay::SCAN_ROW_SCHEMA.clone()
 }
 
+/// Get the schema the `stats` of scan rows parse into (as JSON), for the columns of `schema`:
+///
+/// ```ignored
+/// {
+///    numRecords: long,
+///    nullCount: { <a long per column of schema> },
+///    minValues: { <the columns of schema> },
+///    maxValues: { <the columns of schema> },
+/// }
+/// ```
+///
+/// All fields are nullable, as files need not have stats for every column. Stats are keyed by
+/// physical column name, so with column mapping `schema` must be the physical schema.
+#[internal_api]
+pub(crate) fn file_stats_schema(schema: &StructType) -> DeltaResult<SchemaRef> {
+    data_skipping::stats_schema(schema)
+        .ok_or_else(|| Error::internal_error("Failed to build the stats schema"))
+}
+
 /// All the state needed to process a scan.
 struct StateInfo {
     /// All fields referenced by the query.
@@ -973,6 +1136,7 @@ pub(crate) mod test_utils {
             logical_schema,
             transform_spec,
             None,
+            Default::default(),
         );
         let mut batch_count = 0;
         for res in iter {
@@ -1219,6 +1383,118 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_scan_metadata_limit() {
+        let path = std::fs::canonicalize(PathBuf::from("./tests/data/basic_partitioned/")).unwrap();
+        let url = url::Url::from_directory_path(path).unwrap();
+        let engine = SyncEngine::new();
+        let snapshot = Snapshot::builder_for(url).build(&engine).unwrap();
+
+        // Each of the six files has one row, and both commits add three of them
+        let scan = |limit: u64| snapshot.clone().scan_builder().with_limit(limit).build();
+        let files = get_files_for_scan(scan(2).unwrap(), &engine).unwrap();
+        assert_eq!(files.len(), 2);
+        let files = get_files_for_scan(scan(3).unwrap(), &engine).unwrap();
+        assert_eq!(files.len(), 3);
+        let files = get_files_for_scan(scan(4).unwrap(), &engine).unwrap();
+        assert_eq!(files.len(), 4);
+        let files = get_files_for_scan(scan(100).unwrap(), &engine).unwrap();
+        assert_eq!(files.len(), 6);
+        assert!(get_files_for_scan(scan(0).unwrap(), &engine)
+            .unwrap()
+            .is_empty());
+
+        // The newest commit covers a limit of 3, so the older one is never replayed
+        let limited = scan(3).unwrap();
+        let _: Vec<_> = limited
+            .scan_metadata(&engine)
+            .unwrap()
+            .try_collect()
+            .unwrap();
+        let unlimited = snapshot.clone().scan_builder().build().unwrap();
+        let _: Vec<_> = unlimited
+            .scan_metadata(&engine)
+            .unwrap()
+            .try_collect()
+            .unwrap();
+        assert!(limited.metrics().actions_replayed < unlimited.metrics().actions_replayed);
+
+        // With a predicate we can't tell how many rows match, so the limit is ignored
+        let predicate = Arc::new(column_expr!("number").gt(Expr::literal(0i64)));
+        let scan = snapshot
+            .scan_builder()
+            .with_predicate(predicate)
+            .with_limit(1u64)
+            .build()
+            .unwrap();
+        let files = get_files_for_scan(scan, &engine).unwrap();
+        assert_eq!(files.len(), 6);
+    }
+
+    #[test]
+    fn test_transform_template() {
+        let path = std::fs::canonicalize(PathBuf::from("./tests/data/basic_partitioned/")).unwrap();
+        let url = url::Url::from_directory_path(path).unwrap();
+        let engine = SyncEngine::new();
+        let snapshot = Snapshot::builder_for(url).build(&engine).unwrap();
+
+        // `letter` is the first column, so its parameter column is prepended
+        let scan = snapshot.clone().scan_builder().build().unwrap();
+        let expected = Transform::new_top_level()
+            .with_inserted_field(None::<String>, Arc::new(column_expr!("letter")));
+        assert_eq!(scan.transform_template().unwrap(), expected);
+
+        // without the partition column there is nothing to insert
+        let schema = snapshot.schema().project(&["number", "a_float"]).unwrap();
+        let scan = snapshot.scan_builder().with_schema(schema).build().unwrap();
+        assert_eq!(
+            scan.transform_template().unwrap(),
+            Transform::new_top_level()
+        );
+    }
+
+    #[test]
+    fn test_scan_metrics() {
+        let path =
+            std::fs::canonicalize(PathBuf::from("./tests/data/table-with-dv-small/")).unwrap();
+        let url = url::Url::from_directory_path(path).unwrap();
+        let engine = SyncEngine::new();
+        let snapshot = Snapshot::builder_for(url).build(&engine).unwrap();
+
+        // The newest commit removes the only file and adds it back with a deletion vector
+        let scan = snapshot.clone().scan_builder().build().unwrap();
+        // log files are only counted once replay gets to them
+        drop(scan.scan_metadata(&engine).unwrap());
+        assert_eq!(scan.metrics(), ScanMetrics::default());
+        let scan_metadata: Vec<_> = scan.scan_metadata(&engine).unwrap().try_collect().unwrap();
+        assert_eq!(scan_metadata.len(), 1);
+        let metrics = scan.metrics();
+        assert_eq!(metrics.commit_files_read, 2);
+        assert_eq!(metrics.checkpoint_parts_read, 0);
+        assert_eq!(metrics.sidecar_files_read, 0);
+        assert!(metrics.log_bytes_read > 0);
+        assert_eq!(metrics.actions_replayed, 7);
+        assert_eq!(metrics.files_considered, 2);
+        assert_eq!(metrics.files_skipped_by_stats, 0);
+        assert_eq!(metrics.files_selected, 1);
+        assert_eq!(metrics.files_with_deletion_vector, 1);
+
+        // Every value is below 100, so both adds are skipped using their stats
+        let predicate = Arc::new(column_expr!("value").gt(Expr::literal(100)));
+        let scan = snapshot
+            .scan_builder()
+            .with_predicate(predicate)
+            .build()
+            .unwrap();
+        let scan_metadata: Vec<_> = scan.scan_metadata(&engine).unwrap().try_collect().unwrap();
+        assert!(scan_metadata.iter().all(|data| !data.has_selected_rows()));
+        let metrics = scan.metrics();
+        assert_eq!(metrics.files_considered, 2);
+        assert_eq!(metrics.files_skipped_by_stats, 2);
+        assert_eq!(metrics.files_selected, 0);
+        assert_eq!(metrics.files_with_deletion_vector, 0);
+    }
+
     #[test_log::test]
     fn test_scan_metadata() {
         let path =
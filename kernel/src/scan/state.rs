@@ -3,6 +3,8 @@
 use std::collections::HashMap;
 use std::sync::LazyLock;
 
+use delta_kernel_derive::internal_api;
+
 use crate::actions::deletion_vector::deletion_treemap_to_bools;
 use crate::scan::get_transform_for_row;
 use crate::schema::Schema;
@@ -52,6 +54,12 @@ impl DvInfo {
         self.deletion_vector.is_some()
     }
 
+    /// The descriptor of the deletion vector, if there is one
+    #[internal_api]
+    pub(crate) fn deletion_vector(&self) -> Option<&DeletionVectorDescriptor> {
+        self.deletion_vector.as_ref()
+    }
+
     pub(crate) fn get_treemap(
         &self,
         engine: &dyn Engine,
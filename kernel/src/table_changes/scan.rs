@@ -10,7 +10,7 @@ use crate::actions::deletion_vector::split_vector;
 use crate::scan::{PhysicalPredicate, ScanResult};
 use crate::schema::{SchemaRef, StructType};
 use crate::transforms::ColumnType;
-use crate::{DeltaResult, Engine, FileMeta, PredicateRef};
+use crate::{DeltaResult, Engine, ExpressionRef, FileMeta, PredicateRef};
 
 use super::log_replay::{table_changes_action_iter, TableChangesScanMetadata};
 use super::physical_to_logical::{physical_to_logical_expr, scan_file_physical_schema};
@@ -37,6 +37,34 @@ pub struct TableChangesScan {
     all_fields: Arc<Vec<ColumnType>>,
 }
 
+/// A file to read for a [`TableChangesScan`], as returned by [`TableChangesScan::scan_files`]. This
+/// holds everything an engine needs to read the changes recorded in the file itself: the schema to
+/// read it with, the rows of it that belong to the change data feed, and the expression that turns
+/// its physical data into the logical schema of the scan.
+#[derive(Debug, Clone)]
+pub struct TableChangesScanFile {
+    /// The url of the file
+    pub location: Url,
+    /// The version of the commit the file was added, removed or written in
+    pub commit_version: i64,
+    /// The timestamp of that commit, in milliseconds since the epoch
+    pub commit_timestamp: i64,
+    /// The schema to read the file with. This is the physical schema of the scan, plus the
+    /// `_change_type` column for change data files, which store it physically
+    pub physical_schema: SchemaRef,
+    /// The expression that converts the physical data of the file to the logical schema of the
+    /// scan. It fills in the partition columns and the `_change_type`, `_commit_version` and
+    /// `_commit_timestamp` columns
+    pub transform: ExpressionRef,
+    /// Optional vector of bools. If `selection_vector[i] = true`, then row `i` of the file belongs
+    /// to the change data feed. If `selection_vector` is `None`, then all rows do. The vector may
+    /// be shorter than the file, in which case the remaining rows are selected exactly when
+    /// `rows_past_end_selected` is true
+    pub selection_vector: Option<Vec<bool>>,
+    /// Whether the rows past the end of `selection_vector` belong to the change data feed
+    pub rows_past_end_selected: bool,
+}
+
 /// This builder constructs a [`TableChangesScan`] that can be used to read the [`TableChanges`]
 /// of a table. [`TableChangesScanBuilder`] allows you to specify a schema to project the columns
 /// or specify a predicate to filter rows in the Change Data Feed. Note that predicates containing Change
@@ -233,6 +261,46 @@ impl TableChangesScan {
         }
     }
 
+    /// Get the files to read for the change data feed, in commit order. This is the same metadata
+    /// [`Self::execute`] reads data with, for engines that want to read the files themselves. The
+    /// deletion vectors of the files are already resolved, so one data file may be returned twice:
+    /// once for the rows that were added to it and once for the rows that were removed from it.
+    pub fn scan_files(
+        &self,
+        engine: Arc<dyn Engine>,
+    ) -> DeltaResult<impl Iterator<Item = DeltaResult<TableChangesScanFile>>> {
+        let scan_metadata = self.scan_metadata(engine.clone())?;
+        let scan_files = scan_metadata_to_scan_file(scan_metadata);
+
+        let table_root = self.table_changes.table_root().clone();
+        let dv_table_root = table_root.clone();
+        let logical_schema = self.logical_schema.clone();
+        let physical_schema = self.physical_schema.clone();
+        let all_fields = self.all_fields.clone();
+
+        let result = scan_files
+            .map(move |scan_file| resolve_scan_file_dv(engine.as_ref(), &dv_table_root, scan_file?))
+            .flatten_ok()
+            .map(move |resolved_scan_file| -> DeltaResult<_> {
+                let ResolvedCdfScanFile {
+                    scan_file,
+                    selection_vector,
+                } = resolved_scan_file?;
+                let transform = physical_to_logical_expr(&scan_file, &logical_schema, &all_fields)?;
+                Ok(TableChangesScanFile {
+                    location: table_root.join(&scan_file.path)?,
+                    commit_version: scan_file.commit_version,
+                    commit_timestamp: scan_file.commit_timestamp,
+                    physical_schema: scan_file_physical_schema(&scan_file, &physical_schema),
+                    transform: Arc::new(transform),
+                    selection_vector,
+                    // see `read_scan_file` for how the vectors of resolved pairs differ
+                    rows_past_end_selected: scan_file.remove_dv.is_none(),
+                })
+            });
+        Ok(result)
+    }
+
     /// Perform an "all in one" scan to get the change data feed. This will use the provided `engine`
     /// to read and process all the data for the query. Each [`ScanResult`] in the resultant iterator
     /// encapsulates the raw data and an optional boolean vector built from the deletion vector if it
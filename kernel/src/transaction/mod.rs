@@ -3,6 +3,7 @@ use std::iter;
 use std::ops::Deref;
 use std::sync::{Arc, LazyLock};
 
+use delta_kernel_derive::internal_api;
 use url::Url;
 
 use crate::actions::{
@@ -284,6 +285,12 @@ impl Transaction {
         Expression::struct_from(fields)
     }
 
+    /// The snapshot this transaction reads the table state from and commits on top of.
+    #[internal_api]
+    pub(crate) fn read_snapshot(&self) -> &SnapshotRef {
+        &self.read_snapshot
+    }
+
     /// Get the write context for this transaction. At the moment, this is constant for the whole
     /// transaction.
     // Note: after we introduce metadata updates (modify table schema, etc.), we need to make sure
@@ -1,14 +1,16 @@
 use std::error;
 
-use delta_kernel::arrow::array::RecordBatch;
-use delta_kernel::arrow::compute::filter_record_batch;
+use delta_kernel::arrow::array::{BooleanArray, RecordBatch};
+use delta_kernel::arrow::compute::{concat_batches, filter_record_batch};
 use delta_kernel::arrow::datatypes::Schema as ArrowSchema;
 use itertools::Itertools;
+use url::Url;
 
 use delta_kernel::engine::arrow_conversion::TryFromKernel as _;
 use delta_kernel::engine::default::DefaultEngine;
+use delta_kernel::table_changes::scan::TableChangesScan;
 use delta_kernel::table_changes::TableChanges;
-use delta_kernel::{DeltaResult, Error, PredicateRef, Version};
+use delta_kernel::{DeltaResult, Engine, Error, FileMeta, PredicateRef, Version};
 
 mod common;
 
@@ -25,27 +27,13 @@ fn read_cdf_for_table(
     let test_path = test_dir.path().join(test_name.as_ref());
     let test_path = delta_kernel::try_parse_uri(test_path.to_str().expect("table path to string"))?;
     let engine = DefaultEngine::new_local();
-    let table_changes = TableChanges::try_new(
+    let scan = cdf_scan(
         test_path,
         engine.as_ref(),
         start_version,
         end_version.into(),
+        predicate.into(),
     )?;
-
-    // Project out the commit timestamp since file modification time may change anytime git clones
-    // or switches branches
-    let names = table_changes
-        .schema()
-        .fields()
-        .map(|field| field.name())
-        .filter(|name| *name != "_commit_timestamp")
-        .collect_vec();
-    let schema = table_changes.schema().project(&names)?;
-    let scan = table_changes
-        .into_scan_builder()
-        .with_schema(schema)
-        .with_predicate(predicate)
-        .build()?;
     let scan_schema_as_arrow =
         ArrowSchema::try_from_kernel(scan.logical_schema().as_ref()).unwrap();
     let batches: Vec<RecordBatch> = scan
@@ -66,6 +54,86 @@ fn read_cdf_for_table(
     Ok(batches)
 }
 
+fn cdf_scan(
+    test_path: Url,
+    engine: &dyn Engine,
+    start_version: Version,
+    end_version: Option<Version>,
+    predicate: Option<PredicateRef>,
+) -> DeltaResult<TableChangesScan> {
+    let table_changes = TableChanges::try_new(test_path, engine, start_version, end_version)?;
+
+    // Project out the commit timestamp since file modification time may change anytime git clones
+    // or switches branches
+    let names = table_changes
+        .schema()
+        .fields()
+        .map(|field| field.name())
+        .filter(|name| *name != "_commit_timestamp")
+        .collect_vec();
+    let schema = table_changes.schema().project(&names)?;
+    table_changes
+        .into_scan_builder()
+        .with_schema(schema)
+        .with_predicate(predicate)
+        .build()
+}
+
+// Read the change data feed of a table the way an engine that reads the files itself would, from
+// the files returned by `TableChangesScan::scan_files`
+fn read_cdf_from_scan_files(
+    test_name: &str,
+    start_version: Version,
+    end_version: impl Into<Option<Version>>,
+) -> DeltaResult<Vec<RecordBatch>> {
+    let test_dir = load_test_data("tests/data", test_name).unwrap();
+    let test_path = test_dir.path().join(test_name);
+    let test_path = delta_kernel::try_parse_uri(test_path.to_str().expect("table path to string"))?;
+    let engine = DefaultEngine::new_local();
+    let scan = cdf_scan(
+        test_path,
+        engine.as_ref(),
+        start_version,
+        end_version.into(),
+        None,
+    )?;
+    let mut batches = vec![];
+    for file in scan.scan_files(engine.clone())? {
+        let file = file?;
+        let evaluator = engine.evaluation_handler().new_expression_evaluator(
+            file.physical_schema.clone(),
+            file.transform.clone(),
+            scan.logical_schema().clone().into(),
+        );
+        let meta = FileMeta {
+            location: file.location.clone(),
+            last_modified: 0,
+            size: 0,
+        };
+        let mut rows_read = 0;
+        for data in engine.parquet_handler().read_parquet_files(
+            &[meta],
+            file.physical_schema.clone(),
+            None,
+        )? {
+            let record_batch = to_arrow(evaluator.evaluate(data?.as_ref())?)?;
+            let rows = rows_read..rows_read + record_batch.num_rows();
+            rows_read = rows.end;
+            let mask: BooleanArray = match &file.selection_vector {
+                Some(selection_vector) => rows
+                    .map(|row| {
+                        let selected = selection_vector.get(row).copied();
+                        Some(selected.unwrap_or(file.rows_past_end_selected))
+                    })
+                    .collect(),
+                None => rows.map(|_| Some(true)).collect(),
+            };
+            batches.push(filter_record_batch(&record_batch, &mask)?);
+        }
+    }
+    Ok(batches)
+}
+
 #[test]
 fn cdf_with_deletion_vector() -> Result<(), Box<dyn error::Error>> {
     let batches = read_cdf_for_table("cdf-table-with-dv", 0, None, None)?;
@@ -553,3 +621,24 @@ fn conditional_delete_two_rows() -> DeltaResult<()> {
     assert_batches_sorted_eq!(expected, &batches);
     Ok(())
 }
+
+#[test]
+fn scan_files_match_execute() -> Result<(), Box<dyn error::Error>> {
+    // deletion vectors, change data files and partition columns
+    let tables = [
+        "cdf-table-with-dv",
+        "cdf-table-with-cdc-and-dvs",
+        "cdf-table-partitioned",
+    ];
+    for table in tables {
+        let expected = read_cdf_for_table(table, 0, None, None)?;
+        let actual = read_cdf_from_scan_files(table, 0, None)?;
+        let schema = expected[0].schema();
+        assert_eq!(
+            concat_batches(&schema, &actual)?,
+            concat_batches(&schema, &expected)?,
+            "{table}"
+        );
+    }
+    Ok(())
+}